@@ -353,9 +353,10 @@ function AddProjects(groupName, folders)
 	            "%{prj.location}\\src\\**.hpp"
 			}
 
-			-- Disable CRT secure warnings
+			-- Disable CRT secure warnings, and load OBJ files with the OptimizedObjLoader
 			defines {
-				"_CRT_SECURE_NO_WARNINGS"
+				"_CRT_SECURE_NO_WARNINGS",
+				"OPTIMIZED_OBJ_LOADER"
 			}
 
 			-- We update the reserved include directory to be the project's source directory
@@ -398,6 +399,53 @@ end
 -- Add the User Projects and Sample Projects
 AddProjects("Projects", projects)
 
+-- Command line tools for the asset pipeline, these only need the standard library and zlib
+group("Tools")
+
+-- Packs a project's res folder into an asset archive, see AssetArchive in the project's source
+project "AssetPacker"
+	location "tools/AssetPacker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir ("%{wks.location}\\bin\\" .. outputdir .. "\\%{prj.name}")
+	objdir ("%{wks.location}\\obj\\" .. outputdir .. "\\%{prj.name}")
+
+	files {
+		"%{prj.location}\\src\\**.h",
+		"%{prj.location}\\src\\**.cpp"
+	}
+
+	-- The archive format is shared with the game, so we include it's source folder
+	includedirs {
+		"tools/AssetPacker/src",
+		"projects/INFR1350U-MidtermProject/src",
+		"dependencies/gzip"
+	}
+
+	defines {
+		"_CRT_SECURE_NO_WARNINGS"
+	}
+
+	links {
+		"dependencies/gzip/zlib.lib"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+	filter {}
+
 for k, proj in pairs(sampleGroups) do
 	local name = path.getbasename(proj);
     local samples = os.matchdirs(proj .. "/*")
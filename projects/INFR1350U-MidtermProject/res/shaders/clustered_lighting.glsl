@@ -0,0 +1,44 @@
+// Shared by all the shaders that use clustered lighting, the lights are binned into
+// clusters by the SceneRenderer every frame
+
+// Represents a single light source, must match ClusterLight in SceneRenderer.h
+struct Light {
+	// xyz is the world position, w is the attenuation factor
+	vec4 PositionAttenuation;
+	// rgb is the color, a is unused
+	vec4 Color;
+};
+
+// All the lights in the scene
+layout(std430, binding = 1) readonly buffer LightBuffer {
+	Light Lights[];
+};
+
+// The offset and count of each cluster's lights in LightIndices
+layout(std430, binding = 2) readonly buffer ClusterBuffer {
+	uvec2 Clusters[];
+};
+
+// The packed lists of lights that affect each cluster
+layout(std430, binding = 3) readonly buffer LightIndexBuffer {
+	uint LightIndices[];
+};
+
+// The number of clusters along x, y and depth
+uniform ivec3 u_ClusterCount;
+// The size of a screen tile, in pixels
+uniform vec2  u_ClusterTileSize;
+// Converts log(view depth) into a depth slice
+uniform vec2  u_ClusterDepthScaleBias;
+
+// The camera's view matrix, used to find the fragment's depth slice
+uniform mat4  u_View;
+
+// Gets the offset and count of the lights in LightIndices that can reach the given point
+uvec2 GetLightCluster(vec3 worldPos) {
+	// The slices are exponential so we use log(depth)
+	float viewDepth = -(u_View * vec4(worldPos, 1.0)).z;
+	int   slice = int(clamp(floor(log(max(viewDepth, 0.0001)) * u_ClusterDepthScaleBias.x + u_ClusterDepthScaleBias.y), 0.0, float(u_ClusterCount.z - 1)));
+	ivec2 tile  = min(ivec2(gl_FragCoord.xy / u_ClusterTileSize), u_ClusterCount.xy - 1);
+	return Clusters[tile.x + tile.y * u_ClusterCount.x + slice * u_ClusterCount.x * u_ClusterCount.y];
+}
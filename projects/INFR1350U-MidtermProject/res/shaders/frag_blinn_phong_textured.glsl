@@ -1,10 +1,15 @@
-#version 410
+#version 430
 
 
 layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+// Materials in a texture array get their layer (x) and shininess (y) from the vertex shader, since
+// multi-draws can mix materials from the same array
+#ifdef TEXTURE_ARRAY
+layout(location = 4) flat in vec2 inMaterialParams;
+#endif
 
 // We output a single color to the color buffer
 layout(location = 0) out vec4 frag_color;
@@ -16,18 +21,7 @@ layout(location = 0) out vec4 frag_color;
 // Global light properties
 uniform vec3  u_AmbientCol;
 
-// Represents a single light source
-struct Light {
-	vec3  Position;
-	vec3  Color;
-	float Attenuation;
-};
-
-#define MAX_LIGHTS 20
-// Our array of all lights
-uniform Light u_Lights[MAX_LIGHTS];
-// The number of enabled lights
-uniform int u_NumLights;
+#include "clustered_lighting.glsl"
 
 ////////////////////////////////////////////////////////////////
 /////////////// Frame Level Uniforms ///////////////////////////
@@ -43,10 +37,18 @@ uniform vec3  u_CamPos;
 // Represents a collection of attributes that would define a material
 // For instance, you can think of this like material settings in 
 // Unity
+#ifdef TEXTURE_ARRAY
+struct Material {
+	sampler2DArray Diffuse;
+};
+#define MATERIAL_SHININESS inMaterialParams.y
+#else
 struct Material {
 	sampler2D Diffuse;
 	float     Shininess;
 };
+#define MATERIAL_SHININESS u_Material.Shininess
+#endif
 // Create a uniform for the material
 uniform Material u_Material;
 
@@ -56,7 +58,7 @@ uniform Material u_Material;
 // @param Light  The light to caluclate the contribution for
 vec3 CalcLightContribution(vec3 normal, Light light) {
 	// Get the direction to the light in world space
-	vec3 toLight = light.Position - inWorldPos;
+	vec3 toLight = light.PositionAttenuation.xyz - inWorldPos;
 	// Get distance between fragment and light
 	float dist = length(toLight);
 	// Normalize toLight for other calculations
@@ -67,19 +69,24 @@ vec3 CalcLightContribution(vec3 normal, Light light) {
 	// Halfway vector between light normal and direction to camera
 	vec3 halfDir     = normalize(toLight + viewDir);
 
+#ifdef NO_SPECULAR
+	// Matte materials can compile the specular term out entirely
+	vec3 specularOut = vec3(0);
+#else
 	// Calculate our specular power
-	float specPower  = pow(max(dot(normal, halfDir), 0.0), u_Material.Shininess);
+	float specPower  = pow(max(dot(normal, halfDir), 0.0), MATERIAL_SHININESS);
 	// Calculate specular color
-	vec3 specularOut = specPower * light.Color;
+	vec3 specularOut = specPower * light.Color.rgb;
+#endif
 
 	// Calculate diffuse factor
 	float diffuseFactor = max(dot(normal, toLight), 0);
 	// Calculate diffuse color
-	vec3  diffuseOut = diffuseFactor * light.Color;
+	vec3  diffuseOut = diffuseFactor * light.Color.rgb;
 
 	// We'll use a modified distance squared attenuation factor to keep it simple
 	// We add the one to prevent divide by zero errors
-	float attenuation = 1.0 / (1.0 + light.Attenuation * pow(dist, 2));
+	float attenuation = 1.0 / (1.0 + light.PositionAttenuation.w * pow(dist, 2));
 
 	return (diffuseOut + specularOut) * attenuation;
 }
@@ -92,14 +99,21 @@ void main() {
 	// Normalize our input normal
 	vec3 normal = normalize(inNormal);
 
-	// Iterate over all lights
-	for(int ix = 0; ix < u_NumLights && ix < MAX_LIGHTS; ix++) {
+	// Find the cluster that this fragment is in
+	uvec2 cluster = GetLightCluster(inWorldPos);
+
+	// Iterate over only the lights that can reach this cluster
+	for(uint ix = 0; ix < cluster.y; ix++) {
 		// Additive lighting model
-		lightAccumulation += CalcLightContribution(normal, u_Lights[ix]);
+		lightAccumulation += CalcLightContribution(normal, Lights[LightIndices[cluster.x + ix]]);
 	}
 
 	// Get the albedo from the diffuse / albedo map
+#ifdef TEXTURE_ARRAY
+	vec4 textureColor = texture(u_Material.Diffuse, vec3(inUV, inMaterialParams.x));
+#else
 	vec4 textureColor = texture(u_Material.Diffuse, inUV);
+#endif
 
 	// combine for the final result
 	vec3 result = (u_AmbientCol + lightAccumulation)  * inColor * textureColor.rgb;
@@ -0,0 +1,5 @@
+#version 410
+
+// Nothing to do here, color writes are masked off during the depth pre-pass and we only want the depth
+void main() {
+}
@@ -0,0 +1,15 @@
+#version 410
+
+// Only the position is needed to lay down depth
+layout(location = 0) in vec3 inPosition;
+
+// Must be calculated exactly the same way as in vertex_shader.glsl, since the main pass tests against
+// this depth with GL_EQUAL
+invariant gl_Position;
+
+// Complete MVP
+uniform mat4 u_ModelViewProjection;
+
+void main() {
+	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,33 @@
+#version 450
+// Gives us gl_DrawIDARB, which is core in 4.6 but we want to run on 4.5 drivers (ex: Mesa llvmpipe)
+#extension GL_ARB_shader_draw_parameters : require
+
+// Only the position is needed to lay down depth
+layout(location = 0) in vec3 inPosition;
+
+// Must be calculated exactly the same way as in vertex_shader_indirect.glsl, since the main pass tests
+// against this depth with GL_EQUAL
+invariant gl_Position;
+
+// Must match DrawData in vertex_shader_indirect.glsl
+struct DrawData {
+	mat4 Model;
+	mat4 NormalMatrix;
+	vec4 MaterialParams;
+};
+
+layout(std430, binding = 0) readonly buffer b_DrawData {
+	DrawData Draws[];
+};
+
+// The camera's view projection, shared by all draws
+uniform mat4 u_ViewProjection;
+// The index of the first draw in b_DrawData for this multi-draw
+uniform int  u_DrawOffset;
+
+void main() {
+	DrawData data = Draws[u_DrawOffset + gl_DrawIDARB];
+
+	vec3 worldPos = (data.Model * vec4(inPosition, 1.0)).xyz;
+	gl_Position = u_ViewProjection * vec4(worldPos, 1.0);
+}
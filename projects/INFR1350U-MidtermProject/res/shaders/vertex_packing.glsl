@@ -0,0 +1,17 @@
+// Decoding for the packed vertex formats (VertexPosNormTexPacked and VertexPosNormTexColPacked), must
+// match VertexPacking::DecodeNormal. UVs and colors are expanded by the vertex fetch, so only the
+// normals need any work
+
+// Octahedral encoded normal, GL has already mapped the snorm16s to [-1, 1]
+vec3 DecodeNormal(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	// Unfold the bottom half of the octahedron
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
+// Lets the same shader code handle both formats
+vec3 DecodeNormal(vec3 n) {
+	return n;
+}
@@ -2,13 +2,26 @@
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
+// Meshes using a packed vertex format are drawn with the PACKED_NORMALS keyword
+#ifdef PACKED_NORMALS
+layout(location = 2) in vec2 inNormal;
+#else
 layout(location = 2) in vec3 inNormal;
+#endif
 layout(location = 3) in vec2 inUV;
 
+#include "vertex_packing.glsl"
+
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
+#ifdef TEXTURE_ARRAY
+layout(location = 4) flat out vec2 outMaterialParams;
+#endif
+
+// The depth pre-pass (vertex_depth_only.glsl) has to produce exactly the same positions
+invariant gl_Position;
 
 // Complete MVP
 uniform mat4 u_ModelViewProjection;
@@ -16,6 +29,10 @@ uniform mat4 u_ModelViewProjection;
 uniform mat4 u_Model;
 // Normal Matrix for transforming normals
 uniform mat3 u_NormalMatrix;
+#ifdef TEXTURE_ARRAY
+// The material's texture array layer (x) and shininess (y)
+uniform vec2 u_MaterialParams;
+#endif
 
 void main() {
 
@@ -26,13 +43,21 @@ void main() {
 	outWorldPos = (u_Model * vec4(inPosition, 1.0)).xyz;
 
 	// Normals
-	outNormal = u_NormalMatrix * inNormal;
+	outNormal = u_NormalMatrix * DecodeNormal(inNormal);
 
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
+	#ifdef TEXTURE_ARRAY
+	outMaterialParams = u_MaterialParams;
+	#endif
 
 	///////////
+	// Formats without a color are drawn as if it was white, which is what the OBJ loader fills in
+	#ifdef NO_VERTEX_COLOR
+	outColor = vec3(1.0);
+	#else
 	outColor = inColor;
+	#endif
 
 }
 
@@ -0,0 +1,68 @@
+#version 450
+// Gives us gl_DrawIDARB, which is core in 4.6 but we want to run on 4.5 drivers (ex: Mesa llvmpipe)
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+// Meshes using a packed vertex format are drawn with the PACKED_NORMALS keyword
+#ifdef PACKED_NORMALS
+layout(location = 2) in vec2 inNormal;
+#else
+layout(location = 2) in vec3 inNormal;
+#endif
+layout(location = 3) in vec2 inUV;
+
+#include "vertex_packing.glsl"
+
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec3 outColor;
+layout(location = 2) out vec3 outNormal;
+layout(location = 3) out vec2 outUV;
+#ifdef TEXTURE_ARRAY
+layout(location = 4) flat out vec2 outMaterialParams;
+#endif
+
+// The depth pre-pass (vertex_depth_only_indirect.glsl) has to produce exactly the same positions
+invariant gl_Position;
+
+// The per-object data that we would normally pass as uniforms, one per draw
+struct DrawData {
+	mat4 Model;
+	// Stored as a mat4 to avoid std430 padding issues with mat3
+	mat4 NormalMatrix;
+	// The material's texture array layer (x) and shininess (y), zw are unused
+	vec4 MaterialParams;
+};
+
+layout(std430, binding = 0) readonly buffer b_DrawData {
+	DrawData Draws[];
+};
+
+// The camera's view projection, shared by all draws
+uniform mat4 u_ViewProjection;
+// The index of the first draw in b_DrawData for this multi-draw
+uniform int  u_DrawOffset;
+
+void main() {
+	DrawData data = Draws[u_DrawOffset + gl_DrawIDARB];
+
+	// Pass vertex pos in world space to frag shader
+	outWorldPos = (data.Model * vec4(inPosition, 1.0)).xyz;
+	gl_Position = u_ViewProjection * vec4(outWorldPos, 1.0);
+
+	// Normals
+	outNormal = mat3(data.NormalMatrix) * DecodeNormal(inNormal);
+
+	// Pass our UV coords to the fragment shader
+	outUV = inUV;
+	#ifdef TEXTURE_ARRAY
+	outMaterialParams = data.MaterialParams.xy;
+	#endif
+
+	// Formats without a color are drawn as if it was white, which is what the OBJ loader fills in
+	#ifdef NO_VERTEX_COLOR
+	outColor = vec3(1.0);
+	#else
+	outColor = inColor;
+	#endif
+}
@@ -0,0 +1,63 @@
+#include "Benchmark.h"
+#include <chrono>
+#include <cstring>
+#include <Logging.h>
+
+std::map<std::string, Benchmark::Entry> Benchmark::_benchmarks;
+
+void Benchmark::Register(const std::string& name, const std::string& description, RunFunc func, bool requiresContext /*= false*/) {
+	LOG_ASSERT(_benchmarks.find(name) == _benchmarks.end(), "Benchmark \"{}\" has already been registered!", name);
+	_benchmarks[name] = { description, func, requiresContext };
+}
+
+bool Benchmark::IsRequested(int argc, char** argv) {
+	return argc >= 2 && strcmp(argv[1], "--benchmark") == 0;
+}
+
+bool Benchmark::RequiresContext(int argc, char** argv) {
+	if (!IsRequested(argc, argv) || argc < 3) {
+		return false;
+	}
+	auto it = _benchmarks.find(argv[2]);
+	return it != _benchmarks.end() && it->second.RequiresContext;
+}
+
+int Benchmark::Run(int argc, char** argv) {
+	std::string name = argc >= 3 ? argv[2] : "";
+	auto it = _benchmarks.find(name);
+	if (it == _benchmarks.end()) {
+		LOG_WARN("Unknown benchmark \"{}\", available benchmarks are:", name);
+		for (auto& [key, entry] : _benchmarks) {
+			LOG_INFO("    {:<16} {}", key, entry.Description);
+		}
+		return 1;
+	}
+
+	std::vector<std::string> args;
+	for (int ix = 3; ix < argc; ix++) {
+		args.push_back(argv[ix]);
+	}
+
+	LOG_INFO("Running benchmark \"{}\"", name);
+	return it->second.Func(args);
+}
+
+double Benchmark::TimeMs(int iterations, const std::function<void()>& func) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int ix = 0; ix < iterations; ix++) {
+		func();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / (iterations > 0 ? iterations : 1);
+}
+
+int Benchmark::GetIntArg(const std::vector<std::string>& args, size_t index, int defaultValue) {
+	if (index < args.size()) {
+		try {
+			return std::stoi(args[index]);
+		} catch (...) {
+			LOG_WARN("Could not parse argument \"{}\" as an integer, using {}", args[index], defaultValue);
+		}
+	}
+	return defaultValue;
+}
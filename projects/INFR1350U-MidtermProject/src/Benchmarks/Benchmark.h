@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+/// <summary>
+/// Small registry for our benchmarks, which can be run from the command line instead of the game via
+///     INFR1350U-MidtermProject.exe --benchmark [name] [args...]
+///
+/// Benchmarks return an exit code, 0 for success. Most benchmarks run before anything else is initialized,
+/// benchmarks that need OpenGL run once the game has created it's context (in a hidden window) and
+/// registered it's resource types
+/// </summary>
+class Benchmark {
+public:
+	typedef std::function<int(const std::vector<std::string>&)> RunFunc;
+
+	Benchmark() = delete;
+
+	/// <summary>
+	/// Registers a benchmark with the given name
+	/// </summary>
+	/// <param name="name">The name used to invoke the benchmark from the command line</param>
+	/// <param name="description">A short human readable description, shown when listing benchmarks</param>
+	/// <param name="func">The function that runs the benchmark</param>
+	/// <param name="requiresContext">True if the benchmark needs an OpenGL context</param>
+	static void Register(const std::string& name, const std::string& description, RunFunc func, bool requiresContext = false);
+
+	/// <summary>
+	/// Returns true if the command line arguments are requesting a benchmark
+	/// </summary>
+	static bool IsRequested(int argc, char** argv);
+	/// <summary>
+	/// Returns true if the benchmark requested by the command line arguments needs an OpenGL context
+	/// </summary>
+	static bool RequiresContext(int argc, char** argv);
+	/// <summary>
+	/// Runs the benchmark requested by the command line arguments, or lists all the
+	/// benchmarks if the name was not found
+	/// </summary>
+	/// <returns>The exit code for the application</returns>
+	static int Run(int argc, char** argv);
+
+	/// <summary>
+	/// Runs a function a number of times, and returns the average time per iteration in milliseconds
+	/// </summary>
+	/// <param name="iterations">The number of times to invoke the function</param>
+	/// <param name="func">The function to time</param>
+	static double TimeMs(int iterations, const std::function<void()>& func);
+
+	/// <summary>
+	/// Gets an integer argument at the given index, or a default value if it was not specified
+	/// </summary>
+	static int GetIntArg(const std::vector<std::string>& args, size_t index, int defaultValue);
+
+protected:
+	struct Entry {
+		std::string Description;
+		RunFunc     Func;
+		bool        RequiresContext;
+	};
+	static std::map<std::string, Entry> _benchmarks;
+};
@@ -0,0 +1,154 @@
+#include "ClusterBenchmark.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <Logging.h>
+
+#include "Benchmarks/Benchmark.h"
+#include "Gameplay/Scene.h"
+#include "Gameplay/Components/Camera.h"
+#include "Gameplay/Components/ComponentManager.h"
+#include "Utils/LightGrid.h"
+
+using namespace Gameplay;
+
+// Checks that the camera hands out a view that is the inverse of it's object's transform, and a projection that
+// has actually been calculated, since the grid is binned in the space those define
+static bool ValidateCamera(const Camera::Sptr& camera) {
+	glm::mat4 identity = camera->GetView() * camera->GetGameObject()->GetTransform();
+	for (int col = 0; col < 4; col++) {
+		for (int row = 0; row < 4; row++) {
+			if (glm::abs(identity[col][row] - (col == row ? 1.0f : 0.0f)) > 0.001f) {
+				LOG_ERROR("Camera view is not the inverse of the camera's transform");
+				return false;
+			}
+		}
+	}
+
+	// The near and far planes should land on the edges of the depth range
+	glm::vec4 nearPoint = camera->GetProjection() * glm::vec4(0.0f, 0.0f, -camera->GetNearPlane(), 1.0f);
+	glm::vec4 farPoint  = camera->GetProjection() * glm::vec4(0.0f, 0.0f, -camera->GetFarPlane(), 1.0f);
+	if (glm::abs(nearPoint.z / nearPoint.w + 1.0f) > 0.001f || glm::abs(farPoint.z / farPoint.w - 1.0f) > 0.001f) {
+		LOG_ERROR("Camera projection does not match it's clipping planes");
+		return false;
+	}
+	return true;
+}
+
+// Checks that the grid never misses a light that reaches a point within a cluster, by sampling random points within
+// each cluster's volume, and that every light in a cluster's list at least touches the cluster's bounds
+static bool ValidateGrid(const LightGrid& grid, const glm::mat4& view, const glm::mat4& projection, const std::vector<BoundingSphere>& lights, float nearPlane, float farPlane) {
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	glm::mat4 invProjection = glm::inverse(projection);
+	glm::uvec3 dims = grid.GetDimensions();
+
+	std::vector<BoundingSphere> viewLights(lights.size());
+	for (size_t ix = 0; ix < lights.size(); ix++) {
+		viewLights[ix] = lights[ix].Transformed(view);
+	}
+
+	for (uint32_t slice = 0; slice < dims.z; slice++) {
+		for (uint32_t y = 0; y < dims.y; y++) {
+			for (uint32_t x = 0; x < dims.x; x++) {
+				uint32_t cluster = grid.GetClusterIndex(x, y, slice);
+				const LightGrid::Cluster& range = grid.GetClusters()[cluster];
+				const uint32_t* list = grid.GetLightIndices().data() + range.Offset;
+				AABB bounds = grid.GetClusterBounds(cluster);
+
+				for (uint32_t ix = 0; ix < range.Count; ix++) {
+					const BoundingSphere& sphere = viewLights[list[ix]];
+					glm::vec3 delta = glm::clamp(sphere.Center, bounds.Min, bounds.Max) - sphere.Center;
+					if (glm::dot(delta, delta) > sphere.Radius * sphere.Radius * 1.001f) {
+						LOG_ERROR("Cluster {} contains light {} which does not touch it", cluster, list[ix]);
+						return false;
+					}
+				}
+
+				// Pick random points inside the froxel, any light that reaches them must be in the list
+				for (int sample = 0; sample < 4; sample++) {
+					float ndcX = -1.0f + 2.0f * (x + unit(rng)) / dims.x;
+					float ndcY = -1.0f + 2.0f * (y + unit(rng)) / dims.y;
+					float depth = nearPlane * glm::pow(farPlane / nearPlane, (slice + 0.01f + unit(rng) * 0.98f) / dims.z);
+					glm::vec4 farPoint = invProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+					glm::vec3 dir = glm::vec3(farPoint) / farPoint.w;
+					glm::vec3 point = dir * (depth / -dir.z);
+
+					for (uint32_t light = 0; light < (uint32_t)viewLights.size(); light++) {
+						glm::vec3 offset = point - viewLights[light].Center;
+						if (glm::dot(offset, offset) <= viewLights[light].Radius * viewLights[light].Radius &&
+							std::find(list, list + range.Count, light) == list + range.Count) {
+							LOG_ERROR("Cluster {} is missing light {}", cluster, light);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int ClusterBenchmark::Run(const std::vector<std::string>& args) {
+	int lightCount = Benchmark::GetIntArg(args, 0, 1024);
+	int iterations = Benchmark::GetIntArg(args, 1, 100);
+	int threads    = Benchmark::GetIntArg(args, 2, (int)std::max(std::thread::hardware_concurrency(), 1u));
+
+	// Scatter lights around the table with a fixed seed so runs are comparable
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> range(1.0f, 8.0f);
+	std::vector<BoundingSphere> lights(lightCount);
+	for (int ix = 0; ix < lightCount; ix++) {
+		lights[ix] = BoundingSphere(glm::vec3(position(rng), position(rng), position(rng) * 0.25f), range(rng));
+	}
+
+	// The matrices come from a real camera, set up like the main camera in main.cpp, so that we bin in the same
+	// space as the renderer. We run before main registers the component types
+	ComponentManager::RegisterType<Camera>();
+	Scene scene;
+	GameObject::Sptr cameraObject = scene.CreateGameObject("Main Camera");
+	cameraObject->SetPostion(glm::vec3(0.0f, -3.0f, 13.0f));
+	cameraObject->SetRotation(glm::vec3(8.0f, 0.0f, 0.0f));
+	Camera::Sptr camera = cameraObject->Add<Camera>();
+	camera->ResizeWindow(1600, 900);
+	bool valid = ValidateCamera(camera);
+
+	// Same grid size that the renderer uses by default
+	const glm::mat4& view = camera->GetView();
+	const glm::mat4& projection = camera->GetProjection();
+	float nearPlane = camera->GetNearPlane();
+	float farPlane  = camera->GetFarPlane();
+	LightGrid grid;
+	grid.Configure(16, 9, 24, nearPlane, farPlane);
+
+	double scalarMs = Benchmark::TimeMs(iterations, [&]() {
+		grid.Build(view, projection, lights.data(), lightCount, 1, false);
+	});
+	std::vector<uint32_t> scalarIndices = grid.GetLightIndices();
+	valid &= ValidateGrid(grid, view, projection, lights, nearPlane, farPlane);
+
+	// The other paths should produce exactly the same lists as the scalar path
+	double simdMs = Benchmark::TimeMs(iterations, [&]() {
+		grid.Build(view, projection, lights.data(), lightCount, 1, true);
+	});
+	valid &= grid.GetLightIndices() == scalarIndices;
+
+	// The workers are started once up front, the same as the renderer's pool
+	ThreadPool::Sptr pool = threads > 1 ? ThreadPool::Create(threads - 1) : nullptr;
+	double threadedMs = Benchmark::TimeMs(iterations, [&]() {
+		grid.Build(view, projection, lights.data(), lightCount, threads, true, pool.get());
+	});
+	valid &= grid.GetLightIndices() == scalarIndices;
+
+	LOG_INFO("Binning {} lights into {} clusters, averaged over {} iterations", lightCount, grid.GetClusterCount(), iterations);
+	LOG_INFO("    Scalar:           {:8.4f} ms, {} light references", scalarMs, scalarIndices.size());
+	LOG_INFO("    SSE:              {:8.4f} ms ({:.2f}x)", simdMs, simdMs > 0.0 ? scalarMs / simdMs : 0.0);
+	LOG_INFO("    SSE + {:2} threads: {:8.4f} ms ({:.2f}x)", grid.GetThreadsUsed(), threadedMs, threadedMs > 0.0 ? scalarMs / threadedMs : 0.0);
+
+	if (!valid) {
+		LOG_ERROR("Light grid results do not match the brute force test!");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Times binning lights into the clustered lighting grid with the scalar, SIMD and multithreaded
+/// paths, and checks every cluster's light list against a brute force test. Does not require an
+/// OpenGL context
+///
+/// Arguments: [light count = 1024] [iterations = 100] [threads = hardware threads]
+/// </summary>
+class ClusterBenchmark {
+public:
+	ClusterBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
@@ -0,0 +1,83 @@
+#include "CullingBenchmark.h"
+#include <random>
+#include <Logging.h>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Benchmarks/Benchmark.h"
+#include "Utils/BoundingVolumes.h"
+#include "Utils/Bvh.h"
+
+int CullingBenchmark::Run(const std::vector<std::string>& args) {
+	int objectCount = Benchmark::GetIntArg(args, 0, 10000);
+	int iterations  = Benchmark::GetIntArg(args, 1, 200);
+
+	// Scatter a bunch of objects around a 400 unit cube, with a fixed seed so runs are comparable
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+	std::uniform_real_distribution<float> size(0.25f, 4.0f);
+
+	MeshBounds unitCube;
+	unitCube.Box = AABB(glm::vec3(-0.5f), glm::vec3(0.5f));
+	unitCube.Sphere = BoundingSphere(glm::vec3(0.0f), glm::length(glm::vec3(0.5f)));
+
+	std::vector<BoundingSphere> spheres(objectCount);
+	std::vector<AABB> boxes(objectCount);
+	for (int ix = 0; ix < objectCount; ix++) {
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng)));
+		transform = glm::scale(transform, glm::vec3(size(rng), size(rng), size(rng)));
+		MeshBounds world = unitCube.Transformed(transform);
+		spheres[ix] = world.Sphere;
+		boxes[ix] = world.Box;
+	}
+
+	// A camera sitting at the edge of the volume looking in, similar to our game camera
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, -250.0f, 100.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	Frustum frustum = Frustum::FromViewProjection(projection * view);
+
+	std::vector<uint8_t> results(objectCount);
+	std::vector<uint32_t> bvhResults;
+	bvhResults.reserve(objectCount);
+
+	size_t scalarVisible = 0, simdVisible = 0, boxVisible = 0;
+	double scalarMs = Benchmark::TimeMs(iterations, [&]() {
+		scalarVisible = frustum.CullSpheresScalar(spheres.data(), spheres.size(), results.data());
+	});
+	double simdMs = Benchmark::TimeMs(iterations, [&]() {
+		simdVisible = frustum.CullSpheres(spheres.data(), spheres.size(), results.data());
+	});
+	double boxMs = Benchmark::TimeMs(iterations, [&]() {
+		boxVisible = 0;
+		for (const AABB& box : boxes) {
+			boxVisible += frustum.Intersects(box) ? 1 : 0;
+		}
+	});
+
+	Bvh bvh;
+	double buildMs = Benchmark::TimeMs(iterations, [&]() {
+		bvh.Build(boxes);
+	});
+	double refitMs = Benchmark::TimeMs(iterations, [&]() {
+		bvh.Refit(boxes);
+	});
+	double queryMs = Benchmark::TimeMs(iterations, [&]() {
+		bvhResults.clear();
+		bvh.Query(frustum, bvhResults);
+	});
+
+	LOG_INFO("Culling {} objects, averaged over {} iterations", objectCount, iterations);
+	LOG_INFO("    Sphere (scalar): {:8.4f} ms, {} visible", scalarMs, scalarVisible);
+	LOG_INFO("    Sphere (SSE):    {:8.4f} ms, {} visible ({:.2f}x)", simdMs, simdVisible, simdMs > 0.0 ? scalarMs / simdMs : 0.0);
+	LOG_INFO("    AABB (scalar):   {:8.4f} ms, {} visible", boxMs, boxVisible);
+	LOG_INFO("    BVH build:       {:8.4f} ms, {} nodes", buildMs, bvh.GetNodeCount());
+	LOG_INFO("    BVH refit:       {:8.4f} ms", refitMs);
+	LOG_INFO("    BVH query:       {:8.4f} ms, {} visible", queryMs, bvhResults.size());
+	LOG_INFO("    BVH refit+query: {:8.4f} ms", refitMs + queryMs);
+
+	// The BVH tests boxes, so it should agree with the brute force box test
+	if (scalarVisible != simdVisible || boxVisible != bvhResults.size()) {
+		LOG_ERROR("Culling results do not match between methods!");
+		return 1;
+	}
+	return 0;
+}
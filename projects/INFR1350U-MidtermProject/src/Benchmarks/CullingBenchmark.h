@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Compares the different frustum culling approaches on a randomly generated scene,
+/// does not require an OpenGL context
+///
+/// Arguments: [object count = 10000] [iterations = 200]
+/// </summary>
+class CullingBenchmark {
+public:
+	CullingBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
@@ -0,0 +1,159 @@
+#include "ManifestLoadBenchmark.h"
+#include <algorithm>
+#include <filesystem>
+#include <GLM/glm.hpp>
+#include <Logging.h>
+
+#include "Benchmarks/Benchmark.h"
+#include "Gameplay/Material.h"
+#include "Gameplay/MeshResource.h"
+#include "Graphics/MeshBinaryCache.h"
+#include "Graphics/Shader.h"
+#include "Graphics/Texture2D.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/ThreadPool.h"
+
+using namespace Gameplay;
+
+// The assets from the scene, a material is made for each texture
+static const char* SceneMeshes[] = {
+	"gObj_table/table.obj", "gObj_table/table_plane.obj", "gObj_puck/puck.obj", "gObj_paddle/paddle.obj",
+	"gObj_edge/edge_uni.obj", "gObj_edge/edgeS1.obj", "gObj_edge/edgeS2.obj", "gObj_edge/edgeS3.obj",
+	"gObj_edge/edgeS4.obj", "gObj_edge/bagua.obj"
+};
+static const char* SceneTextures[] = {
+	"textures/monkey-uvMap.png", "gObj_table/tex_table.png", "gObj_table/blankTexture.jpg", "gObj_puck/GoldenDark2.jpg",
+	"gObj_paddle/Red.jpg", "gObj_paddle/Blue.jpg", "gObj_edge/tex_edge.png"
+};
+
+// The GUIDs of what we put in the manifest, so we can check that it all came back
+struct ManifestContents {
+	std::vector<Guid> Meshes;
+	std::vector<Guid> Textures;
+	std::vector<Guid> Shaders;
+	std::vector<Guid> Materials;
+};
+
+// Creates the scene's assets and saves them to a manifest
+static ManifestContents CreateManifest(const std::string& path) {
+	ManifestContents result;
+
+	Shader::Sptr shader = ResourceManager::CreateAsset<Shader>(std::unordered_map<ShaderPartType, std::string>{
+		{ ShaderPartType::Vertex, "shaders/vertex_shader.glsl" },
+		{ ShaderPartType::Fragment, "shaders/frag_blinn_phong_textured.glsl" }
+	});
+	result.Shaders.push_back(shader->GetGUID());
+
+	for (const char* mesh : SceneMeshes) {
+		result.Meshes.push_back(ResourceManager::CreateAsset<MeshResource>(mesh)->GetGUID());
+	}
+	// The rails and table are packed in the scene, so make sure we cover those too
+	result.Meshes.push_back(ResourceManager::CreateAsset<MeshResource>("gObj_table/table.obj", MeshVertexFormat::Packed)->GetGUID());
+	result.Meshes.push_back(ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj", MeshVertexFormat::Packed)->GetGUID());
+
+	for (const char* texture : SceneTextures) {
+		Texture2D::Sptr tex = ResourceManager::CreateAsset<Texture2D>(texture);
+		result.Textures.push_back(tex->GetGUID());
+
+		Material::Sptr material = ResourceManager::CreateAsset<Material>();
+		material->Name = texture;
+		material->MatShader = shader;
+		material->Texture = tex;
+		material->Shininess = 32.0f;
+		result.Materials.push_back(material->GetGUID());
+	}
+
+	ResourceManager::SaveManifest(path);
+	return result;
+}
+
+// Makes sure everything in the manifest was loaded, and that the materials point at the loaded shader and textures
+static bool CheckContents(const ManifestContents& contents) {
+	bool valid = true;
+	for (const Guid& guid : contents.Meshes) {
+		MeshResource::Sptr mesh = ResourceManager::Get<MeshResource>(guid);
+		valid = valid && mesh != nullptr && mesh->Mesh != nullptr;
+	}
+	for (const Guid& guid : contents.Textures) {
+		valid = valid && ResourceManager::Get<Texture2D>(guid) != nullptr;
+	}
+	for (const Guid& guid : contents.Shaders) {
+		valid = valid && ResourceManager::Get<Shader>(guid) != nullptr;
+	}
+	for (const Guid& guid : contents.Materials) {
+		Material::Sptr material = ResourceManager::Get<Material>(guid);
+		valid = valid && material != nullptr &&
+			material->MatShader != nullptr && material->MatShader == ResourceManager::Get<Shader>(material->MatShader->GetGUID()) &&
+			material->Texture != nullptr && material->Texture == ResourceManager::Get<Texture2D>(material->Texture->GetGUID());
+	}
+	return valid;
+}
+
+// Loads the manifest a number of times, returning the average of the stats
+static ResourceManager::ManifestStats TimeLoad(const std::string& path, int workerThreads, int iterations, const ManifestContents& contents, bool& valid) {
+	ResourceManager::ManifestStats result;
+	for (int ix = 0; ix < iterations; ix++) {
+		ResourceManager::Cleanup();
+		// Make sure the driver has actually finished the last load before we start timing the next one
+		glFinish();
+
+		ResourceManager::ManifestStats stats = ResourceManager::LoadManifest(path, workerThreads);
+		glFinish();
+		valid = CheckContents(contents) && valid;
+
+		result.Resources = stats.Resources;
+		result.WorkerThreads = stats.WorkerThreads;
+		result.TotalMs += stats.TotalMs / iterations;
+		result.DecodeMs += stats.DecodeMs / iterations;
+		result.UploadMs += stats.UploadMs / iterations;
+		result.WaitMs += stats.WaitMs / iterations;
+	}
+	return result;
+}
+
+static void ReportLoad(const char* label, const ResourceManager::ManifestStats& stats, float serialMs) {
+	LOG_INFO("    {:<10} {:8.2f} ms ({:5.2f}x)  decode {:8.2f} ms  upload {:8.2f} ms  wait {:8.2f} ms",
+		label, stats.TotalMs, stats.TotalMs > 0.0f ? serialMs / stats.TotalMs : 0.0f, stats.DecodeMs, stats.UploadMs, stats.WaitMs);
+}
+
+int ManifestLoadBenchmark::Run(const std::vector<std::string>& args) {
+	int iterations    = std::max(Benchmark::GetIntArg(args, 0, 5), 1);
+	int workerThreads = std::max(Benchmark::GetIntArg(args, 1, (int)ThreadPool::GetDefaultThreadCount()), 1);
+
+	if (!std::filesystem::exists("shaders")) {
+		LOG_ERROR("The manifest benchmark needs the project's assets, run it from the res folder");
+		return 1;
+	}
+
+	std::string path = (std::filesystem::temp_directory_path() / "manifest-benchmark.json").string();
+	ManifestContents contents = CreateManifest(path);
+	size_t resourceCount = contents.Meshes.size() + contents.Textures.size() + contents.Shaders.size() + contents.Materials.size();
+	LOG_INFO("Loading {} resources, {} iterations, {} worker threads", resourceCount, iterations, workerThreads);
+
+	// The first load writes any missing mesh sidecars and warms up the file cache, so it's not counted
+	ResourceManager::Cleanup();
+	ResourceManager::LoadManifest(path, 0);
+
+	bool valid = true;
+	bool meshCache = MeshBinaryCache::IsEnabled();
+	for (bool cacheEnabled : { true, false }) {
+		MeshBinaryCache::SetEnabled(cacheEnabled);
+		ResourceManager::ManifestStats serial   = TimeLoad(path, 0, iterations, contents, valid);
+		ResourceManager::ManifestStats parallel = TimeLoad(path, workerThreads, iterations, contents, valid);
+		valid = valid && serial.Resources == resourceCount && parallel.Resources == resourceCount;
+
+		LOG_INFO("Mesh cache {}:", cacheEnabled ? "enabled" : "disabled");
+		ReportLoad("serial", serial, serial.TotalMs);
+		ReportLoad("parallel", parallel, serial.TotalMs);
+	}
+	MeshBinaryCache::SetEnabled(meshCache);
+
+	ResourceManager::Cleanup();
+	std::error_code error;
+	std::filesystem::remove(path, error);
+
+	if (!valid) {
+		LOG_ERROR("Not every resource was loaded, or a material lost it's shader or texture");
+	}
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Compares loading a manifest entirely on the main thread against decoding it on worker threads, with
+/// only the OpenGL uploads left on the main thread. The manifest is built from the project's shaders,
+/// textures, meshes and materials (written to the temp directory and deleted afterwards), and each mode is
+/// timed with the mesh cache enabled and disabled. Checks that every resource was created, and that the
+/// materials were given their shader and texture. Requires an OpenGL context, must be run from the res folder
+///
+/// Arguments: [iterations = 5] [worker threads = hardware threads - 1]
+/// </summary>
+class ManifestLoadBenchmark {
+public:
+	ManifestLoadBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
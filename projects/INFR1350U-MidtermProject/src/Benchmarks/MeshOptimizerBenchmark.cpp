@@ -0,0 +1,199 @@
+#include "MeshOptimizerBenchmark.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <Logging.h>
+
+#include "Benchmarks/Benchmark.h"
+#include "Utils/MeshFactory.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/ObjLoader.h"
+
+typedef std::array<uint64_t, 3> TriangleKey;
+
+// Hashes the raw bytes of a vertex, so we can compare triangles after the vertices have been renumbered
+static uint64_t HashVertex(const VertexPosNormTexCol& vertex) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&vertex);
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t ix = 0; ix < sizeof(VertexPosNormTexCol); ix++) {
+		hash = (hash ^ bytes[ix]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// Gets a sorted list of every triangle in the mesh. Each triangle is rotated so that it starts with it's smallest
+// vertex, which keeps the winding order intact, so a flipped triangle will not match
+static std::vector<TriangleKey> GetTriangles(const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& indices) {
+	std::vector<TriangleKey> result;
+	result.reserve(indices.size() / 3);
+	for (size_t ix = 0; ix + 2 < indices.size(); ix += 3) {
+		TriangleKey key = { HashVertex(vertices[indices[ix]]), HashVertex(vertices[indices[ix + 1]]), HashVertex(vertices[indices[ix + 2]]) };
+		std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+		result.push_back(key);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// Optimizes a copy of the mesh, logs the results, and returns false if the triangles didn't survive
+static bool OptimizeAndReport(const std::string& name, const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& indices, uint32_t cacheSize) {
+	std::vector<VertexPosNormTexCol> optimizedVertices = vertices;
+	std::vector<uint32_t> optimizedIndices = indices;
+
+	MeshOptimizer::Options options;
+	options.CacheSize = cacheSize;
+	MeshOptimizer::Stats stats = MeshOptimizer::Optimize(optimizedVertices, optimizedIndices, options);
+
+	// Tipsify on it's own, to see how much ACMR the overdraw clusters cost us
+	std::vector<uint32_t> tipsifyIndices = indices;
+	MeshOptimizer::OptimizeVertexCache(tipsifyIndices, vertices.size(), cacheSize);
+
+	LOG_INFO("    {:<36} {:7} tris  ACMR {:5.3f} -> {:5.3f} (Tipsify only {:5.3f}, FIFO 32 {:5.3f})  ATVR {:5.3f} -> {:5.3f}  {:5} clusters  {:8.2f} ms",
+		name, indices.size() / 3, stats.AcmrBefore, stats.AcmrAfter, MeshOptimizer::CalculateAcmr(tipsifyIndices, vertices.size(), cacheSize),
+		MeshOptimizer::CalculateAcmr(optimizedIndices, optimizedVertices.size(), 32), stats.AtvrBefore, stats.AtvrAfter, stats.Clusters, stats.Milliseconds);
+
+	if (optimizedIndices.size() != indices.size() || GetTriangles(optimizedVertices, optimizedIndices) != GetTriangles(vertices, indices)) {
+		LOG_ERROR("Optimizing \"{}\" changed it's triangles", name);
+		return false;
+	}
+	// The vertex fetch stage should leave the indices in first use order
+	uint32_t nextVertex = 0;
+	for (uint32_t index : optimizedIndices) {
+		if (index > nextVertex) {
+			LOG_ERROR("Optimizing \"{}\" did not put the vertices in the order they are used", name);
+			return false;
+		}
+		nextVertex = std::max(nextVertex, index + 1);
+	}
+	return true;
+}
+
+// Checks the FIFO cache simulation against a few cases that are easy to work out by hand
+static bool CheckFifoSimulation() {
+	bool valid = true;
+	auto expect = [&](const char* name, float actual, float expected) {
+		if (std::abs(actual - expected) > 0.0001f) {
+			LOG_ERROR("FIFO check \"{}\" failed, expected {} but got {}", name, expected, actual);
+			valid = false;
+		}
+	};
+
+	// Every vertex of a lone triangle has to be transformed
+	expect("single triangle", MeshOptimizer::CalculateAcmr({ 0, 1, 2 }, 3, 16), 3.0f);
+	// A quad shares 2 of it's vertices between it's triangles
+	expect("quad", MeshOptimizer::CalculateAcmr({ 0, 1, 2, 2, 1, 3 }, 4, 16), 2.0f);
+	// A FIFO cache doesn't refresh vertices on a hit, with room for 3 vertices, 0 is pushed out by 3 even though it was just used
+	expect("FIFO eviction", MeshOptimizer::CalculateAcmr({ 0, 1, 2, 0, 2, 3, 3, 2, 0 }, 4, 3), 5.0f / 3.0f);
+	// With room for 4 it stays in the cache
+	expect("FIFO hit", MeshOptimizer::CalculateAcmr({ 0, 1, 2, 0, 2, 3, 3, 2, 0 }, 4, 4), 4.0f / 3.0f);
+	expect("ATVR", MeshOptimizer::CalculateAtvr({ 0, 1, 2, 0, 2, 3, 3, 2, 0 }, 4, 4), 1.0f);
+	return valid;
+}
+
+// Creates a gridSize x gridSize height field, with the triangles in row order
+static void CreateGrid(int gridSize, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices) {
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> height(-0.5f, 0.5f);
+	for (int y = 0; y < gridSize; y++) {
+		for (int x = 0; x < gridSize; x++) {
+			vertices.emplace_back(glm::vec3((float)x, (float)y, height(rng)), glm::vec3(0.0f, 0.0f, 1.0f),
+				glm::vec2((float)x / (gridSize - 1), (float)y / (gridSize - 1)), glm::vec4(1.0f));
+		}
+	}
+	for (int y = 0; y < gridSize - 1; y++) {
+		for (int x = 0; x < gridSize - 1; x++) {
+			uint32_t a = y * gridSize + x;
+			uint32_t b = a + 1;
+			uint32_t c = a + gridSize;
+			uint32_t d = c + 1;
+			indices.insert(indices.end(), { a, b, d, a, d, c });
+		}
+	}
+}
+
+// Gets the vertices and indices the MeshBuilder would bake for a generated shape
+static void CreateGenerated(MeshBuilder<VertexPosNormTexCol>& builder, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices) {
+	vertices.assign(builder.GetVertexDataPtr(), builder.GetVertexDataPtr() + builder.GetVertexCount());
+	indices.assign(builder.GetIndexDataPtr(), builder.GetIndexDataPtr() + builder.GetIndexCount());
+	if (indices.empty()) {
+		MeshOptimizer::GenerateIndices(vertices, indices);
+	}
+}
+
+// Optimizes every OBJ under the working directory (our res folder)
+static bool ReportAssets(uint32_t cacheSize) {
+	if (!std::filesystem::exists("shaders")) {
+		LOG_WARN("Not running from the res folder, skipping the project's OBJ files");
+		return true;
+	}
+
+	bool valid = true;
+	LOG_INFO("Project OBJ files:");
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(".")) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".obj") {
+			continue;
+		}
+		std::string path = entry.path().generic_string();
+
+		std::vector<VertexPosNormTexCol> vertices;
+		std::vector<uint32_t> indices;
+		ObjLoader::LoadVertices(path, vertices, indices);
+		valid = OptimizeAndReport(path, vertices, indices, cacheSize) && valid;
+	}
+	return valid;
+}
+
+int MeshOptimizerBenchmark::Run(const std::vector<std::string>& args) {
+	int gridSize       = std::max(Benchmark::GetIntArg(args, 0, 256), 2);
+	uint32_t cacheSize = (uint32_t)std::max(Benchmark::GetIntArg(args, 1, 16), 3);
+
+	bool valid = CheckFifoSimulation();
+
+	std::vector<VertexPosNormTexCol> vertices;
+	std::vector<uint32_t> indices;
+
+	LOG_INFO("Optimizing meshes for a {} vertex FIFO cache", cacheSize);
+	CreateGrid(gridSize, vertices, indices);
+	valid = OptimizeAndReport(fmt::format("Grid {}x{}", gridSize, gridSize), vertices, indices, cacheSize) && valid;
+
+	// Shuffling the triangles is about as bad as an exporter can do
+	std::vector<uint32_t> shuffled(indices.size() / 3);
+	for (uint32_t ix = 0; ix < shuffled.size(); ix++) {
+		shuffled[ix] = ix;
+	}
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(5678));
+	std::vector<uint32_t> shuffledIndices;
+	shuffledIndices.reserve(indices.size());
+	for (uint32_t triangle : shuffled) {
+		shuffledIndices.insert(shuffledIndices.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+	}
+	valid = OptimizeAndReport(fmt::format("Grid {}x{} (shuffled)", gridSize, gridSize), vertices, shuffledIndices, cacheSize) && valid;
+
+	// Generated shapes, indexed the same way that MeshBuilder::Bake does it
+	{
+		MeshBuilder<VertexPosNormTexCol> builder;
+		MeshFactory::AddUvSphere(builder, glm::vec3(0.0f), 1.0f, 4);
+		vertices.clear(); indices.clear();
+		CreateGenerated(builder, vertices, indices);
+		valid = OptimizeAndReport("MeshFactory UV sphere (4)", vertices, indices, cacheSize) && valid;
+	}
+	{
+		MeshBuilder<VertexPosNormTexCol> builder;
+		MeshFactory::AddIcoSphere(builder, glm::vec3(0.0f), 1.0f, 4);
+		vertices.clear(); indices.clear();
+		CreateGenerated(builder, vertices, indices);
+		valid = OptimizeAndReport("MeshFactory ico sphere (4)", vertices, indices, cacheSize) && valid;
+	}
+	{
+		MeshBuilder<VertexPosNormTexCol> builder;
+		MeshFactory::AddCube(builder, glm::vec3(0.0f), glm::vec3(1.0f));
+		vertices.clear(); indices.clear();
+		CreateGenerated(builder, vertices, indices);
+		valid = OptimizeAndReport("MeshFactory cube", vertices, indices, cacheSize) && valid;
+	}
+
+	valid = ReportAssets(cacheSize) && valid;
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Runs the MeshOptimizer over a few meshes and reports the ACMR (vertex shader invocations per triangle)
+/// before and after, using a simulated FIFO post-transform cache. Does not require an OpenGL context
+///
+/// The meshes are a height field grid (once in row order, and once with it's triangles shuffled), the
+/// shapes from the MeshFactory, and every OBJ file in the project when run from the res folder. Checks
+/// that the optimized meshes still contain exactly the same triangles, and that the FIFO simulation
+/// gives the expected results for a few hand made cases
+///
+/// Arguments: [grid size = 256] [cache size = 16]
+/// </summary>
+class MeshOptimizerBenchmark {
+public:
+	MeshOptimizerBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
@@ -0,0 +1,195 @@
+#include "ObjLoaderBenchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <Logging.h>
+
+#include "Benchmarks/Benchmark.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+
+// Roughly how many bytes of OBJ text each grid cell takes up (a position, UV, normal, and two faces)
+static const size_t BYTES_PER_CELL = 210;
+
+// Writes a gridSize x gridSize height field in the same layout that Blender exports. Rows alternate between
+// triangles with positive face indices and quads with negative indices, so every path gets exercised
+static bool WriteGridObj(const std::string& path, int gridSize) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> height(-0.5f, 0.5f);
+
+	file << "# Synthetic height field for the OBJ loader benchmark\n";
+	file << "mtllib grid.mtl\n";
+	file << "o Grid\n";
+
+	char line[128];
+	int vertexCount = gridSize * gridSize;
+	for (int y = 0; y < gridSize; y++) {
+		for (int x = 0; x < gridSize; x++) {
+			int length = snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", (float)x - gridSize * 0.5f, (float)y - gridSize * 0.5f, height(rng));
+			file.write(line, length);
+		}
+	}
+	for (int y = 0; y < gridSize; y++) {
+		for (int x = 0; x < gridSize; x++) {
+			int length = snprintf(line, sizeof(line), "vt %.6f %.6f\n", (float)x / (gridSize - 1), (float)y / (gridSize - 1));
+			file.write(line, length);
+		}
+	}
+	for (int ix = 0; ix < vertexCount; ix++) {
+		glm::vec3 normal = glm::normalize(glm::vec3(height(rng), height(rng), 1.0f));
+		int length = snprintf(line, sizeof(line), "vn %.4f %.4f %.4f\n", normal.x, normal.y, normal.z);
+		file.write(line, length);
+	}
+
+	file << "usemtl Grid\n";
+	file << "s off\n";
+	for (int y = 0; y < gridSize - 1; y++) {
+		// Every other row uses quads, with indices relative to the end of the attribute lists. The quads
+		// are wound so that they triangulate into exactly the same triangles as the other rows
+		bool isQuadRow = y % 2 == 1;
+		int offset = isQuadRow ? -(vertexCount + 1) : 0;
+		for (int x = 0; x < gridSize - 1; x++) {
+			int a = y * gridSize + x + 1 + offset;
+			int b = a + 1;
+			int c = a + gridSize;
+			int d = c + 1;
+			if (isQuadRow) {
+				int length = snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d, c, c, c);
+				file.write(line, length);
+			} else {
+				int length = snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d);
+				file.write(line, length);
+				length = snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, c, c, c);
+				file.write(line, length);
+			}
+		}
+	}
+	return (bool)file;
+}
+
+// Checks that two loaders produced exactly the same mesh
+static bool MeshesMatch(const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& indices,
+	const std::vector<VertexPosNormTexCol>& expectedVertices, const std::vector<uint32_t>& expectedIndices)
+{
+	return vertices.size() == expectedVertices.size() && indices.size() == expectedIndices.size() &&
+		(vertices.empty() || memcmp(vertices.data(), expectedVertices.data(), vertices.size() * sizeof(VertexPosNormTexCol)) == 0) &&
+		(indices.empty() || memcmp(indices.data(), expectedIndices.data(), indices.size() * sizeof(uint32_t)) == 0);
+}
+
+// Loads every OBJ under the working directory (our res folder), and reports how much smaller the indexed meshes
+// are on the GPU than if every face corner had it's own vertex, like the loader used to do
+static bool ReportAssets() {
+	if (!std::filesystem::exists("shaders")) {
+		LOG_WARN("Not running from the res folder, skipping the project's OBJ files");
+		return true;
+	}
+
+	bool valid = true;
+	size_t totalCorners = 0, totalVertices = 0, totalSoupBytes = 0, totalIndexedBytes = 0;
+	LOG_INFO("Project OBJ files (vertex buffer + index buffer sizes):");
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(".")) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".obj") {
+			continue;
+		}
+		std::string path = entry.path().generic_string();
+
+		std::vector<VertexPosNormTexCol> expectedVertices, vertices;
+		std::vector<uint32_t> expectedIndices, indices;
+		ObjLoader::LoadVertices(path, expectedVertices, expectedIndices);
+		OptimizedObjLoader::LoadVertices(path, vertices, indices);
+		if (!MeshesMatch(vertices, indices, expectedVertices, expectedIndices)) {
+			LOG_ERROR("Loaders do not agree on \"{}\"", path);
+			valid = false;
+		}
+
+		IndexType indexType = GetSmallestIndexType(vertices.size());
+		size_t soupBytes = indices.size() * sizeof(VertexPosNormTexCol);
+		size_t indexedBytes = vertices.size() * sizeof(VertexPosNormTexCol) + indices.size() * GetIndexTypeSize(indexType);
+		LOG_INFO("    {:<32} {:7} -> {:7} vertices ({:<6}), {:9} -> {:9} bytes ({:5.1f}% smaller)", path, indices.size(), vertices.size(), ~indexType,
+			soupBytes, indexedBytes, soupBytes > 0 ? 100.0 * (1.0 - (double)indexedBytes / soupBytes) : 0.0);
+
+		totalCorners += indices.size();
+		totalVertices += vertices.size();
+		totalSoupBytes += soupBytes;
+		totalIndexedBytes += indexedBytes;
+	}
+	LOG_INFO("    {:<32} {:7} -> {:7} vertices,          {:9} -> {:9} bytes ({:5.1f}% smaller)", "Total", totalCorners, totalVertices,
+		totalSoupBytes, totalIndexedBytes, totalSoupBytes > 0 ? 100.0 * (1.0 - (double)totalIndexedBytes / totalSoupBytes) : 0.0);
+	return valid;
+}
+
+int ObjLoaderBenchmark::Run(const std::vector<std::string>& args) {
+	int sizeMb     = Benchmark::GetIntArg(args, 0, 64);
+	int iterations = Benchmark::GetIntArg(args, 1, 3);
+
+	int gridSize = std::max((int)std::sqrt((double)sizeMb * 1024.0 * 1024.0 / BYTES_PER_CELL), 2);
+	std::string path = (std::filesystem::temp_directory_path() / "obj_loader_benchmark.obj").string();
+	if (!WriteGridObj(path, gridSize)) {
+		LOG_ERROR("Failed to write the benchmark OBJ to \"{}\"", path);
+		return 1;
+	}
+	double fileMb = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+	std::vector<VertexPosNormTexCol> expected;
+	std::vector<uint32_t> expectedIndices;
+	double streamMs = Benchmark::TimeMs(iterations, [&]() {
+		expected.clear();
+		expectedIndices.clear();
+		ObjLoader::LoadVertices(path, expected, expectedIndices);
+	});
+
+	std::vector<VertexPosNormTexCol> actual;
+	std::vector<uint32_t> actualIndices;
+	double optimizedMs = Benchmark::TimeMs(iterations, [&]() {
+		actual.clear();
+		actualIndices.clear();
+		OptimizedObjLoader::LoadVertices(path, actual, actualIndices);
+	});
+
+	// The parse on it's own, with the file already mapped and paged in
+	MemoryMappedFile mapped;
+	mapped.Open(path);
+	std::vector<VertexPosNormTexCol> parsed;
+	std::vector<uint32_t> parsedIndices;
+	double parseMs = Benchmark::TimeMs(iterations, [&]() {
+		parsed.clear();
+		parsedIndices.clear();
+		OptimizedObjLoader::Parse(mapped.GetData(), mapped.GetSize(), parsed, parsedIndices);
+	});
+	mapped.Close();
+
+	std::filesystem::remove(path);
+
+	auto throughput = [&](double ms) { return ms > 0.0 ? fileMb / (ms / 1000.0) : 0.0; };
+	LOG_INFO("Loading a {:.1f} MB OBJ ({}x{} grid), averaged over {} iterations", fileMb, gridSize, gridSize, iterations);
+	LOG_INFO("    ObjLoader:           {:10.2f} ms, {:8.2f} MB/s, {} vertices, {} indices", streamMs, throughput(streamMs), expected.size(), expectedIndices.size());
+	LOG_INFO("    OptimizedObjLoader:  {:10.2f} ms, {:8.2f} MB/s, {} vertices, {} indices ({:.2f}x)", optimizedMs, throughput(optimizedMs), actual.size(), actualIndices.size(),
+		optimizedMs > 0.0 ? streamMs / optimizedMs : 0.0);
+	LOG_INFO("    Parse (in memory):   {:10.2f} ms, {:8.2f} MB/s", parseMs, throughput(parseMs));
+
+	bool valid = true;
+	// Each grid point has a single position/uv/normal combination, so it should only become one vertex
+	size_t expectedVertexCount = (size_t)gridSize * gridSize;
+	size_t expectedIndexCount = (size_t)(gridSize - 1) * (gridSize - 1) * 6;
+	if (expected.size() != expectedVertexCount || expectedIndices.size() != expectedIndexCount) {
+		LOG_ERROR("Expected {} vertices and {} indices from the ObjLoader, but got {} and {}", expectedVertexCount, expectedIndexCount, expected.size(), expectedIndices.size());
+		valid = false;
+	}
+	if (!MeshesMatch(actual, actualIndices, expected, expectedIndices) || !MeshesMatch(parsed, parsedIndices, expected, expectedIndices)) {
+		LOG_ERROR("OptimizedObjLoader's output does not match the ObjLoader's");
+		valid = false;
+	}
+
+	valid = ReportAssets() && valid;
+	return valid ? 0 : 1;
+}
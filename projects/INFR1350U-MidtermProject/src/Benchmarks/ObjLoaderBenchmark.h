@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Compares the throughput of the ObjLoader and the OptimizedObjLoader on a large synthetic OBJ file
+/// (a triangulated height field, written to the temp directory and deleted afterwards). Checks that both
+/// loaders produce exactly the same vertices and indices. Does not require an OpenGL context, mesh creation
+/// is not included in the timings
+///
+/// When run from the res folder, also loads every OBJ file in the project and reports how much GPU memory
+/// the indexed meshes save compared to one vertex per face corner
+///
+/// Arguments: [file size in MB = 64] [iterations = 3]
+/// </summary>
+class ObjLoaderBenchmark {
+public:
+	ObjLoaderBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
@@ -0,0 +1,137 @@
+#include "PhysicsDebugBenchmark.h"
+#include <algorithm>
+#include <memory>
+#include <Logging.h>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <btBulletCollisionCommon.h>
+
+#include "Benchmarks/Benchmark.h"
+#include "Gameplay/Physics/PhysicsDebugCache.h"
+#include "Gameplay/TableRails.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/GlmBulletConversions.h"
+
+// Stands in for BulletDebugDraw, writing each line into a vertex list like the DebugDrawer does
+class VertexListDebugDraw : public btIDebugDraw {
+public:
+	std::vector<VertexPosCol> Vertices;
+	int Mode = DBG_DrawWireframe;
+
+	virtual void drawLine(const btVector3& from, const btVector3& to, const btVector3& color) override {
+		Vertices.push_back({ ToGlm(from), glm::vec4(ToGlm(color), 1.0f) });
+		Vertices.push_back({ ToGlm(to), glm::vec4(ToGlm(color), 1.0f) });
+	}
+	virtual void drawContactPoint(const btVector3&, const btVector3&, btScalar, int, const btVector3&) override { }
+	virtual void reportErrorWarning(const char* warningString) override { LOG_WARN(warningString); }
+	virtual void draw3dText(const btVector3&, const char*) override { }
+	virtual void setDebugMode(int debugMode) override { Mode = debugMode; }
+	virtual int getDebugMode() const override { return Mode; }
+};
+
+// Builds a rounded rail along the X axis out of roughly the given number of triangles, similar to the rail meshes
+static btTriangleMesh* CreateRailMesh(int triangles) {
+	const int sides = 16;
+	int rings = std::max(triangles / (sides * 2), 1);
+	btTriangleMesh* mesh = new btTriangleMesh();
+	auto point = [&](int ring, int side) {
+		float angle = glm::two_pi<float>() * side / sides;
+		return btVector3(-1.0f + 2.0f * ring / rings, glm::cos(angle) * 0.5f, glm::sin(angle) * 0.5f);
+	};
+	for (int ring = 0; ring < rings; ring++) {
+		for (int side = 0; side < sides; side++) {
+			mesh->addTriangle(point(ring, side), point(ring + 1, side), point(ring + 1, side + 1));
+			mesh->addTriangle(point(ring, side), point(ring + 1, side + 1), point(ring, side + 1));
+		}
+	}
+	return mesh;
+}
+
+int PhysicsDebugBenchmark::Run(const std::vector<std::string>& args) {
+	int triangles  = Benchmark::GetIntArg(args, 0, 2048);
+	int iterations = Benchmark::GetIntArg(args, 1, 200);
+
+	btDefaultCollisionConfiguration config;
+	btCollisionDispatcher dispatcher(&config);
+	btDbvtBroadphase broadphase;
+	btCollisionWorld world(&dispatcher, &broadphase, &config);
+	VertexListDebugDraw drawer;
+	world.setDebugDrawer(&drawer);
+
+	// Set up the rails the same way TriggerVolume does, a ghost object with a compound shape around the mesh collider
+	std::vector<std::unique_ptr<btTriangleMesh>> meshes;
+	std::vector<std::unique_ptr<btCollisionShape>> shapes;
+	std::vector<std::unique_ptr<btCollisionObject>> objects;
+	for (const Gameplay::TableRail& rail : Gameplay::TABLE_RAILS) {
+		meshes.emplace_back(CreateRailMesh(triangles));
+		btConvexTriangleMeshShape* hull = new btConvexTriangleMeshShape(meshes.back().get());
+		hull->setLocalScaling(btVector3(rail.Length, 1.0f, 1.0f));
+		shapes.emplace_back(hull);
+		btCompoundShape* compound = new btCompoundShape();
+		btTransform identity;
+		identity.setIdentity();
+		compound->addChildShape(identity, hull);
+		shapes.emplace_back(compound);
+
+		btTransform transform;
+		transform.setIdentity();
+		transform.setOrigin(ToBt(rail.Position));
+		transform.setRotation(btQuaternion(btVector3(0.0f, 0.0f, 1.0f), glm::radians(rail.Rotation)));
+		btCollisionObject* object = new btCollisionObject();
+		object->setCollisionShape(compound);
+		object->setWorldTransform(transform);
+		object->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE);
+		objects.emplace_back(object);
+		world.addCollisionObject(object);
+	}
+
+	// Looking down at the table so that all the rails are in view
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, -30.0f, 25.0f), glm::vec3(0.0f, 0.0f, -8.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 viewProjection = projection * view;
+
+	double bulletMs = Benchmark::TimeMs(iterations, [&]() {
+		drawer.Vertices.clear();
+		world.debugDrawWorld();
+	});
+	size_t bulletVertices = drawer.Vertices.size();
+
+	// The first frame has to tessellate everything, after that we only cull and gather instances
+	Gameplay::Physics::PhysicsDebugCache cache;
+	double coldMs = Benchmark::TimeMs(1, [&]() {
+		cache.Prepare(&world, viewProjection);
+	});
+	double cachedMs = Benchmark::TimeMs(iterations, [&]() {
+		cache.Prepare(&world, viewProjection);
+	});
+	Gameplay::Physics::PhysicsDebugCache::Stats stats = cache.GetStats();
+
+	// Looking away from the table should cull every rail
+	glm::mat4 awayViewProjection = projection * glm::lookAt(glm::vec3(0.0f, -30.0f, 25.0f), glm::vec3(0.0f, -60.0f, 25.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	cache.Prepare(&world, awayViewProjection);
+	uint32_t culledAway = cache.GetStats().Culled;
+
+	LOG_INFO("Drawing {} rail triggers with ~{} triangles each, averaged over {} iterations", objects.size(), triangles, iterations);
+	LOG_INFO("    debugDrawWorld: {:8.4f} ms, {} line vertices", bulletMs, bulletVertices);
+	LOG_INFO("    Cached (cold):  {:8.4f} ms, {} shapes tessellated", coldMs, stats.CachedShapes);
+	LOG_INFO("    Cached:         {:8.4f} ms ({:.2f}x), {} visible, {} draws, {} instance bytes", cachedMs, cachedMs > 0.0 ? bulletMs / cachedMs : 0.0,
+		stats.Shapes - stats.Culled, cache.GetBatches().size(), cache.GetInstances().size() * sizeof(Gameplay::Physics::PhysicsDebugCache::Instance));
+
+	for (auto& object : objects) {
+		world.removeCollisionObject(object.get());
+	}
+
+	bool valid = true;
+	if (stats.Shapes != objects.size() || stats.Culled != 0) {
+		LOG_ERROR("Expected all {} rails to be visible, {} of {} shapes were culled", objects.size(), stats.Culled, stats.Shapes);
+		valid = false;
+	}
+	if (stats.LineVertices != bulletVertices) {
+		LOG_ERROR("Cache drew {} line vertices, but Bullet drew {}", stats.LineVertices, bulletVertices);
+		valid = false;
+	}
+	if (culledAway != objects.size()) {
+		LOG_ERROR("Expected all {} rails to be culled when looking away, but {} were", objects.size(), culledAway);
+		valid = false;
+	}
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Compares the CPU frame time of drawing the air hockey table's 12 rail triggers through
+/// btCollisionWorld::debugDrawWorld against the PhysicsDebugCache, with all the rails in view.
+/// Checks that the cache draws the same number of lines as Bullet. Does not require an OpenGL
+/// context, the cache's GPU upload is not included in the timings
+///
+/// Arguments: [triangles per rail = 2048] [iterations = 200]
+/// </summary>
+class PhysicsDebugBenchmark {
+public:
+	PhysicsDebugBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
@@ -0,0 +1,157 @@
+#include "VertexFormatBenchmark.h"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <Logging.h>
+
+#include "Benchmarks/Benchmark.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/VertexPacking.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/ObjLoader.h"
+
+// The meshes from the scene that are drawn with a packed format, and how many copies of them are in the scene
+struct SceneMesh {
+	const char* Path;
+	int         Copies;
+};
+static const SceneMesh SceneMeshes[] = {
+	{ "gObj_table/table.obj", 1 },
+	{ "gObj_edge/edge_uni.obj", 12 }
+};
+
+// Gets the angle between two unit vectors, in degrees. acos loses too much precision this close to 0
+static double AngleBetween(const glm::vec3& a, const glm::vec3& b) {
+	glm::dvec3 da = glm::dvec3(a);
+	glm::dvec3 db = glm::dvec3(b);
+	return glm::degrees(std::atan2(glm::length(glm::cross(da, db)), glm::dot(da, db)));
+}
+
+// Checks the normal and UV encodings against random values, returns false if they are outside of what we promise
+static bool CheckEncodingError(int samples) {
+	std::mt19937 rng(1234);
+	std::normal_distribution<float> gaussian(0.0f, 1.0f);
+	std::uniform_real_distribution<float> uvRange(-4.0f, 4.0f);
+
+	double maxAngle = 0.0;
+	double sumAngle = 0.0;
+	float maxUvError = 0.0f;
+	for (int ix = 0; ix < samples; ix++) {
+		// Normally distributed components give us directions evenly spread over the sphere
+		glm::vec3 normal = glm::vec3(gaussian(rng), gaussian(rng), gaussian(rng));
+		if (glm::length(normal) < 0.0001f) {
+			continue;
+		}
+		normal = glm::normalize(normal);
+		glm::vec3 decoded = VertexPacking::DecodeNormal(VertexPacking::EncodeNormal(normal));
+		double angle = AngleBetween(normal, decoded);
+		maxAngle = std::max(maxAngle, angle);
+		sumAngle += angle;
+
+		// Half floats have a relative error, so measure it relative to the size of the UV
+		glm::vec2 uv = glm::vec2(uvRange(rng), uvRange(rng));
+		glm::vec2 uvError = glm::abs(VertexPacking::DecodeUV(VertexPacking::EncodeUV(uv)) - uv) / glm::max(glm::abs(uv), glm::vec2(1.0f));
+		maxUvError = std::max(maxUvError, std::max(uvError.x, uvError.y));
+	}
+
+	// The axes and the octahedron's edges are where the mapping is most likely to go wrong
+	const glm::vec3 edgeCases[] = {
+		glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1),
+		glm::normalize(glm::vec3(1, 1, 0)), glm::normalize(glm::vec3(-1, 1, 0)), glm::normalize(glm::vec3(1, -1, 0)), glm::normalize(glm::vec3(-1, -1, 0)),
+		glm::normalize(glm::vec3(1, 1, -1)), glm::normalize(glm::vec3(-1, -1, -1)), glm::normalize(glm::vec3(1, 0, -1)), glm::normalize(glm::vec3(0, -1, -1))
+	};
+	for (const glm::vec3& normal : edgeCases) {
+		glm::vec3 decoded = VertexPacking::DecodeNormal(VertexPacking::EncodeNormal(normal));
+		maxAngle = std::max(maxAngle, AngleBetween(normal, decoded));
+	}
+
+	LOG_INFO("Encoding error over {} samples:", samples);
+	LOG_INFO("    Normals: {:.5f} degrees max, {:.5f} degrees average", maxAngle, sumAngle / samples);
+	LOG_INFO("    UVs:     {:.6f} max relative error", maxUvError);
+
+	bool valid = true;
+	if (maxAngle > 0.01) {
+		LOG_ERROR("Normal encoding error of {} degrees is larger than expected", maxAngle);
+		valid = false;
+	}
+	// Half floats have an 11 bit significand
+	if (maxUvError > 1.0f / 2048.0f) {
+		LOG_ERROR("UV encoding error of {} is larger than expected", maxUvError);
+		valid = false;
+	}
+	if (VertexPacking::DecodeColor(VertexPacking::EncodeColor(glm::vec4(0.0f, 0.5f, 1.0f, 2.0f))) != glm::vec4(0.0f, 128.0f / 255.0f, 1.0f, 1.0f)) {
+		LOG_ERROR("Color encoding did not round or clamp as expected");
+		valid = false;
+	}
+	return valid;
+}
+
+// Reports the memory and fetch bandwidth of a mesh in each of the vertex formats. Meshes only live in their geometry
+// arena, so the memory is the mesh's vertices plus it's indices in the arena's index type
+static bool ReportMesh(const SceneMesh& mesh, uint32_t cacheSize, size_t totals[3][2]) {
+	std::vector<VertexPosNormTexCol> vertices;
+	std::vector<uint32_t> indices;
+	if (!ObjLoader::LoadVertices(mesh.Path, vertices, indices) || vertices.empty()) {
+		LOG_ERROR("Failed to load \"{}\"", mesh.Path);
+		return false;
+	}
+	// Same as what the mesh goes through when it is imported
+	MeshOptimizer::Optimize(vertices, indices);
+
+	size_t misses = (size_t)(MeshOptimizer::CalculateAcmr(indices, vertices.size(), cacheSize) * (indices.size() / 3) + 0.5f);
+	const size_t strides[3] = { sizeof(VertexPosNormTexCol), sizeof(VertexPosNormTexPacked), sizeof(VertexPosNormTexColPacked) };
+	IndexType indexType = GeometryArena::GetIndexTypeFor(vertices.size());
+	size_t indexMemory = indices.size() * GetIndexTypeSize(indexType);
+
+	LOG_INFO("    {} (x{}), {} vertices, {} {} indices ({:.1f} KB), {} fetches per draw", mesh.Path, mesh.Copies, vertices.size(),
+		indices.size(), ~indexType, indexMemory / 1024.0f, misses);
+	for (int format = 0; format < 3; format++) {
+		size_t memory = vertices.size() * strides[format] + indexMemory;
+		size_t fetched = misses * strides[format];
+		LOG_INFO("        {:<12} {:2} B/vertex  Arena {:8.1f} KB  fetch {:8.1f} KB/draw", ~(MeshVertexFormat)format, strides[format], memory / 1024.0f, fetched / 1024.0f);
+		// Every copy shares the same allocation, but each one is drawn
+		totals[format][0] += memory;
+		totals[format][1] += fetched * mesh.Copies;
+	}
+
+	// Make sure the conversion keeps the normals we're lighting with
+	double maxAngle = 0.0;
+	for (const VertexPosNormTexCol& vertex : vertices) {
+		if (glm::length(vertex.Normal) < 0.0001f) {
+			continue;
+		}
+		VertexPosNormTexPacked packed(vertex);
+		glm::vec3 normal = glm::normalize(vertex.Normal);
+		maxAngle = std::max(maxAngle, AngleBetween(normal, VertexPacking::DecodeNormal(packed.Normal)));
+	}
+	LOG_INFO("        Max normal error after packing: {:.5f} degrees", maxAngle);
+	return true;
+}
+
+int VertexFormatBenchmark::Run(const std::vector<std::string>& args) {
+	int samples        = std::max(Benchmark::GetIntArg(args, 0, 1000000), 1);
+	uint32_t cacheSize = (uint32_t)std::max(Benchmark::GetIntArg(args, 1, 16), 3);
+
+	bool valid = CheckEncodingError(samples);
+
+	if (!std::filesystem::exists("shaders")) {
+		LOG_WARN("Not running from the res folder, skipping the scene meshes");
+		return valid ? 0 : 1;
+	}
+
+	// [format][0] is arena memory (vertices and indices), [format][1] is fetch bandwidth for a frame
+	size_t totals[3][2] = { { 0, 0 }, { 0, 0 }, { 0, 0 } };
+	LOG_INFO("Scene meshes, with a {} vertex FIFO cache:", cacheSize);
+	for (const SceneMesh& mesh : SceneMeshes) {
+		valid = ReportMesh(mesh, cacheSize, totals) && valid;
+	}
+
+	LOG_INFO("Totals:");
+	for (int format = 0; format < 3; format++) {
+		LOG_INFO("    {:<12} Arena {:8.1f} KB ({:5.1f}%)  fetch {:8.1f} KB/frame ({:5.1f}%)", ~(MeshVertexFormat)format,
+			totals[format][0] / 1024.0f, 100.0f * totals[format][0] / std::max(totals[0][0], (size_t)1),
+			totals[format][1] / 1024.0f, 100.0f * totals[format][1] / std::max(totals[0][1], (size_t)1));
+	}
+	return valid ? 0 : 1;
+}
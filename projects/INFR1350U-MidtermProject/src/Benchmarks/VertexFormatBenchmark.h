@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Compares the packed vertex formats (VertexPosNormTexPacked and VertexPosNormTexColPacked) against
+/// VertexPosNormTexCol. Measures the worst case error of the normal and UV encodings over a large set of
+/// random values, then loads the table and rail meshes and reports how much VBO memory and vertex fetch
+/// bandwidth each format needs. Does not require an OpenGL context
+///
+/// Fetch bandwidth is estimated by running the mesh's indices through a FIFO cache, every miss reads a
+/// full vertex. This ignores the fetch cache lines, so the real savings are usually a bit better
+///
+/// Arguments: [samples = 1000000] [cache size = 16]
+/// </summary>
+class VertexFormatBenchmark {
+public:
+	VertexFormatBenchmark() = delete;
+
+	static int Run(const std::vector<std::string>& args);
+};
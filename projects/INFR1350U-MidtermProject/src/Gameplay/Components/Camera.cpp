@@ -89,11 +89,20 @@ namespace Gameplay {
 		_isProjectionDirty = true;
 	}
 
+	const glm::mat4& Camera::GetView() const {
+		_view = glm::inverse(GetGameObject()->GetTransform());
+		return _view;
+	}
+
 	const glm::mat4& Camera::GetViewProjection() const {
-		_viewProjection = __CalculateProjection() * glm::inverse(GetGameObject()->GetTransform());
+		_viewProjection = __CalculateProjection() * GetView();
 		return _viewProjection;
 	}
 
+	Frustum Camera::GetFrustum() const {
+		return Frustum::FromViewProjection(GetViewProjection());
+	}
+
 	const glm::mat4& Camera::__CalculateProjection() const
 	{
 		if (_isProjectionDirty) {
@@ -3,6 +3,7 @@
 #include <memory>
 #include <GLM/glm.hpp>
 #include "Gameplay/Components/IComponent.h"
+#include "Utils/BoundingVolumes.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -69,17 +70,30 @@ namespace Gameplay {
 		bool GetOrthoEnabled() const { return _isOrtho; }
 
 		/// <summary>
-		/// Gets the view matrix for this camera
+		/// Gets the distance to the camera's near clipping plane
 		/// </summary>
-		const glm::mat4& GetView() const { return _view; }
+		float GetNearPlane() const { return _nearPlane; }
 		/// <summary>
-		/// Gets the projection matrix for this camera
+		/// Gets the distance to the camera's far clipping plane
 		/// </summary>
-		const glm::mat4& GetProjection() const { return _projection; }
+		float GetFarPlane() const { return _farPlane; }
+
+		/// <summary>
+		/// Gets the view matrix for this camera, calculated from the camera's game object
+		/// </summary>
+		const glm::mat4& GetView() const;
+		/// <summary>
+		/// Gets the projection matrix for this camera, calculating if needed
+		/// </summary>
+		const glm::mat4& GetProjection() const { return __CalculateProjection(); }
 		/// <summary>
 		/// Gets the combined view-projection matrix for this camera, calculating if needed
 		/// </summary>
 		const glm::mat4& GetViewProjection() const;
+		/// <summary>
+		/// Gets the view frustum for this camera in world space, extracted from the view projection
+		/// </summary>
+		Frustum GetFrustum() const;
 
 	protected:
 		float _nearPlane;
@@ -90,7 +104,7 @@ namespace Gameplay {
 		bool _isOrtho;
 		mutable bool _isProjectionDirty;
 
-		glm::mat4 _view;
+		mutable glm::mat4 _view;
 		mutable glm::mat4 _projection;
 
 		// The view projection, it is mutable so we can re-calculate it during const methods
@@ -1,6 +1,8 @@
 #include "Gameplay/Components/RenderComponent.h"
 
 #include "Utils/ResourceManager/ResourceManager.h"
+#include "Gameplay/GameObject.h"
+#include "Gameplay/Scene.h"
 
 
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
@@ -17,6 +19,7 @@ RenderComponent::RenderComponent() :
 
 void RenderComponent::SetMesh(const Gameplay::MeshResource::Sptr& mesh) {
 	_mesh = mesh;
+	_InvalidateStaticBatch();
 }
 
 const Gameplay::MeshResource::Sptr& RenderComponent::GetMeshResource() const {
@@ -29,12 +32,20 @@ const VertexArrayObject::Sptr& RenderComponent::GetMesh() const {
 
 void RenderComponent::SetMaterial(const Gameplay::Material::Sptr& mat) {
 	_material = mat;
+	_InvalidateStaticBatch();
 }
 
 const Gameplay::Material::Sptr& RenderComponent::GetMaterial() const {
 	return _material;
 }
 
+MeshBounds RenderComponent::GetWorldBounds() const {
+	if (_mesh == nullptr) {
+		return MeshBounds();
+	}
+	return _mesh->GetBounds().Transformed(GetGameObject()->GetTransform());
+}
+
 nlohmann::json RenderComponent::ToJson() const {
 	nlohmann::json result;
 	result["mesh"] = _mesh ? _mesh->GetGUID().str() : "null";
@@ -50,8 +61,15 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 	return result;
 }
 
+void RenderComponent::_InvalidateStaticBatch() {
+	Gameplay::GameObject* object = GetGameObject();
+	if (object != nullptr && object->IsStatic && object->GetScene() != nullptr) {
+		object->GetScene()->GetStaticBatcher()->Invalidate(object);
+	}
+}
+
 void RenderComponent::RenderImGui() {
-	ImGui::Text("Indexed:   %s", _mesh->Mesh != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
+	ImGui::Text("Indexed:   %s", _mesh->Mesh != nullptr ? (_mesh->Mesh->GetIndexCount() > 0 ? "true" : "false") : "N/A");
 	ImGui::Text("Triangles: %d", _mesh->Mesh != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
 	ImGui::Text("Source:    %s", _mesh->Filename.empty() ? "Generated" : _mesh->Filename.c_str());
 	ImGui::Separator();
@@ -30,6 +30,11 @@ public:
 	/// </summary>
 	const Gameplay::Material::Sptr& GetMaterial() const;
 
+	/// <summary>
+	/// Gets the bounds of this object's mesh in world space, using the game object's transform
+	/// </summary>
+	MeshBounds GetWorldBounds() const;
+
 	/// <summary>
 	/// Sets this render component's mesh resource, from which the VAO will be retrieved for rendering
 	/// </summary>
@@ -57,4 +62,7 @@ protected:
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
+
+	// Notifies the scene's static batcher if our object is static and we've changed
+	void _InvalidateStaticBatch();
 };
\ No newline at end of file
@@ -16,6 +16,7 @@ namespace Gameplay {
 	GameObject::GameObject() :
 		Name("Unknown"),
 		GUID(Guid::New()),
+		IsStatic(false),
 		_components(std::vector<IComponent::Sptr>()),
 		_scene(nullptr),
 		_position(ZERO),
@@ -58,6 +59,9 @@ namespace Gameplay {
 	void GameObject::SetPostion(const glm::vec3& position) {
 		_position = position;
 		_isTransformDirty = true;
+		if (IsStatic) {
+			_InvalidateStaticBatch();
+		}
 	}
 
 	const glm::vec3& GameObject::GetPosition() const {
@@ -67,6 +71,9 @@ namespace Gameplay {
 	void GameObject::SetRotation(const glm::quat& value) {
 		_rotation = value;
 		_isTransformDirty = true;
+		if (IsStatic) {
+			_InvalidateStaticBatch();
+		}
 	}
 
 	const glm::quat& GameObject::GetRotation() const {
@@ -76,6 +83,9 @@ namespace Gameplay {
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
 		_rotation = glm::quat(glm::radians(eulerAngles));
 		_isTransformDirty = true;
+		if (IsStatic) {
+			_InvalidateStaticBatch();
+		}
 	}
 
 	const glm::vec3& GameObject::GetRotationEuler() const {
@@ -85,6 +95,9 @@ namespace Gameplay {
 	void GameObject::SetScale(const glm::vec3& value) {
 		_scale = value;
 		_isTransformDirty = true;
+		if (IsStatic) {
+			_InvalidateStaticBatch();
+		}
 	}
 
 	const glm::vec3& GameObject::GetScale() const {
@@ -105,6 +118,12 @@ namespace Gameplay {
 		return _scene;
 	}
 
+	void GameObject::_InvalidateStaticBatch() {
+		if (_scene != nullptr) {
+			_scene->GetStaticBatcher()->Invalidate(this);
+		}
+	}
+
 	void GameObject::Awake() {
 		for (auto& component : _components) {
 			component->Awake();
@@ -124,8 +143,13 @@ namespace Gameplay {
 		if (ImGui::CollapsingHeader(Name.c_str())) {
 			ImGui::Indent();
 
+			// Static objects need to let their batch know when they've been edited
+			if (ImGui::Checkbox("Static", &IsStatic)) {
+				_InvalidateStaticBatch();
+			}
+
 			// Render position label
-			_isTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
+			bool transformEdited = LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
 			
 			// Get the ImGui storage state so we can avoid gimbal locking issues by storing euler angles in the editor
 			glm::vec3 euler = GetRotationEuler();
@@ -151,7 +175,14 @@ namespace Gameplay {
 			}
 			
 			// Draw the scale
-			_isTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+			transformEdited |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+
+			if (transformEdited) {
+				_isTransformDirty = true;
+				if (IsStatic) {
+					_InvalidateStaticBatch();
+				}
+			}
 
 			ImGui::Separator();
 			ImGui::TextUnformatted("Components");
@@ -180,6 +211,7 @@ namespace Gameplay {
 		// Load in basic info
 		result->Name = data["name"];
 		result->GUID = Guid(data["guid"]);
+		result->IsStatic  = JsonGet(data, "static", false);
 		result->_position = ParseJsonVec3(data["position"]);
 		result->_rotation = ParseJsonQuat(data["rotation"]);
 		result->_scale    = ParseJsonVec3(data["scale"]);
@@ -206,6 +238,7 @@ namespace Gameplay {
 		nlohmann::json result = {
 			{ "name", Name },
 			{ "guid", GUID.str() },
+			{ "static", IsStatic },
 			{ "position", GlmToJson(_position) },
 			{ "rotation", GlmToJson(_rotation) },
 			{ "scale",    GlmToJson(_scale) },
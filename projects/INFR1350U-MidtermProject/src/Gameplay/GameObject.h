@@ -32,6 +32,9 @@ namespace Gameplay {
 		std::string             Name;
 		// Unique ID for the object
 		Guid                    GUID;
+		// Whether the object will never move, static objects that share a material will be
+		// merged into a single mesh by the scene's StaticBatcher
+		bool                    IsStatic;
 
 		/// <summary>
 		/// Rotates this object to look at the given point in world coordinates
@@ -220,6 +223,12 @@ namespace Gameplay {
 		// or load, we don't need to worry about ref counting
 		Scene* _scene;
 
+		/// <summary>
+		/// Lets the scene's static batcher know that this object has changed in a way that
+		/// may affect it's batch
+		/// </summary>
+		void _InvalidateStaticBatch();
+
 		/// <summary>
 		/// Only scenes will be allowed to create gameobjects
 		/// </summary>
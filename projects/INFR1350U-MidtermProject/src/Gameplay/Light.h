@@ -20,6 +20,18 @@ namespace Gameplay {
 		/// </summary>
 		float Range = 4.0f;
 
+		/// <summary>
+		/// Gets the distance at which the light's contribution falls below the given fraction, our
+		/// attenuation never actually reaches zero so we need a cutoff for light culling
+		/// </summary>
+		/// <param name="threshold">The contribution below which we consider the light to have no effect</param>
+		inline float GetInfluenceRadius(float threshold = 1.0f / 256.0f) const {
+			// Diffuse and specular can both contribute the full color, and the shader attenuates by 1 / (1 + k * d^2)
+			float intensity = 2.0f * glm::max(Color.x, glm::max(Color.y, Color.z));
+			float attenuation = 1.0f / (1.0f + Range);
+			return intensity > threshold ? glm::sqrt((intensity / threshold - 1.0f) / attenuation) : 0.0f;
+		}
+
 		/// <summary>
 		/// Loads a light from a JSON blob
 		/// </summary>
@@ -1,16 +1,101 @@
 #include "Gameplay/Material.h"
 #include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/JsonGlmHelpers.h"
 
 namespace Gameplay {
+	Material::Material() :
+		IResource(),
+		Name(""),
+		MatShader(nullptr),
+		Keywords(std::vector<std::string>()),
+		Texture(nullptr),
+		TextureArray(nullptr),
+		TextureLayer(0),
+		Shininess(0.0f),
+		_samplerSlotsProgram(0),
+		_variant(nullptr),
+		_variantSource(nullptr),
+		_variantKeywords(std::vector<std::string>()),
+		_variantArray(false),
+		_vertexVariants(std::map<std::vector<std::string>, Shader::Sptr>()),
+		_vertexVariantSource(nullptr),
+		_vertexVariantKeywords(std::vector<std::string>()),
+		_vertexVariantArray(false)
+	{ }
+
 	void Material::Apply() {
-		// Material properties
-		MatShader->SetUniform("u_Material.Shininess", Shininess);
+		Apply(GetShader());
+	}
+
+	std::vector<std::string> Material::GetKeywords() const {
+		std::vector<std::string> result = Keywords;
+		if (TextureArray != nullptr) {
+			result.push_back("TEXTURE_ARRAY");
+		}
+		return result;
+	}
+
+	const Shader::Sptr& Material::GetShader() {
+		bool useArray = TextureArray != nullptr;
+		if ((Keywords.empty() && !useArray) || MatShader == nullptr) {
+			return MatShader;
+		}
+
+		// Only look up the variant again if the shader or our keywords have changed
+		if (_variantSource != MatShader.get() || _variantKeywords != Keywords || _variantArray != useArray) {
+			_variant = MatShader->GetVariant(GetKeywords());
+			_variantSource = MatShader.get();
+			_variantKeywords = Keywords;
+			_variantArray = useArray;
+		}
+		return _variant != nullptr ? _variant : MatShader;
+	}
 
-		// For textures, we pass the *slot* that the texture sure draw from
-		MatShader->SetUniform("u_Material.Diffuse", 0);
+	const Shader::Sptr& Material::GetShader(const std::vector<std::string>& vertexKeywords) {
+		const Shader::Sptr& shader = GetShader();
+		if (vertexKeywords.empty() || MatShader == nullptr) {
+			return shader;
+		}
+
+		bool useArray = TextureArray != nullptr;
+		if (_vertexVariantSource != MatShader.get() || _vertexVariantKeywords != Keywords || _vertexVariantArray != useArray) {
+			_vertexVariants.clear();
+			_vertexVariantSource = MatShader.get();
+			_vertexVariantKeywords = Keywords;
+			_vertexVariantArray = useArray;
+		}
+
+		auto it = _vertexVariants.find(vertexKeywords);
+		if (it == _vertexVariants.end()) {
+			std::vector<std::string> keywords = GetKeywords();
+			keywords.insert(keywords.end(), vertexKeywords.begin(), vertexKeywords.end());
+			Shader::Sptr variant = MatShader->GetVariant(keywords);
+			// Not much we can do if it fails, the mesh will look wrong but at least it will draw
+			it = _vertexVariants.emplace(vertexKeywords, variant != nullptr ? variant : shader).first;
+		}
+		return it->second;
+	}
+
+	void Material::Apply(const Shader::Sptr& shader) {
+		// Material properties, materials in a texture array pass theirs along with the layer, so that the
+		// multi-draw path can give each draw it's own (see SceneRenderer::IndirectDrawData)
+		if (TextureArray != nullptr) {
+			shader->SetUniform("u_MaterialParams", glm::vec2((float)TextureLayer, Shininess));
+		} else {
+			shader->SetUniform("u_Material.Shininess", Shininess);
+		}
+
+		// For textures, we pass the *slot* that the texture sure draw from, this is program state
+		// so we can skip it if we've already set it on this program
+		if (_samplerSlotsProgram != shader->GetProgramId()) {
+			shader->SetUniform("u_Material.Diffuse", 0);
+			_samplerSlotsProgram = shader->GetProgramId();
+		}
 
 		// Bind the texture
-		if (Texture != nullptr) {
+		if (TextureArray != nullptr) {
+			TextureArray->Bind(0);
+		} else if (Texture != nullptr) {
 			Texture->Bind(0);
 		}
 	}
@@ -24,7 +109,24 @@ namespace Gameplay {
 
 		// material specific parameters
 		result->Texture = ResourceManager::Get<Texture2D>(Guid(data["texture"]));
+		if (data.contains("texture_array")) {
+			result->TextureArray = ResourceManager::Get<Texture2DArray>(Guid(data["texture_array"]));
+			result->TextureLayer = JsonGet(data, "texture_layer", 0);
+		}
 		result->Shininess = data["shininess"].get<float>();
+		if (data.contains("keywords")) {
+			result->Keywords = data["keywords"].get<std::vector<std::string>>();
+		}
+		return result;
+	}
+
+	std::vector<Guid> Material::GetJsonDependencies(const nlohmann::json& data) {
+		std::vector<Guid> result;
+		for (const char* key : { "shader", "texture", "texture_array" }) {
+			if (data.contains(key) && data[key].is_string() && data[key].get<std::string>() != "null") {
+				result.push_back(Guid(data[key].get<std::string>()));
+			}
+		}
 		return result;
 	}
 
@@ -35,7 +137,10 @@ namespace Gameplay {
 			{ "shader", MatShader ? MatShader->GetGUID().str() : "null" },
 
 			{ "texture", Texture ? Texture->IResource::GetGUID().str() : "null" },
+			{ "texture_array", TextureArray ? TextureArray->IResource::GetGUID().str() : "null" },
+			{ "texture_layer", TextureLayer },
 			{ "shininess", Shininess },
+			{ "keywords", Keywords },
 		};
 	}
 }
\ No newline at end of file
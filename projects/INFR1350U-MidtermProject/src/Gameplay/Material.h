@@ -1,6 +1,8 @@
 #pragma once
+#include <map>
 #include <memory>
 #include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DArray.h"
 #include "Graphics/Shader.h"
 
 namespace Gameplay {
@@ -19,12 +21,23 @@ namespace Gameplay {
 		/// The shader that the material is using
 		/// </summary>
 		Shader::Sptr    MatShader;
+		/// <summary>
+		/// Shader keywords that this material needs, used to pick a variant of MatShader
+		/// so that any features the material doesn't use get compiled out (ex: NO_SPECULAR)
+		/// </summary>
+		std::vector<std::string> Keywords;
 
 		/// <summary>
 		/// Material shader parameters
 		/// </summary>
 		Texture2D::Sptr Texture;
 		/// <summary>
+		/// If set, the material samples layer TextureLayer of this array instead of Texture. Materials with the
+		/// base shader that share an array can be drawn in the same multi-draw, since the layer is passed per draw
+		/// </summary>
+		Texture2DArray::Sptr TextureArray;
+		int             TextureLayer;
+		/// <summary>
 		/// How reflective the material is, controls specular power
 		/// </summary>
 		float           Shininess;
@@ -34,17 +47,60 @@ namespace Gameplay {
 		/// Will bind the shader, update material uniforms, and bind textures
 		/// </summary>
 		virtual void Apply();
+		/// <summary>
+		/// Applies this material's state to the given shader instead of MatShader, used when
+		/// the renderer draws with a variant of MatShader
+		/// </summary>
+		/// <param name="shader">The shader to apply the material uniforms to</param>
+		virtual void Apply(const Shader::Sptr& shader);
 
-		
+		/// <summary>
+		/// Gets the variant of MatShader for this material's keywords, or MatShader itself if the
+		/// material has no keywords (or the variant failed to compile)
+		/// </summary>
+		const Shader::Sptr& GetShader();
+		/// <summary>
+		/// Gets the variant of MatShader for this material's keywords, plus any keywords that the mesh's vertex
+		/// format needs (see VertexPacking::GetShaderKeywords)
+		/// </summary>
+		/// <param name="vertexKeywords">The extra keywords for the vertex format, if empty this is the same as GetShader()</param>
+		const Shader::Sptr& GetShader(const std::vector<std::string>& vertexKeywords);
+		/// <summary>
+		/// Gets the keywords that the material needs, which is Keywords plus TEXTURE_ARRAY if the material uses TextureArray
+		/// </summary>
+		std::vector<std::string> GetKeywords() const;
+
+		Material();
 
 		/// <summary>
 		/// Loads a material from a JSON blob
 		/// </summary>
 		static Material::Sptr FromJson(const nlohmann::json& data);
+		/// <summary>
+		/// Gets the shader and textures that a material's JSON blob refers to, so that LoadManifest
+		/// can create them before the material
+		/// </summary>
+		static std::vector<Guid> GetJsonDependencies(const nlohmann::json& data);
 
 		/// <summary>
 		/// Converts this material into it's JSON representation for storage
 		/// </summary>
 		nlohmann::json ToJson() const;
+
+	protected:
+		// The ID of the shader program that we last set up our sampler slots on (see Shader::GetProgramId),
+		// since these never change we only need to send them once per program
+		uint32_t _samplerSlotsProgram;
+
+		// The variant we resolved for our keywords, along with what it was resolved from so we know when to update it
+		Shader::Sptr             _variant;
+		Shader*                  _variantSource;
+		std::vector<std::string> _variantKeywords;
+		bool                     _variantArray;
+		// The variants for each vertex format we've been drawn with, and what they were resolved from
+		std::map<std::vector<std::string>, Shader::Sptr> _vertexVariants;
+		Shader*                  _vertexVariantSource;
+		std::vector<std::string> _vertexVariantKeywords;
+		bool                     _vertexVariantArray;
 	};
 }
\ No newline at end of file
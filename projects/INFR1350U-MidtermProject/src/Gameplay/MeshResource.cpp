@@ -1,25 +1,34 @@
 #include "MeshResource.h"
-#include <filesystem>
+#include <chrono>
+#include <memory>
+#include <type_traits>
+#include <Logging.h>
 
+#include "Graphics/MeshBinaryCache.h"
+#include "Utils/FileHelpers.h"
+#include "Utils/MeshOptimizer.h"
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
 
 namespace Gameplay {
 	MeshResource::MeshResource() :
 		IResource(),
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		VertexFormat(MeshVertexFormat::Full),
 		Mesh(nullptr),
 		BulletTriMesh(nullptr)
 	{ }
 
-	MeshResource::MeshResource(const std::string& filename) :
+	MeshResource::MeshResource(const std::string& filename, MeshVertexFormat format) :
 		IResource(),
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		VertexFormat(format),
 		Mesh(nullptr),
 		BulletTriMesh(nullptr)
 	{
-		Mesh = ObjLoader::LoadFromFile(filename);
+		LoadFromFile();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -35,6 +44,7 @@ namespace Gameplay {
 			result["params"] = params;
 		} else {
 			result["filename"] = Filename.empty() ? "null" : Filename;
+			result["format"] = ~VertexFormat;
 		}
 		return result;
 	}
@@ -53,18 +63,60 @@ namespace Gameplay {
 			result->Mesh = mesh.Bake();
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
-				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
-				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
-				#endif
-
+			result->VertexFormat = JsonParseEnum(MeshVertexFormat, blob, "format", MeshVertexFormat::Full);
+			if (result->Filename != "null" && FileHelpers::Exists(result->Filename)) {
+				result->LoadFromFile();
 			}
 		}
 		return result;
 	}
 
+	std::function<MeshResource::Sptr()> MeshResource::DecodeJson(const nlohmann::json& blob) {
+		// Everything that doesn't need GL happens here, the function we return finishes the mesh on the main thread
+		if (blob.contains("params") && blob["params"].is_array()) {
+			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
+			std::vector<MeshBuilderParam> params;
+			std::shared_ptr<MeshBuilder<VertexPosNormTexCol>> mesh = std::make_shared<MeshBuilder<VertexPosNormTexCol>>();
+			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
+				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
+				params.push_back(p);
+				MeshFactory::AddParameterized(*mesh, p);
+			}
+			return [params, mesh]() {
+				MeshResource::Sptr result = std::make_shared<MeshResource>();
+				result->MeshBuilderParams = params;
+				result->Mesh = mesh->Bake();
+				return result;
+			};
+		}
+
+		std::string filename = JsonGet<std::string>(blob, "filename", "null");
+		MeshVertexFormat format = JsonParseEnum(MeshVertexFormat, blob, "format", MeshVertexFormat::Full);
+		std::function<void(MeshResource&)> upload = nullptr;
+		if (filename != "null" && FileHelpers::Exists(filename)) {
+			switch (format) {
+				case MeshVertexFormat::Packed:
+					upload = _DecodeFile<VertexPosNormTexPacked>(filename, format);
+					break;
+				case MeshVertexFormat::PackedColor:
+					upload = _DecodeFile<VertexPosNormTexColPacked>(filename, format);
+					break;
+				default:
+					upload = _DecodeFile<VertexPosNormTexCol>(filename, format);
+					break;
+			}
+		}
+		return [filename, format, upload]() {
+			MeshResource::Sptr result = std::make_shared<MeshResource>();
+			result->Filename = filename;
+			result->VertexFormat = format;
+			if (upload) {
+				upload(*result);
+			}
+			return result;
+		};
+	}
+
 	void MeshResource::GenerateMesh() {
 		MeshBuilder<VertexPosNormTexCol> mesh;
 		for (auto& param : MeshBuilderParams) {
@@ -73,7 +125,106 @@ namespace Gameplay {
 		Mesh = mesh.Bake();
 	}
 
+	void MeshResource::LoadFromFile() {
+		switch (VertexFormat) {
+			case MeshVertexFormat::Packed:
+				_LoadFromFile<VertexPosNormTexPacked>();
+				break;
+			case MeshVertexFormat::PackedColor:
+				_LoadFromFile<VertexPosNormTexColPacked>();
+				break;
+			default:
+				_LoadFromFile<VertexPosNormTexCol>();
+				break;
+		}
+	}
+
+	template <typename VertType>
+	bool MeshResource::_ImportFile(const std::string& filename, std::vector<VertType>& outVertices, std::vector<uint32_t>& outIndices) {
+		std::vector<VertexPosNormTexCol> vertices;
+		#ifdef OPTIMIZED_OBJ_LOADER
+		bool loaded = OptimizedObjLoader::LoadVertices(filename, vertices, outIndices);
+		#else
+		bool loaded = ObjLoader::LoadVertices(filename, vertices, outIndices);
+		#endif
+		if (!loaded) {
+			return false;
+		}
+		// Optimize before storing, so the sidecar gets the optimized order and we only pay for this once
+		if (MeshOptimizer::IsEnabled()) {
+			MeshOptimizer::Stats stats = MeshOptimizer::Optimize(vertices, outIndices);
+			LOG_TRACE("Optimized mesh \"{}\" in {:.3f} ms, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} clusters", filename, stats.Milliseconds,
+				stats.AcmrBefore, stats.AcmrAfter, stats.AtvrBefore, stats.AtvrAfter, stats.Clusters);
+		}
+		// The loaders always give us our full format, so convert if we need to. The layout of the triangles
+		// doesn't change, so the optimized order still holds
+		if constexpr (std::is_same<VertType, VertexPosNormTexCol>::value) {
+			outVertices = std::move(vertices);
+		} else {
+			outVertices = std::vector<VertType>(vertices.begin(), vertices.end());
+		}
+		return true;
+	}
+
+	template <typename VertType>
+	void MeshResource::_LoadFromFile() {
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		// Try the binary sidecar first, it's just a memcpy into our buffers
+		Mesh = MeshBinaryCache::TryLoad<VertType>(Filename);
+		bool fromCache = Mesh != nullptr;
+
+		if (!fromCache) {
+			std::vector<VertType> vertices;
+			std::vector<uint32_t> indices;
+			if (!_ImportFile(Filename, vertices, indices)) {
+				return;
+			}
+			Mesh = ObjLoader::CreateMesh(vertices, indices);
+			MeshBinaryCache::Store(Filename, vertices, indices, Mesh->GetBounds());
+		}
+
+		float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		MeshBinaryCache::RecordLoadTime(fromCache, elapsed);
+		LOG_TRACE("Loaded mesh \"{}\" from {} in {:.3f} ms ({} vertices, {} indices, {} format)", Filename, fromCache ? "cache" : "OBJ", elapsed,
+			Mesh->GetVertexCount(), Mesh->GetIndexCount(), ~VertexFormat);
+	}
+
+	template <typename VertType>
+	std::function<void(MeshResource&)> MeshResource::_DecodeFile(const std::string& filename, MeshVertexFormat format) {
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		// Same as _LoadFromFile, but the sidecar is copied out instead of being handed to GL. The vertices are
+		// shared so that the upload function stays copyable
+		std::shared_ptr<std::vector<VertType>> vertices = std::make_shared<std::vector<VertType>>();
+		std::shared_ptr<std::vector<uint32_t>> indices = std::make_shared<std::vector<uint32_t>>();
+		bool invalidated = false;
+		bool fromCache = MeshBinaryCache::TryRead(filename, *vertices, *indices, invalidated);
+		if (!fromCache && !_ImportFile(filename, *vertices, *indices)) {
+			return nullptr;
+		}
+		float decodeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		return [filename, format, vertices, indices, fromCache, invalidated, decodeMs](MeshResource& resource) {
+			auto uploadStart = std::chrono::high_resolution_clock::now();
+			resource.Mesh = ObjLoader::CreateMesh(*vertices, *indices);
+			if (!fromCache) {
+				MeshBinaryCache::Store(filename, *vertices, *indices, resource.Mesh->GetBounds());
+			}
+
+			float elapsed = decodeMs + std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+			MeshBinaryCache::RecordLoadTime(fromCache, elapsed, invalidated);
+			LOG_TRACE("Loaded mesh \"{}\" from {} in {:.3f} ms ({} vertices, {} indices, {} format)", filename, fromCache ? "cache" : "OBJ", elapsed,
+				resource.Mesh->GetVertexCount(), resource.Mesh->GetIndexCount(), ~format);
+		};
+	}
+
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	const MeshBounds& MeshResource::GetBounds() const {
+		static const MeshBounds empty = MeshBounds();
+		return Mesh != nullptr ? Mesh->GetBounds() : empty;
+	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
@@ -22,7 +23,8 @@ namespace Gameplay {
 		/// Constructor for loading from file
 		/// </summary>
 		/// <param name="filename"></param>
-		MeshResource(const std::string& filename);
+		/// <param name="format">The vertex format to import the mesh into</param>
+		MeshResource(const std::string& filename, MeshVertexFormat format = MeshVertexFormat::Full);
 
 		virtual ~MeshResource();
 
@@ -35,6 +37,11 @@ namespace Gameplay {
 		/// The mesh builder parameters if this mesh resource is created at runtime
 		/// </summary>
 		std::vector<MeshBuilderParam>   MeshBuilderParams;
+		/// <summary>
+		/// The vertex format that the mesh is imported into when loading from a file, the packed formats
+		/// are less than half the size, but are drawn with a shader variant that decodes the normals
+		/// </summary>
+		MeshVertexFormat                VertexFormat;
 
 		/// <summary>
 		/// The VAO for rendering this mesh in OpenGL
@@ -56,14 +63,49 @@ namespace Gameplay {
 		/// </summary>
 		void GenerateMesh();
 		/// <summary>
+		/// Loads the mesh from Filename, using the binary sidecar from the MeshBinaryCache if it's up to
+		/// date, otherwise the OBJ is imported and a new sidecar is written for next time
+		/// </summary>
+		void LoadFromFile();
+		/// <summary>
 		/// Adds a new mesh builder parameter to the mesh
 		/// </summary>
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Gets the object space bounds of the mesh, the bounds will be invalid if the mesh has not been loaded
+		/// </summary>
+		const MeshBounds& GetBounds() const;
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+		/// <summary>
+		/// Reads or imports the mesh described by the JSON blob without touching OpenGL, so that manifests
+		/// can be loaded on worker threads
+		/// </summary>
+		/// <returns>A function that creates the mesh resource, must be called on the main thread</returns>
+		static std::function<MeshResource::Sptr()> DecodeJson(const nlohmann::json& blob);
+
+	protected:
+		/// <summary>
+		/// Loads the mesh from Filename into the given vertex format
+		/// </summary>
+		template <typename VertType>
+		void _LoadFromFile();
+		/// <summary>
+		/// Imports a mesh from an OBJ file and optimizes it, converting it to the given vertex format
+		/// </summary>
+		/// <returns>True if the file could be loaded</returns>
+		template <typename VertType>
+		static bool _ImportFile(const std::string& filename, std::vector<VertType>& outVertices, std::vector<uint32_t>& outIndices);
+		/// <summary>
+		/// Reads a mesh from it's sidecar or imports it, returning a function to upload it to the GPU
+		/// </summary>
+		/// <returns>The upload function, or nullptr if the file could not be loaded</returns>
+		template <typename VertType>
+		static std::function<void(MeshResource&)> _DecodeFile(const std::string& filename, MeshVertexFormat format);
 	};
 }
\ No newline at end of file
@@ -85,76 +85,24 @@ namespace Gameplay::Physics {
 			}
 			BufferAttribute posAttrib = *it;
 
-			// Get the VBO that contains our data about the position elements
-			const auto* vertBuff = vao->GetBufferBinding(AttribUsage::Position);
-			if (vertBuff != nullptr) {
-				// Shorthand our buffers
-				IndexBuffer::Sptr indexBuff = vao->GetIndexBuffer();
-				VertexBuffer::Sptr vertexBuff = vertBuff->Buffer;
-
+			// Read the mesh data back into CPU memory, this comes from the mesh's arena allocation if it has no buffers of it's own
+			std::vector<uint8_t> vertexStore;
+			std::vector<uint32_t> indices;
+			if (vao->ReadBack(vertexStore, indices)) {
 				// Create the bullet physics triangle mesh
 				_triMesh = new btTriangleMesh();
-
-				// Helper for extracting an int from a raw index buffer datastore
-				auto getBufferIndex = [](IndexBuffer::Sptr buff, uint8_t* dataStore, int offset) {
-					switch (buff->GetElementType())
-					{
-						case IndexType::UByte:
-							return (int)*(dataStore + offset);
-						case IndexType::UShort:
-							return (int)*(reinterpret_cast<uint16_t*>(dataStore) + offset);
-						case IndexType::UInt:
-							return (int)*(reinterpret_cast<uint32_t*>(dataStore) + offset);
-						case IndexType::Unknown:
-						default:
-							return 0;
-					}
-				};
-
-				// Allocate some space to read data from OpenGL and read our buffer data back into CPU memory
-				uint8_t* vertexStore = reinterpret_cast<uint8_t*>(malloc(vertexBuff->GetTotalSize()));
-				glGetNamedBufferSubData(vertexBuff->GetHandle(), 0, vertexBuff->GetTotalSize(), vertexStore);
 				_triMesh->preallocateVertices(vao->GetVertexCount());
 
-				// If our data is indexed, we use the index buffer to add our triangles
-				if (indexBuff != nullptr) {
-					// Allocate and read space for the indices
-					uint8_t* indexStore = reinterpret_cast<uint8_t*>(malloc(indexBuff->GetTotalSize()));
-					glGetNamedBufferSubData(indexBuff->GetHandle(), 0, indexBuff->GetTotalSize(), indexStore);
-
-					// Iterate over index triangles
-					for (int ix = 0; ix < indexBuff->GetElementCount(); ix+=3) {
-						// Extract index from the raw data
-						int i1 = getBufferIndex(indexBuff, indexStore, ix);
-						int i2 = getBufferIndex(indexBuff, indexStore, ix + 1);
-						int i3 = getBufferIndex(indexBuff, indexStore, ix + 2);
-
-						// Find the positions for the indices
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + (i1 * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + (i2 * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + (i3 * posAttrib.Stride) + posAttrib.Offset);
-
-						// Add the triangle
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
-					}
-			
-					// Free the data we copied the indices into
-					free(indexStore);
+				// Iterate over index triangles, unindexed meshes get their vertices in order
+				for (size_t ix = 0; ix + 2 < indices.size(); ix+=3) {
+					// Find the positions for the indices
+					glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore.data() + (indices[ix + 0] * posAttrib.Stride) + posAttrib.Offset);
+					glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore.data() + (indices[ix + 1] * posAttrib.Stride) + posAttrib.Offset);
+					glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore.data() + (indices[ix + 2] * posAttrib.Stride) + posAttrib.Offset);
 
+					// Add the triangle
+					_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
 				}
-				// We only have vertex data, create triangles sequentially
-				else {
-					// Iterate over triangles, and add each to the mesh
-					for (int ix = 0; ix < vertexBuff->GetElementCount(); ix+=3) {
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 0) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 1) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 2) * posAttrib.Stride) + posAttrib.Offset);
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
-					}
-				}
-
-				// free our vertex store data
-				free(vertexStore);
 
 				// Store the bullet tri mesh in the MeshResource in case we want it later
 				mesh->BulletTriMesh = std::shared_ptr<btTriangleMesh>(_triMesh);
@@ -0,0 +1,390 @@
+#include "Gameplay/Physics/PhysicsDebugCache.h"
+#include <chrono>
+#include <Logging.h>
+#include <BulletCollision/CollisionShapes/btConvexTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleMeshShape.h>
+
+#include "Graphics/DebugDraw.h"
+#include "Utils/GlmBulletConversions.h"
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay::Physics {
+	// Per-instance attributes, the model matrix takes up 4 slots since attributes are at most a vec4
+	static const std::vector<BufferAttribute> INSTANCE_DECL = {
+		BufferAttribute(2, 4, AttributeType::Float, sizeof(PhysicsDebugCache::Instance), offsetof(PhysicsDebugCache::Instance, Transform) + sizeof(glm::vec4) * 0, AttribUsage::User0),
+		BufferAttribute(3, 4, AttributeType::Float, sizeof(PhysicsDebugCache::Instance), offsetof(PhysicsDebugCache::Instance, Transform) + sizeof(glm::vec4) * 1, AttribUsage::User1),
+		BufferAttribute(4, 4, AttributeType::Float, sizeof(PhysicsDebugCache::Instance), offsetof(PhysicsDebugCache::Instance, Transform) + sizeof(glm::vec4) * 2, AttribUsage::User2),
+		BufferAttribute(5, 4, AttributeType::Float, sizeof(PhysicsDebugCache::Instance), offsetof(PhysicsDebugCache::Instance, Transform) + sizeof(glm::vec4) * 3, AttribUsage::User3),
+		BufferAttribute(6, 4, AttributeType::Float, sizeof(PhysicsDebugCache::Instance), offsetof(PhysicsDebugCache::Instance, Color), AttribUsage::Color1),
+	};
+
+	/// <summary>
+	/// Collects the lines that Bullet draws into a vertex list
+	/// </summary>
+	class CaptureDebugDraw : public btIDebugDraw {
+	public:
+		std::vector<VertexPosCol>* Output;
+		int Mode;
+
+		// By default we only want the shape itself, not it's frame axes or normals
+		CaptureDebugDraw(std::vector<VertexPosCol>* output, int mode = DBG_DrawWireframe) : Output(output), Mode(mode) { }
+
+		virtual void drawLine(const btVector3& from, const btVector3& to, const btVector3& color) override {
+			Output->push_back({ ToGlm(from), glm::vec4(ToGlm(color), 1.0f) });
+			Output->push_back({ ToGlm(to), glm::vec4(ToGlm(color), 1.0f) });
+		}
+		virtual void drawContactPoint(const btVector3&, const btVector3&, btScalar, int, const btVector3&) override { }
+		virtual void reportErrorWarning(const char* warningString) override { LOG_WARN(warningString); }
+		virtual void draw3dText(const btVector3&, const char*) override { }
+		virtual void setDebugMode(int) override { }
+		virtual int getDebugMode() const override { return Mode; }
+	};
+
+	PhysicsDebugCache::Frame::Frame() :
+		Geometry(std::vector<VertexPosCol>()),
+		GeometryChanged(false),
+		Instances(std::vector<Instance>()),
+		Batches(std::vector<Batch>()),
+		Lines(std::vector<VertexPosCol>())
+	{ }
+
+	void PhysicsDebugCache::Frame::Clear() {
+		Geometry.clear();
+		GeometryChanged = false;
+		Instances.clear();
+		Batches.clear();
+		Lines.clear();
+	}
+
+	PhysicsDebugCache::Stats::Stats() :
+		CachedShapes(0),
+		Shapes(0),
+		Culled(0),
+		Regenerated(0),
+		DrawCalls(0),
+		LineVertices(0),
+		FrameTimeMs(0.0f)
+	{ }
+
+	bool PhysicsDebugCache::ShapeSignature::operator==(const ShapeSignature& other) const {
+		return Type == other.Type &&
+			Scaling == other.Scaling &&
+			AabbMin == other.AabbMin &&
+			AabbMax == other.AabbMax &&
+			Margin == other.Margin &&
+			MeshData == other.MeshData;
+	}
+
+	PhysicsDebugCache::PhysicsDebugCache() :
+		_isEnabled(true),
+		_frame(0),
+		_stats(Stats()),
+		_shapes(std::unordered_map<const btCollisionShape*, CachedShape>()),
+		_vertices(std::vector<VertexPosCol>()),
+		_isGeometryDirty(false),
+		_isGeometryCaptured(false),
+		_instances(std::vector<Instance>()),
+		_batches(std::vector<Batch>()),
+		_vertexBuffer(nullptr),
+		_instanceBuffer(nullptr),
+		_vao(nullptr),
+		_shader(nullptr)
+	{ }
+
+	PhysicsDebugCache::~PhysicsDebugCache() = default;
+
+	void PhysicsDebugCache::Capture(btCollisionWorld* world, const glm::mat4& viewProjection, Frame& outFrame) {
+		auto start = std::chrono::high_resolution_clock::now();
+		outFrame.Clear();
+
+		btIDebugDraw* drawer = world->getDebugDrawer();
+		int mode = drawer->getDebugMode();
+		bool useCache = _isEnabled && (mode & btIDebugDraw::DBG_DrawWireframe);
+
+		// Bullet still handles everything except for the wireframes, we keep it's lines to draw with the rest of the frame
+		int bulletMode = useCache ? (mode & ~btIDebugDraw::DBG_DrawWireframe) : mode;
+		if (bulletMode != btIDebugDraw::DBG_NoDebug) {
+			CaptureDebugDraw capture(&outFrame.Lines, bulletMode);
+			capture.setDefaultColors(drawer->getDefaultColors());
+			world->setDebugDrawer(&capture);
+			world->debugDrawWorld();
+			world->setDebugDrawer(drawer);
+		}
+
+		if (useCache) {
+			Prepare(world, viewProjection);
+			// The renderer keeps the wireframes between frames, so we only send them when they change
+			if (!_isGeometryCaptured) {
+				outFrame.Geometry = _vertices;
+				outFrame.GeometryChanged = true;
+				_isGeometryCaptured = true;
+			}
+			outFrame.Instances = _instances;
+			outFrame.Batches = _batches;
+		} else {
+			_batches.clear();
+			_stats.Shapes = _stats.Culled = _stats.Regenerated = _stats.LineVertices = 0;
+		}
+		_stats.DrawCalls = (uint32_t)outFrame.Batches.size();
+
+		_stats.FrameTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void PhysicsDebugCache::Prepare(btCollisionWorld* world, const glm::mat4& viewProjection) {
+		_frame++;
+		_stats.Shapes = 0;
+		_stats.Culled = 0;
+		_stats.Regenerated = 0;
+
+		Frustum frustum = Frustum::FromViewProjection(viewProjection);
+		btIDebugDraw* drawer = world->getDebugDrawer();
+
+		const btCollisionObjectArray& objects = world->getCollisionObjectArray();
+		for (int ix = 0; ix < objects.size(); ix++) {
+			const btCollisionObject* object = objects[ix];
+			if ((object->getCollisionFlags() & btCollisionObject::CF_DISABLE_VISUALIZE_OBJECT) != 0 || object->getCollisionShape() == nullptr) {
+				continue;
+			}
+			_GatherShape(world, object->getCollisionShape(), object->getWorldTransform(), _GetObjectColor(object, drawer), frustum);
+		}
+
+		// Anything we didn't see has been removed from the world (or deleted, in which case it's pointer may be reused)
+		for (auto it = _shapes.begin(); it != _shapes.end();) {
+			if (it->second.LastSeenFrame != _frame) {
+				_isGeometryDirty |= it->second.HasGeometry;
+				it = _shapes.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		// Re-pack the wireframes of all our shapes if anything was added or removed
+		if (_isGeometryDirty) {
+			_vertices.clear();
+			for (auto& [shape, cached] : _shapes) {
+				if (cached.HasGeometry) {
+					cached.FirstVertex = (uint32_t)_vertices.size();
+					_vertices.insert(_vertices.end(), cached.Vertices.begin(), cached.Vertices.end());
+				}
+			}
+			_isGeometryDirty = false;
+			_isGeometryCaptured = false;
+		}
+
+		// Each shape with visible instances becomes a single instanced draw
+		_instances.clear();
+		_batches.clear();
+		_stats.LineVertices = 0;
+		for (auto& [shape, cached] : _shapes) {
+			if (cached.Instances.empty()) {
+				continue;
+			}
+			Batch batch;
+			batch.FirstVertex = cached.FirstVertex;
+			batch.VertexCount = (uint32_t)cached.Vertices.size();
+			batch.FirstInstance = (uint32_t)_instances.size();
+			batch.InstanceCount = (uint32_t)cached.Instances.size();
+			_instances.insert(_instances.end(), cached.Instances.begin(), cached.Instances.end());
+			cached.Instances.clear();
+
+			if (batch.VertexCount > 0) {
+				_batches.push_back(batch);
+				_stats.LineVertices += batch.VertexCount * batch.InstanceCount;
+			}
+		}
+		_stats.CachedShapes = (uint32_t)_shapes.size();
+	}
+
+	void PhysicsDebugCache::Render(const Frame& frame, const glm::mat4& viewProjection) {
+		if (_vao == nullptr && (frame.GeometryChanged || !frame.Batches.empty())) {
+			_InitGraphics();
+		}
+
+		// The geometry only changes when shapes do, so most frames only upload the instances
+		if (frame.GeometryChanged && !frame.Geometry.empty()) {
+			_vertexBuffer->LoadData(frame.Geometry.data(), frame.Geometry.size());
+		}
+
+		if (!frame.Batches.empty()) {
+			_instanceBuffer->LoadData(frame.Instances.data(), frame.Instances.size());
+
+			_shader->Bind();
+			_shader->SetUniformMatrix("u_ViewProjection", viewProjection);
+			_vao->Bind();
+			for (const Batch& batch : frame.Batches) {
+				glDrawArraysInstancedBaseInstance(GL_LINES, batch.FirstVertex, batch.VertexCount, batch.InstanceCount, batch.FirstInstance);
+			}
+		}
+
+		if (!frame.Lines.empty()) {
+			DebugDrawer& drawer = DebugDrawer::Get();
+			drawer.SetViewProjection(viewProjection);
+			for (size_t ix = 0; ix + 1 < frame.Lines.size(); ix += 2) {
+				const VertexPosCol& from = frame.Lines[ix];
+				const VertexPosCol& to = frame.Lines[ix + 1];
+				drawer.DrawLine(from.Position, to.Position, glm::vec3(from.Color), glm::vec3(to.Color));
+			}
+			drawer.FlushAll();
+		}
+	}
+
+	void PhysicsDebugCache::Clear() {
+		_shapes.clear();
+		_vertices.clear();
+		_instances.clear();
+		_batches.clear();
+		_isGeometryDirty = false;
+		_isGeometryCaptured = false;
+		_stats.CachedShapes = 0;
+	}
+
+	void PhysicsDebugCache::RenderImGui() {
+		ImGui::Checkbox("Cache Physics Wireframes", &_isEnabled);
+		ImGui::Text("Debug Capture: %.3f ms", _stats.FrameTimeMs);
+		if (_isEnabled) {
+			ImGui::Text("Shapes:     %u visible / %u (%u cached, %u regenerated)", _stats.Shapes - _stats.Culled, _stats.Shapes, _stats.CachedShapes, _stats.Regenerated);
+			ImGui::Text("Draws:      %u (%u line vertices)", _stats.DrawCalls, _stats.LineVertices);
+		}
+	}
+
+	void PhysicsDebugCache::_GatherShape(btCollisionWorld* world, const btCollisionShape* shape, const btTransform& transform, const glm::vec4& color, const Frustum& frustum) {
+		// Compound children are cached on their own, so changing one child doesn't re-tessellate the rest
+		if (shape->isCompound()) {
+			const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+			for (int ix = compound->getNumChildShapes() - 1; ix >= 0; ix--) {
+				_GatherShape(world, compound->getChildShape(ix), transform * compound->getChildTransform(ix), color, frustum);
+			}
+			return;
+		}
+
+		_stats.Shapes++;
+		ShapeSignature signature = _GetSignature(shape);
+		auto it = _shapes.find(shape);
+		if (it == _shapes.end() || it->second.Signature != signature) {
+			// Either a new shape, or one that has been resized (or a new shape that got the address of a deleted one)
+			CachedShape& cached = _shapes[shape];
+			_isGeometryDirty |= cached.HasGeometry;
+			cached.Signature = signature;
+			cached.Bounds = AABB(ToGlm(signature.AabbMin), ToGlm(signature.AabbMax));
+			cached.Vertices.clear();
+			cached.HasGeometry = false;
+			cached.FirstVertex = 0;
+			cached.Instances.clear();
+			it = _shapes.find(shape);
+		}
+		CachedShape& cached = it->second;
+		cached.LastSeenFrame = _frame;
+
+		glm::mat4 model;
+		transform.getOpenGLMatrix(&model[0][0]);
+		if (!frustum.Intersects(cached.Bounds.Transformed(model))) {
+			_stats.Culled++;
+			return;
+		}
+
+		// We don't tessellate shapes until we actually need to draw them
+		if (!cached.HasGeometry) {
+			_Tessellate(world, shape, cached);
+		}
+		cached.Instances.push_back({ model, color });
+	}
+
+	void PhysicsDebugCache::_Tessellate(btCollisionWorld* world, const btCollisionShape* shape, CachedShape& cached) {
+		// Have Bullet draw the shape at the origin into our capture drawer, so our wireframes are identical to Bullet's
+		CaptureDebugDraw capture(&cached.Vertices);
+		btIDebugDraw* drawer = world->getDebugDrawer();
+		world->setDebugDrawer(&capture);
+		btTransform identity;
+		identity.setIdentity();
+		world->debugDrawObject(identity, shape, btVector3(1.0f, 1.0f, 1.0f));
+		world->setDebugDrawer(drawer);
+
+		cached.HasGeometry = true;
+		_isGeometryDirty = true;
+		_stats.Regenerated++;
+	}
+
+	void PhysicsDebugCache::_InitGraphics() {
+		const char* vs_source = R"LIT(#version 450
+				layout (location = 0) in vec3 inPosition;
+				layout (location = 1) in vec4 inColor;
+				layout (location = 2) in mat4 inModel;
+				layout (location = 6) in vec4 inTint;
+
+				layout (location = 0) out vec4 outColor;
+
+				layout (location = 0) uniform mat4 u_ViewProjection;
+
+				void main() {
+					gl_Position = u_ViewProjection * inModel * vec4(inPosition, 1.0);
+					outColor = inColor * inTint;
+				}
+			)LIT";
+		const char* fs_source = R"LIT(#version 450
+				layout (location=0) in  vec4 inColor;
+				layout (location=0) out vec4 outColor;
+
+				void main() {
+					outColor = inColor;
+				}
+			)LIT";
+
+		_shader = Shader::Create();
+		_shader->LoadShaderPart(vs_source, ShaderPartType::Vertex);
+		_shader->LoadShaderPart(fs_source, ShaderPartType::Fragment);
+		_shader->Link();
+
+		_vertexBuffer = VertexBuffer::Create(BufferUsage::StaticDraw);
+		_instanceBuffer = VertexBuffer::Create(BufferUsage::StreamDraw);
+		_vao = VertexArrayObject::Create();
+		_vao->AddVertexBuffer(_vertexBuffer, VertexPosCol::V_DECL);
+		_vao->AddVertexBuffer(_instanceBuffer, INSTANCE_DECL, 1);
+	}
+
+	PhysicsDebugCache::ShapeSignature PhysicsDebugCache::_GetSignature(const btCollisionShape* shape) {
+		ShapeSignature result;
+		result.Type = shape->getShapeType();
+		result.Scaling = shape->getLocalScaling();
+		result.Margin = shape->getMargin();
+		btTransform identity;
+		identity.setIdentity();
+		shape->getAabb(identity, result.AabbMin, result.AabbMax);
+
+		// Meshes can have the same bounds with different triangles
+		result.MeshData = nullptr;
+		if (result.Type == CONVEX_TRIANGLEMESH_SHAPE_PROXYTYPE) {
+			result.MeshData = static_cast<const btConvexTriangleMeshShape*>(shape)->getMeshInterface();
+		} else if (result.Type == TRIANGLE_MESH_SHAPE_PROXYTYPE) {
+			result.MeshData = static_cast<const btTriangleMeshShape*>(shape)->getMeshInterface();
+		}
+		return result;
+	}
+
+	glm::vec4 PhysicsDebugCache::_GetObjectColor(const btCollisionObject* object, btIDebugDraw* drawer) {
+		// Matches the colors that btCollisionWorld::debugDrawWorld uses
+		btIDebugDraw::DefaultColors defaultColors = drawer != nullptr ? drawer->getDefaultColors() : btIDebugDraw::DefaultColors();
+		btVector3 color;
+		switch (object->getActivationState()) {
+			case ACTIVE_TAG:
+				color = defaultColors.m_activeObject;
+				break;
+			case ISLAND_SLEEPING:
+				color = defaultColors.m_deactivatedObject;
+				break;
+			case WANTS_DEACTIVATION:
+				color = defaultColors.m_wantsDeactivationObject;
+				break;
+			case DISABLE_DEACTIVATION:
+				color = defaultColors.m_disabledDeactivationObject;
+				break;
+			case DISABLE_SIMULATION:
+				color = defaultColors.m_disabledSimulationObject;
+				break;
+			default:
+				color = btVector3(0.3f, 0.3f, 0.3f);
+				break;
+		}
+		object->getCustomDebugColor(color);
+		return glm::vec4(ToGlm(color), 1.0f);
+	}
+}
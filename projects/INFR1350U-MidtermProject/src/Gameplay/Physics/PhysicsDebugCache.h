@@ -0,0 +1,214 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <btBulletCollisionCommon.h>
+
+#include "Graphics/Shader.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/BoundingVolumes.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Draws the wireframes of all the collision shapes in a physics world without going through
+	/// btCollisionWorld::debugDrawWorld, which re-tessellates every shape into individual drawLine
+	/// calls every frame
+	///
+	/// Each collision shape is tessellated once (using Bullet's own debugDrawObject, so the wireframes
+	/// match), and is only regenerated if the shape changes. Every frame we just cull each shape's
+	/// bounds against the camera, and draw the visible shapes as instances of their cached geometry
+	///
+	/// The simulation captures what to draw into a Frame, which goes to the renderer with the rest of
+	/// the frame's RenderPacket, so the physics world is never read while the render thread is drawing
+	/// </summary>
+	class PhysicsDebugCache {
+	public:
+		typedef std::shared_ptr<PhysicsDebugCache> Sptr;
+
+		static inline Sptr Create() {
+			return std::make_shared<PhysicsDebugCache>();
+		}
+
+		/// <summary>
+		/// The transform and color of a single visible collision shape, uploaded as per-instance vertex attributes
+		/// </summary>
+		struct Instance {
+			glm::mat4 Transform;
+			glm::vec4 Color;
+		};
+
+		/// <summary>
+		/// A single instanced draw, covering all the visible instances of one cached shape
+		/// </summary>
+		struct Batch {
+			uint32_t FirstVertex;
+			uint32_t VertexCount;
+			uint32_t FirstInstance;
+			uint32_t InstanceCount;
+		};
+
+		/// <summary>
+		/// Everything needed to draw the physics debug view for one frame, captured by the simulation and
+		/// drawn by Render on the thread that owns the GL context
+		/// </summary>
+		struct Frame {
+			// The wireframes of all cached shapes, only filled in when they have changed since the last capture
+			std::vector<VertexPosCol> Geometry;
+			bool                      GeometryChanged;
+			std::vector<Instance>     Instances;
+			std::vector<Batch>        Batches;
+			// Lines that Bullet drew itself in world space (ex: AABBs, or all the wireframes if the cache is disabled)
+			std::vector<VertexPosCol> Lines;
+
+			Frame();
+
+			/// <summary>
+			/// True if there is nothing to upload or draw
+			/// </summary>
+			bool IsEmpty() const { return !GeometryChanged && Batches.empty() && Lines.empty(); }
+			/// <summary>
+			/// Empties the frame, keeping it's memory
+			/// </summary>
+			void Clear();
+		};
+
+		struct Stats {
+			// The number of shapes that have cached wireframes
+			uint32_t CachedShapes;
+			// The number of leaf shapes in the world, and how many of them were outside the frustum
+			uint32_t Shapes;
+			uint32_t Culled;
+			// The number of shapes that were tessellated this frame
+			uint32_t Regenerated;
+			uint32_t DrawCalls;
+			// The number of line vertices that were drawn, across all instances
+			uint32_t LineVertices;
+			// Time spent capturing the physics world on the CPU, including the non-cached debug modes
+			float    FrameTimeMs;
+
+			Stats();
+		};
+
+		PhysicsDebugCache();
+		~PhysicsDebugCache();
+
+		PhysicsDebugCache(const PhysicsDebugCache& other) = delete;
+		PhysicsDebugCache(PhysicsDebugCache&& other) = delete;
+		PhysicsDebugCache& operator=(const PhysicsDebugCache& other) = delete;
+		PhysicsDebugCache& operator=(PhysicsDebugCache&& other) = delete;
+
+		/// <summary>
+		/// Sets whether the cache is used, when disabled we fall back to btCollisionWorld::debugDrawWorld
+		/// so that the two can be compared
+		/// </summary>
+		void SetEnabled(bool value) { _isEnabled = value; }
+		bool IsEnabled() const { return _isEnabled; }
+
+		/// <summary>
+		/// Captures what to draw for the physics world with it's current debug mode. Wireframes go through the
+		/// cache if it is enabled, anything else (AABBs, contact points, constraints) is still drawn by Bullet,
+		/// into the frame's lines. Does not touch OpenGL
+		/// </summary>
+		/// <param name="world">The world to capture, it's debug drawer sets the debug mode</param>
+		/// <param name="viewProjection">The camera's view projection matrix, used for culling</param>
+		/// <param name="outFrame">Receives everything that needs to be drawn</param>
+		void Capture(btCollisionWorld* world, const glm::mat4& viewProjection, Frame& outFrame);
+
+		/// <summary>
+		/// Gathers the visible collision shapes in the world into batches, tessellating any shapes
+		/// that are new or have changed. Does not touch OpenGL
+		/// </summary>
+		/// <param name="world">The world to gather shapes from</param>
+		/// <param name="viewProjection">The camera's view projection matrix, used for culling</param>
+		void Prepare(btCollisionWorld* world, const glm::mat4& viewProjection);
+		/// <summary>
+		/// Uploads and draws a frame from Capture, must be called on the thread that owns the GL context.
+		/// Frames must be rendered in the order they were captured, since geometry is only sent when it changes
+		/// </summary>
+		/// <param name="frame">The frame to draw</param>
+		/// <param name="viewProjection">The camera's view projection matrix</param>
+		void Render(const Frame& frame, const glm::mat4& viewProjection);
+
+		/// <summary>
+		/// Drops all cached geometry, it will be regenerated the next time it is needed
+		/// </summary>
+		void Clear();
+
+		const std::vector<Batch>& GetBatches() const { return _batches; }
+		const std::vector<Instance>& GetInstances() const { return _instances; }
+		const Stats& GetStats() const { return _stats; }
+
+		/// <summary>
+		/// Draws the cache toggle and stats to the current ImGui window
+		/// </summary>
+		void RenderImGui();
+
+	protected:
+		// The things about a shape that change it's wireframe, if any of these change we need to re-tessellate
+		struct ShapeSignature {
+			int         Type;
+			btVector3   Scaling;
+			btVector3   AabbMin;
+			btVector3   AabbMax;
+			btScalar    Margin;
+			const void* MeshData;
+
+			bool operator==(const ShapeSignature& other) const;
+			bool operator!=(const ShapeSignature& other) const { return !(*this == other); }
+		};
+
+		struct CachedShape {
+			ShapeSignature Signature;
+			// The local space bounds of the shape, used for culling
+			AABB           Bounds;
+			// The tessellated wireframe, empty until the shape is first visible
+			std::vector<VertexPosCol> Vertices;
+			bool           HasGeometry;
+			// Where the shape's vertices are in our combined vertex buffer
+			uint32_t       FirstVertex;
+			// The visible instances of this shape for the current frame
+			std::vector<Instance> Instances;
+			// Used to drop shapes that are no longer in the world
+			uint32_t       LastSeenFrame;
+		};
+
+		bool _isEnabled;
+		uint32_t _frame;
+		Stats _stats;
+
+		std::unordered_map<const btCollisionShape*, CachedShape> _shapes;
+
+		// The wireframes of all cached shapes, rebuilt whenever a shape is added, changed, or removed
+		std::vector<VertexPosCol> _vertices;
+		bool                      _isGeometryDirty;
+		// True once the current wireframes have gone out in a captured frame
+		bool                      _isGeometryCaptured;
+
+		std::vector<Instance> _instances;
+		std::vector<Batch>    _batches;
+
+		// Only used by Render, so the simulation can capture the next frame while we draw
+		VertexBuffer::Sptr      _vertexBuffer;
+		VertexBuffer::Sptr      _instanceBuffer;
+		VertexArrayObject::Sptr _vao;
+		Shader::Sptr            _shader;
+
+		/// <summary>
+		/// Gathers an instance of the given shape, recursing into the children of compound shapes
+		/// </summary>
+		void _GatherShape(btCollisionWorld* world, const btCollisionShape* shape, const btTransform& transform, const glm::vec4& color, const Frustum& frustum);
+		/// <summary>
+		/// Tessellates a shape's wireframe by capturing the lines that Bullet draws for it
+		/// </summary>
+		void _Tessellate(btCollisionWorld* world, const btCollisionShape* shape, CachedShape& cached);
+		/// <summary>
+		/// Creates the shader, buffers and VAO, called the first time there's something to render
+		/// </summary>
+		void _InitGraphics();
+
+		static ShapeSignature _GetSignature(const btCollisionShape* shape);
+		static glm::vec4 _GetObjectColor(const btCollisionObject* object, btIDebugDraw* drawer);
+	};
+}
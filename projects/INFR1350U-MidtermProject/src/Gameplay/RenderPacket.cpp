@@ -0,0 +1,36 @@
+#include "Gameplay/RenderPacket.h"
+
+namespace Gameplay {
+	RenderPacket::RenderPacket() :
+		Frame(0),
+		SourceScene(nullptr),
+		View(glm::mat4(1.0f)),
+		Projection(glm::mat4(1.0f)),
+		ViewProjection(glm::mat4(1.0f)),
+		CameraPosition(glm::vec3(0.0f)),
+		NearPlane(0.0f),
+		FarPlane(0.0f),
+		AmbientLight(glm::vec3(0.0f)),
+		Lights(std::vector<Light>()),
+		Items(std::vector<DrawItem>()),
+		StaticBatches(0),
+		BaseShader(nullptr),
+		IndirectShader(nullptr),
+		PhysicsDebug(),
+		Commands(std::vector<std::function<void()>>()),
+		UiDrawData(),
+		SimStart(Clock::now()),
+		Submitted(Clock::now())
+	{ }
+
+	void RenderPacket::Reset() {
+		SourceScene = nullptr;
+		Lights.clear();
+		Items.clear();
+		StaticBatches = 0;
+		BaseShader = nullptr;
+		IndirectShader = nullptr;
+		PhysicsDebug.Clear();
+		Commands.clear();
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/Scene.h"
+#include "Gameplay/Light.h"
+#include "Gameplay/Material.h"
+#include "Graphics/Shader.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/BoundingVolumes.h"
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// A single mesh to be drawn, either from a render component or a static batch
+	/// </summary>
+	struct DrawItem {
+		// The render component or batch that the item was made from, used to detect changes in the item list
+		const void*        Source;
+		VertexArrayObject* Mesh;
+		// The view space depth of the item's bounds, used for front-to-back sorting
+		float              Depth;
+		Material*          ItemMaterial;
+		glm::mat4          Transform;
+		// The bounds of the mesh in world space
+		MeshBounds         Bounds;
+	};
+
+	/// <summary>
+	/// Everything the renderer needs to draw a single frame, captured from the scene at the end of the
+	/// simulation's update. The renderer only reads from a packet once it's been submitted, so the
+	/// simulation can move on to it's next frame while this one is being drawn
+	/// </summary>
+	struct RenderPacket {
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// The index of the frame that the packet was built for
+		uint64_t    Frame;
+		// Keeps the scene (and the meshes and materials our items point into) alive until we've been drawn
+		Scene::Sptr SourceScene;
+
+		glm::mat4   View;
+		glm::mat4   Projection;
+		glm::mat4   ViewProjection;
+		glm::vec3   CameraPosition;
+		float       NearPlane;
+		float       FarPlane;
+
+		glm::vec3          AmbientLight;
+		std::vector<Light> Lights;
+
+		std::vector<DrawItem> Items;
+		uint32_t              StaticBatches;
+		Shader::Sptr          BaseShader;
+		Shader::Sptr          IndirectShader;
+
+		// The physics debug view, empty unless physics debug drawing is on
+		Physics::PhysicsDebugCache::Frame PhysicsDebug;
+
+		// GL work that the simulation queued up while building the packet (ex: setting uniforms), these
+		// are run in order before anything is drawn
+		std::vector<std::function<void()>> Commands;
+
+		ImGuiDrawSnapshot UiDrawData;
+
+		// When the simulation started working on the frame, and when it handed the packet over
+		Clock::time_point SimStart;
+		Clock::time_point Submitted;
+
+		RenderPacket();
+
+		/// <summary>
+		/// Clears the packet so it can be filled for another frame, keeping it's memory. Releases the scene
+		/// and any resources held by the commands, so should be called on the thread that owns the GL context
+		/// </summary>
+		void Reset();
+	};
+}
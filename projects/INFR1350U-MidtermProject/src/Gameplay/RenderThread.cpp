@@ -0,0 +1,232 @@
+#include "Gameplay/RenderThread.h"
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay {
+	// Set on the render thread, so we can tell when we're already on it
+	static thread_local bool IsOnRenderThread = false;
+
+	std::thread             RenderThread::_thread;
+	std::mutex              RenderThread::_mutex;
+	std::condition_variable RenderThread::_signal;
+	bool                    RenderThread::_isRunning = false;
+	bool                    RenderThread::_stopRequested = false;
+
+	GLFWwindow*                  RenderThread::_window = nullptr;
+	RenderThread::BeginFrameFunc RenderThread::_beginFrame;
+	RenderThread::RenderFunc     RenderThread::_render;
+
+	RenderPacket  RenderThread::_packets[2];
+	uint32_t      RenderThread::_writeIndex = 0;
+	RenderPacket* RenderThread::_pending = nullptr;
+	RenderPacket* RenderThread::_drawing = nullptr;
+	const std::function<void()>* RenderThread::_execute = nullptr;
+
+	std::atomic<float>        RenderThread::_lastWaitMs(0.0f);
+	RenderThread::FrameTiming RenderThread::_history[RenderThread::HISTORY_SIZE];
+	uint32_t                  RenderThread::_historyHead = 0;
+	uint64_t                  RenderThread::_framesRendered = 0;
+
+	RenderThread::FrameStats::FrameStats() :
+		SimMs(0.0f),
+		WaitMs(0.0f),
+		RenderMs(0.0f),
+		LatencyMs(0.0f),
+		MaxLatencyMs(0.0f),
+		FramesRendered(0),
+		Samples(0)
+	{ }
+
+	void RenderThread::Start(GLFWwindow* window, const BeginFrameFunc& beginFrame, const RenderFunc& render) {
+		LOG_ASSERT(!_isRunning, "The render thread has already been started!");
+
+		_window = window;
+		_beginFrame = beginFrame;
+		_render = render;
+		_stopRequested = false;
+		_pending = nullptr;
+		_drawing = nullptr;
+		_execute = nullptr;
+		_writeIndex = 0;
+		_historyHead = 0;
+		_framesRendered = 0;
+		_packets[_writeIndex].SimStart = Clock::now();
+
+		// A context can only be current on one thread at a time
+		glfwMakeContextCurrent(nullptr);
+		_isRunning = true;
+		_thread = std::thread(_Run);
+
+		LOG_INFO("Started render thread");
+	}
+
+	void RenderThread::Stop() {
+		if (!_isRunning) {
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopRequested = true;
+		}
+		_signal.notify_all();
+		_thread.join();
+		_isRunning = false;
+
+		// Anything we were writing will never be drawn
+		_packets[_writeIndex].Reset();
+		glfwMakeContextCurrent(_window);
+
+		LOG_INFO("Stopped render thread after {} frames", _framesRendered);
+	}
+
+	bool RenderThread::IsRenderThread() {
+		return IsOnRenderThread;
+	}
+
+	RenderPacket& RenderThread::GetWritePacket() {
+		return _packets[_writeIndex];
+	}
+
+	void RenderThread::Submit() {
+		LOG_ASSERT(_isRunning, "Submit can only be used while the render thread is running");
+
+		RenderPacket& packet = _packets[_writeIndex];
+		Clock::time_point waitStart = Clock::now();
+		packet.Submitted = waitStart;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			// The render thread may not have picked up our last packet yet
+			_signal.wait(lock, []() { return _pending == nullptr; });
+			_pending = &packet;
+			_writeIndex ^= 1;
+			_signal.notify_all();
+
+			// Our next packet is the one that was submitted before this one, wait until it's been drawn
+			_signal.wait(lock, []() { return _drawing != &_packets[_writeIndex]; });
+		}
+		Clock::time_point now = Clock::now();
+		_lastWaitMs = std::chrono::duration<float, std::milli>(now - waitStart).count();
+		_packets[_writeIndex].SimStart = now;
+	}
+
+	void RenderThread::Enqueue(std::function<void()>&& command) {
+		if (!_isRunning || IsRenderThread()) {
+			command();
+		} else {
+			_packets[_writeIndex].Commands.push_back(std::move(command));
+		}
+	}
+
+	void RenderThread::Execute(const std::function<void()>& func) {
+		if (!_isRunning || IsRenderThread()) {
+			func();
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_execute = &func;
+		_signal.notify_all();
+		_signal.wait(lock, []() { return _execute == nullptr; });
+	}
+
+	RenderThread::FrameStats RenderThread::GetStats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		FrameStats result;
+		result.FramesRendered = _framesRendered;
+		result.Samples = (uint32_t)glm::min(_framesRendered, (uint64_t)HISTORY_SIZE);
+		for (uint32_t ix = 0; ix < result.Samples; ix++) {
+			const FrameTiming& timing = _history[ix];
+			result.SimMs += timing.SimMs;
+			result.WaitMs += timing.WaitMs;
+			result.RenderMs += timing.RenderMs;
+			result.LatencyMs += timing.LatencyMs;
+			result.MaxLatencyMs = glm::max(result.MaxLatencyMs, timing.LatencyMs);
+		}
+		if (result.Samples > 0) {
+			float scale = 1.0f / result.Samples;
+			result.SimMs *= scale;
+			result.WaitMs *= scale;
+			result.RenderMs *= scale;
+			result.LatencyMs *= scale;
+		}
+		return result;
+	}
+
+	void RenderThread::RenderImGui() {
+		if (!_isRunning) {
+			ImGui::TextDisabled("Not running (start with --render-thread)");
+			return;
+		}
+		FrameStats stats = GetStats();
+		ImGui::Text("Simulation: %.3f ms (%.3f ms waiting on render)", stats.SimMs, stats.WaitMs);
+		ImGui::Text("Render:     %.3f ms", stats.RenderMs);
+		ImGui::Text("Latency:    %.3f ms avg, %.3f ms max", stats.LatencyMs, stats.MaxLatencyMs);
+		ImGui::Text("Frames:     %llu", (unsigned long long)stats.FramesRendered);
+	}
+
+	void RenderThread::_Run() {
+		IsOnRenderThread = true;
+		glfwMakeContextCurrent(_window);
+
+		_beginFrame();
+		while (true) {
+			RenderPacket* packet = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_signal.wait(lock, []() { return _pending != nullptr || _execute != nullptr || _stopRequested; });
+
+				// Packets come first, work from Execute belongs to the frame that the simulation is building,
+				// which comes after any packet that has already been submitted
+				if (_pending != nullptr) {
+					packet = _pending;
+					_pending = nullptr;
+					_drawing = packet;
+					_signal.notify_all();
+				} else if (_execute != nullptr) {
+					// The simulation is blocked until we're done, so we don't need the lock while we run it
+					lock.unlock();
+					(*_execute)();
+					lock.lock();
+					_execute = nullptr;
+					_signal.notify_all();
+					continue;
+				} else {
+					break;
+				}
+			}
+
+			Clock::time_point renderStart = Clock::now();
+			for (auto& command : packet->Commands) {
+				command();
+			}
+			_render(*packet);
+			Clock::time_point renderEnd = Clock::now();
+
+			FrameTiming timing;
+			timing.SimMs = std::chrono::duration<float, std::milli>(packet->Submitted - packet->SimStart).count();
+			timing.WaitMs = _lastWaitMs;
+			timing.RenderMs = std::chrono::duration<float, std::milli>(renderEnd - renderStart).count();
+			timing.LatencyMs = std::chrono::duration<float, std::milli>(renderEnd - packet->SimStart).count();
+
+			// Release the scene and anything the commands were holding while we still have the context
+			packet->Reset();
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_history[_historyHead] = timing;
+				_historyHead = (_historyHead + 1) % HISTORY_SIZE;
+				_framesRendered++;
+				_drawing = nullptr;
+			}
+			_signal.notify_all();
+
+			_beginFrame();
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+}
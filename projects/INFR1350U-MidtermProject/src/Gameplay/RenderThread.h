@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Gameplay/RenderPacket.h"
+
+struct GLFWwindow;
+
+namespace Gameplay {
+	/// <summary>
+	/// Runs all of our GL submission on a dedicated thread that owns the context, so the simulation for
+	/// frame N+1 can run while frame N is being drawn
+	///
+	/// The simulation fills in a render packet each frame and submits it. Packets are double buffered,
+	/// so the simulation can only ever be one frame ahead of the renderer. Anything else that needs GL
+	/// goes through Enqueue (deferred until the packet is drawn) or Execute (blocks the simulation until
+	/// the render thread is between frames, for work that reads simulation state). When the render thread
+	/// is not running, both of these just run the function right away, so the same code works either way
+	///
+	/// Usage:
+	///     RenderThread::Start(window, beginFrame, renderFrame);
+	///     while (running) {
+	///         RenderPacket& packet = RenderThread::GetWritePacket();
+	///         ... update the simulation, fill in the packet ...
+	///         RenderThread::Submit();
+	///     }
+	///     RenderThread::Stop();
+	/// </summary>
+	class RenderThread {
+	public:
+		// The number of frames that the timing stats are averaged over
+		static const uint32_t HISTORY_SIZE = 120;
+
+		/// <summary>
+		/// Called on the render thread to set up a new frame (ex: clearing the back buffer), before any
+		/// work from Execute or the next packet
+		/// </summary>
+		typedef std::function<void()> BeginFrameFunc;
+		/// <summary>
+		/// Called on the render thread to draw and present a packet
+		/// </summary>
+		typedef std::function<void(RenderPacket&)> RenderFunc;
+
+		/// <summary>
+		/// Timing for the pipeline, averaged over the last HISTORY_SIZE frames, all times are in milliseconds
+		/// </summary>
+		struct FrameStats {
+			// Time the simulation spent building a frame, before submitting it
+			float    SimMs;
+			// Time the simulation spent blocked waiting for the render thread
+			float    WaitMs;
+			// Time the render thread spent drawing and presenting a packet
+			float    RenderMs;
+			// Time from the simulation starting a frame to that frame being presented
+			float    LatencyMs;
+			float    MaxLatencyMs;
+			uint64_t FramesRendered;
+			// The number of frames that the stats were calculated from
+			uint32_t Samples;
+
+			FrameStats();
+		};
+
+		RenderThread() = delete;
+
+		/// <summary>
+		/// Hands our GL context over to a new render thread, must be called from the thread that currently
+		/// has the context current
+		/// </summary>
+		/// <param name="window">The window that owns the context</param>
+		/// <param name="beginFrame">Sets up the back buffer for a new frame</param>
+		/// <param name="render">Draws a packet and presents it</param>
+		static void Start(GLFWwindow* window, const BeginFrameFunc& beginFrame, const RenderFunc& render);
+		/// <summary>
+		/// Draws any packet that has already been submitted, stops the render thread, and makes the
+		/// context current on the calling thread again
+		/// </summary>
+		static void Stop();
+
+		static bool IsRunning() { return _isRunning; }
+		/// <summary>
+		/// Returns true if called from the render thread
+		/// </summary>
+		static bool IsRenderThread();
+
+		/// <summary>
+		/// Gets the packet that the simulation should be filling in for the current frame. This stays the
+		/// same until the next call to Submit
+		/// </summary>
+		static RenderPacket& GetWritePacket();
+		/// <summary>
+		/// Hands the current packet over to the render thread. Blocks if the render thread is still
+		/// drawing the packet that we will be writing to next
+		/// </summary>
+		static void Submit();
+
+		/// <summary>
+		/// Queues up some GL work to be done on the render thread before the current packet is drawn.
+		/// Anything the command uses must be captured by value, since the simulation will have moved on
+		/// by the time it runs
+		/// </summary>
+		static void Enqueue(std::function<void()>&& command);
+		/// <summary>
+		/// Runs some GL work on the render thread as soon as it has finished it's current frame, and waits
+		/// for it to complete. Since the simulation is paused, the function can safely read and modify
+		/// simulation state, but it stalls the pipeline so should only be used for rare or debug work
+		/// </summary>
+		static void Execute(const std::function<void()>& func);
+
+		static FrameStats GetStats();
+
+		/// <summary>
+		/// Draws the pipeline timings to the current ImGui window
+		/// </summary>
+		static void RenderImGui();
+
+	protected:
+		typedef RenderPacket::Clock Clock;
+
+		struct FrameTiming {
+			float SimMs;
+			float WaitMs;
+			float RenderMs;
+			float LatencyMs;
+		};
+
+		static std::thread             _thread;
+		static std::mutex              _mutex;
+		static std::condition_variable _signal;
+		static bool                    _isRunning;
+		static bool                    _stopRequested;
+
+		static GLFWwindow*    _window;
+		static BeginFrameFunc _beginFrame;
+		static RenderFunc     _render;
+
+		static RenderPacket  _packets[2];
+		// The packet the simulation is writing to
+		static uint32_t      _writeIndex;
+		// The packet that has been submitted but not picked up by the render thread
+		static RenderPacket* _pending;
+		// The packet that the render thread is currently drawing
+		static RenderPacket* _drawing;
+		// Work from Execute that is waiting for the render thread
+		static const std::function<void()>* _execute;
+
+		// Time the simulation spent blocked in it's last call to Submit
+		static std::atomic<float> _lastWaitMs;
+		static FrameTiming _history[HISTORY_SIZE];
+		static uint32_t    _historyHead;
+		static uint64_t    _framesRendered;
+
+		/// <summary>
+		/// The main loop for the render thread
+		/// </summary>
+		static void _Run();
+	};
+}
@@ -9,6 +9,8 @@
 #include "Gameplay/Physics/TriggerVolume.h"
 
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GeometryArena.h"
+#include "Gameplay/RenderThread.h"
 
 namespace Gameplay {
 	Scene::Scene() :
@@ -17,12 +19,14 @@ namespace Gameplay {
 		IsPlaying(false),
 		MainCamera(nullptr),
 		BaseShader(nullptr),
+		_indirectShader(nullptr),
 		_isAwake(false),
 		_filePath(""),
 		_ambientLight(glm::vec3(0.1f)),
 		_gravity(glm::vec3(0.0f, 0.0f, -9.81f))
 	{
 		_InitPhysics();
+		_staticBatcher = std::make_unique<StaticBatcher>(this);
 	}
 
 	Scene::~Scene() {
@@ -59,7 +63,7 @@ namespace Gameplay {
 
 	void Scene::SetAmbientLight(const glm::vec3& value) {
 		_ambientLight = value;
-		BaseShader->SetUniform("u_AmbientCol", glm::vec3(0.1f));
+		_SetLightingUniform("u_AmbientCol", glm::vec3(0.1f));
 	}
 
 	const glm::vec3& Scene::GetAmbientLight() const { 
@@ -77,9 +81,20 @@ namespace Gameplay {
 		for (auto& obj : Objects) {
 			obj->Awake();
 		}
+		// If we can use multi-draw indirect, we need a version of our shader that gets it's transforms from the draw ID
+		if (BaseShader != nullptr && GeometryArena::IsIndirectSupported()) {
+			_indirectShader = BaseShader->CreateVariant(ShaderPartType::Vertex, "shaders/vertex_shader_indirect.glsl");
+			if (_indirectShader == nullptr) {
+				LOG_WARN("Failed to create indirect variant of the base shader, falling back to individual draws");
+			}
+		}
+
 		// Set up our lighting 
 		SetupShaderAndLights();
 
+		// Merge all our static objects now that everything is loaded
+		_staticBatcher->Build();
+
 		_isAwake = true;
 	}
 
@@ -101,12 +116,17 @@ namespace Gameplay {
 				body->PhysicsPostStep(dt);
 			});
 			if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
-				_physicsWorld->debugDrawWorld();
-				DebugDrawer::Get().FlushAll();
+				// We only read the physics world here, the renderer draws what we capture with the rest of the frame
+				_physicsDebugCache->Capture(_physicsWorld, MainCamera->GetViewProjection(), _physicsDebugFrame);
 			}
 		}
 	}
 
+	void Scene::TakePhysicsDebugFrame(Physics::PhysicsDebugCache::Frame& frame) {
+		std::swap(frame, _physicsDebugFrame);
+		_physicsDebugFrame.Clear();
+	}
+
 	void Scene::Update(float dt) {
 		if (IsPlaying) {
 			for (auto& obj : Objects) {
@@ -115,24 +135,12 @@ namespace Gameplay {
 		}
 	}
 
-	void Scene::SetShaderLight(int index, bool update /*= true*/) {
-		std::stringstream stream;
-		stream << "u_Lights[" << index << "]";
-		std::string name = stream.str();
-
-		Light& light = Lights[index];
-	
-		// Set the shader uniforms for the light
-		BaseShader->SetUniform(name + ".Position", light.Position);
-		BaseShader->SetUniform(name + ".Color", light.Color);
-		BaseShader->SetUniform(name + ".Attenuation", 1.0f / (1.0f + light.Range));
+	void Scene::_EnqueueGlCommand(std::function<void()>&& command) {
+		RenderThread::Enqueue(std::move(command));
 	}
 
 	void Scene::SetupShaderAndLights() {
-		BaseShader->SetUniform("u_NumLights", (int)Lights.size());
-		for (int ix = 0; ix < Lights.size(); ix++) {
-			SetShaderLight(ix, true);
-		}
+		_SetLightingUniform("u_AmbientCol", _ambientLight);
 	}
 
 	btDynamicsWorld* Scene::GetPhysicsWorld() const {
@@ -233,6 +241,7 @@ namespace Gameplay {
 		_bulletDebugDraw = new BulletDebugDraw();
 		_physicsWorld->setDebugDrawer(_bulletDebugDraw);
 		_bulletDebugDraw->setDebugMode(btIDebugDraw::DBG_NoDebug);
+		_physicsDebugCache = Physics::PhysicsDebugCache::Create();
 	}
 
 	void Scene::_CleanupPhysics() {
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <btBulletDynamicsCommon.h>
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 
@@ -6,6 +7,8 @@
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Light.h"
 #include "Physics/BulletDebugDraw.h"
+#include "Physics/PhysicsDebugCache.h"
+#include "Gameplay/StaticBatcher.h"
 
 struct GLFWwindow;
 
@@ -23,7 +26,8 @@ namespace Gameplay {
 	public:
 		typedef std::shared_ptr<Scene> Sptr;
 
-		static const int MAX_LIGHTS = 8;
+		// Lights are binned into clusters by the SceneRenderer, so the shader no longer limits how many we can have
+		static const int MAX_LIGHTS = 1024;
 
 		// Stores all the lights in our scene
 		std::vector<Light>         Lights;
@@ -111,15 +115,8 @@ namespace Gameplay {
 		void Update(float dt);
 
 		/// <summary>
-		/// Handles setting the shader uniforms for our light structure in our array of lights
-		/// </summary>
-		/// <param name="shader">The pointer to the shader</param>
-		/// <param name="uniformName">The name of the uniform (ex: u_Lights)</param>
-		/// <param name="index">The index of the light to set</param>
-		/// <param name="light">The light data to copy over</param>
-		void SetShaderLight(int index, bool update = true);
-		/// <summary>
-		/// Creates the shader and sets up all the lights
+		/// Sets up the lighting uniforms that are shared by the whole scene, the lights themselves
+		/// are uploaded by the SceneRenderer every frame
 		/// </summary>
 		void SetupShaderAndLights();
 
@@ -133,6 +130,28 @@ namespace Gameplay {
 		/// </summary>
 		btDynamicsWorld* GetPhysicsWorld() const;
 
+		/// <summary>
+		/// Gets the batcher that merges the static objects in this scene
+		/// </summary>
+		StaticBatcher* GetStaticBatcher() const { return _staticBatcher.get(); }
+
+		/// <summary>
+		/// Gets the cache that draws the wireframes of our physics shapes when physics debug drawing is on
+		/// </summary>
+		const Physics::PhysicsDebugCache::Sptr& GetPhysicsDebugCache() const { return _physicsDebugCache; }
+		/// <summary>
+		/// Hands over the physics debug view captured by the last DoPhysics, swapping it with the given frame
+		/// so that both keep their memory
+		/// </summary>
+		/// <param name="frame">The frame to fill, will be cleared if nothing was captured</param>
+		void TakePhysicsDebugFrame(Physics::PhysicsDebugCache::Frame& frame);
+
+		/// <summary>
+		/// Gets the variant of BaseShader that reads per-draw data from a storage buffer, for use with
+		/// multi-draw indirect. Will be nullptr before Awake, or if the driver does not support it
+		/// </summary>
+		const Shader::Sptr& GetIndirectShader() const { return _indirectShader; }
+
 		/// <summary>
 		/// Loads a scene from a JSON blob
 		/// </summary>
@@ -173,6 +192,15 @@ namespace Gameplay {
 		btGhostPairCallback*      _ghostCallback;
 
 		BulletDebugDraw* _bulletDebugDraw;
+		// Caches the wireframes for debug drawing, so we don't re-tessellate every shape each frame
+		Physics::PhysicsDebugCache::Sptr _physicsDebugCache;
+		// What DoPhysics captured for the physics debug view, waiting to be put in a RenderPacket
+		Physics::PhysicsDebugCache::Frame _physicsDebugFrame;
+
+		// Merges static objects that share materials, built on Awake
+		StaticBatcher::Uptr _staticBatcher;
+		// BaseShader with the vertex stage swapped out for multi-draw indirect, created on Awake
+		Shader::Sptr        _indirectShader;
 
 		// The path that we've saved or loaded this scene from
 		std::string             _filePath;
@@ -186,6 +214,26 @@ namespace Gameplay {
 
 		bool                       _isAwake;
 
+		/// <summary>
+		/// Sets a lighting uniform on all of the shaders that the scene manages
+		/// </summary>
+		template <typename T>
+		void _SetLightingUniform(const std::string& name, const T& value) {
+			// The GL context may belong to the render thread, so the command can't reference the scene
+			Shader::Sptr baseShader = BaseShader;
+			Shader::Sptr indirectShader = _indirectShader;
+			_EnqueueGlCommand([=]() {
+				baseShader->SetUniform(name, value);
+				if (indirectShader != nullptr) {
+					indirectShader->SetUniform(name, value);
+				}
+			});
+		}
+		/// <summary>
+		/// Runs a command on the thread that owns the GL context, see RenderThread::Enqueue
+		/// </summary>
+		void _EnqueueGlCommand(std::function<void()>&& command);
+
 		/// <summary>
 		/// Handles configuring our bullet physics stuff
 		/// </summary>
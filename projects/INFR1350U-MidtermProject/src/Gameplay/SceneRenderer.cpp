@@ -0,0 +1,663 @@
+#include "Gameplay/SceneRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+#include "Gameplay/Components/ComponentManager.h"
+#include "Gameplay/Components/RenderComponent.h"
+#include "Gameplay/RenderThread.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/VertexPacking.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay {
+	SceneRenderer::Options SceneRenderer::_options = SceneRenderer::Options();
+	SceneRenderer::FrameStats SceneRenderer::_lastStats = SceneRenderer::FrameStats();
+
+	RenderPacket                         SceneRenderer::_immediatePacket;
+	std::vector<DrawItem>                SceneRenderer::_items;
+	std::vector<BoundingSphere>          SceneRenderer::_spheres;
+	std::vector<AABB>                    SceneRenderer::_boxes;
+	std::vector<uint8_t>                 SceneRenderer::_visibility;
+	std::vector<uint32_t>                SceneRenderer::_bvhResults;
+	std::vector<const void*>             SceneRenderer::_bvhSources;
+	Bvh                                  SceneRenderer::_bvh;
+
+	std::vector<uint32_t>                    SceneRenderer::_indirectItems;
+	std::vector<SceneRenderer::IndirectDrawData> SceneRenderer::_drawData;
+	std::vector<DrawElementsIndirectCommand> SceneRenderer::_commands;
+	ShaderStorageBuffer::Sptr                SceneRenderer::_drawDataBuffer = nullptr;
+	DrawIndirectBuffer::Sptr                 SceneRenderer::_commandBuffer = nullptr;
+
+	LightGrid                                SceneRenderer::_lightGrid;
+	ThreadPool::Sptr                         SceneRenderer::_lightBinPool = nullptr;
+	std::vector<BoundingSphere>              SceneRenderer::_lightSpheres;
+	std::vector<SceneRenderer::ClusterLight> SceneRenderer::_clusterLights;
+	ShaderStorageBuffer::Sptr                SceneRenderer::_lightBuffer = nullptr;
+	ShaderStorageBuffer::Sptr                SceneRenderer::_clusterBuffer = nullptr;
+	ShaderStorageBuffer::Sptr                SceneRenderer::_lightIndexBuffer = nullptr;
+	glm::vec2                                SceneRenderer::_clusterTileSize = glm::vec2(1.0f);
+
+	std::vector<uint32_t>                    SceneRenderer::_drawOrder;
+	Shader::Sptr                             SceneRenderer::_depthShader = nullptr;
+	Shader::Sptr                             SceneRenderer::_depthIndirectShader = nullptr;
+	bool                                     SceneRenderer::_depthShadersBuilt = false;
+
+	GLuint     SceneRenderer::_sampleQueries[SceneRenderer::SAMPLE_QUERY_COUNT] = { 0 };
+	bool       SceneRenderer::_sampleQueryPending[SceneRenderer::SAMPLE_QUERY_COUNT] = { false };
+	bool       SceneRenderer::_sampleQueryPrepass[SceneRenderer::SAMPLE_QUERY_COUNT] = { false };
+	uint32_t   SceneRenderer::_sampleQueryIndex = 0;
+	uint64_t   SceneRenderer::_shadedSamples[2] = { 0, 0 };
+	glm::ivec2 SceneRenderer::_sampleViewport = glm::ivec2(0);
+
+	// The size of the cluster grid, 16x9 tiles matches most widescreen resolutions
+	static const uint32_t CLUSTER_TILES_X = 16;
+	static const uint32_t CLUSTER_TILES_Y = 9;
+	static const uint32_t CLUSTER_SLICES  = 24;
+
+	SceneRenderer::Options::Options() :
+		EnableCulling(true),
+		UseSimd(true),
+		BvhThreshold(1024),
+		UseIndirect(true),
+		LightBinThreads(glm::max(std::thread::hardware_concurrency(), 1u)),
+		LightBinSimd(true),
+		DepthPrepass(false),
+		SortFrontToBack(true),
+		CountSamples(true)
+	{ }
+
+	SceneRenderer::FrameStats::FrameStats() :
+		Submitted(0),
+		Visible(0),
+		Batches(0),
+		UsedBvh(false),
+		CullTimeMs(0.0f),
+		DrawCalls(0),
+		IndirectDraws(0),
+		LightBinTimeMs(0.0f),
+		LightReferences(0),
+		LightBinThreadsUsed(0),
+		UsedPrepass(false),
+		PrepassDrawCalls(0)
+	{ }
+
+	void SceneRenderer::Render(const Scene::Sptr& scene) {
+		_immediatePacket.Reset();
+		Gather(scene, _immediatePacket);
+		Render(_immediatePacket);
+		// Don't hold on to the scene between frames
+		_immediatePacket.Reset();
+	}
+
+	void SceneRenderer::Gather(const Scene::Sptr& scene, RenderPacket& packet) {
+		Camera::Sptr camera = scene->MainCamera;
+
+		packet.SourceScene    = scene;
+		packet.View           = camera->GetView();
+		packet.Projection     = camera->GetProjection();
+		packet.ViewProjection = camera->GetViewProjection();
+		packet.CameraPosition = camera->GetGameObject()->GetPosition();
+		packet.NearPlane      = camera->GetNearPlane();
+		packet.FarPlane       = camera->GetFarPlane();
+
+		packet.AmbientLight = scene->GetAmbientLight();
+		packet.Lights       = scene->Lights;
+
+		packet.BaseShader     = scene->BaseShader;
+		packet.IndirectShader = scene->GetIndirectShader();
+
+		scene->TakePhysicsDebugFrame(packet.PhysicsDebug);
+
+		_GatherItems(scene, packet);
+	}
+
+	void SceneRenderer::Render(const RenderPacket& packet) {
+		const glm::mat4& viewProj = packet.ViewProjection;
+
+		// We sort and store depths in the items, so we work on our own copy
+		_items = packet.Items;
+
+		FrameStats stats;
+		stats.Submitted = (uint32_t)_items.size();
+		stats.Batches = packet.StaticBatches;
+
+		auto cullStart = std::chrono::high_resolution_clock::now();
+		if (_options.EnableCulling) {
+			_Cull(Frustum::FromViewProjection(viewProj));
+			stats.UsedBvh = _items.size() >= _options.BvhThreshold;
+		} else {
+			_visibility.assign(_items.size(), 1);
+		}
+		stats.CullTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - cullStart).count();
+
+		_UpdateLights(packet, stats);
+
+		bool useIndirect = _options.UseIndirect && packet.IndirectShader != nullptr;
+		_indirectItems.clear();
+		_drawOrder.clear();
+
+		// Split our visible objects into the ones we draw individually, and the ones in the geometry arena
+		// that get drawn together with multi-draw indirect
+		for (size_t ix = 0; ix < _items.size(); ix++) {
+			if (!_visibility[ix]) {
+				continue;
+			}
+			stats.Visible++;
+			if (useIndirect && _CanDrawIndirect(_items[ix], packet)) {
+				_indirectItems.push_back((uint32_t)ix);
+			} else {
+				_drawOrder.push_back((uint32_t)ix);
+			}
+		}
+
+		bool usePrepass = _options.DepthPrepass && _CanDepthPrepass();
+
+		// With a pre-pass, the main pass only shades visible fragments so the order doesn't matter, and we
+		// keep the material order to avoid state changes. Otherwise, drawing the nearest objects first lets
+		// the depth test reject the fragments that they cover before they are shaded
+		if (_options.SortFrontToBack && !usePrepass) {
+			const glm::mat4& view = packet.View;
+			for (uint32_t index : _drawOrder) {
+				_items[index].Depth = _GetViewDepth(_items[index], view);
+			}
+			for (uint32_t index : _indirectItems) {
+				_items[index].Depth = _GetViewDepth(_items[index], view);
+			}
+			auto nearestFirst = [](uint32_t a, uint32_t b) { return _items[a].Depth < _items[b].Depth; };
+			std::sort(_drawOrder.begin(), _drawOrder.end(), nearestFirst);
+			// Indirect draws are grouped by material with a stable sort, so this order is kept within each material
+			std::sort(_indirectItems.begin(), _indirectItems.end(), nearestFirst);
+		}
+
+		if (!_indirectItems.empty()) {
+			_PrepareIndirect();
+		}
+
+		if (usePrepass) {
+			_DepthPrepass(viewProj, stats);
+			// Only the fragments that wrote the depth in the pre-pass will pass, and the depth is already there
+			GlStateCache::SetDepthFunc(DepthFunc::Equal);
+			GlStateCache::SetDepthWrite(false);
+		}
+
+		// Count the samples that make it through the depth test, these are the ones that get shaded (as long as
+		// the driver can do early depth testing, which it can since none of our shaders discard or write depth)
+		_ResolveSampleQueries();
+		bool countSamples = _options.CountSamples && !_sampleQueryPending[_sampleQueryIndex];
+		if (countSamples) {
+			if (_sampleQueries[0] == 0) {
+				glCreateQueries(GL_SAMPLES_PASSED, SAMPLE_QUERY_COUNT, _sampleQueries);
+			}
+			glBeginQuery(GL_SAMPLES_PASSED, _sampleQueries[_sampleQueryIndex]);
+		}
+
+		// The current material that is bound for rendering
+		Material* currentMat = nullptr;
+		// The shader keywords for the current mesh's vertex format, these lists are static so we compare them by address
+		const std::vector<std::string>* currentVertexKeywords = nullptr;
+		Shader::Sptr shader = nullptr;
+
+		// Render all our visible objects
+		for (uint32_t ix : _drawOrder) {
+			const DrawItem& item = _items[ix];
+			const std::vector<std::string>& vertexKeywords = VertexPacking::GetShaderKeywords(item.Mesh->GetVDecl());
+
+			// If the material has changed, we need to bind the new shader and set up our material and frame data
+			// Note: This is a good reason why we should be sorting the render components in ComponentManager
+			if (item.ItemMaterial != currentMat || &vertexKeywords != currentVertexKeywords) {
+				currentMat = item.ItemMaterial;
+				currentVertexKeywords = &vertexKeywords;
+				// Materials with keywords, and meshes with packed vertices, will be using a variant of the material's shader
+				const Shader::Sptr& matShader = currentMat->GetShader(vertexKeywords);
+				if (matShader != shader) {
+					shader = matShader;
+					shader->Bind();
+					shader->SetUniform("u_CamPos", packet.CameraPosition);
+					_ApplyLightUniforms(shader, packet);
+				}
+				currentMat->Apply(shader);
+			}
+
+			// Set vertex shader parameters
+			shader->SetUniformMatrix("u_ModelViewProjection", viewProj * item.Transform);
+			shader->SetUniformMatrix("u_Model", item.Transform);
+			shader->SetUniformMatrix("u_NormalMatrix", glm::mat3(glm::transpose(glm::inverse(item.Transform))));
+			// Draw the object
+			item.Mesh->Draw();
+			stats.DrawCalls++;
+		}
+
+		if (!_indirectItems.empty()) {
+			_DrawIndirect(packet, stats);
+		}
+
+		if (countSamples) {
+			glEndQuery(GL_SAMPLES_PASSED);
+			_sampleQueryPending[_sampleQueryIndex] = true;
+			_sampleQueryPrepass[_sampleQueryIndex] = usePrepass;
+			_sampleQueryIndex = (_sampleQueryIndex + 1) % SAMPLE_QUERY_COUNT;
+		}
+
+		if (usePrepass) {
+			GlStateCache::SetDepthFunc(DepthFunc::Less);
+			GlStateCache::SetDepthWrite(true);
+			stats.UsedPrepass = true;
+		}
+
+		_lastStats = stats;
+	}
+
+	float SceneRenderer::_GetViewDepth(const DrawItem& item, const glm::mat4& view) {
+		// Items without bounds fall back to their origin
+		glm::vec3 center = item.Bounds.Box.IsValid() ? item.Bounds.Sphere.Center : glm::vec3(item.Transform[3]);
+		// The camera looks down -Z in view space
+		return -(view * glm::vec4(center, 1.0f)).z;
+	}
+
+	bool SceneRenderer::_CanDepthPrepass() {
+		// We only try to build the shaders once, so a broken shader doesn't spam the log every frame
+		if (!_depthShadersBuilt) {
+			_depthShadersBuilt = true;
+			_depthShader = Shader::Create();
+			bool loaded = _depthShader->LoadShaderPartFromFile("shaders/vertex_depth_only.glsl", ShaderPartType::Vertex);
+			loaded &= _depthShader->LoadShaderPartFromFile("shaders/frag_depth_only.glsl", ShaderPartType::Fragment);
+			if (!loaded || !_depthShader->Link()) {
+				LOG_ERROR("Failed to build the depth pre-pass shader, the pre-pass will be skipped");
+				_depthShader = nullptr;
+			} else if (GeometryArena::IsIndirectSupported()) {
+				_depthIndirectShader = _depthShader->CreateVariant(ShaderPartType::Vertex, "shaders/vertex_depth_only_indirect.glsl");
+				if (_depthIndirectShader == nullptr) {
+					LOG_ERROR("Failed to build the indirect depth pre-pass shader, the pre-pass will be skipped on frames with multi-draws");
+				}
+			}
+		}
+
+		// The main pass draws the arena's meshes with a different vertex shader than the per-object depth shader,
+		// so they can only match bit for bit if they go through the indirect depth shader
+		return _depthShader != nullptr && (_indirectItems.empty() || _depthIndirectShader != nullptr);
+	}
+
+	void SceneRenderer::_DepthPrepass(const glm::mat4& viewProj, FrameStats& stats) {
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		GlStateCache::SetDepthFunc(DepthFunc::Less);
+		GlStateCache::SetDepthWrite(true);
+
+		_depthShader->Bind();
+		for (uint32_t ix : _drawOrder) {
+			const DrawItem& item = _items[ix];
+			// Needs to be exactly the same matrix as the main pass, so the depths match bit for bit
+			_depthShader->SetUniformMatrix("u_ModelViewProjection", viewProj * item.Transform);
+			item.Mesh->Draw();
+			stats.PrepassDrawCalls++;
+		}
+
+		// Materials don't matter for depth, so all the meshes in an arena can go in a single multi-draw. Every
+		// vertex format has a float3 position in slot 0, so the same shader works for all of them
+		if (!_indirectItems.empty() && _depthIndirectShader != nullptr) {
+			_depthIndirectShader->Bind();
+			_depthIndirectShader->SetUniformMatrix("u_ViewProjection", viewProj);
+
+			_drawDataBuffer->Bind(0);
+			_commandBuffer->Bind();
+			size_t count = _indirectItems.size();
+			for (size_t start = 0; start < count;) {
+				GeometryArena* arena = _items[_indirectItems[start]].Mesh->GetArenaAllocation()->Arena.get();
+				size_t end = start + 1;
+				while (end < count && _items[_indirectItems[end]].Mesh->GetArenaAllocation()->Arena.get() == arena) {
+					end++;
+				}
+
+				arena->GetVao()->Bind();
+				_depthIndirectShader->SetUniform("u_DrawOffset", (int)start);
+				glMultiDrawElementsIndirect(GL_TRIANGLES, (GLenum)arena->GetIndexType(),
+					(const void*)(start * sizeof(DrawElementsIndirectCommand)), (GLsizei)(end - start), 0);
+				stats.PrepassDrawCalls++;
+
+				start = end;
+			}
+			DrawIndirectBuffer::UnBind();
+		}
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	}
+
+	void SceneRenderer::_ResolveSampleQueries() {
+		for (uint32_t ix = 0; ix < SAMPLE_QUERY_COUNT; ix++) {
+			if (!_sampleQueryPending[ix]) {
+				continue;
+			}
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(_sampleQueries[ix], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+				GLuint64 samples = 0;
+				glGetQueryObjectui64v(_sampleQueries[ix], GL_QUERY_RESULT, &samples);
+				_shadedSamples[_sampleQueryPrepass[ix] ? 1 : 0] = samples;
+				_sampleQueryPending[ix] = false;
+			}
+		}
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		_sampleViewport = glm::ivec2(viewport[2], viewport[3]);
+	}
+
+	bool SceneRenderer::_CanDrawIndirect(const DrawItem& item, const RenderPacket& packet) {
+		// The indirect shader is a variant of the base shader, meshes from any arena can use it since the packed
+		// vertex formats and texture arrays get a keyword variant of it in _DrawIndirect
+		const std::shared_ptr<ArenaAllocation>& allocation = item.Mesh->GetArenaAllocation();
+		return allocation != nullptr &&
+			item.ItemMaterial->MatShader == packet.BaseShader &&
+			item.ItemMaterial->Keywords.empty();
+	}
+
+	// Materials that sample the same texture array only differ by their per-draw params, so they share a multi-draw
+	static const void* GetIndirectBatchKey(const Material* material) {
+		return material->TextureArray != nullptr ? (const void*)material->TextureArray.get() : (const void*)material;
+	}
+
+	void SceneRenderer::_PrepareIndirect() {
+		// Sort so that all the draws for an arena and material (or texture array) are next to each other, each of those
+		// becomes a single multi-draw
+		std::stable_sort(_indirectItems.begin(), _indirectItems.end(), [](uint32_t a, uint32_t b) {
+			GeometryArena* arenaA = _items[a].Mesh->GetArenaAllocation()->Arena.get();
+			GeometryArena* arenaB = _items[b].Mesh->GetArenaAllocation()->Arena.get();
+			return arenaA != arenaB ? arenaA < arenaB : GetIndirectBatchKey(_items[a].ItemMaterial) < GetIndirectBatchKey(_items[b].ItemMaterial);
+		});
+
+		// Build our per-draw data and the draw commands, the shader finds it's data using gl_DrawIDARB
+		size_t count = _indirectItems.size();
+		_drawData.resize(count);
+		_commands.resize(count);
+		for (size_t ix = 0; ix < count; ix++) {
+			const DrawItem& item = _items[_indirectItems[ix]];
+			_drawData[ix].Model = item.Transform;
+			_drawData[ix].NormalMatrix = glm::mat4(glm::mat3(glm::transpose(glm::inverse(item.Transform))));
+			_drawData[ix].MaterialParams = glm::vec4((float)item.ItemMaterial->TextureLayer, item.ItemMaterial->Shininess, 0.0f, 0.0f);
+			_commands[ix] = item.Mesh->GetArenaAllocation()->GetDrawCommand();
+		}
+
+		if (_drawDataBuffer == nullptr) {
+			_drawDataBuffer = ShaderStorageBuffer::Create();
+			_commandBuffer = DrawIndirectBuffer::Create();
+		}
+		_drawDataBuffer->LoadData(_drawData.data(), count);
+		_commandBuffer->LoadData(_commands.data(), count);
+	}
+
+	void SceneRenderer::_DrawIndirect(const RenderPacket& packet, FrameStats& stats) {
+		size_t count = _indirectItems.size();
+
+		_drawDataBuffer->Bind(0);
+		_commandBuffer->Bind();
+
+		GeometryArena* currentArena = nullptr;
+		bool currentUsesArray = false;
+		Shader::Sptr shader = nullptr;
+		for (size_t start = 0; start < count;) {
+			Material* material = _items[_indirectItems[start]].ItemMaterial;
+			const void* batchKey = GetIndirectBatchKey(material);
+			GeometryArena* arena = _items[_indirectItems[start]].Mesh->GetArenaAllocation()->Arena.get();
+			size_t end = start + 1;
+			while (end < count && GetIndirectBatchKey(_items[_indirectItems[end]].ItemMaterial) == batchKey &&
+				_items[_indirectItems[end]].Mesh->GetArenaAllocation()->Arena.get() == arena) {
+				end++;
+			}
+
+			// Each arena has it's own VAO, and the packed formats need a variant of the shader to decode them,
+			// as do texture arrays
+			bool usesArray = material->TextureArray != nullptr;
+			if (arena != currentArena || usesArray != currentUsesArray) {
+				currentArena = arena;
+				currentUsesArray = usesArray;
+				const VertexArrayObject::Sptr& vao = arena->GetVao();
+				std::vector<std::string> keywords = VertexPacking::GetShaderKeywords(vao->GetVDecl());
+				if (usesArray) {
+					keywords.push_back("TEXTURE_ARRAY");
+				}
+				Shader::Sptr variant = keywords.empty() ? packet.IndirectShader : packet.IndirectShader->GetVariant(keywords);
+				if (variant == nullptr) {
+					variant = packet.IndirectShader;
+				}
+				if (variant != shader) {
+					shader = variant;
+					shader->Bind();
+					shader->SetUniform("u_CamPos", packet.CameraPosition);
+					shader->SetUniformMatrix("u_ViewProjection", packet.ViewProjection);
+					_ApplyLightUniforms(shader, packet);
+				}
+				vao->Bind();
+			}
+
+			// Draws in a texture array run only differ by their layer and shininess, which are in the draw data
+			material->Apply(shader);
+			shader->SetUniform("u_DrawOffset", (int)start);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, (GLenum)arena->GetIndexType(),
+				(const void*)(start * sizeof(DrawElementsIndirectCommand)), (GLsizei)(end - start), 0);
+			stats.DrawCalls++;
+
+			start = end;
+		}
+
+		DrawIndirectBuffer::UnBind();
+		stats.IndirectDraws = (uint32_t)count;
+	}
+
+	void SceneRenderer::_UpdateLights(const RenderPacket& packet, FrameStats& stats) {
+		// The slices are spread between the camera's clipping planes, so we need to rebuild if they change
+		if (_lightGrid.GetClusterCount() == 0 || _lightGrid.GetNearPlane() != packet.NearPlane || _lightGrid.GetFarPlane() != packet.FarPlane) {
+			_lightGrid.Configure(CLUSTER_TILES_X, CLUSTER_TILES_Y, CLUSTER_SLICES, packet.NearPlane, packet.FarPlane);
+		}
+
+		size_t lightCount = packet.Lights.size();
+		_lightSpheres.resize(lightCount);
+		_clusterLights.resize(lightCount);
+		for (size_t ix = 0; ix < lightCount; ix++) {
+			const Light& light = packet.Lights[ix];
+			_lightSpheres[ix] = BoundingSphere(light.Position, light.GetInfluenceRadius());
+			_clusterLights[ix].PositionAttenuation = glm::vec4(light.Position, 1.0f / (1.0f + light.Range));
+			_clusterLights[ix].Color = glm::vec4(light.Color, 1.0f);
+		}
+
+		// This thread bins too, so the pool only needs the extra threads
+		uint32_t workers = _options.LightBinThreads > 1 ? _options.LightBinThreads - 1 : 0;
+		if (workers == 0) {
+			_lightBinPool = nullptr;
+		} else if (_lightBinPool == nullptr || _lightBinPool->GetThreadCount() != workers) {
+			_lightBinPool = ThreadPool::Create(workers);
+		}
+
+		auto binStart = std::chrono::high_resolution_clock::now();
+		_lightGrid.Build(packet.View, packet.Projection, _lightSpheres.data(), (uint32_t)lightCount, _options.LightBinThreads, _options.LightBinSimd, _lightBinPool.get());
+		stats.LightBinTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - binStart).count();
+		stats.LightReferences = (uint32_t)_lightGrid.GetLightIndices().size();
+		stats.LightBinThreadsUsed = _lightGrid.GetThreadsUsed();
+
+		if (_lightBuffer == nullptr) {
+			_lightBuffer = ShaderStorageBuffer::Create();
+			_clusterBuffer = ShaderStorageBuffer::Create();
+			_lightIndexBuffer = ShaderStorageBuffer::Create();
+		}
+
+		// Binding an empty buffer is an error, so we always upload at least one element (the shader won't read it)
+		if (_clusterLights.empty()) {
+			_clusterLights.push_back({ glm::vec4(0.0f), glm::vec4(0.0f) });
+		}
+		const std::vector<uint32_t>& indices = _lightGrid.GetLightIndices();
+		uint32_t emptyIndex = 0;
+		_lightBuffer->LoadData(_clusterLights.data(), _clusterLights.size());
+		_clusterBuffer->LoadData(_lightGrid.GetClusters().data(), _lightGrid.GetClusters().size());
+		_lightIndexBuffer->LoadData(indices.empty() ? &emptyIndex : indices.data(), glm::max(indices.size(), (size_t)1));
+
+		_lightBuffer->Bind(1);
+		_clusterBuffer->Bind(2);
+		_lightIndexBuffer->Bind(3);
+
+		// The tile size depends on the viewport, so we grab it from GL instead of assuming the window size
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glm::uvec3 dimensions = _lightGrid.GetDimensions();
+		_clusterTileSize = glm::vec2(viewport[2], viewport[3]) / glm::vec2(dimensions.x, dimensions.y);
+	}
+
+	void SceneRenderer::_ApplyLightUniforms(const Shader::Sptr& shader, const RenderPacket& packet) {
+		// Any shader (or keyword variant) we draw with this frame needs the cluster info, so we set it
+		// whenever we switch shaders instead of on a fixed list of shaders
+		shader->SetUniformMatrix("u_View", packet.View);
+		shader->SetUniform("u_AmbientCol", packet.AmbientLight);
+		shader->SetUniform("u_ClusterCount", glm::ivec3(_lightGrid.GetDimensions()));
+		shader->SetUniform("u_ClusterTileSize", _clusterTileSize);
+		shader->SetUniform("u_ClusterDepthScaleBias", _lightGrid.GetSliceScaleBias());
+	}
+
+	void SceneRenderer::_GatherItems(const Scene::Sptr& scene, RenderPacket& packet) {
+		packet.Items.clear();
+
+		// Rebuilding a batch creates new meshes, so it needs to happen on the thread with the GL context
+		StaticBatcher* batcher = scene->GetStaticBatcher();
+		batcher->DetectChanges();
+		if (batcher->HasPendingRebuilds()) {
+			RenderThread::Execute([batcher]() { batcher->GetBatches(); });
+		}
+
+		// Static batches are already in world space
+		const auto& batches = batcher->GetBatches();
+		packet.StaticBatches = (uint32_t)batches.size();
+		for (const auto& batch : batches) {
+			DrawItem item;
+			item.Source       = batch.get();
+			item.Mesh         = batch->Mesh.get();
+			item.ItemMaterial = batch->BatchMaterial.get();
+			item.Transform    = glm::mat4(1.0f);
+			item.Bounds       = batch->Mesh->GetBounds();
+			item.Depth        = 0.0f;
+			packet.Items.push_back(item);
+		}
+
+		// Gather all the renderables that we can draw, and that aren't already drawn in a batch
+		ComponentManager::Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
+			if (renderable->GetMeshResource() == nullptr || renderable->GetMesh() == nullptr || renderable->GetMaterial() == nullptr) {
+				return;
+			}
+			GameObject* object = renderable->GetGameObject();
+			if (batcher->IsBatched(object)) {
+				return;
+			}
+
+			DrawItem item;
+			item.Source       = renderable.get();
+			item.Mesh         = renderable->GetMesh().get();
+			item.ItemMaterial = renderable->GetMaterial().get();
+			item.Transform    = object->GetTransform();
+			item.Bounds       = renderable->GetMeshResource()->GetBounds().Transformed(item.Transform);
+			item.Depth        = 0.0f;
+			packet.Items.push_back(item);
+		});
+	}
+
+	void SceneRenderer::_Cull(const Frustum& frustum) {
+		size_t count = _items.size();
+		_visibility.resize(count);
+
+		// Large scenes go through the BVH so we can reject whole groups of objects at once
+		if (count >= _options.BvhThreshold) {
+			_boxes.resize(count);
+			for (size_t ix = 0; ix < count; ix++) {
+				const MeshBounds& bounds = _items[ix].Bounds;
+				// Meshes with no bounds can't be culled, so we give them a huge box (not infinite, since that would
+				// give us a NaN center when building the BVH)
+				_boxes[ix] = bounds.Box.IsValid() ? bounds.Box : AABB(glm::vec3(-1e30f), glm::vec3(1e30f));
+			}
+
+			// Only rebuild the tree when the set of items changes, otherwise we can just refit it
+			bool itemsChanged = _bvhSources.size() != count;
+			for (size_t ix = 0; ix < count && !itemsChanged; ix++) {
+				itemsChanged = _bvhSources[ix] != _items[ix].Source;
+			}
+			if (itemsChanged) {
+				_bvh.Build(_boxes);
+				_bvhSources.resize(count);
+				for (size_t ix = 0; ix < count; ix++) {
+					_bvhSources[ix] = _items[ix].Source;
+				}
+			} else {
+				_bvh.Refit(_boxes);
+			}
+
+			_bvhResults.clear();
+			_bvh.Query(frustum, _bvhResults);
+			std::fill(_visibility.begin(), _visibility.end(), 0);
+			for (uint32_t index : _bvhResults) {
+				_visibility[index] = 1;
+			}
+		}
+		// Otherwise we can brute force the spheres
+		else {
+			_spheres.resize(count);
+			for (size_t ix = 0; ix < count; ix++) {
+				const MeshBounds& bounds = _items[ix].Bounds;
+				// Meshes with no bounds can't be culled, so we give them an infinite radius
+				_spheres[ix] = bounds.Box.IsValid() ? bounds.Sphere : BoundingSphere(glm::vec3(0.0f), std::numeric_limits<float>::infinity());
+			}
+			if (_options.UseSimd) {
+				frustum.CullSpheres(_spheres.data(), count, _visibility.data());
+			} else {
+				frustum.CullSpheresScalar(_spheres.data(), count, _visibility.data());
+			}
+		}
+	}
+
+	void SceneRenderer::RenderImGui() {
+		ImGui::Checkbox("Frustum Culling", &_options.EnableCulling);
+		ImGui::Checkbox("SIMD Sphere Test", &_options.UseSimd);
+		ImGui::Checkbox("Multi-Draw Indirect", &_options.UseIndirect);
+		int threshold = (int)_options.BvhThreshold;
+		if (LABEL_LEFT(ImGui::DragInt, "BVH Threshold", &threshold, 1.0f, 0, 100000)) {
+			_options.BvhThreshold = (uint32_t)threshold;
+		}
+		ImGui::Text("Visible:   %u / %u (%u static batches)", _lastStats.Visible, _lastStats.Submitted, _lastStats.Batches);
+		ImGui::Text("Cull Time: %.3f ms (%s)", _lastStats.CullTimeMs, _lastStats.UsedBvh ? "BVH" : "Linear");
+		ImGui::Text("Draws:     %u (%u objects drawn indirect)", _lastStats.DrawCalls, _lastStats.IndirectDraws);
+		if (ImGui::TreeNode("Overdraw")) {
+			ImGui::Checkbox("Depth Pre-Pass", &_options.DepthPrepass);
+			ImGui::Checkbox("Front-to-Back Sorting", &_options.SortFrontToBack);
+			if (_options.DepthPrepass) {
+				ImGui::SameLine();
+				ImGui::TextDisabled("(unused with pre-pass)");
+			}
+			ImGui::Checkbox("Count Shaded Samples", &_options.CountSamples);
+			if (_lastStats.UsedPrepass) {
+				ImGui::Text("Pre-Pass:  %u draws", _lastStats.PrepassDrawCalls);
+			}
+			// We keep the last result for each mode, so toggling the pre-pass shows us how much it saves
+			float pixels = (float)glm::max(_sampleViewport.x * _sampleViewport.y, 1);
+			for (int ix = 0; ix < 2; ix++) {
+				ImGui::Text("%s %llu samples (%.2f per pixel)", ix ? "With:    " : "Without: ",
+					(unsigned long long)_shadedSamples[ix], _shadedSamples[ix] / pixels);
+			}
+			if (_shadedSamples[0] > 0 && _shadedSamples[1] > 0) {
+				ImGui::Text("Saved:     %.1f%% of shaded samples", 100.0f * (1.0f - (float)_shadedSamples[1] / (float)_shadedSamples[0]));
+			}
+			ImGui::TreePop();
+		}
+		if (ImGui::TreeNode("Light Clusters")) {
+			int threads = (int)_options.LightBinThreads;
+			if (LABEL_LEFT(ImGui::DragInt, "Bin Threads", &threads, 0.1f, 1, 64)) {
+				_options.LightBinThreads = (uint32_t)threads;
+			}
+			ImGui::Checkbox("SIMD Cluster Test", &_options.LightBinSimd);
+			glm::uvec3 dimensions = _lightGrid.GetDimensions();
+			ImGui::Text("Grid:      %u x %u x %u", dimensions.x, dimensions.y, dimensions.z);
+			ImGui::Text("Bin Time:  %.3f ms (%u threads)", _lastStats.LightBinTimeMs, _lastStats.LightBinThreadsUsed);
+			ImGui::Text("Light Refs: %u", _lastStats.LightReferences);
+			ImGui::TreePop();
+		}
+		if (ImGui::TreeNode("Geometry Arenas")) {
+			GeometryArena::RenderSharedImGui();
+			ImGui::TreePop();
+		}
+	}
+}
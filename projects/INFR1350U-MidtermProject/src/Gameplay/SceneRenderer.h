@@ -0,0 +1,239 @@
+#pragma once
+#include <vector>
+#include "Gameplay/Scene.h"
+#include "Gameplay/RenderPacket.h"
+#include "Utils/BoundingVolumes.h"
+#include "Utils/Bvh.h"
+#include "Utils/LightGrid.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/ShaderStorageBuffer.h"
+#include "Graphics/DrawIndirectBuffer.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// Handles drawing all the render components in a scene from the point of view
+	/// of the scene's main camera, culling any objects that are outside of the view
+	/// </summary>
+	class SceneRenderer {
+	public:
+		/// <summary>
+		/// Options for controlling how the renderer behaves
+		/// </summary>
+		struct Options {
+			// Whether objects outside of the camera frustum should be skipped
+			bool     EnableCulling;
+			// Whether to use the SSE batch test for bounding spheres
+			bool     UseSimd;
+			// The number of renderables at which we switch to building a BVH for culling
+			uint32_t BvhThreshold;
+			// Whether meshes in the geometry arena should be drawn with multi-draw indirect
+			bool     UseIndirect;
+			// The maximum number of threads to use when binning lights into clusters
+			uint32_t LightBinThreads;
+			// Whether to use the SSE cluster test when binning lights
+			bool     LightBinSimd;
+			// Whether to lay down depth with a position-only shader first, so that the main pass (which tests
+			// with GL_EQUAL) only shades the closest fragment of each pixel
+			bool     DepthPrepass;
+			// Whether to sort opaque draws from nearest to farthest when there is no pre-pass, so that early
+			// depth testing can reject more fragments. Trades away some material grouping
+			bool     SortFrontToBack;
+			// Whether to count the samples that pass the depth test in the main pass with GL_SAMPLES_PASSED
+			bool     CountSamples;
+
+			Options();
+		};
+
+		/// <summary>
+		/// Information about the last frame that was rendered
+		/// </summary>
+		struct FrameStats {
+			uint32_t Submitted;
+			uint32_t Visible;
+			// The number of draws that came from static batches
+			uint32_t Batches;
+			bool     UsedBvh;
+			// Time spent culling, in milliseconds
+			float    CullTimeMs;
+			// The number of draw calls we actually made to OpenGL
+			uint32_t DrawCalls;
+			// The number of objects that were drawn through multi-draw indirect
+			uint32_t IndirectDraws;
+			// Time spent binning lights into clusters, in milliseconds
+			float    LightBinTimeMs;
+			// The total number of light indices across all clusters
+			uint32_t LightReferences;
+			uint32_t LightBinThreadsUsed;
+			// Whether the depth pre-pass ran, and how many draw calls it made
+			bool     UsedPrepass;
+			uint32_t PrepassDrawCalls;
+
+			FrameStats();
+		};
+
+		SceneRenderer() = delete;
+
+		/// <summary>
+		/// Renders all the enabled render components in the scene
+		/// </summary>
+		/// <param name="scene">The scene to render, must have a main camera</param>
+		static void Render(const Scene::Sptr& scene);
+
+		/// <summary>
+		/// Captures everything we need to draw the scene into a render packet, does not touch OpenGL
+		/// so it can be called from the simulation while another thread is rendering
+		/// </summary>
+		/// <param name="scene">The scene to capture, must have a main camera</param>
+		/// <param name="packet">The packet to fill, should have been reset</param>
+		static void Gather(const Scene::Sptr& scene, RenderPacket& packet);
+		/// <summary>
+		/// Culls and draws the items in a render packet, must be called on the thread that owns the GL context
+		/// </summary>
+		static void Render(const RenderPacket& packet);
+
+		/// <summary>
+		/// Gets the options for the renderer, these can be modified at any time
+		/// </summary>
+		static Options& GetOptions() { return _options; }
+		/// <summary>
+		/// Gets the stats for the last frame that was rendered
+		/// </summary>
+		static const FrameStats& GetLastFrameStats() { return _lastStats; }
+		/// <summary>
+		/// Gets the number of samples that were shaded by the main pass, from the most recent query that
+		/// the GPU has finished. Index 0 is without the depth pre-pass, index 1 is with it
+		/// </summary>
+		static uint64_t GetShadedSamples(bool withPrepass) { return _shadedSamples[withPrepass ? 1 : 0]; }
+
+		/// <summary>
+		/// Draws the renderer options and stats to the current ImGui window
+		/// </summary>
+		static void RenderImGui();
+
+	protected:
+		/// <summary>
+		/// The per-draw data for multi-draw indirect, must match DrawData in vertex_shader_indirect.glsl
+		/// </summary>
+		struct IndirectDrawData {
+			glm::mat4 Model;
+			// Padded out to a mat4 so that it matches the std430 layout
+			glm::mat4 NormalMatrix;
+			// The material's texture array layer (x) and shininess (y), so that materials sharing an array can be
+			// drawn in the same multi-draw
+			glm::vec4 MaterialParams;
+		};
+
+		/// <summary>
+		/// A single light for clustered shading, must match Light in frag_blinn_phong_textured.glsl
+		/// </summary>
+		struct ClusterLight {
+			// xyz is the world position, w is the attenuation factor
+			glm::vec4 PositionAttenuation;
+			glm::vec4 Color;
+		};
+
+		static Options    _options;
+		static FrameStats _lastStats;
+
+		// Used when rendering a scene directly, instead of from a packet built by the simulation
+		static RenderPacket                _immediatePacket;
+
+		// We keep these around between frames so we don't need to keep re-allocating them
+		// The items from the packet we are drawing, copied since we sort them
+		static std::vector<DrawItem>       _items;
+		static std::vector<BoundingSphere> _spheres;
+		static std::vector<AABB>           _boxes;
+		static std::vector<uint8_t>        _visibility;
+		static std::vector<uint32_t>       _bvhResults;
+		// The item sources that the BVH was last built with
+		static std::vector<const void*>    _bvhSources;
+		static Bvh                         _bvh;
+
+		// Indices into _items that will be drawn with multi-draw indirect
+		static std::vector<uint32_t>                    _indirectItems;
+		static std::vector<IndirectDrawData>            _drawData;
+		static std::vector<DrawElementsIndirectCommand> _commands;
+		// Created on first use, since we need a GL context
+		static ShaderStorageBuffer::Sptr                _drawDataBuffer;
+		static DrawIndirectBuffer::Sptr                 _commandBuffer;
+
+		// Lights are binned into clusters on the CPU, then uploaded to these buffers for the fragment shader
+		static LightGrid                   _lightGrid;
+		// The workers that bin lights alongside the render thread, kept between frames and only replaced when
+		// LightBinThreads changes
+		static ThreadPool::Sptr            _lightBinPool;
+		static std::vector<BoundingSphere> _lightSpheres;
+		static std::vector<ClusterLight>   _clusterLights;
+		static ShaderStorageBuffer::Sptr   _lightBuffer;
+		static ShaderStorageBuffer::Sptr   _clusterBuffer;
+		static ShaderStorageBuffer::Sptr   _lightIndexBuffer;
+		// The size of a cluster tile in pixels for the current viewport
+		static glm::vec2                   _clusterTileSize;
+
+		// Indices into _items that will be drawn individually, in the order they will be drawn
+		static std::vector<uint32_t>       _drawOrder;
+		// Position-only shaders for the depth pre-pass, created on first use
+		static Shader::Sptr                _depthShader;
+		static Shader::Sptr                _depthIndirectShader;
+		static bool                        _depthShadersBuilt;
+
+		// We keep a few GL_SAMPLES_PASSED queries in flight, so reading them back never stalls
+		static const uint32_t SAMPLE_QUERY_COUNT = 4;
+		static GLuint   _sampleQueries[SAMPLE_QUERY_COUNT];
+		// Whether each query has been issued and not read yet, and whether it's frame used the pre-pass
+		static bool     _sampleQueryPending[SAMPLE_QUERY_COUNT];
+		static bool     _sampleQueryPrepass[SAMPLE_QUERY_COUNT];
+		static uint32_t _sampleQueryIndex;
+		static uint64_t _shadedSamples[2];
+		// The viewport size when the samples were last counted, to report samples per pixel
+		static glm::ivec2 _sampleViewport;
+
+		/// <summary>
+		/// Collects the static batches and all the render components that are not part of a batch
+		/// </summary>
+		static void _GatherItems(const Scene::Sptr& scene, RenderPacket& packet);
+		/// <summary>
+		/// Determines which of the gathered items are visible to the frustum, storing the results in _visibility
+		/// </summary>
+		static void _Cull(const Frustum& frustum);
+		/// <summary>
+		/// Returns true if the item can be drawn from the geometry arena with the scene's indirect shader
+		/// </summary>
+		static bool _CanDrawIndirect(const DrawItem& item, const RenderPacket& packet);
+		/// <summary>
+		/// Sorts the items in _indirectItems by arena and material, then builds and uploads the draw data and commands
+		/// </summary>
+		static void _PrepareIndirect();
+		/// <summary>
+		/// Draws all the items in _indirectItems, with one multi-draw indirect call per arena and material. Arenas
+		/// with a packed vertex format use a keyword variant of the indirect shader
+		/// </summary>
+		static void _DrawIndirect(const RenderPacket& packet, FrameStats& stats);
+		/// <summary>
+		/// Gets the view space depth of an item's bounds, larger values are further from the camera
+		/// </summary>
+		static float _GetViewDepth(const DrawItem& item, const glm::mat4& view);
+		/// <summary>
+		/// Builds the depth-only shaders on first use, and checks that they can cover everything we are about to draw.
+		/// Anything missing from the pre-pass would fail the main pass's equal depth test and disappear
+		/// </summary>
+		/// <returns>True if the pre-pass can be used this frame</returns>
+		static bool _CanDepthPrepass();
+		/// <summary>
+		/// Draws the depth of everything in _drawOrder and _indirectItems with color writes disabled
+		/// </summary>
+		static void _DepthPrepass(const glm::mat4& viewProj, FrameStats& stats);
+		/// <summary>
+		/// Reads back any sample queries that the GPU has finished with
+		/// </summary>
+		static void _ResolveSampleQueries();
+		/// <summary>
+		/// Bins the scene's lights into the cluster grid, uploads the light lists and binds them for the lit shaders
+		/// </summary>
+		static void _UpdateLights(const RenderPacket& packet, FrameStats& stats);
+		/// <summary>
+		/// Sets the per-frame lighting uniforms on a shader that we are about to draw with
+		/// </summary>
+		static void _ApplyLightUniforms(const Shader::Sptr& shader, const RenderPacket& packet);
+	};
+}
@@ -0,0 +1,260 @@
+#include "Gameplay/StaticBatcher.h"
+#include <algorithm>
+
+#include "Gameplay/Scene.h"
+#include "Gameplay/GameObject.h"
+#include "Gameplay/Components/RenderComponent.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/MeshBuilder.h"
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay {
+	StaticBatcher::StaticBatcher(Scene* scene) :
+		_scene(scene),
+		_isBuilt(false),
+		_batches(std::vector<std::shared_ptr<Batch>>()),
+		_objectBatches(std::unordered_map<const GameObject*, Batch*>()),
+		_objectMaterials(std::unordered_map<const GameObject*, Material*>()),
+		_dirtyMaterials(std::unordered_set<Material*>())
+	{ }
+
+	void StaticBatcher::Build() {
+		_batches.clear();
+		_objectBatches.clear();
+		_objectMaterials.clear();
+		_dirtyMaterials.clear();
+		_isBuilt = true;
+
+		// Find all the materials that are used by static objects, and build a batch for each
+		std::unordered_set<Material*> materials;
+		for (int ix = 0; ix < _scene->NumObjects(); ix++) {
+			GameObject* object = _scene->GetObjectByIndex(ix).get();
+			if (_IsBatchable(object)) {
+				materials.insert(object->Get<RenderComponent>()->GetMaterial().get());
+			}
+		}
+		for (Material* material : materials) {
+			_RebuildMaterial(material);
+		}
+
+		LOG_INFO("Built {} static batches from {} objects", _batches.size(), _objectBatches.size());
+	}
+
+	void StaticBatcher::Invalidate(GameObject* object) {
+		// Changes before the scene has woken up will be picked up by Build
+		if (!_isBuilt) {
+			return;
+		}
+
+		// The batch with the object's previous material needs to be rebuilt, since it may no longer be a member
+		auto it = _objectMaterials.find(object);
+		if (it != _objectMaterials.end()) {
+			_dirtyMaterials.insert(it->second);
+		}
+
+		// The batch for the object's current material needs to be rebuilt, since it may now be a member
+		if (_IsBatchable(object)) {
+			_dirtyMaterials.insert(object->Get<RenderComponent>()->GetMaterial().get());
+		}
+	}
+
+	void StaticBatcher::DetectChanges() {
+		if (!_isBuilt) {
+			return;
+		}
+
+		// Static objects that are batchable now but weren't checked with their material (ex: their renderer was
+		// re-enabled), or that were checked but are no longer batchable (ex: their renderer was disabled)
+		size_t tracked = 0;
+		for (int ix = 0; ix < _scene->NumObjects(); ix++) {
+			GameObject* object = _scene->GetObjectByIndex(ix).get();
+			if (!object->IsStatic) {
+				continue;
+			}
+			auto it = _objectMaterials.find(object);
+			Material* previous = it != _objectMaterials.end() ? it->second : nullptr;
+			Material* current = _IsBatchable(object) ? object->Get<RenderComponent>()->GetMaterial().get() : nullptr;
+			tracked += previous != nullptr ? 1 : 0;
+			if (current != previous) {
+				Invalidate(object);
+			}
+		}
+
+		// If we're tracking objects that we didn't find, they've been removed from the scene
+		if (tracked != _objectMaterials.size()) {
+			std::unordered_set<const GameObject*> found;
+			for (int ix = 0; ix < _scene->NumObjects(); ix++) {
+				found.insert(_scene->GetObjectByIndex(ix).get());
+			}
+			for (const auto& [object, material] : _objectMaterials) {
+				if (found.find(object) == found.end()) {
+					_dirtyMaterials.insert(material);
+				}
+			}
+		}
+
+		// Objects that were destroyed, and the memory re-used for a new object before we noticed
+		for (const auto& batch : _batches) {
+			for (const std::weak_ptr<GameObject>& member : batch->Members) {
+				if (member.expired()) {
+					_dirtyMaterials.insert(batch->BatchMaterial.get());
+					break;
+				}
+			}
+		}
+	}
+
+	const std::vector<std::shared_ptr<StaticBatcher::Batch>>& StaticBatcher::GetBatches() {
+		if (!_dirtyMaterials.empty()) {
+			for (Material* material : _dirtyMaterials) {
+				_RebuildMaterial(material);
+			}
+			_dirtyMaterials.clear();
+		}
+		return _batches;
+	}
+
+	bool StaticBatcher::IsBatched(const GameObject* object) const {
+		return _objectBatches.find(object) != _objectBatches.end();
+	}
+
+	void StaticBatcher::RenderImGui() {
+		ImGui::Text("Static Batches: %d", (int)_batches.size());
+		for (const auto& batch : _batches) {
+			ImGui::BulletText("%s: %d objects, %d triangles", batch->BatchMaterial->Name.c_str(),
+				(int)batch->Members.size(), (int)batch->Mesh->GetElementCount() / 3);
+		}
+	}
+
+	void StaticBatcher::_RebuildMaterial(Material* material) {
+		_RemoveBatch(material);
+
+		// Gather all the static objects that use the material
+		std::vector<GameObject::Sptr> members;
+		Material::Sptr materialPtr = nullptr;
+		for (int ix = 0; ix < _scene->NumObjects(); ix++) {
+			GameObject::Sptr object = _scene->GetObjectByIndex(ix);
+			if (_IsBatchable(object.get())) {
+				const Material::Sptr& objMaterial = object->Get<RenderComponent>()->GetMaterial();
+				if (objMaterial.get() == material) {
+					members.push_back(object);
+					materialPtr = objMaterial;
+				}
+			}
+		}
+
+		// Remember which material each object was checked with, even if no batch gets made
+		for (const GameObject::Sptr& object : members) {
+			_objectMaterials[object.get()] = material;
+		}
+
+		// No point in batching a single object
+		if (members.size() < 2) {
+			return;
+		}
+
+		std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+		batch->BatchMaterial = materialPtr;
+		batch->Members.assign(members.begin(), members.end());
+		batch->Mesh = _MergeMeshes(members);
+		if (batch->Mesh == nullptr) {
+			return;
+		}
+
+		for (const GameObject::Sptr& object : members) {
+			_objectBatches[object.get()] = batch.get();
+		}
+		_batches.push_back(batch);
+	}
+
+	void StaticBatcher::_RemoveBatch(Material* material) {
+		auto it = std::find_if(_batches.begin(), _batches.end(), [&](const std::shared_ptr<Batch>& batch) {
+			return batch->BatchMaterial.get() == material;
+		});
+		if (it != _batches.end()) {
+			// Members may have been destroyed, so we find them by the batch instead of through the member list
+			Batch* batch = it->get();
+			for (auto member = _objectBatches.begin(); member != _objectBatches.end();) {
+				if (member->second == batch) {
+					_objectMaterials.erase(member->first);
+					member = _objectBatches.erase(member);
+				} else {
+					member++;
+				}
+			}
+			_batches.erase(it);
+		}
+		// Objects that were checked but not batched may still be pointing at the material
+		for (auto mat = _objectMaterials.begin(); mat != _objectMaterials.end();) {
+			if (mat->second == material) {
+				mat = _objectMaterials.erase(mat);
+			} else {
+				mat++;
+			}
+		}
+	}
+
+	bool StaticBatcher::_IsBatchable(GameObject* object) {
+		if (object == nullptr || !object->IsStatic) {
+			return false;
+		}
+		RenderComponent::Sptr renderer = object->Get<RenderComponent>();
+		if (renderer == nullptr || !renderer->IsEnabled || renderer->GetMaterial() == nullptr ||
+			renderer->GetMeshResource() == nullptr || renderer->GetMesh() == nullptr) {
+			return false;
+		}
+
+		// We can only merge meshes that use our standard vertex format, stored in a single interleaved buffer
+		const VertexArrayObject::Sptr& vao = renderer->GetMesh();
+		const VertexArrayObject::VertexDeclaration& vDecl = vao->GetVDecl();
+		if (vDecl.size() != VertexPosNormTexCol::V_DECL.size()) {
+			return false;
+		}
+		for (size_t ix = 0; ix < vDecl.size(); ix++) {
+			if (vDecl[ix].Usage != VertexPosNormTexCol::V_DECL[ix].Usage || vDecl[ix].Offset != VertexPosNormTexCol::V_DECL[ix].Offset ||
+				vDecl[ix].Stride != sizeof(VertexPosNormTexCol)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	VertexArrayObject::Sptr StaticBatcher::_MergeMeshes(const std::vector<GameObject::Sptr>& objects) {
+		MeshBuilder<VertexPosNormTexCol> builder;
+		std::vector<uint8_t> vertexData;
+		std::vector<uint32_t> indices;
+
+		for (const GameObject::Sptr& object : objects) {
+			// Read the mesh data back from the GPU (usually from it's arena), this only happens when a batch is built so the stall is fine
+			const VertexArrayObject::Sptr& vao = object->Get<RenderComponent>()->GetMesh();
+			if (!vao->ReadBack(vertexData, indices)) {
+				continue;
+			}
+			VertexPosNormTexCol* vertices = reinterpret_cast<VertexPosNormTexCol*>(vertexData.data());
+			size_t vertexCount = vertexData.size() / sizeof(VertexPosNormTexCol);
+
+			// Pre-transform all the vertices into world space
+			const glm::mat4& transform = object->GetTransform();
+			glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(transform)));
+			uint32_t baseVertex = (uint32_t)builder.GetVertexCount();
+			builder.ReserveVertexSpace(vertexCount);
+			for (size_t ix = 0; ix < vertexCount; ix++) {
+				VertexPosNormTexCol vertex = vertices[ix];
+				vertex.Position = glm::vec3(transform * glm::vec4(vertex.Position, 1.0f));
+				vertex.Normal   = glm::normalize(normalMatrix * vertex.Normal);
+				builder.AddVertex(vertex);
+			}
+
+			// Copy the indices over, offset by where this mesh starts in the batch
+			builder.ReserveIndexSpace(indices.size());
+			for (uint32_t index : indices) {
+				builder.AddIndex(baseVertex + index);
+			}
+		}
+
+		if (builder.GetVertexCount() == 0) {
+			return nullptr;
+		}
+		return builder.Bake();
+	}
+}
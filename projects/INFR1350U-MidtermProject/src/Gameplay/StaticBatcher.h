@@ -0,0 +1,111 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Gameplay/Material.h"
+
+namespace Gameplay {
+	class Scene;
+	struct GameObject;
+
+	/// <summary>
+	/// Merges the meshes of static game objects that share a material into a single
+	/// pre-transformed mesh, so they can be drawn with a single draw call
+	///
+	/// Batches are built when the scene wakes up, after that any changes to a static
+	/// object will only rebuild the batch(es) that the object belongs to, the next
+	/// time that the batches are requested
+	///
+	/// Objects don't tell us about everything (ex: their render component being disabled, or the
+	/// object being removed from the scene), so DetectChanges checks for those each frame
+	/// </summary>
+	class StaticBatcher {
+	public:
+		typedef std::unique_ptr<StaticBatcher> Uptr;
+
+		/// <summary>
+		/// A single merged mesh, and the objects that it was built from
+		/// </summary>
+		struct Batch {
+			Material::Sptr                          BatchMaterial;
+			VertexArrayObject::Sptr                 Mesh;
+			// Weak, so that an object being destroyed is noticed instead of leaving a dangling pointer
+			std::vector<std::weak_ptr<GameObject>>  Members;
+		};
+
+		StaticBatcher(Scene* scene);
+		~StaticBatcher() = default;
+
+		/// <summary>
+		/// Builds all the batches from the scene's static objects, discarding any existing batches
+		/// </summary>
+		void Build();
+
+		/// <summary>
+		/// Notifies the batcher that a static object has changed (transform, mesh, material, or
+		/// it's static flag), so that any batches it is involved with are rebuilt
+		/// </summary>
+		/// <param name="object">The object that was modified</param>
+		void Invalidate(GameObject* object);
+		/// <summary>
+		/// Invalidates the batches for any static objects that have changed without calling Invalidate, such as
+		/// objects whose render component was enabled or disabled, and objects that were removed from the scene.
+		/// This only looks up each static object's render component, so it's cheap enough to call every frame
+		/// </summary>
+		void DetectChanges();
+
+		/// <summary>
+		/// Rebuilds any batches that have been invalidated, and returns the current list of batches
+		/// </summary>
+		const std::vector<std::shared_ptr<Batch>>& GetBatches();
+		/// <summary>
+		/// Returns true if any batches have been invalidated, and will be rebuilt by the next call to GetBatches
+		/// </summary>
+		bool HasPendingRebuilds() const { return !_dirtyMaterials.empty(); }
+
+		/// <summary>
+		/// Returns true if the object is currently being drawn as part of a batch, and should
+		/// not be drawn by itself
+		/// </summary>
+		bool IsBatched(const GameObject* object) const;
+
+		/// <summary>
+		/// Draws the batch info to the current ImGui window
+		/// </summary>
+		void RenderImGui();
+
+	protected:
+		Scene* _scene;
+		bool   _isBuilt;
+
+		std::vector<std::shared_ptr<Batch>>                 _batches;
+		// Maps from objects to the batch that they are a part of. The keys are only used for lookups, they are never
+		// dereferenced, since the object may have been destroyed
+		std::unordered_map<const GameObject*, Batch*>       _objectBatches;
+		// Maps from static objects to the material they were last batched with, so that material changes
+		// can invalidate the old batch. Same as above, the keys are never dereferenced
+		std::unordered_map<const GameObject*, Material*>    _objectMaterials;
+		// The materials which need to have their batches rebuilt
+		std::unordered_set<Material*>                       _dirtyMaterials;
+
+		/// <summary>
+		/// Rebuilds the batch for a single material from the objects in the scene
+		/// </summary>
+		void _RebuildMaterial(Material* material);
+		/// <summary>
+		/// Removes the batch for a material, if it exists
+		/// </summary>
+		void _RemoveBatch(Material* material);
+		/// <summary>
+		/// Merges the meshes for the given objects into a single pre-transformed mesh
+		/// </summary>
+		static VertexArrayObject::Sptr _MergeMeshes(const std::vector<std::shared_ptr<GameObject>>& objects);
+		/// <summary>
+		/// Returns true if the object is static, and has a render component we can merge into a batch
+		/// </summary>
+		static bool _IsBatchable(GameObject* object);
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+namespace Gameplay {
+	/// <summary>
+	/// Where one of the rails around the edge of the air hockey table sits. The rails all use the same
+	/// mesh, which runs along the X axis and is stretched to the rail's length
+	/// </summary>
+	struct TableRail {
+		glm::vec3 Position;
+		// Rotation around the Z axis, in degrees
+		float     Rotation;
+		// Scale along the X axis
+		float     Length;
+	};
+
+	/// <summary>
+	/// The table's 12 rails, used to build the scene in main.cpp and by the benchmarks that need the same layout
+	/// </summary>
+	inline const TableRail TABLE_RAILS[12] = {
+		{ glm::vec3(-17.230f,   5.540f, -8.02f),  -93.5f, 2.980f },
+		{ glm::vec3(-17.230f,  -5.540f, -8.02f),  -86.5f, 2.980f },
+		{ glm::vec3(-12.790f,  11.280f, -8.02f), -147.1f, 5.080f },
+		{ glm::vec3(-12.790f, -11.280f, -8.02f),  -32.9f, 5.080f },
+		{ glm::vec3( -4.210f,  12.800f, -8.02f),  163.7f, 4.430f },
+		{ glm::vec3( -4.210f, -12.800f, -8.02f),   16.3f, 4.430f },
+		{ glm::vec3(  4.210f,  12.800f, -8.02f), -163.7f, 4.430f },
+		{ glm::vec3(  4.210f, -12.800f, -8.02f),  -16.3f, 4.430f },
+		{ glm::vec3( 12.790f,  11.280f, -8.02f),  147.1f, 5.080f },
+		{ glm::vec3( 12.790f, -11.280f, -8.02f),   32.9f, 5.080f },
+		{ glm::vec3( 17.230f,   5.540f, -8.02f),   93.5f, 2.980f },
+		{ glm::vec3( 17.230f,  -5.540f, -8.02f),   86.5f, 2.980f },
+	};
+}
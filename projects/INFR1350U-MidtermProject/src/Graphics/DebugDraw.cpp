@@ -7,15 +7,13 @@ DebugDrawer::DebugDrawer() :
 	_lineOffset(0),
 	_triangleOffset(0)
 {
-	_linesVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
-	_linesVBO->LoadData<VertexPosCol>(nullptr, LINE_BATCH_SIZE * 2);
+	_lines = PersistentRingBuffer::Create(sizeof(VertexPosCol), LINE_BATCH_SIZE * 2);
 	_linesVAO = VertexArrayObject::Create();
-	_linesVAO->AddVertexBuffer(_linesVBO, VertexPosCol::V_DECL);
+	_linesVAO->AddVertexBuffer(_lines->GetBuffer(), VertexPosCol::V_DECL);
 
-	_trisVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
-	_trisVBO->LoadData<VertexPosCol>(nullptr, TRI_BATCH_SIZE * 3);
+	_tris = PersistentRingBuffer::Create(sizeof(VertexPosCol), TRI_BATCH_SIZE * 3);
 	_trisVAO = VertexArrayObject::Create();
-	_trisVAO->AddVertexBuffer(_trisVBO, VertexPosCol::V_DECL);
+	_trisVAO->AddVertexBuffer(_tris->GetBuffer(), VertexPosCol::V_DECL);
 
 	_colorStack.push(glm::vec3(1.0f));
 	_transformStack.push(glm::mat4(1.0f));
@@ -54,15 +52,13 @@ void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::
 
 void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& color1, const glm::vec3& color2)
 {
-	_lineBuffer[_lineOffset + 0].Color = glm::vec4(color1, 1.0f);
-	_lineBuffer[_lineOffset + 0].Position = p1;
-	_lineBuffer[_lineOffset + 1].Color = glm::vec4(color2, 1.0f);
-	_lineBuffer[_lineOffset + 1].Position = p2;
+	VertexPosCol* verts = _Reserve(_lines, _lineOffset, 2, &DebugDrawer::FlushLines);
+	verts[0].Color = glm::vec4(color1, 1.0f);
+	verts[0].Position = p1;
+	verts[1].Color = glm::vec4(color2, 1.0f);
+	verts[1].Position = p2;
 
 	_lineOffset += 2;
-	if (_lineOffset >= LINE_BATCH_SIZE) {
-		FlushLines();
-	}
 }
 
 void DebugDrawer::FlushLines()
@@ -70,17 +66,10 @@ void DebugDrawer::FlushLines()
 	if (_lineOffset > 0) {
 		__Shader->Bind();
 		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_linesVBO->LoadData<VertexPosCol>(_lineBuffer, LINE_BATCH_SIZE * 2);
-		_linesVAO->Bind();
-		_linesVAO->Draw(DrawMode::LineList);
-		_linesVAO->Unbind();
+		// The vertices are already in the mapped buffer, we just draw the part we've written since the last flush
+		_linesVAO->Draw(DrawMode::LineList, _lines->GetHead(), (uint32_t)_lineOffset);
+		_lines->Advance(_lineOffset);
 		_lineOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
 	}
 }
 
@@ -95,17 +84,15 @@ void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::v
 
 void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& c3)
 {
-	_triBuffer[_triangleOffset + 0].Color = glm::vec4(c1, 1.0f);
-	_triBuffer[_triangleOffset + 0].Position = p1;
-	_triBuffer[_triangleOffset + 1].Color = glm::vec4(c2, 1.0f);
-	_triBuffer[_triangleOffset + 1].Position = p2;
-	_triBuffer[_triangleOffset + 2].Color = glm::vec4(c3, 1.0f);
-	_triBuffer[_triangleOffset + 2].Position = p3;
+	VertexPosCol* verts = _Reserve(_tris, _triangleOffset, 3, &DebugDrawer::FlushTris);
+	verts[0].Color = glm::vec4(c1, 1.0f);
+	verts[0].Position = p1;
+	verts[1].Color = glm::vec4(c2, 1.0f);
+	verts[1].Position = p2;
+	verts[2].Color = glm::vec4(c3, 1.0f);
+	verts[2].Position = p3;
 
 	_triangleOffset += 3;
-	if (_triangleOffset >= TRI_BATCH_SIZE) {
-		FlushTris();
-	}
 }
 
 void DebugDrawer::FlushTris()
@@ -113,20 +100,21 @@ void DebugDrawer::FlushTris()
 	if (_triangleOffset > 0) {
 		__Shader->Bind();
 		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_trisVBO->LoadData<VertexPosCol>(_triBuffer, TRI_BATCH_SIZE * 3);
-		_trisVAO->Bind();
-		_trisVAO->Draw(DrawMode::LineList);
-		_trisVAO->Unbind();
+		_trisVAO->Draw(DrawMode::TriangleList, _tris->GetHead(), (uint32_t)_triangleOffset);
+		_tris->Advance(_triangleOffset);
 		_triangleOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
 	}
 }
 
+VertexPosCol* DebugDrawer::_Reserve(const PersistentRingBuffer::Sptr& buffer, size_t& pending, size_t count, void (DebugDrawer::*flush)()) {
+	// If the segment is full, we draw what we have and move on to the next segment
+	if (buffer->GetRemaining() < pending + count) {
+		(this->*flush)();
+		buffer->NextSegment();
+	}
+	return buffer->GetWritePointer<VertexPosCol>() + pending;
+}
+
 void DebugDrawer::FlushAll()
 {
 	FlushLines();
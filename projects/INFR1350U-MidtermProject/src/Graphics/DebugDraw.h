@@ -3,6 +3,7 @@
 #include <stack>
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Shader.h"
+#include "Graphics/PersistentRingBuffer.h"
 
 /// <summary>
 /// Utility class for drawing lines and triangles in an immediate mode style
@@ -125,6 +126,11 @@ public:
 	/// </summary>
 	void SetViewProjection(const glm::mat4& viewProjection);
 
+	/// <summary>
+	/// Gets the number of times that we've had to wait on the GPU for room in our vertex buffers
+	/// </summary>
+	uint32_t GetStallCount() const { return _lines->GetStallCount() + _tris->GetStallCount(); }
+
 protected:
 	DebugDrawer();
 
@@ -133,15 +139,22 @@ protected:
 	glm::mat4    _viewProjection;
 	glm::mat4    _worldMatrix;
 
+	// The number of vertices that have been written to the ring buffers but not drawn yet
 	size_t       _lineOffset;
-	VertexPosCol _lineBuffer[LINE_BATCH_SIZE * 2];
 	size_t       _triangleOffset;
-	VertexPosCol _triBuffer[TRI_BATCH_SIZE * 3];
 
-	VertexBuffer::Sptr _linesVBO;
-	VertexArrayObject::Sptr _linesVAO;
-	VertexBuffer::Sptr _trisVBO;
-	VertexArrayObject::Sptr _trisVAO;
+	// Vertices are written straight into these, each segment holds a full batch
+	PersistentRingBuffer::Sptr _lines;
+	VertexArrayObject::Sptr    _linesVAO;
+	PersistentRingBuffer::Sptr _tris;
+	VertexArrayObject::Sptr    _trisVAO;
+
+	/// <summary>
+	/// Makes sure there is room for count more vertices in a ring buffer, flushing and moving to
+	/// the next segment if there isn't
+	/// </summary>
+	/// <returns>A pointer to where the vertices should be written</returns>
+	VertexPosCol* _Reserve(const PersistentRingBuffer::Sptr& buffer, size_t& pending, size_t count, void (DebugDrawer::*flush)());
 
 	inline static DebugDrawer* __Instance = nullptr;
 	inline static Shader::Sptr __Shader = nullptr;
@@ -0,0 +1,41 @@
+#pragma once
+#include "IBuffer.h"
+#include <cstdint>
+#include <memory>
+
+/// <summary>
+/// The layout that OpenGL expects for a single command in an indirect indexed draw
+/// </summary>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glMultiDrawElementsIndirect.xhtml</see>
+struct DrawElementsIndirectCommand {
+	uint32_t Count;
+	uint32_t InstanceCount;
+	uint32_t FirstIndex;
+	int32_t  BaseVertex;
+	uint32_t BaseInstance;
+};
+
+/// <summary>
+/// The draw indirect buffer stores a list of DrawElementsIndirectCommands, so that we can submit
+/// many draws with a single glMultiDrawElementsIndirect call
+/// </summary>
+class DrawIndirectBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<DrawIndirectBuffer> Sptr;
+
+	static inline Sptr Create(BufferUsage usage = BufferUsage::StreamDraw) {
+		return std::make_shared<DrawIndirectBuffer>(usage);
+	}
+
+	/// <summary>
+	/// Creates a new draw indirect buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_STREAM_DRAW since we usually refill these every frame</param>
+	DrawIndirectBuffer(BufferUsage usage = BufferUsage::StreamDraw) : IBuffer(BufferType::DrawIndirect, usage) { }
+
+	/// <summary>
+	/// Unbinds the current draw indirect buffer
+	/// </summary>
+	static void UnBind() { IBuffer::UnBind(BufferType::DrawIndirect); }
+};
@@ -0,0 +1,85 @@
+#include "Graphics/Framebuffer.h"
+#include <stb_image_write.h>
+#include <Logging.h>
+
+Framebuffer::Framebuffer(int width, int height) :
+	_handle(0),
+	_colorBuffer(0),
+	_depthBuffer(0),
+	_width(width),
+	_height(height)
+{
+	_Create();
+}
+
+Framebuffer::~Framebuffer() {
+	_Destroy();
+}
+
+void Framebuffer::Resize(int width, int height) {
+	if (width != _width || height != _height) {
+		_Destroy();
+		_width = width;
+		_height = height;
+		_Create();
+	}
+}
+
+void Framebuffer::Bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, _handle);
+	glViewport(0, 0, _width, _height);
+}
+
+void Framebuffer::Unbind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::ReadPixels(std::vector<uint8_t>& output) const {
+	output.resize((size_t)_width * _height * 4);
+	// Our rows are tightly packed, the default alignment of 4 happens to work for RGBA8 but we don't want to rely on it
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glNamedFramebufferReadBuffer(_handle, GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _handle);
+	glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, output.data());
+}
+
+bool Framebuffer::SaveToFile(const std::string& path) const {
+	std::vector<uint8_t> pixels;
+	ReadPixels(pixels);
+	// OpenGL gives us the bottom row first, images expect the top row first
+	stbi_flip_vertically_on_write(true);
+	bool result = stbi_write_png(path.c_str(), _width, _height, 4, pixels.data(), _width * 4) != 0;
+	if (!result) {
+		LOG_ERROR("Failed to write framebuffer to \"{}\"", path);
+	}
+	return result;
+}
+
+void Framebuffer::_Create() {
+	glCreateRenderbuffers(1, &_colorBuffer);
+	glNamedRenderbufferStorage(_colorBuffer, GL_RGBA8, _width, _height);
+	glCreateRenderbuffers(1, &_depthBuffer);
+	glNamedRenderbufferStorage(_depthBuffer, GL_DEPTH_COMPONENT24, _width, _height);
+
+	glCreateFramebuffers(1, &_handle);
+	glNamedFramebufferRenderbuffer(_handle, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorBuffer);
+	glNamedFramebufferRenderbuffer(_handle, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+
+	GLenum status = glCheckNamedFramebufferStatus(_handle, GL_FRAMEBUFFER);
+	LOG_ASSERT(status == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is not complete, status 0x{:X}", status);
+}
+
+void Framebuffer::_Destroy() {
+	if (_handle != 0) {
+		glDeleteFramebuffers(1, &_handle);
+		_handle = 0;
+	}
+	if (_colorBuffer != 0) {
+		glDeleteRenderbuffers(1, &_colorBuffer);
+		_colorBuffer = 0;
+	}
+	if (_depthBuffer != 0) {
+		glDeleteRenderbuffers(1, &_depthBuffer);
+		_depthBuffer = 0;
+	}
+}
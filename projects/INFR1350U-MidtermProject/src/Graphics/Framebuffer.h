@@ -0,0 +1,71 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A simple offscreen render target, with an RGBA8 color buffer and a 24 bit depth buffer. Used
+/// when we don't have a window to draw to, for instance when rendering offscreen with a hidden window
+/// </summary>
+class Framebuffer final {
+public:
+	typedef std::shared_ptr<Framebuffer> Sptr;
+
+	static inline Sptr Create(int width, int height) {
+		return std::make_shared<Framebuffer>(width, height);
+	}
+
+	/// <summary>
+	/// Creates a new framebuffer with the given size in pixels
+	/// </summary>
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	Framebuffer(const Framebuffer& other) = delete;
+	Framebuffer(Framebuffer&& other) = delete;
+	Framebuffer& operator=(const Framebuffer& other) = delete;
+	Framebuffer& operator=(Framebuffer&& other) = delete;
+
+	int GetWidth() const { return _width; }
+	int GetHeight() const { return _height; }
+	GLuint GetHandle() const { return _handle; }
+
+	/// <summary>
+	/// Re-creates the attachments at a new size, the contents are lost
+	/// </summary>
+	void Resize(int width, int height);
+
+	/// <summary>
+	/// Binds this framebuffer for drawing and reading, and sets the viewport to cover it
+	/// </summary>
+	void Bind();
+	/// <summary>
+	/// Binds the default framebuffer (ie the window) again
+	/// </summary>
+	static void Unbind();
+
+	/// <summary>
+	/// Reads the color buffer back into tightly packed RGBA8 pixels, with the bottom row first. This waits
+	/// for the GPU to finish drawing to the framebuffer
+	/// </summary>
+	/// <param name="output">The vector to store the pixels in, will be resized to fit</param>
+	void ReadPixels(std::vector<uint8_t>& output) const;
+	/// <summary>
+	/// Reads the color buffer back and writes it to a PNG file
+	/// </summary>
+	/// <param name="path">The path of the file to write</param>
+	/// <returns>True if the file was written</returns>
+	bool SaveToFile(const std::string& path) const;
+
+protected:
+	GLuint _handle;
+	GLuint _colorBuffer;
+	GLuint _depthBuffer;
+	int    _width;
+	int    _height;
+
+	void _Create();
+	void _Destroy();
+};
@@ -0,0 +1,274 @@
+#include "Graphics/GeometryArena.h"
+#include <algorithm>
+#include <cstring>
+#include <Logging.h>
+
+#include "Utils/ImGuiHelper.h"
+
+ArenaAllocation::ArenaAllocation() :
+	Arena(nullptr),
+	BaseVertex(0),
+	VertexCount(0),
+	FirstIndex(0),
+	IndexCount(0)
+{ }
+
+ArenaAllocation::~ArenaAllocation() {
+	if (Arena != nullptr) {
+		Arena->_Free(*this);
+	}
+}
+
+DrawElementsIndirectCommand ArenaAllocation::GetDrawCommand() const {
+	DrawElementsIndirectCommand result;
+	result.Count         = IndexCount;
+	result.InstanceCount = 1;
+	result.FirstIndex    = FirstIndex;
+	result.BaseVertex    = (int32_t)BaseVertex;
+	result.BaseInstance  = 0;
+	return result;
+}
+
+void ArenaAllocation::Draw(DrawMode mode, uint32_t first, uint32_t count) const {
+	// Grab the VAO every time, since it gets replaced when the arena grows
+	Arena->GetVao()->Bind();
+	size_t indexSize = GetIndexTypeSize(Arena->_indexType);
+	glDrawElementsBaseVertex((GLenum)mode, count, (GLenum)Arena->_indexType, (const void*)((FirstIndex + first) * indexSize), (GLint)BaseVertex);
+}
+
+void ArenaAllocation::ReadVertices(std::vector<uint8_t>& outVertices) const {
+	outVertices.resize((size_t)VertexCount * Arena->_vertexStride);
+	glGetNamedBufferSubData(Arena->_vertices->GetHandle(), (GLintptr)BaseVertex * Arena->_vertexStride, outVertices.size(), outVertices.data());
+}
+
+void ArenaAllocation::ReadIndices(std::vector<uint32_t>& outIndices) const {
+	outIndices.resize(IndexCount);
+	GLuint handle = Arena->_indices->GetHandle();
+	if (Arena->_indexType == IndexType::UShort) {
+		std::vector<uint16_t> narrow(IndexCount);
+		glGetNamedBufferSubData(handle, (GLintptr)FirstIndex * sizeof(uint16_t), narrow.size() * sizeof(uint16_t), narrow.data());
+		std::copy(narrow.begin(), narrow.end(), outIndices.begin());
+	} else {
+		glGetNamedBufferSubData(handle, (GLintptr)FirstIndex * sizeof(uint32_t), outIndices.size() * sizeof(uint32_t), outIndices.data());
+	}
+}
+
+std::map<std::pair<std::type_index, IndexType>, GeometryArena::Sptr> GeometryArena::_sharedArenas;
+
+const GeometryArena::Sptr& GeometryArena::Get(std::type_index type, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, IndexType indexType) {
+	// References into a map stay valid when other arenas are added, so we can hand this out
+	Sptr& arena = _sharedArenas[std::make_pair(type, indexType)];
+	if (arena == nullptr) {
+		arena = Create(vDecl, vertexStride, indexType);
+	}
+	return arena;
+}
+
+void GeometryArena::Cleanup() {
+	for (auto& [key, arena] : _sharedArenas) {
+		if (arena.use_count() > 1) {
+			LOG_WARN("Geometry arena still has {} allocations at cleanup, it will be freed with it's last mesh", arena->GetAllocationCount());
+		}
+	}
+	_sharedArenas.clear();
+}
+
+bool GeometryArena::IsIndirectSupported() {
+	// Only need to check the extension list once, it can't change for the lifetime of the context
+	static int supported = -1;
+	if (supported == -1) {
+		supported = 0;
+		if (GLAD_GL_VERSION_4_3) {
+			GLint extensionCount = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+			for (GLint ix = 0; ix < extensionCount; ix++) {
+				if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, ix), "GL_ARB_shader_draw_parameters") == 0) {
+					supported = 1;
+					break;
+				}
+			}
+		}
+		LOG_INFO("Multi-draw indirect is {}", supported ? "supported" : "not supported, falling back to individual draws");
+	}
+	return supported == 1;
+}
+
+void GeometryArena::RenderSharedImGui() {
+	for (auto& [key, arena] : _sharedArenas) {
+		ImGui::PushID(arena.get());
+		if (ImGui::TreeNode("Arena", "%s (%u B/vertex, %s indices)", key.first.name(), arena->_vertexStride, (~arena->_indexType).c_str())) {
+			arena->RenderImGui();
+			ImGui::TreePop();
+		}
+		ImGui::PopID();
+	}
+}
+
+GeometryArena::GeometryArena(const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, IndexType indexType, uint32_t vertexCapacity, uint32_t indexCapacity) :
+	_vDecl(vDecl),
+	_vertexStride(vertexStride),
+	_indexType(indexType),
+	_vertices(nullptr),
+	_indices(nullptr),
+	_vao(nullptr),
+	_vertexCapacity(0),
+	_indexCapacity(0),
+	_verticesUsed(0),
+	_indicesUsed(0),
+	_allocationCount(0),
+	_freeVertices(std::vector<FreeRange>()),
+	_freeIndices(std::vector<FreeRange>())
+{
+	LOG_ASSERT(indexType == IndexType::UShort || indexType == IndexType::UInt, "Geometry arenas only support 16 and 32 bit indices");
+	_Grow(vertexCapacity, indexCapacity);
+}
+
+ArenaAllocation::Sptr GeometryArena::Allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+	if (vertexCount == 0) {
+		return nullptr;
+	}
+	LOG_ASSERT(GetSmallestIndexType(vertexCount) != IndexType::UInt || _indexType == IndexType::UInt, "Mesh has too many vertices for this arena's index type!");
+
+	// Un-indexed meshes just draw their vertices in order
+	std::vector<uint32_t> sequential;
+	if (indices == nullptr) {
+		sequential.resize(vertexCount);
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			sequential[ix] = ix;
+		}
+		indices = sequential.data();
+		indexCount = vertexCount;
+	}
+
+	int64_t vertexOffset = _AllocRange(_freeVertices, vertexCount);
+	int64_t indexOffset  = _AllocRange(_freeIndices, indexCount);
+
+	// If either buffer is full, put back what we got and grow the arena
+	if (vertexOffset < 0 || indexOffset < 0) {
+		if (vertexOffset >= 0) {
+			_FreeRange(_freeVertices, (uint32_t)vertexOffset, vertexCount);
+		}
+		if (indexOffset >= 0) {
+			_FreeRange(_freeIndices, (uint32_t)indexOffset, indexCount);
+		}
+		_Grow(vertexOffset < 0 ? vertexCount : 0, indexOffset < 0 ? indexCount : 0);
+		vertexOffset = _AllocRange(_freeVertices, vertexCount);
+		indexOffset  = _AllocRange(_freeIndices, indexCount);
+		LOG_ASSERT(vertexOffset >= 0 && indexOffset >= 0, "Failed to allocate space in geometry arena after growing!");
+	}
+
+	glNamedBufferSubData(_vertices->GetHandle(), vertexOffset * _vertexStride, (GLsizeiptr)vertexCount * _vertexStride, vertices);
+	if (_indexType == IndexType::UShort) {
+		std::vector<uint16_t> narrowed(indices, indices + indexCount);
+		glNamedBufferSubData(_indices->GetHandle(), indexOffset * sizeof(uint16_t), (GLsizeiptr)indexCount * sizeof(uint16_t), narrowed.data());
+	} else {
+		glNamedBufferSubData(_indices->GetHandle(), indexOffset * sizeof(uint32_t), (GLsizeiptr)indexCount * sizeof(uint32_t), indices);
+	}
+
+	ArenaAllocation::Sptr result = std::make_shared<ArenaAllocation>();
+	result->Arena       = shared_from_this();
+	result->BaseVertex  = (uint32_t)vertexOffset;
+	result->VertexCount = vertexCount;
+	result->FirstIndex  = (uint32_t)indexOffset;
+	result->IndexCount  = indexCount;
+
+	_verticesUsed += vertexCount;
+	_indicesUsed  += indexCount;
+	_allocationCount++;
+	return result;
+}
+
+void GeometryArena::RenderImGui() {
+	ImGui::Text("Allocations: %u", _allocationCount);
+	ImGui::Text("Vertices:    %u / %u (%u free blocks)", _verticesUsed, _vertexCapacity, (uint32_t)_freeVertices.size());
+	ImGui::Text("Indices:     %u / %u (%u free blocks)", _indicesUsed, _indexCapacity, (uint32_t)_freeIndices.size());
+}
+
+void GeometryArena::_Free(const ArenaAllocation& allocation) {
+	_FreeRange(_freeVertices, allocation.BaseVertex, allocation.VertexCount);
+	_FreeRange(_freeIndices, allocation.FirstIndex, allocation.IndexCount);
+	_verticesUsed -= allocation.VertexCount;
+	_indicesUsed  -= allocation.IndexCount;
+	_allocationCount--;
+}
+
+void GeometryArena::_Grow(uint32_t extraVertices, uint32_t extraIndices) {
+	// We double the capacity of whichever buffer ran out, so that loading many meshes doesn't keep copying
+	uint32_t vertexCapacity = extraVertices > 0 ? std::max(_vertexCapacity * 2, _vertexCapacity + extraVertices) : _vertexCapacity;
+	uint32_t indexCapacity  = extraIndices  > 0 ? std::max(_indexCapacity * 2,  _indexCapacity + extraIndices)   : _indexCapacity;
+
+	if (vertexCapacity != _vertexCapacity) {
+		VertexBuffer::Sptr vertices = VertexBuffer::Create();
+		vertices->LoadData(nullptr, _vertexStride, vertexCapacity);
+		if (_vertices != nullptr) {
+			glCopyNamedBufferSubData(_vertices->GetHandle(), vertices->GetHandle(), 0, 0, (GLsizeiptr)_vertexCapacity * _vertexStride);
+		}
+		_FreeRange(_freeVertices, _vertexCapacity, vertexCapacity - _vertexCapacity);
+		_vertices = vertices;
+		_vertexCapacity = vertexCapacity;
+	}
+	if (indexCapacity != _indexCapacity) {
+		IndexBuffer::Sptr indices = IndexBuffer::Create();
+		size_t indexSize = GetIndexTypeSize(_indexType);
+		indices->LoadData(nullptr, indexSize, indexCapacity, _indexType);
+		if (_indices != nullptr) {
+			glCopyNamedBufferSubData(_indices->GetHandle(), indices->GetHandle(), 0, 0, (GLsizeiptr)_indexCapacity * indexSize);
+		}
+		_FreeRange(_freeIndices, _indexCapacity, indexCapacity - _indexCapacity);
+		_indices = indices;
+		_indexCapacity = indexCapacity;
+	}
+
+	LOG_TRACE("Geometry arena resized to {} vertices, {} indices", _vertexCapacity, _indexCapacity);
+	_RebuildVao();
+}
+
+void GeometryArena::_RebuildVao() {
+	_vao = VertexArrayObject::Create();
+	_vao->AddVertexBuffer(_vertices, _vDecl);
+	_vao->SetIndexBuffer(_indices);
+	_vao->SetVDecl(_vDecl);
+}
+
+int64_t GeometryArena::_AllocRange(std::vector<FreeRange>& freeList, uint32_t count) {
+	// First fit, meshes are mostly loaded up front and rarely freed so fragmentation isn't a big concern
+	for (auto it = freeList.begin(); it != freeList.end(); it++) {
+		if (it->Count >= count) {
+			uint32_t offset = it->Offset;
+			it->Offset += count;
+			it->Count  -= count;
+			if (it->Count == 0) {
+				freeList.erase(it);
+			}
+			return offset;
+		}
+	}
+	return -1;
+}
+
+void GeometryArena::_FreeRange(std::vector<FreeRange>& freeList, uint32_t offset, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	// Find the first free range after this one, so we keep the list sorted
+	auto next = std::lower_bound(freeList.begin(), freeList.end(), offset, [](const FreeRange& range, uint32_t value) {
+		return range.Offset < value;
+	});
+	next = freeList.insert(next, { offset, count });
+
+	// Merge with the following range
+	auto after = next + 1;
+	if (after != freeList.end() && next->Offset + next->Count == after->Offset) {
+		next->Count += after->Count;
+		freeList.erase(after);
+	}
+	// Merge with the previous range
+	if (next != freeList.begin()) {
+		auto before = next - 1;
+		if (before->Offset + before->Count == next->Offset) {
+			before->Count += next->Count;
+			freeList.erase(next);
+		}
+	}
+}
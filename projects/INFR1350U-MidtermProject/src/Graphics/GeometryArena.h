@@ -0,0 +1,217 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/DrawIndirectBuffer.h"
+
+class GeometryArena;
+
+/// <summary>
+/// Represents a block of vertices and indices that have been allocated in a GeometryArena,
+/// the block is returned to the arena when the allocation is destroyed
+/// </summary>
+struct ArenaAllocation {
+	typedef std::shared_ptr<ArenaAllocation> Sptr;
+
+	// The arena that this allocation lives in, the allocation keeps it alive
+	std::shared_ptr<GeometryArena> Arena;
+	// The index of the first vertex in the arena's vertex buffer
+	uint32_t BaseVertex;
+	uint32_t VertexCount;
+	// The index of the first index in the arena's index buffer
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+
+	ArenaAllocation();
+	~ArenaAllocation();
+
+	/// <summary>
+	/// Gets the indirect command that will draw this allocation
+	/// </summary>
+	DrawElementsIndirectCommand GetDrawCommand() const;
+	/// <summary>
+	/// Draws a range of this allocation's indices with the arena's VAO, for meshes that can't go through multi-draw indirect
+	/// </summary>
+	/// <param name="mode">The primitive type to draw</param>
+	/// <param name="first">The first index to draw, relative to the start of the allocation</param>
+	/// <param name="count">The number of indices to draw</param>
+	void Draw(DrawMode mode, uint32_t first, uint32_t count) const;
+
+	/// <summary>
+	/// Reads this allocation's vertices back from the arena, stalls until the GPU is done with the buffer
+	/// </summary>
+	/// <param name="outVertices">Receives the raw vertex data, VertexCount vertices of the arena's stride</param>
+	void ReadVertices(std::vector<uint8_t>& outVertices) const;
+	/// <summary>
+	/// Reads this allocation's indices back from the arena, widened to 32 bits and relative to the allocation's first vertex
+	/// </summary>
+	/// <param name="outIndices">Receives the IndexCount indices</param>
+	void ReadIndices(std::vector<uint32_t>& outIndices) const;
+};
+
+/// <summary>
+/// A geometry arena stores the meshes for a single vertex format in one large vertex buffer
+/// and one large index buffer, so that all of them can be drawn without switching VAOs, and
+/// submitted with a single glMultiDrawElementsIndirect
+///
+/// Indices are stored relative to the allocation's first vertex, so 16 bit indices can address any mesh with up to
+/// 65536 vertices no matter where it lands in the arena. Each vertex format has a shared arena per index type, see GetForMesh
+///
+/// The arena is the only copy of a mesh's geometry, meshes with an allocation don't get buffers of their own. Meshes
+/// that can't go through multi-draw indirect (materials with keywords or their own shader, drivers without
+/// GL_ARB_shader_draw_parameters) are drawn from the arena's VAO with a base vertex, see ArenaAllocation::Draw
+/// </summary>
+class GeometryArena final : public std::enable_shared_from_this<GeometryArena> {
+public:
+	typedef std::shared_ptr<GeometryArena> Sptr;
+
+	static inline Sptr Create(const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, IndexType indexType = IndexType::UInt, uint32_t vertexCapacity = 65536, uint32_t indexCapacity = 196608) {
+		return std::make_shared<GeometryArena>(vDecl, vertexStride, indexType, vertexCapacity, indexCapacity);
+	}
+
+	/// <summary>
+	/// Gets the shared arena for the given vertex type and index type, creating it on first use
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the arena, must have a V_DECL</typeparam>
+	/// <param name="indexType">The type of indices stored in the arena, must be UShort or UInt</param>
+	template <typename VertType>
+	static const Sptr& Get(IndexType indexType = IndexType::UInt) {
+		return Get(std::type_index(typeid(VertType)), VertType::V_DECL, sizeof(VertType), indexType);
+	}
+	/// <summary>
+	/// Gets the shared arena that a mesh with the given number of vertices should be allocated in, see GetIndexTypeFor
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the arena, must have a V_DECL</typeparam>
+	template <typename VertType>
+	static const Sptr& GetForMesh(size_t vertexCount) {
+		return Get<VertType>(GetIndexTypeFor(vertexCount));
+	}
+	/// <summary>
+	/// Gets the shared arena for a vertex format, creating it on first use
+	/// </summary>
+	/// <param name="type">The type of vertex stored in the arena, used to look up the arena</param>
+	/// <param name="vDecl">The vertex declaration of the vertex type</param>
+	/// <param name="vertexStride">The size of a single vertex, in bytes</param>
+	/// <param name="indexType">The type of indices stored in the arena, must be UShort or UInt</param>
+	static const Sptr& Get(std::type_index type, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, IndexType indexType);
+	/// <summary>
+	/// Gets the index type of the arena that a mesh with the given number of vertices should go in. We don't use
+	/// byte indices here, they aren't natively supported by most hardware and would make for a lot of tiny arenas
+	/// </summary>
+	static IndexType GetIndexTypeFor(size_t vertexCount) {
+		return GetSmallestIndexType(vertexCount) == IndexType::UInt ? IndexType::UInt : IndexType::UShort;
+	}
+	/// <summary>
+	/// Releases our references to the shared arenas, so their buffers are deleted while we still have a GL
+	/// context. Must be called before the context is destroyed, after the meshes that were allocated in
+	/// them (an arena is kept alive by it's allocations)
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Returns true if the driver supports everything that we need to draw from the arena
+	/// using multi-draw indirect (GL 4.3 and GL_ARB_shader_draw_parameters for gl_DrawIDARB)
+	/// </summary>
+	static bool IsIndirectSupported();
+
+	/// <summary>
+	/// Draws the usage of all the shared arenas to the current ImGui window
+	/// </summary>
+	static void RenderSharedImGui();
+
+	GeometryArena(const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, IndexType indexType, uint32_t vertexCapacity, uint32_t indexCapacity);
+	~GeometryArena() = default;
+
+	GeometryArena(const GeometryArena& other) = delete;
+	GeometryArena(GeometryArena&& other) = delete;
+	GeometryArena& operator=(const GeometryArena& other) = delete;
+	GeometryArena& operator=(GeometryArena&& other) = delete;
+
+	/// <summary>
+	/// Copies a mesh into the arena, growing the arena's buffers if there is not enough room
+	/// </summary>
+	/// <param name="vertices">The vertex data, must match the arena's vertex stride</param>
+	/// <param name="vertexCount">The number of vertices to copy</param>
+	/// <param name="indices">The indices of the mesh, or nullptr to draw the vertices in order. Narrowed to the arena's index type</param>
+	/// <param name="indexCount">The number of indices to copy, ignored if indices is nullptr</param>
+	/// <returns>The new allocation, or nullptr if the mesh is empty</returns>
+	ArenaAllocation::Sptr Allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+	/// <summary>
+	/// Gets the VAO that reads from the arena's buffers, note that this gets replaced when the arena grows
+	/// </summary>
+	const VertexArrayObject::Sptr& GetVao() const { return _vao; }
+	/// <summary>
+	/// Gets the type of indices stored in the arena, this is what draws from the arena must use
+	/// </summary>
+	IndexType GetIndexType() const { return _indexType; }
+	uint32_t GetVertexStride() const { return _vertexStride; }
+
+	uint32_t GetVertexCapacity() const { return _vertexCapacity; }
+	uint32_t GetIndexCapacity() const { return _indexCapacity; }
+	uint32_t GetVerticesUsed() const { return _verticesUsed; }
+	uint32_t GetIndicesUsed() const { return _indicesUsed; }
+	uint32_t GetAllocationCount() const { return _allocationCount; }
+
+	/// <summary>
+	/// Draws the arena's usage to the current ImGui window
+	/// </summary>
+	void RenderImGui();
+
+protected:
+	friend struct ArenaAllocation;
+
+	// A free range of elements in one of our buffers
+	struct FreeRange {
+		uint32_t Offset;
+		uint32_t Count;
+	};
+
+	VertexArrayObject::VertexDeclaration _vDecl;
+	uint32_t _vertexStride;
+	IndexType _indexType;
+
+	VertexBuffer::Sptr      _vertices;
+	IndexBuffer::Sptr       _indices;
+	VertexArrayObject::Sptr _vao;
+
+	uint32_t _vertexCapacity;
+	uint32_t _indexCapacity;
+	uint32_t _verticesUsed;
+	uint32_t _indicesUsed;
+	uint32_t _allocationCount;
+
+	// Free lists for each buffer, sorted by offset
+	std::vector<FreeRange> _freeVertices;
+	std::vector<FreeRange> _freeIndices;
+
+	// The shared arena for each vertex type and index type, see Get
+	static std::map<std::pair<std::type_index, IndexType>, Sptr> _sharedArenas;
+
+	/// <summary>
+	/// Frees a previously allocated range, called by ArenaAllocation's destructor
+	/// </summary>
+	void _Free(const ArenaAllocation& allocation);
+	/// <summary>
+	/// Grows the buffers so that they can fit at least the given number of extra elements,
+	/// existing allocations keep their offsets
+	/// </summary>
+	void _Grow(uint32_t extraVertices, uint32_t extraIndices);
+	/// <summary>
+	/// Recreates the VAO around our current buffers
+	/// </summary>
+	void _RebuildVao();
+
+	/// <summary>
+	/// Finds the first free range that fits count elements, and removes it from the free list
+	/// </summary>
+	/// <returns>The offset of the allocated range, or -1 if there is no room</returns>
+	static int64_t _AllocRange(std::vector<FreeRange>& freeList, uint32_t count);
+	/// <summary>
+	/// Returns a range to the free list, merging it with any neighbouring free ranges
+	/// </summary>
+	static void _FreeRange(std::vector<FreeRange>& freeList, uint32_t offset, uint32_t count);
+};
@@ -357,7 +357,7 @@ constexpr uint32_t ShaderDataTypeComponentCount(ShaderDataType type)
 			return (uint32_t)type & ShaderDataType_Size1Mask * (((uint32_t)type & ShaderDataType_Size2Mask) >> 3);
 			return (uint32_t)type & ShaderDataType_Size1Mask;
 		default:
-			LOG_WARN(false, "Unknown ShaderDataType! {}", type);
+			LOG_WARN("Unknown ShaderDataType! {}", type);
 			return 1;
 	}
 }
@@ -484,3 +484,47 @@ constexpr GLenum ToGLElementType(ShaderDataTypecode typecode) {
 			LOG_ASSERT(false, "Unknown Shader Data Typecode!"); return 0;
 	}
 }
+
+#pragma region Pipeline State
+/// <summary>
+/// The comparison functions available for depth testing
+/// </summary>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glDepthFunc.xhtml</see>
+ENUM(DepthFunc, GLenum,
+	Never        = GL_NEVER,
+	Less         = GL_LESS, // Default
+	Equal        = GL_EQUAL,
+	LessEqual    = GL_LEQUAL,
+	Greater      = GL_GREATER,
+	NotEqual     = GL_NOTEQUAL,
+	GreaterEqual = GL_GEQUAL,
+	Always       = GL_ALWAYS
+);
+
+/// <summary>
+/// The faces that can be culled when face culling is enabled
+/// </summary>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glCullFace.xhtml</see>
+ENUM(CullMode, GLenum,
+	Front        = GL_FRONT,
+	Back         = GL_BACK, // Default
+	FrontAndBack = GL_FRONT_AND_BACK
+);
+
+/// <summary>
+/// Some of the more common factors used for blending
+/// </summary>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBlendFunc.xhtml</see>
+ENUM(BlendFactor, GLenum,
+	Zero             = GL_ZERO,
+	One              = GL_ONE,
+	SrcColor         = GL_SRC_COLOR,
+	OneMinusSrcColor = GL_ONE_MINUS_SRC_COLOR,
+	DstColor         = GL_DST_COLOR,
+	OneMinusDstColor = GL_ONE_MINUS_DST_COLOR,
+	SrcAlpha         = GL_SRC_ALPHA,
+	OneMinusSrcAlpha = GL_ONE_MINUS_SRC_ALPHA,
+	DstAlpha         = GL_DST_ALPHA,
+	OneMinusDstAlpha = GL_ONE_MINUS_DST_ALPHA
+);
+#pragma endregion
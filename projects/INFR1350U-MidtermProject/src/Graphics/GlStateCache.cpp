@@ -0,0 +1,199 @@
+#include "GlStateCache.h"
+#include <algorithm>
+#include "Utils/ImGuiHelper.h"
+
+GLuint GlStateCache::_program     = GlStateCache::UNKNOWN;
+GLuint GlStateCache::_vertexArray = GlStateCache::UNKNOWN;
+std::vector<GLuint> GlStateCache::_textures;
+std::vector<GLuint> GlStateCache::_samplers;
+
+int8_t GlStateCache::_depthTest  = -1;
+int8_t GlStateCache::_depthWrite = -1;
+GLenum GlStateCache::_depthFunc  = GlStateCache::UNKNOWN;
+int8_t GlStateCache::_culling    = -1;
+GLenum GlStateCache::_cullMode   = GlStateCache::UNKNOWN;
+int8_t GlStateCache::_blending   = -1;
+GLenum GlStateCache::_blendSrc   = GlStateCache::UNKNOWN;
+GLenum GlStateCache::_blendDst   = GlStateCache::UNKNOWN;
+
+GlStateCache::FrameStats GlStateCache::_currentStats;
+GlStateCache::FrameStats GlStateCache::_lastStats;
+
+GlStateCache::FrameStats::FrameStats() {
+	std::fill(Issued, Issued + NUM_CALL_TYPES, 0);
+	std::fill(Elided, Elided + NUM_CALL_TYPES, 0);
+}
+
+uint32_t GlStateCache::FrameStats::TotalIssued() const {
+	uint32_t result = 0;
+	for (int ix = 0; ix < NUM_CALL_TYPES; ix++) {
+		result += Issued[ix];
+	}
+	return result;
+}
+
+uint32_t GlStateCache::FrameStats::TotalElided() const {
+	uint32_t result = 0;
+	for (int ix = 0; ix < NUM_CALL_TYPES; ix++) {
+		result += Elided[ix];
+	}
+	return result;
+}
+
+void GlStateCache::UseProgram(GLuint program) {
+	if (_Update(_program, program, GlStateCall::Program)) {
+		glUseProgram(program);
+	}
+}
+
+void GlStateCache::BindVertexArray(GLuint vao) {
+	if (_Update(_vertexArray, vao, GlStateCall::VertexArray)) {
+		glBindVertexArray(vao);
+	}
+}
+
+void GlStateCache::BindTextureUnit(uint32_t unit, GLuint texture) {
+	if (_Update(_GetUnitSlot(_textures, unit), texture, GlStateCall::Texture)) {
+		glBindTextureUnit(unit, texture);
+	}
+}
+
+void GlStateCache::BindSampler(uint32_t unit, GLuint sampler) {
+	if (_Update(_GetUnitSlot(_samplers, unit), sampler, GlStateCall::Sampler)) {
+		glBindSampler(unit, sampler);
+	}
+}
+
+void GlStateCache::SetDepthTest(bool enabled) {
+	_SetCapability(_depthTest, GL_DEPTH_TEST, enabled, GlStateCall::Depth);
+}
+
+void GlStateCache::SetDepthWrite(bool enabled) {
+	if (_Update(_depthWrite, (int8_t)enabled, GlStateCall::Depth)) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GlStateCache::SetDepthFunc(DepthFunc func) {
+	if (_Update(_depthFunc, (GLenum)func, GlStateCall::Depth)) {
+		glDepthFunc((GLenum)func);
+	}
+}
+
+void GlStateCache::SetCulling(bool enabled) {
+	_SetCapability(_culling, GL_CULL_FACE, enabled, GlStateCall::Cull);
+}
+
+void GlStateCache::SetCullMode(CullMode mode) {
+	if (_Update(_cullMode, (GLenum)mode, GlStateCall::Cull)) {
+		glCullFace((GLenum)mode);
+	}
+}
+
+void GlStateCache::SetBlending(bool enabled) {
+	_SetCapability(_blending, GL_BLEND, enabled, GlStateCall::Blend);
+}
+
+void GlStateCache::SetBlendFunc(BlendFactor src, BlendFactor dst) {
+	// Both factors are set in a single call, so only count this as one
+	if (_blendSrc == (GLenum)src && _blendDst == (GLenum)dst) {
+		_currentStats.Elided[(int)GlStateCall::Blend]++;
+		return;
+	}
+	_blendSrc = (GLenum)src;
+	_blendDst = (GLenum)dst;
+	_currentStats.Issued[(int)GlStateCall::Blend]++;
+	glBlendFunc((GLenum)src, (GLenum)dst);
+}
+
+void GlStateCache::NotifyProgramDeleted(GLuint program) {
+	// Deleting the active program does not unbind it, but the handle may be re-used
+	if (_program == program) {
+		_program = UNKNOWN;
+	}
+}
+
+void GlStateCache::NotifyVertexArrayDeleted(GLuint vao) {
+	// Deleting a bound VAO reverts the binding to 0
+	if (_vertexArray == vao) {
+		_vertexArray = 0;
+	}
+}
+
+void GlStateCache::NotifyTextureDeleted(GLuint texture) {
+	// Deleting a texture unbinds it from all units
+	for (GLuint& slot : _textures) {
+		if (slot == texture) {
+			slot = 0;
+		}
+	}
+}
+
+void GlStateCache::NotifySamplerDeleted(GLuint sampler) {
+	for (GLuint& slot : _samplers) {
+		if (slot == sampler) {
+			slot = 0;
+		}
+	}
+}
+
+void GlStateCache::Invalidate() {
+	_program     = UNKNOWN;
+	_vertexArray = UNKNOWN;
+	std::fill(_textures.begin(), _textures.end(), UNKNOWN);
+	std::fill(_samplers.begin(), _samplers.end(), UNKNOWN);
+	_depthTest  = -1;
+	_depthWrite = -1;
+	_depthFunc  = UNKNOWN;
+	_culling    = -1;
+	_cullMode   = UNKNOWN;
+	_blending   = -1;
+	_blendSrc   = UNKNOWN;
+	_blendDst   = UNKNOWN;
+}
+
+void GlStateCache::NewFrame() {
+	_lastStats = _currentStats;
+	_currentStats = FrameStats();
+}
+
+const GlStateCache::FrameStats& GlStateCache::GetLastFrameStats() {
+	return _lastStats;
+}
+
+void GlStateCache::DrawStatsGui() {
+	ImGui::Columns(3, "gl_state_stats");
+	ImGui::Separator();
+	ImGui::Text("State");  ImGui::NextColumn();
+	ImGui::Text("Issued"); ImGui::NextColumn();
+	ImGui::Text("Elided"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (int ix = 0; ix < NUM_CALL_TYPES; ix++) {
+		ImGui::TextUnformatted((~(GlStateCall)ix).c_str()); ImGui::NextColumn();
+		ImGui::Text("%u", _lastStats.Issued[ix]);           ImGui::NextColumn();
+		ImGui::Text("%u", _lastStats.Elided[ix]);           ImGui::NextColumn();
+	}
+	ImGui::Separator();
+	ImGui::Text("Total");                            ImGui::NextColumn();
+	ImGui::Text("%u", _lastStats.TotalIssued());    ImGui::NextColumn();
+	ImGui::Text("%u", _lastStats.TotalElided());    ImGui::NextColumn();
+	ImGui::Columns(1);
+	ImGui::Separator();
+}
+
+void GlStateCache::_SetCapability(int8_t& cached, GLenum cap, bool enabled, GlStateCall type) {
+	if (_Update(cached, (int8_t)enabled, type)) {
+		if (enabled) {
+			glEnable(cap);
+		} else {
+			glDisable(cap);
+		}
+	}
+}
+
+GLuint& GlStateCache::_GetUnitSlot(std::vector<GLuint>& slots, uint32_t unit) {
+	if (unit >= slots.size()) {
+		slots.resize(unit + 1, UNKNOWN);
+	}
+	return slots[unit];
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include <EnumToString.h>
+#include "Graphics/GlEnums.h"
+
+/// <summary>
+/// The categories of state changes that the state cache tracks, used for reporting
+/// </summary>
+ENUM(GlStateCall, uint8_t,
+	Program     = 0,
+	VertexArray = 1,
+	Texture     = 2,
+	Sampler     = 3,
+	Depth       = 4,
+	Cull        = 5,
+	Blend       = 6
+);
+
+/// <summary>
+/// Central cache for the OpenGL pipeline state, so that we can skip API calls
+/// that would not actually change anything. All binding and state changes in our
+/// graphics classes should be routed through here, if something modifies the GL
+/// state behind our back, call Invalidate() so we stop trusting our cached values
+/// </summary>
+class GlStateCache {
+public:
+	// Number of categories in GlStateCall
+	static const int NUM_CALL_TYPES = 7;
+
+	/// <summary>
+	/// Counts of the calls that were made to the state cache over a single frame
+	/// </summary>
+	struct FrameStats {
+		uint32_t Issued[NUM_CALL_TYPES];
+		uint32_t Elided[NUM_CALL_TYPES];
+
+		FrameStats();
+
+		uint32_t TotalIssued() const;
+		uint32_t TotalElided() const;
+	};
+
+	GlStateCache() = delete;
+
+	/// <summary>
+	/// Sets the active shader program (glUseProgram)
+	/// </summary>
+	/// <param name="program">The program to bind, or 0 to unbind</param>
+	static void UseProgram(GLuint program);
+	/// <summary>
+	/// Sets the active vertex array object (glBindVertexArray)
+	/// </summary>
+	/// <param name="vao">The VAO to bind, or 0 to unbind</param>
+	static void BindVertexArray(GLuint vao);
+	/// <summary>
+	/// Binds a texture to the given texture unit (glBindTextureUnit)
+	/// </summary>
+	/// <param name="unit">The texture unit to bind to</param>
+	/// <param name="texture">The texture to bind, or 0 to unbind</param>
+	static void BindTextureUnit(uint32_t unit, GLuint texture);
+	/// <summary>
+	/// Binds a sampler object to the given texture unit (glBindSampler)
+	/// </summary>
+	/// <param name="unit">The texture unit to bind to</param>
+	/// <param name="sampler">The sampler to bind, or 0 to use the texture's sampling parameters</param>
+	static void BindSampler(uint32_t unit, GLuint sampler);
+
+	/// <summary>
+	/// Enables or disables depth testing (GL_DEPTH_TEST)
+	/// </summary>
+	static void SetDepthTest(bool enabled);
+	/// <summary>
+	/// Enables or disables writing to the depth buffer (glDepthMask)
+	/// </summary>
+	static void SetDepthWrite(bool enabled);
+	/// <summary>
+	/// Sets the comparison used for depth testing (glDepthFunc)
+	/// </summary>
+	static void SetDepthFunc(DepthFunc func);
+
+	/// <summary>
+	/// Enables or disables face culling (GL_CULL_FACE)
+	/// </summary>
+	static void SetCulling(bool enabled);
+	/// <summary>
+	/// Sets which faces will be culled when culling is enabled (glCullFace)
+	/// </summary>
+	static void SetCullMode(CullMode mode);
+
+	/// <summary>
+	/// Enables or disables blending (GL_BLEND)
+	/// </summary>
+	static void SetBlending(bool enabled);
+	/// <summary>
+	/// Sets the blending factors (glBlendFunc)
+	/// </summary>
+	static void SetBlendFunc(BlendFactor src, BlendFactor dst);
+
+	/// <summary>
+	/// Notifies the cache that a GL object has been deleted, since OpenGL will
+	/// silently unbind deleted objects and may re-use the handle
+	/// </summary>
+	static void NotifyProgramDeleted(GLuint program);
+	static void NotifyVertexArrayDeleted(GLuint vao);
+	static void NotifyTextureDeleted(GLuint texture);
+	static void NotifySamplerDeleted(GLuint sampler);
+
+	/// <summary>
+	/// Forgets all cached state, the next call for each piece of state will always
+	/// be issued to OpenGL. Use this after handing the context to code that does not
+	/// use the cache
+	/// </summary>
+	static void Invalidate();
+
+	/// <summary>
+	/// Marks the start of a new frame, moving the current counters into the last frame stats
+	/// </summary>
+	static void NewFrame();
+	/// <summary>
+	/// Gets the issued vs elided call counts from the last completed frame
+	/// </summary>
+	static const FrameStats& GetLastFrameStats();
+
+	/// <summary>
+	/// Draws the stats for the last frame into the current ImGui window
+	/// </summary>
+	static void DrawStatsGui();
+
+protected:
+	// Sentinel we use for state that we do not know the value of
+	static const GLuint UNKNOWN = ~0u;
+
+	static GLuint _program;
+	static GLuint _vertexArray;
+	static std::vector<GLuint> _textures;
+	static std::vector<GLuint> _samplers;
+
+	// For booleans, -1 means we do not know the state
+	static int8_t _depthTest;
+	static int8_t _depthWrite;
+	static GLenum _depthFunc;
+	static int8_t _culling;
+	static GLenum _cullMode;
+	static int8_t _blending;
+	static GLenum _blendSrc;
+	static GLenum _blendDst;
+
+	static FrameStats _currentStats;
+	static FrameStats _lastStats;
+
+	/// <summary>
+	/// Compares and updates a cached value, recording stats for the call
+	/// </summary>
+	/// <returns>True if the value has changed and the GL call should be issued</returns>
+	template <typename T>
+	static bool _Update(T& cached, T value, GlStateCall type) {
+		if (cached == value) {
+			_currentStats.Elided[(int)type]++;
+			return false;
+		}
+		cached = value;
+		_currentStats.Issued[(int)type]++;
+		return true;
+	}
+
+	static void _SetCapability(int8_t& cached, GLenum cap, bool enabled, GlStateCall type);
+	static GLuint& _GetUnitSlot(std::vector<GLuint>& slots, uint32_t unit);
+};
@@ -0,0 +1,15 @@
+#include "Graphics/GpuFence.h"
+
+bool GpuFence::IsSignalled(GLsync fence, bool wait) {
+	if (fence == nullptr) {
+		return true;
+	}
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	// The first wait needs to flush, otherwise the fence may never be submitted
+	GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (wait && result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, waitFlags, 1000000);
+		waitFlags = 0;
+	}
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
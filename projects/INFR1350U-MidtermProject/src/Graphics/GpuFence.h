@@ -0,0 +1,19 @@
+#pragma once
+#include <glad/glad.h>
+
+/// <summary>
+/// Helpers for the fences that we put after commands that read CPU written memory (ex: our persistently
+/// mapped buffers), so that we know when it is safe to write to that memory again
+/// </summary>
+class GpuFence {
+public:
+	GpuFence() = delete;
+
+	/// <summary>
+	/// Checks if the GPU has passed a fence, optionally blocking until it has
+	/// </summary>
+	/// <param name="fence">The fence to check, nullptr counts as signalled</param>
+	/// <param name="wait">True to block until the fence is signalled, false to only check it without flushing</param>
+	/// <returns>True if the fence has been signalled</returns>
+	static bool IsSignalled(GLsync fence, bool wait);
+};
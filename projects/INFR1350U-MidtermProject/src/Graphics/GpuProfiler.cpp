@@ -0,0 +1,347 @@
+#include "Graphics/GpuProfiler.h"
+#include <algorithm>
+#include <Logging.h>
+
+#include "Utils/ImGuiHelper.h"
+
+bool                                      GpuProfiler::_isSupported = false;
+uint64_t                                  GpuProfiler::_frame = 0;
+uint32_t                                  GpuProfiler::_droppedFrames = 0;
+GpuProfiler::FrameRecord                  GpuProfiler::_frames[FRAME_LATENCY];
+std::vector<GLuint>                       GpuProfiler::_freeQueries;
+std::vector<GpuProfiler::PassHistory>     GpuProfiler::_passes;
+std::unordered_map<std::string, uint32_t> GpuProfiler::_passLookup;
+GpuProfiler::PassHistory                  GpuProfiler::_frameHistory;
+int                                       GpuProfiler::_activePass = -1;
+GpuProfiler::Clock::time_point            GpuProfiler::_passStart;
+GpuProfiler::Clock::time_point            GpuProfiler::_frameStart;
+std::ofstream                             GpuProfiler::_capture;
+std::mutex                                GpuProfiler::_historyMutex;
+std::vector<float>                        GpuProfiler::_resolveScratch;
+
+// Returns the value at the given percentile of a sorted list
+static float Percentile(const std::vector<float>& sorted, float percentile) {
+	if (sorted.empty()) {
+		return 0.0f;
+	}
+	size_t index = (size_t)(percentile * (sorted.size() - 1) + 0.5f);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+GpuProfiler::PassStats::PassStats() :
+	GpuAvgMs(0.0f),
+	GpuP50Ms(0.0f),
+	GpuP95Ms(0.0f),
+	GpuP99Ms(0.0f),
+	GpuMaxMs(0.0f),
+	CpuAvgMs(0.0f),
+	CpuP95Ms(0.0f),
+	Samples(0)
+{ }
+
+void GpuProfiler::PassHistory::Push(float gpuMs, float cpuMs) {
+	if (GpuMs.size() != HISTORY_SIZE) {
+		GpuMs.resize(HISTORY_SIZE, 0.0f);
+		CpuMs.resize(HISTORY_SIZE, 0.0f);
+	}
+	GpuMs[Head] = gpuMs;
+	CpuMs[Head] = cpuMs;
+	Head = (Head + 1) % HISTORY_SIZE;
+	Count = std::min(Count + 1, HISTORY_SIZE);
+}
+
+GpuProfiler::PassStats GpuProfiler::PassHistory::Calculate() const {
+	PassStats result;
+	result.Samples = Count;
+	if (Count == 0) {
+		return result;
+	}
+
+	// Once the ring is full the order doesn't matter, and before then the samples are all at the start
+	std::vector<float> gpu(GpuMs.begin(), GpuMs.begin() + Count);
+	std::vector<float> cpu(CpuMs.begin(), CpuMs.begin() + Count);
+	std::sort(gpu.begin(), gpu.end());
+	std::sort(cpu.begin(), cpu.end());
+
+	for (uint32_t ix = 0; ix < Count; ix++) {
+		result.GpuAvgMs += gpu[ix];
+		result.CpuAvgMs += cpu[ix];
+	}
+	result.GpuAvgMs /= Count;
+	result.CpuAvgMs /= Count;
+	result.GpuP50Ms = Percentile(gpu, 0.50f);
+	result.GpuP95Ms = Percentile(gpu, 0.95f);
+	result.GpuP99Ms = Percentile(gpu, 0.99f);
+	result.GpuMaxMs = gpu.back();
+	result.CpuP95Ms = Percentile(cpu, 0.95f);
+	return result;
+}
+
+void GpuProfiler::Init() {
+	// Some drivers expose the query but have no actual counter behind it, those report 0 bits
+	GLint bits = 0;
+	glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+	_isSupported = bits > 0;
+	if (_isSupported) {
+		LOG_INFO("GPU profiler enabled, timer queries have {} bits", bits);
+	} else {
+		LOG_WARN("GL_TIME_ELAPSED queries are not supported, the GPU profiler will only record CPU times");
+	}
+
+	_frameHistory.Name = "Frame";
+	_frameHistory.Head = 0;
+	_frameHistory.Count = 0;
+	for (uint32_t ix = 0; ix < FRAME_LATENCY; ix++) {
+		_frames[ix].Frame = 0;
+		_frames[ix].CpuMs = 0.0f;
+		_frames[ix].IsPending = false;
+	}
+	_frameStart = Clock::now();
+}
+
+void GpuProfiler::Cleanup() {
+	StopCapture();
+	for (uint32_t ix = 0; ix < FRAME_LATENCY; ix++) {
+		_Release(_frames[ix]);
+	}
+	if (!_freeQueries.empty()) {
+		glDeleteQueries((GLsizei)_freeQueries.size(), _freeQueries.data());
+		_freeQueries.clear();
+	}
+}
+
+void GpuProfiler::BeginFrame() {
+	// Collect everything the GPU has finished, oldest first. If a frame isn't done the ones after it won't be either
+	for (uint64_t frame = _frame >= FRAME_LATENCY ? _frame - FRAME_LATENCY + 1 : 0; frame < _frame; frame++) {
+		FrameRecord& record = _frames[frame % FRAME_LATENCY];
+		if (record.IsPending && record.Frame == frame && !_TryResolve(record)) {
+			break;
+		}
+	}
+
+	// If the slot we're about to use is still waiting, the GPU is too far behind, so we drop it rather than wait
+	FrameRecord& record = _frames[_frame % FRAME_LATENCY];
+	if (record.IsPending) {
+		_Release(record);
+		_droppedFrames++;
+	}
+	record.Frame = _frame;
+	record.Start = Clock::now();
+	record.CpuMs = 0.0f;
+	record.Passes.clear();
+	record.IsPending = true;
+
+	_frameStart = record.Start;
+}
+
+void GpuProfiler::EndFrame() {
+	LOG_ASSERT(_activePass < 0, "GPU profiler pass was not ended before the end of the frame!");
+	FrameRecord& record = _frames[_frame % FRAME_LATENCY];
+	record.CpuMs = std::chrono::duration<float, std::milli>(Clock::now() - _frameStart).count();
+	_frame++;
+}
+
+void GpuProfiler::BeginPass(const std::string& name) {
+	LOG_ASSERT(_activePass < 0, "GPU profiler passes cannot be nested!");
+	FrameRecord& record = _frames[_frame % FRAME_LATENCY];
+
+	PassRecord pass;
+	pass.Pass = _GetPassIndex(name);
+	pass.Query = 0;
+	pass.CpuMs = 0.0f;
+	if (_isSupported) {
+		pass.Query = _AllocateQuery();
+		glBeginQuery(GL_TIME_ELAPSED, pass.Query);
+	}
+	_activePass = (int)record.Passes.size();
+	record.Passes.push_back(pass);
+	_passStart = Clock::now();
+}
+
+void GpuProfiler::EndPass() {
+	LOG_ASSERT(_activePass >= 0, "Ending a GPU profiler pass that was never started!");
+	FrameRecord& record = _frames[_frame % FRAME_LATENCY];
+	PassRecord& pass = record.Passes[_activePass];
+	pass.CpuMs = std::chrono::duration<float, std::milli>(Clock::now() - _passStart).count();
+	if (pass.Query != 0) {
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	_activePass = -1;
+}
+
+std::vector<std::string> GpuProfiler::GetPassNames() {
+	std::lock_guard<std::mutex> lock(_historyMutex);
+	std::vector<std::string> result;
+	result.reserve(_passes.size());
+	for (const PassHistory& pass : _passes) {
+		result.push_back(pass.Name);
+	}
+	return result;
+}
+
+GpuProfiler::PassStats GpuProfiler::GetPassStats(const std::string& name) {
+	std::lock_guard<std::mutex> lock(_historyMutex);
+	if (name == _frameHistory.Name) {
+		return _frameHistory.Calculate();
+	}
+	auto it = _passLookup.find(name);
+	return it != _passLookup.end() ? _passes[it->second].Calculate() : PassStats();
+}
+
+bool GpuProfiler::StartCapture(const std::string& path) {
+	StopCapture();
+	std::lock_guard<std::mutex> lock(_historyMutex);
+	_capture.open(path, std::ios::out | std::ios::trunc);
+	if (!_capture.is_open()) {
+		LOG_ERROR("Failed to open \"{}\" for GPU profiler capture", path);
+		return false;
+	}
+	_capture << "frame,pass,gpu_ms,cpu_ms\n";
+	LOG_INFO("Capturing GPU profiler timings to \"{}\"", path);
+	return true;
+}
+
+void GpuProfiler::StopCapture() {
+	std::lock_guard<std::mutex> lock(_historyMutex);
+	if (_capture.is_open()) {
+		_capture.close();
+	}
+}
+
+void GpuProfiler::RenderImGui() {
+	if (!_isSupported) {
+		ImGui::TextUnformatted("Timer queries not supported, GPU times will be 0");
+	}
+
+	std::unique_lock<std::mutex> lock(_historyMutex);
+
+	// Plot the GPU time for the whole frame in order, oldest first
+	if (_frameHistory.Count > 0) {
+		uint32_t start = _frameHistory.Count < HISTORY_SIZE ? 0 : _frameHistory.Head;
+		ImGui::PlotLines("GPU ms", _frameHistory.GpuMs.data(), (int)_frameHistory.Count, (int)start, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+	}
+
+	ImGui::Columns(6, "gpu_profiler");
+	ImGui::Separator();
+	ImGui::Text("Pass");    ImGui::NextColumn();
+	ImGui::Text("GPU avg"); ImGui::NextColumn();
+	ImGui::Text("GPU p50"); ImGui::NextColumn();
+	ImGui::Text("GPU p95"); ImGui::NextColumn();
+	ImGui::Text("GPU p99"); ImGui::NextColumn();
+	ImGui::Text("CPU avg"); ImGui::NextColumn();
+	ImGui::Separator();
+	auto drawRow = [](const PassHistory& pass) {
+		PassStats stats = pass.Calculate();
+		ImGui::TextUnformatted(pass.Name.c_str());  ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.GpuAvgMs);        ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.GpuP50Ms);        ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.GpuP95Ms);        ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.GpuP99Ms);        ImGui::NextColumn();
+		ImGui::Text("%.3f", stats.CpuAvgMs);        ImGui::NextColumn();
+	};
+	for (const PassHistory& pass : _passes) {
+		drawRow(pass);
+	}
+	ImGui::Separator();
+	drawRow(_frameHistory);
+	ImGui::Columns(1);
+	ImGui::Separator();
+	lock.unlock();
+
+	ImGui::Text("Dropped frames: %u", _droppedFrames);
+	if (IsCapturing()) {
+		if (ImGui::Button("Stop Capture")) {
+			StopCapture();
+		}
+	} else if (ImGui::Button("Capture to gpu_timings.csv")) {
+		StartCapture("gpu_timings.csv");
+	}
+}
+
+bool GpuProfiler::_TryResolve(FrameRecord& frame) {
+	for (const PassRecord& pass : frame.Passes) {
+		if (pass.Query != 0) {
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(pass.Query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				return false;
+			}
+		}
+	}
+
+	std::vector<float>& gpuMs = _resolveScratch;
+	gpuMs.assign(frame.Passes.size(), 0.0f);
+	for (size_t ix = 0; ix < frame.Passes.size(); ix++) {
+		if (frame.Passes[ix].Query != 0) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(frame.Passes[ix].Query, GL_QUERY_RESULT, &elapsed);
+			gpuMs[ix] = (float)(elapsed / 1000000.0);
+		}
+	}
+
+	// The GPU can't have spent longer on the frame than has passed since we started it. Some drivers (llvmpipe)
+	// return garbage for the first queries of a context, so we throw out frames that fail this check
+	float wallMs = std::chrono::duration<float, std::milli>(Clock::now() - frame.Start).count();
+	float frameGpuMs = 0.0f;
+	for (float ms : gpuMs) {
+		frameGpuMs += ms;
+	}
+	if (frameGpuMs > wallMs) {
+		_Release(frame);
+		_droppedFrames++;
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lock(_historyMutex);
+	for (size_t ix = 0; ix < frame.Passes.size(); ix++) {
+		const PassRecord& pass = frame.Passes[ix];
+		_passes[pass.Pass].Push(gpuMs[ix], pass.CpuMs);
+		if (_capture.is_open()) {
+			_capture << frame.Frame << "," << _passes[pass.Pass].Name << "," << gpuMs[ix] << "," << pass.CpuMs << "\n";
+		}
+	}
+	_frameHistory.Push(frameGpuMs, frame.CpuMs);
+	if (_capture.is_open()) {
+		_capture << frame.Frame << "," << _frameHistory.Name << "," << frameGpuMs << "," << frame.CpuMs << "\n";
+	}
+
+	_Release(frame);
+	return true;
+}
+
+void GpuProfiler::_Release(FrameRecord& frame) {
+	for (const PassRecord& pass : frame.Passes) {
+		if (pass.Query != 0) {
+			_freeQueries.push_back(pass.Query);
+		}
+	}
+	frame.Passes.clear();
+	frame.IsPending = false;
+}
+
+GLuint GpuProfiler::_AllocateQuery() {
+	if (_freeQueries.empty()) {
+		GLuint query = 0;
+		glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+		return query;
+	}
+	GLuint result = _freeQueries.back();
+	_freeQueries.pop_back();
+	return result;
+}
+
+uint32_t GpuProfiler::_GetPassIndex(const std::string& name) {
+	auto it = _passLookup.find(name);
+	if (it != _passLookup.end()) {
+		return it->second;
+	}
+	std::lock_guard<std::mutex> lock(_historyMutex);
+	uint32_t index = (uint32_t)_passes.size();
+	PassHistory history;
+	history.Name = name;
+	history.Head = 0;
+	history.Count = 0;
+	_passes.push_back(history);
+	_passLookup[name] = index;
+	return index;
+}
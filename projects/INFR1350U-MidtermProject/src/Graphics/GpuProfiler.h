@@ -0,0 +1,179 @@
+#pragma once
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Times named passes of the frame on both the GPU (with GL_TIME_ELAPSED queries) and the CPU, so
+/// that we can tell which one we're waiting on
+///
+/// Query results are read back a few frames later, we keep FRAME_LATENCY sets of queries in flight
+/// and only read the ones that are already available, so profiling never stalls the pipeline. Passes
+/// cannot be nested, since only one GL_TIME_ELAPSED query can be active at a time
+///
+/// Usage:
+///     GpuProfiler::BeginFrame();
+///     GpuProfiler::BeginPass("Scene");
+///     ... draw stuff ...
+///     GpuProfiler::EndPass();
+///     GpuProfiler::EndFrame();
+/// </summary>
+class GpuProfiler {
+public:
+	// The number of frames of queries that can be waiting on the GPU before we give up on the oldest
+	static const uint32_t FRAME_LATENCY = 4;
+	// The number of frames that the rolling averages and percentiles are calculated over
+	static const uint32_t HISTORY_SIZE = 240;
+
+	/// <summary>
+	/// Rolling statistics for a single pass, all times are in milliseconds
+	/// </summary>
+	struct PassStats {
+		float    GpuAvgMs;
+		float    GpuP50Ms;
+		float    GpuP95Ms;
+		float    GpuP99Ms;
+		float    GpuMaxMs;
+		float    CpuAvgMs;
+		float    CpuP95Ms;
+		// The number of frames that the stats were calculated from
+		uint32_t Samples;
+
+		PassStats();
+	};
+
+	GpuProfiler() = delete;
+
+	/// <summary>
+	/// Checks for timer query support and allocates our queries, must be called after GLAD is loaded
+	/// </summary>
+	static void Init();
+	/// <summary>
+	/// Deletes all our queries and closes the capture file, if any
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Returns true if the driver has a working GL_TIME_ELAPSED counter, if not we only record CPU times
+	/// </summary>
+	static bool IsSupported() { return _isSupported; }
+
+	/// <summary>
+	/// Starts a new frame, collecting the results of any earlier frames that the GPU has finished
+	/// </summary>
+	static void BeginFrame();
+	/// <summary>
+	/// Ends the current frame, call this before swapping buffers
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// Starts timing a pass, passes with the same name are combined in the stats
+	/// </summary>
+	/// <param name="name">The name of the pass</param>
+	static void BeginPass(const std::string& name);
+	/// <summary>
+	/// Ends the pass that was started by the last call to BeginPass
+	/// </summary>
+	static void EndPass();
+
+	/// <summary>
+	/// Gets the names of all the passes we've seen, in the order they were first used
+	/// </summary>
+	static std::vector<std::string> GetPassNames();
+	/// <summary>
+	/// Calculates the rolling stats for a pass, or for the whole frame if name is "Frame"
+	/// </summary>
+	static PassStats GetPassStats(const std::string& name);
+	/// <summary>
+	/// Gets the number of frames whose GPU results were dropped because they were not ready in time
+	/// </summary>
+	static uint32_t GetDroppedFrames() { return _droppedFrames; }
+
+	/// <summary>
+	/// Starts writing per-frame GPU and CPU timings to a CSV file, one row per pass per frame
+	/// </summary>
+	/// <param name="path">The path to the file to write, will be overwritten</param>
+	/// <returns>True if the file could be opened</returns>
+	static bool StartCapture(const std::string& path);
+	/// <summary>
+	/// Stops writing timings and closes the capture file
+	/// </summary>
+	static void StopCapture();
+	static bool IsCapturing() { return _capture.is_open(); }
+
+	/// <summary>
+	/// Draws the pass timings and capture controls to the current ImGui window
+	/// </summary>
+	static void RenderImGui();
+
+protected:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// A single timed pass within a frame
+	struct PassRecord {
+		uint32_t Pass;
+		GLuint   Query;
+		float    CpuMs;
+	};
+	// All the passes for a frame that we are still waiting on
+	struct FrameRecord {
+		uint64_t                Frame;
+		Clock::time_point       Start;
+		float                   CpuMs;
+		std::vector<PassRecord> Passes;
+		bool                    IsPending;
+	};
+	// The last HISTORY_SIZE results for a pass, as a ring buffer
+	struct PassHistory {
+		std::string        Name;
+		std::vector<float> GpuMs;
+		std::vector<float> CpuMs;
+		uint32_t           Head;
+		uint32_t           Count;
+
+		void Push(float gpuMs, float cpuMs);
+		PassStats Calculate() const;
+	};
+
+	static bool        _isSupported;
+	static uint64_t    _frame;
+	static uint32_t    _droppedFrames;
+	static FrameRecord _frames[FRAME_LATENCY];
+	// Queries that are not currently in use
+	static std::vector<GLuint> _freeQueries;
+
+	static std::vector<PassHistory>                  _passes;
+	static std::unordered_map<std::string, uint32_t> _passLookup;
+	// The totals for each frame, GPU time is the sum of all passes
+	static PassHistory _frameHistory;
+
+	// The index of the pass in the current frame's list that is being timed, or -1
+	static int               _activePass;
+	static Clock::time_point _passStart;
+	static Clock::time_point _frameStart;
+
+	static std::ofstream _capture;
+	// Guards the pass histories and the capture file, since the stats can be drawn in ImGui on the
+	// simulation thread while the render thread is resolving frames
+	static std::mutex    _historyMutex;
+	// Reused between frames so resolving doesn't allocate
+	static std::vector<float> _resolveScratch;
+
+	/// <summary>
+	/// Reads back a frame's queries if they are all available
+	/// </summary>
+	/// <returns>True if the results were read, false if the GPU has not finished with the frame</returns>
+	static bool _TryResolve(FrameRecord& frame);
+	/// <summary>
+	/// Returns a frame's queries to the pool without reading them
+	/// </summary>
+	static void _Release(FrameRecord& frame);
+	static GLuint _AllocateQuery();
+	static uint32_t _GetPassIndex(const std::string& name);
+};
@@ -25,6 +25,20 @@ void IBuffer::LoadData(const void* data, size_t elementSize, size_t elementCount
 	_elementSize = elementSize;
 }
 
+void IBuffer::AllocateStorage(const void* data, size_t elementSize, size_t elementCount, GLbitfield flags) {
+	glNamedBufferStorage(_handle, elementSize * elementCount, data, flags);
+
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+}
+
+uint8_t* IBuffer::AllocatePersistent(size_t elementSize, size_t elementCount) {
+	// Coherent mapping means we don't have to flush our writes
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	AllocateStorage(nullptr, elementSize, elementCount, flags);
+	return (uint8_t*)glMapNamedBufferRange(_handle, 0, (GLsizeiptr)(elementSize * elementCount), flags);
+}
+
 void IBuffer::Bind() const {
 	glBindBuffer((GLenum)_type, _handle);
 }
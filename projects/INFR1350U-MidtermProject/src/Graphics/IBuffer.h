@@ -8,7 +8,10 @@
 enum class BufferType {
 	Vertex = GL_ARRAY_BUFFER,
 	Index = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Uniform = GL_UNIFORM_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+	DrawIndirect = GL_DRAW_INDIRECT_BUFFER,
+	PixelUnpack = GL_PIXEL_UNPACK_BUFFER
 };
 
 /// <summary>
@@ -74,6 +77,24 @@ public:
 		IBuffer::LoadData((const void*)(data), sizeof(T), count);
 	}
 
+	/// <summary>
+	/// Allocates immutable storage for this buffer using glNamedBufferStorage, this is needed for
+	/// persistent mapping. Note that LoadData can't be used on the buffer after this
+	/// </summary>
+	/// <param name="data">The initial data for the buffer, or nullptr</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to allocate</param>
+	/// <param name="flags">The storage flags (ex: GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT)</param>
+	void AllocateStorage(const void* data, size_t elementSize, size_t elementCount, GLbitfield flags);
+	/// <summary>
+	/// Allocates immutable storage for this buffer and maps all of it for writing, the mapping stays valid until
+	/// the buffer is unmapped. The mapping is coherent, so writes are visible to any command issued after them
+	/// </summary>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to allocate</param>
+	/// <returns>A pointer to the start of the buffer, or nullptr if it could not be mapped</returns>
+	uint8_t* AllocatePersistent(size_t elementSize, size_t elementCount);
+
 	/// <summary>
 	/// Returns the number of elements that are loaded into this buffer
 	/// </summary>
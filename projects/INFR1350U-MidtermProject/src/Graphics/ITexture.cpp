@@ -1,4 +1,5 @@
 #include "ITexture.h"
+#include "GlStateCache.h"
 
 ITexture::Limits ITexture::__limits = ITexture::Limits();
 bool ITexture::__isStaticInit = false;
@@ -21,6 +22,7 @@ void ITexture::_Recreate()
 
 ITexture::~ITexture() {
 	if (glIsTexture(_handle)) {
+		GlStateCache::NotifyTextureDeleted(_handle);
 		glDeleteTextures(1, &_handle);
 		_handle = 0;
 	}
@@ -29,12 +31,13 @@ ITexture::~ITexture() {
 void ITexture::Bind(int slot) {
 	if (_handle != 0) {
 		// Instead of glActiveTexture + glBindTexture, we can one line it now :D
-		glBindTextureUnit(slot, _handle); 
+		// The state cache will skip the call if this texture is already in the slot
+		GlStateCache::BindTextureUnit(slot, _handle);
 	}
 }
 
 void ITexture::Unbind(int slot) {
-	glBindTextureUnit(slot, 0);
+	GlStateCache::BindTextureUnit(slot, 0);
 }
 
 void ITexture::Clear(const glm::vec4& color) {
@@ -43,6 +46,23 @@ void ITexture::Clear(const glm::vec4& color) {
 	}
 }
 
+GLuint ITexture::_ApplySampler(const SamplerDescription& sampler) {
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)sampler.MinificationFilter);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)sampler.MagnificationFilter);
+	return SamplerCache::Get(sampler);
+}
+
+uint32_t ITexture::_CalculateMipLevels(uint32_t width, uint32_t height, bool mipMaps) {
+	// We need a mip level for every halving of our largest dimension, down to 1x1
+	uint32_t result = 1;
+	if (mipMaps) {
+		for (uint32_t size = glm::max(width, height); size > 1; size >>= 1) {
+			result++;
+		}
+	}
+	return result;
+}
+
 void ITexture::__StaticInit()
 {
 	// If we've already run the static initializer, abort now
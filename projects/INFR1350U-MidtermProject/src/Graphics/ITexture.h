@@ -3,6 +3,7 @@
 #include <glad/glad.h>
 #include <cstdint>
 #include <Graphics/TextureEnums.h>
+#include "Graphics/SamplerCache.h"
 #include <GLM/glm.hpp>
 #include "Utils/ResourceManager/IResource.h"
 
@@ -61,6 +62,32 @@ protected:
 	/// </summary>
 	virtual void _Recreate();
 
+	/// <summary>
+	/// Gets a sampler object from the cache for the given settings, and sets the same filtering on the
+	/// texture itself, for anything that draws it without our sampler (ex: ImGui)
+	/// </summary>
+	/// <returns>The shared sampler object</returns>
+	GLuint _ApplySampler(const SamplerDescription& sampler);
+
+	/// <summary>
+	/// Gets the sampler settings from a texture description, any description with the usual filter and wrap fields will work
+	/// </summary>
+	template <typename TDescription>
+	static SamplerDescription _GetSamplerDescription(const TDescription& description) {
+		SamplerDescription result;
+		result.MinificationFilter  = description.MinificationFilter;
+		result.MagnificationFilter = description.MagnificationFilter;
+		result.HorizontalWrap      = description.HorizontalWrap;
+		result.VerticalWrap        = description.VerticalWrap;
+		result.MaxAnisotropy       = description.MaxAnisotropy;
+		return result;
+	}
+
+	/// <summary>
+	/// Gets the number of mip levels we need for a texture of the given size, down to 1x1
+	/// </summary>
+	static uint32_t _CalculateMipLevels(uint32_t width, uint32_t height, bool mipMaps);
+
 	GLuint _handle;    // The OpenGL handle for this textureW
 	TextureType _type; // The type for this texture, mainly used for debugging
 
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include <memory>
+#include <vector>
 #include <EnumToString.h>
 
 /// <summary>
@@ -27,6 +28,19 @@ inline size_t GetIndexTypeSize(IndexType type) {
 	}
 }
 
+/// <summary>
+/// Gets the smallest index type that can address the given number of vertices
+/// </summary>
+inline IndexType GetSmallestIndexType(size_t vertexCount) {
+	if (vertexCount <= 0xFF + 1) {
+		return IndexType::UByte;
+	} else if (vertexCount <= 0xFFFF + 1) {
+		return IndexType::UShort;
+	} else {
+		return IndexType::UInt;
+	}
+}
+
 /// <summary>
 /// The index buffer will store indices for rendering (uint8_t, uint16_t and uint32_t)
 /// </summary>
@@ -72,6 +86,15 @@ public:
 	template <typename T>
 	void LoadData(const T* data, size_t count) { throw std::runtime_error("Must be one of uint8_t, uint16_t or uint32_t"); } // Note, see template specializations below
 
+	/// <summary>
+	/// Loads 32 bit indices into this buffer, narrowing them to the smallest type that can address all
+	/// of the mesh's vertices, see GetSmallestIndexType
+	/// </summary>
+	/// <param name="data">A pointer to the start of the indices</param>
+	/// <param name="count">The number of indices to upload</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	void LoadCompact(const uint32_t* data, size_t count, size_t vertexCount);
+
 	/// <summary>
 	/// Gets the underlying index type for this buffer (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
 	/// </summary>
@@ -105,3 +128,21 @@ inline void IndexBuffer::LoadData<uint32_t>(const uint32_t* data, size_t count)
 	IBuffer::LoadData<uint32_t>(data, count);
 	_elementType = IndexType::UInt;
 }
+
+inline void IndexBuffer::LoadCompact(const uint32_t* data, size_t count, size_t vertexCount) {
+	switch (GetSmallestIndexType(vertexCount)) {
+		case IndexType::UByte: {
+			std::vector<uint8_t> narrowed(data, data + count);
+			LoadData(narrowed.data(), count);
+			break;
+		}
+		case IndexType::UShort: {
+			std::vector<uint16_t> narrowed(data, data + count);
+			LoadData(narrowed.data(), count);
+			break;
+		}
+		default:
+			LoadData(data, count);
+			break;
+	}
+}
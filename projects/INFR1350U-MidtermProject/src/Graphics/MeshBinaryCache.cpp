@@ -0,0 +1,352 @@
+#include "Graphics/MeshBinaryCache.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <Logging.h>
+
+#include "Graphics/GeometryArena.h"
+#include "Graphics/IndexBuffer.h"
+#include "Graphics/ShaderBinaryCache.h"
+#include "Graphics/VertexBuffer.h"
+#include "Utils/MemoryMappedFile.h"
+
+// The header at the start of every sidecar, bump the version if the layout ever changes
+struct MeshBinaryHeader {
+	uint32_t  Magic;
+	uint32_t  Version;
+	// What the source file looked like when the sidecar was written
+	uint64_t  SourceHash;
+	uint64_t  SourceSize;
+	int64_t   SourceTime;
+	uint32_t  AttributeCount;
+	uint32_t  VertexStride;
+	uint32_t  VertexCount;
+	uint32_t  IndexCount;
+	GLenum    IndexType;
+	uint32_t  Reserved;
+	glm::vec3 BoxMin;
+	glm::vec3 BoxMax;
+	glm::vec3 SphereCenter;
+	float     SphereRadius;
+	// Offsets of the blobs from the start of the file
+	uint64_t  VertexOffset;
+	uint64_t  IndexOffset;
+};
+// A single entry in the vertex declaration, following the header
+struct MeshBinaryAttribute {
+	uint32_t Slot;
+	int32_t  Size;
+	GLenum   Type;
+	uint32_t Normalized;
+	int32_t  Stride;
+	int32_t  Offset;
+	uint32_t Usage;
+};
+static const uint32_t MESH_BINARY_MAGIC   = 0x424D544F; // "OTMB"
+// Version 2: meshes are stored after the MeshOptimizer pass, so older sidecars need to be re-imported
+static const uint32_t MESH_BINARY_VERSION = 2;
+// Blobs start on a 16 byte boundary, the mapping itself is always page aligned
+static const uint64_t MESH_BINARY_ALIGNMENT = 16;
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+static inline uint64_t AlignOffset(uint64_t offset) {
+	return (offset + MESH_BINARY_ALIGNMENT - 1) & ~(MESH_BINARY_ALIGNMENT - 1);
+}
+
+bool MeshBinaryCache::_enabled = true;
+MeshBinaryCache::Stats MeshBinaryCache::_stats = MeshBinaryCache::Stats();
+
+MeshBinaryCache::Stats::Stats() :
+	CacheHits(0),
+	Imported(0),
+	Invalidated(0),
+	CacheLoadMs(0.0f),
+	ImportMs(0.0f)
+{ }
+
+std::string MeshBinaryCache::GetCachePath(const std::string& sourcePath, const std::string& vertexFormat) {
+	return sourcePath + "." + vertexFormat + ".mesh";
+}
+
+// Makes sure a mapped sidecar is ours, that it's all there, and that it was written with the given declaration
+static bool ValidateSidecar(const MemoryMappedFile& file, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, MeshBinaryHeader& outHeader) {
+	if (file.GetSize() < sizeof(MeshBinaryHeader)) {
+		return false;
+	}
+	const char* data = file.GetData();
+	memcpy(&outHeader, data, sizeof(MeshBinaryHeader));
+
+	size_t indexSize = GetIndexTypeSize((IndexType)outHeader.IndexType);
+	bool valid =
+		outHeader.Magic == MESH_BINARY_MAGIC && outHeader.Version == MESH_BINARY_VERSION &&
+		outHeader.AttributeCount == vDecl.size() && outHeader.VertexStride == vertexStride &&
+		indexSize > 0 && outHeader.VertexCount > 0 &&
+		outHeader.VertexOffset >= sizeof(MeshBinaryHeader) + outHeader.AttributeCount * sizeof(MeshBinaryAttribute) &&
+		outHeader.VertexOffset + (uint64_t)outHeader.VertexCount * outHeader.VertexStride <= outHeader.IndexOffset &&
+		outHeader.IndexOffset + (uint64_t)outHeader.IndexCount * indexSize <= file.GetSize();
+
+	// The declaration has to match the format we were asked for exactly
+	const MeshBinaryAttribute* attributes = reinterpret_cast<const MeshBinaryAttribute*>(data + sizeof(MeshBinaryHeader));
+	for (size_t ix = 0; valid && ix < vDecl.size(); ix++) {
+		const MeshBinaryAttribute& attrib = attributes[ix];
+		valid =
+			attrib.Slot == vDecl[ix].Slot && attrib.Size == vDecl[ix].Size && attrib.Type == (GLenum)vDecl[ix].Type &&
+			attrib.Normalized == (vDecl[ix].Normalized ? 1u : 0u) &&
+			attrib.Stride == vDecl[ix].Stride && attrib.Offset == vDecl[ix].Offset && attrib.Usage == (uint32_t)vDecl[ix].Usage;
+	}
+	return valid;
+}
+
+// Widens the index blob back out to 32 bit indices
+static void ReadIndices(const MeshBinaryHeader& header, const char* data, std::vector<uint32_t>& outIndices) {
+	outIndices.resize(header.IndexCount);
+	const uint8_t* indexData = reinterpret_cast<const uint8_t*>(data + header.IndexOffset);
+	for (uint32_t ix = 0; ix < header.IndexCount; ix++) {
+		switch ((IndexType)header.IndexType) {
+			case IndexType::UByte:  outIndices[ix] = indexData[ix]; break;
+			case IndexType::UShort: outIndices[ix] = reinterpret_cast<const uint16_t*>(indexData)[ix]; break;
+			default:                outIndices[ix] = reinterpret_cast<const uint32_t*>(indexData)[ix]; break;
+		}
+	}
+}
+
+VertexArrayObject::Sptr MeshBinaryCache::_TryLoad(const std::string& sourcePath, const std::string& path, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, std::type_index vertexType) {
+	if (!_enabled) {
+		return nullptr;
+	}
+
+	std::error_code error;
+	if (!std::filesystem::exists(path, error) || !std::filesystem::exists(sourcePath, error)) {
+		return nullptr;
+	}
+
+	MeshBinaryHeader header;
+	VertexArrayObject::Sptr result = nullptr;
+	bool refreshTime = false;
+	{
+		MemoryMappedFile file;
+		if (!file.Open(path)) {
+			_stats.Invalidated++;
+			return nullptr;
+		}
+		if (!ValidateSidecar(file, vDecl, vertexStride, header)) {
+			LOG_WARN("Mesh cache \"{}\" is from an older version or is corrupt, re-importing", path);
+			_stats.Invalidated++;
+			return nullptr;
+		}
+		if (!_IsSourceUnchanged(sourcePath, header.SourceSize, header.SourceTime, header.SourceHash, refreshTime)) {
+			_stats.Invalidated++;
+			return nullptr;
+		}
+		const char* data = file.GetData();
+
+		result = VertexArrayObject::Create();
+		result->SetVDecl(vDecl);
+
+		MeshBounds bounds;
+		bounds.Box.Min = header.BoxMin;
+		bounds.Box.Max = header.BoxMax;
+		bounds.Sphere.Center = header.SphereCenter;
+		bounds.Sphere.Radius = header.SphereRadius;
+		result->SetBounds(bounds);
+
+		// The vertices go straight into the arena, the indices get narrowed or widened to the arena's index type
+		std::vector<uint32_t> arenaIndices;
+		ReadIndices(header, data, arenaIndices);
+		const GeometryArena::Sptr& arena = GeometryArena::Get(vertexType, vDecl, vertexStride, GeometryArena::GetIndexTypeFor(header.VertexCount));
+		result->SetArenaAllocation(arena->Allocate(
+			data + header.VertexOffset, header.VertexCount, header.IndexCount > 0 ? arenaIndices.data() : nullptr, header.IndexCount));
+	}
+
+	if (refreshTime) {
+		_RefreshSourceTime(sourcePath, path, header.SourceTime);
+	}
+
+	return result;
+}
+
+bool MeshBinaryCache::_TryRead(const std::string& sourcePath, const std::string& path, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride,
+	const std::function<void*(uint32_t)>& allocVertices, std::vector<uint32_t>& outIndices, bool& outInvalidated)
+{
+	outInvalidated = false;
+	if (!_enabled) {
+		return false;
+	}
+
+	std::error_code error;
+	if (!std::filesystem::exists(path, error) || !std::filesystem::exists(sourcePath, error)) {
+		return false;
+	}
+
+	MeshBinaryHeader header;
+	bool refreshTime = false;
+	{
+		MemoryMappedFile file;
+		if (!file.Open(path)) {
+			outInvalidated = true;
+			return false;
+		}
+		if (!ValidateSidecar(file, vDecl, vertexStride, header)) {
+			LOG_WARN("Mesh cache \"{}\" is from an older version or is corrupt, re-importing", path);
+			outInvalidated = true;
+			return false;
+		}
+		if (!_IsSourceUnchanged(sourcePath, header.SourceSize, header.SourceTime, header.SourceHash, refreshTime)) {
+			outInvalidated = true;
+			return false;
+		}
+
+		// Copy out of the mapping, since it will be gone by the time the mesh is uploaded
+		const char* data = file.GetData();
+		memcpy(allocVertices(header.VertexCount), data + header.VertexOffset, (size_t)header.VertexCount * header.VertexStride);
+		ReadIndices(header, data, outIndices);
+	}
+
+	if (refreshTime) {
+		_RefreshSourceTime(sourcePath, path, header.SourceTime);
+	}
+
+	return true;
+}
+
+bool MeshBinaryCache::_IsSourceUnchanged(const std::string& sourcePath, uint64_t size, int64_t time, uint64_t hash, bool& outRefreshTime) {
+	// The time and size are enough most of the time, but if the time has changed we check the contents before throwing it out
+	std::error_code error;
+	uint64_t sourceSize = std::filesystem::file_size(sourcePath, error);
+	if (error || sourceSize != size) {
+		return false;
+	}
+	outRefreshTime = false;
+	if (_GetWriteTime(sourcePath) != time) {
+		uint64_t sourceHash = 0;
+		if (!_HashFile(sourcePath, sourceHash) || sourceHash != hash) {
+			return false;
+		}
+		outRefreshTime = true;
+	}
+	return true;
+}
+
+void MeshBinaryCache::_RefreshSourceTime(const std::string& sourcePath, const std::string& path, int64_t& time) {
+	// Same contents with a new time, update the sidecar so we don't have to hash it again next time. This
+	// has to wait until we've unmapped it, since Windows won't let us write to a file that's mapped
+	time = _GetWriteTime(sourcePath);
+	std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+	if (file.is_open()) {
+		file.seekp(offsetof(MeshBinaryHeader, SourceTime));
+		file.write((const char*)&time, sizeof(time));
+	}
+}
+
+void MeshBinaryCache::_Store(const std::string& sourcePath, const std::string& path, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride,
+	const void* vertices, size_t vertexCount, const std::vector<uint32_t>& indices, const MeshBounds& bounds)
+{
+	if (!_enabled || vertexCount == 0) {
+		return;
+	}
+
+	MeshBinaryHeader header;
+	memset(&header, 0, sizeof(MeshBinaryHeader));
+	header.Magic = MESH_BINARY_MAGIC;
+	header.Version = MESH_BINARY_VERSION;
+	std::error_code error;
+	header.SourceSize = std::filesystem::file_size(sourcePath, error);
+	header.SourceTime = _GetWriteTime(sourcePath);
+	if (error || !_HashFile(sourcePath, header.SourceHash)) {
+		return;
+	}
+
+	IndexType indexType = GetSmallestIndexType(vertexCount);
+	header.AttributeCount = (uint32_t)vDecl.size();
+	header.VertexStride = vertexStride;
+	header.VertexCount = (uint32_t)vertexCount;
+	header.IndexCount = (uint32_t)indices.size();
+	header.IndexType = (GLenum)indexType;
+	header.BoxMin = bounds.Box.Min;
+	header.BoxMax = bounds.Box.Max;
+	header.SphereCenter = bounds.Sphere.Center;
+	header.SphereRadius = bounds.Sphere.Radius;
+	header.VertexOffset = AlignOffset(sizeof(MeshBinaryHeader) + vDecl.size() * sizeof(MeshBinaryAttribute));
+	header.IndexOffset = AlignOffset(header.VertexOffset + (uint64_t)header.VertexCount * header.VertexStride);
+
+	std::vector<MeshBinaryAttribute> attributes(vDecl.size());
+	for (size_t ix = 0; ix < vDecl.size(); ix++) {
+		attributes[ix].Slot = vDecl[ix].Slot;
+		attributes[ix].Size = vDecl[ix].Size;
+		attributes[ix].Type = (GLenum)vDecl[ix].Type;
+		attributes[ix].Normalized = vDecl[ix].Normalized ? 1 : 0;
+		attributes[ix].Stride = vDecl[ix].Stride;
+		attributes[ix].Offset = vDecl[ix].Offset;
+		attributes[ix].Usage = (uint32_t)vDecl[ix].Usage;
+	}
+
+	// Narrow the indices down to what we'll upload
+	size_t indexSize = GetIndexTypeSize(indexType);
+	std::vector<uint8_t> indexData(indices.size() * indexSize);
+	for (size_t ix = 0; ix < indices.size(); ix++) {
+		switch (indexType) {
+			case IndexType::UByte:  indexData[ix] = (uint8_t)indices[ix]; break;
+			case IndexType::UShort: reinterpret_cast<uint16_t*>(indexData.data())[ix] = (uint16_t)indices[ix]; break;
+			default:                reinterpret_cast<uint32_t*>(indexData.data())[ix] = indices[ix]; break;
+		}
+	}
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		LOG_WARN("Could not write mesh cache to \"{}\"", path);
+		return;
+	}
+	const char padding[MESH_BINARY_ALIGNMENT] = { 0 };
+	file.write((const char*)&header, sizeof(MeshBinaryHeader));
+	file.write((const char*)attributes.data(), attributes.size() * sizeof(MeshBinaryAttribute));
+	file.write(padding, header.VertexOffset - (sizeof(MeshBinaryHeader) + attributes.size() * sizeof(MeshBinaryAttribute)));
+	file.write((const char*)vertices, vertexCount * vertexStride);
+	file.write(padding, header.IndexOffset - (header.VertexOffset + vertexCount * vertexStride));
+	file.write((const char*)indexData.data(), indexData.size());
+
+	// Don't leave a half written file behind, it would fail validation but we'd still pay to map it
+	if (!file.good()) {
+		file.close();
+		LOG_WARN("Failed writing mesh cache \"{}\"", path);
+		std::filesystem::remove(path, error);
+	}
+}
+
+void MeshBinaryCache::RecordLoadTime(bool fromCache, float milliseconds, bool invalidated /*= false*/) {
+	if (invalidated) {
+		_stats.Invalidated++;
+	}
+	if (fromCache) {
+		_stats.CacheHits++;
+		_stats.CacheLoadMs += milliseconds;
+	} else {
+		_stats.Imported++;
+		_stats.ImportMs += milliseconds;
+	}
+}
+
+void MeshBinaryCache::LogStats() {
+	LOG_INFO("Meshes ready in {:.2f} ms ({}): {} from cache in {:.2f} ms, {} imported in {:.2f} ms, {} out of date",
+		_stats.CacheLoadMs + _stats.ImportMs,
+		_enabled ? "cache enabled" : "cache disabled",
+		_stats.CacheHits, _stats.CacheLoadMs,
+		_stats.Imported, _stats.ImportMs,
+		_stats.Invalidated);
+}
+
+bool MeshBinaryCache::_HashFile(const std::string& path, uint64_t& outHash) {
+	MemoryMappedFile file;
+	if (!file.Open(path)) {
+		return false;
+	}
+	outHash = ShaderBinaryCache::Hash(file.GetData(), file.GetSize(), FNV_OFFSET_BASIS);
+	return true;
+}
+
+int64_t MeshBinaryCache::_GetWriteTime(const std::string& path) {
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+	return error ? 0 : (int64_t)time.time_since_epoch().count();
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Graphics/GeometryArena.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/StringUtils.h"
+
+/// <summary>
+/// Stores imported meshes in a binary sidecar next to their source file (ex: paddle.obj.PosNormTexCol.mesh), so
+/// that on the next launch we can skip parsing the OBJ entirely. The sidecar is memory mapped and
+/// it's vertex and index blobs are handed straight to glNamedBufferData
+///
+/// A sidecar is only used if it's source file has the same size and modification time as when it
+/// was written. If only the time changed (ex: after a fresh checkout), the source is hashed, and
+/// the sidecar is kept if the contents are the same
+///
+/// File layout: header, vertex declaration, bounds (in the header), vertex blob, index blob. The
+/// index blob uses the smallest index type that fits the mesh. Each vertex format gets it's own
+/// sidecar, so the same file can be loaded in more than one format without re-importing it every time
+/// </summary>
+class MeshBinaryCache {
+public:
+	/// <summary>
+	/// Timing and hit counts for all the meshes loaded since startup
+	/// </summary>
+	struct Stats {
+		// Meshes loaded from a sidecar
+		uint32_t CacheHits;
+		// Meshes that had to be imported from their source file
+		uint32_t Imported;
+		// Sidecars that were out of date or unreadable
+		uint32_t Invalidated;
+		// Total time spent loading meshes from sidecars, in milliseconds
+		float    CacheLoadMs;
+		// Total time spent importing meshes from source, in milliseconds
+		float    ImportMs;
+
+		Stats();
+	};
+
+	MeshBinaryCache() = delete;
+
+	/// <summary>
+	/// Allows the cache to be turned off, ex: to time the import path
+	/// </summary>
+	static void SetEnabled(bool value) { _enabled = value; }
+	static bool IsEnabled() { return _enabled; }
+
+	/// <summary>
+	/// Gets the path of the sidecar for the given source file and vertex format
+	/// </summary>
+	/// <param name="sourcePath">The path of the mesh's source file (ex: an OBJ)</param>
+	/// <param name="vertexFormat">The name of the vertex format (ex: PosNormTexPacked)</param>
+	static std::string GetCachePath(const std::string& sourcePath, const std::string& vertexFormat);
+	template <typename VertType>
+	static std::string GetCachePath(const std::string& sourcePath) {
+		std::string format = StringTools::SanitizeClassName(typeid(VertType).name());
+		if (format.rfind("Vertex", 0) == 0) {
+			format = format.substr(6);
+		}
+		return GetCachePath(sourcePath, format);
+	}
+
+	/// <summary>
+	/// Attempts to load a mesh from the sidecar for the given source file
+	/// </summary>
+	/// <typeparam name="VertType">The vertex format the mesh should be in</typeparam>
+	/// <param name="sourcePath">The path of the mesh's source file (ex: an OBJ)</param>
+	/// <returns>The mesh, or nullptr if there is no valid sidecar and the source needs to be imported</returns>
+	template <typename VertType = VertexPosNormTexCol>
+	static VertexArrayObject::Sptr TryLoad(const std::string& sourcePath) {
+		return _TryLoad(sourcePath, GetCachePath<VertType>(sourcePath), VertType::V_DECL, sizeof(VertType), std::type_index(typeid(VertType)));
+	}
+	/// <summary>
+	/// Attempts to read a mesh's vertices and indices from it's sidecar, without touching OpenGL. This is safe
+	/// to call from worker threads, and does not update the stats (pass outInvalidated to RecordLoadTime instead)
+	/// </summary>
+	/// <typeparam name="VertType">The vertex format the mesh should be in</typeparam>
+	/// <param name="sourcePath">The path of the mesh's source file (ex: an OBJ)</param>
+	/// <param name="outVertices">Receives the mesh's vertices</param>
+	/// <param name="outIndices">Receives the mesh's triangle indices</param>
+	/// <param name="outInvalidated">Set to true if there was a sidecar, but it was out of date or unreadable</param>
+	/// <returns>True if the mesh was read, false if the source needs to be imported</returns>
+	template <typename VertType>
+	static bool TryRead(const std::string& sourcePath, std::vector<VertType>& outVertices, std::vector<uint32_t>& outIndices, bool& outInvalidated) {
+		return _TryRead(sourcePath, GetCachePath<VertType>(sourcePath), VertType::V_DECL, sizeof(VertType), [&](uint32_t count) {
+			outVertices.resize(count);
+			return (void*)outVertices.data();
+		}, outIndices, outInvalidated);
+	}
+	/// <summary>
+	/// Writes a sidecar for an imported mesh
+	/// </summary>
+	/// <param name="sourcePath">The path of the mesh's source file</param>
+	/// <param name="vertices">The mesh's vertices</param>
+	/// <param name="indices">The mesh's triangle indices</param>
+	/// <param name="bounds">The mesh's object space bounds</param>
+	template <typename VertType>
+	static void Store(const std::string& sourcePath, const std::vector<VertType>& vertices, const std::vector<uint32_t>& indices, const MeshBounds& bounds) {
+		_Store(sourcePath, GetCachePath<VertType>(sourcePath), VertType::V_DECL, sizeof(VertType), vertices.data(), vertices.size(), indices, bounds);
+	}
+
+	/// <summary>
+	/// Records how long it took for a mesh to load, used for our startup timing logs
+	/// </summary>
+	/// <param name="fromCache">True if the mesh was loaded from a sidecar</param>
+	/// <param name="milliseconds">The time taken to load the mesh</param>
+	/// <param name="invalidated">True if the mesh had a sidecar that could not be used</param>
+	static void RecordLoadTime(bool fromCache, float milliseconds, bool invalidated = false);
+	/// <summary>
+	/// Gets the timing and hit counts since startup
+	/// </summary>
+	static const Stats& GetStats() { return _stats; }
+	/// <summary>
+	/// Logs a summary of how long mesh loading took, and how much of it was served from the cache
+	/// </summary>
+	static void LogStats();
+
+protected:
+	static bool  _enabled;
+	static Stats _stats;
+
+	/// <summary>
+	/// Loads a sidecar, making sure it was written with the given vertex declaration
+	/// </summary>
+	static VertexArrayObject::Sptr _TryLoad(const std::string& sourcePath, const std::string& path, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride, std::type_index vertexType);
+	/// <summary>
+	/// Writes a sidecar for vertices in any format
+	/// </summary>
+	static void _Store(const std::string& sourcePath, const std::string& path, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride,
+		const void* vertices, size_t vertexCount, const std::vector<uint32_t>& indices, const MeshBounds& bounds);
+	/// <summary>
+	/// Reads a sidecar's blobs into memory, making sure it was written with the given vertex declaration
+	/// </summary>
+	/// <param name="allocVertices">Called with the vertex count, should return somewhere to copy the vertices to</param>
+	static bool _TryRead(const std::string& sourcePath, const std::string& path, const VertexArrayObject::VertexDeclaration& vDecl, uint32_t vertexStride,
+		const std::function<void*(uint32_t)>& allocVertices, std::vector<uint32_t>& outIndices, bool& outInvalidated);
+
+	/// <summary>
+	/// Checks that a source file is the same as when it's sidecar was written
+	/// </summary>
+	/// <param name="outRefreshTime">Set to true if only the modification time changed, and the sidecar should be updated</param>
+	static bool _IsSourceUnchanged(const std::string& sourcePath, uint64_t size, int64_t time, uint64_t hash, bool& outRefreshTime);
+	/// <summary>
+	/// Updates the modification time stored in a sidecar, must be called after the sidecar has been unmapped
+	/// </summary>
+	static void _RefreshSourceTime(const std::string& sourcePath, const std::string& path, int64_t& time);
+
+	/// <summary>
+	/// Hashes the entire contents of a file
+	/// </summary>
+	/// <returns>True if the file could be read</returns>
+	static bool _HashFile(const std::string& path, uint64_t& outHash);
+	/// <summary>
+	/// Gets a file's modification time as a plain integer that can be stored in our header
+	/// </summary>
+	static int64_t _GetWriteTime(const std::string& path);
+};
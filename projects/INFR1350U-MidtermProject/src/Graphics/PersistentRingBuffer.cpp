@@ -0,0 +1,60 @@
+#include "Graphics/PersistentRingBuffer.h"
+#include <Logging.h>
+
+#include "Graphics/GpuFence.h"
+
+PersistentRingBuffer::PersistentRingBuffer(size_t elementSize, size_t segmentCapacity) :
+	_buffer(nullptr),
+	_mapped(nullptr),
+	_elementSize(elementSize),
+	_segmentCapacity(segmentCapacity),
+	_segment(0),
+	_head(0),
+	_segmentEnd(segmentCapacity),
+	_stallCount(0)
+{
+	for (uint32_t ix = 0; ix < SEGMENT_COUNT; ix++) {
+		_fences[ix] = nullptr;
+	}
+
+	_buffer = VertexBuffer::Create(BufferUsage::StreamDraw);
+	_mapped = _buffer->AllocatePersistent(elementSize, segmentCapacity * SEGMENT_COUNT);
+	LOG_ASSERT(_mapped != nullptr, "Failed to map persistent ring buffer!");
+}
+
+PersistentRingBuffer::~PersistentRingBuffer() {
+	for (uint32_t ix = 0; ix < SEGMENT_COUNT; ix++) {
+		if (_fences[ix] != nullptr) {
+			glDeleteSync(_fences[ix]);
+		}
+	}
+	if (_mapped != nullptr) {
+		glUnmapNamedBuffer(_buffer->GetHandle());
+		_mapped = nullptr;
+	}
+}
+
+void PersistentRingBuffer::Advance(size_t count) {
+	LOG_ASSERT(_head + count <= _segmentEnd, "Wrote past the end of a ring buffer segment!");
+	_head += count;
+}
+
+void PersistentRingBuffer::NextSegment() {
+	// Everything that reads the current segment has been submitted, so the fence goes right after it
+	_fences[_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	_segment = (_segment + 1) % SEGMENT_COUNT;
+	_head = _segment * _segmentCapacity;
+	_segmentEnd = _head + _segmentCapacity;
+
+	// Make sure the GPU is done with the segment we're about to overwrite
+	GLsync fence = _fences[_segment];
+	if (fence != nullptr) {
+		if (!GpuFence::IsSignalled(fence, false)) {
+			_stallCount++;
+			GpuFence::IsSignalled(fence, true);
+		}
+		glDeleteSync(fence);
+		_fences[_segment] = nullptr;
+	}
+}
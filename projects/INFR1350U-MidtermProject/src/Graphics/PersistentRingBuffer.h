@@ -0,0 +1,92 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+
+#include "Graphics/VertexBuffer.h"
+
+/// <summary>
+/// A vertex buffer that stays mapped for it's whole lifetime, so that dynamic geometry can be
+/// written straight into GPU visible memory without any staging copies or buffer re-allocations
+///
+/// The buffer is split into segments that are used in turn. When we move on from a segment we
+/// put a fence after the draws that read it, and we wait on that fence before writing to it
+/// again, so we never write over vertices that the GPU has not drawn yet
+/// </summary>
+class PersistentRingBuffer final {
+public:
+	typedef std::shared_ptr<PersistentRingBuffer> Sptr;
+
+	// Triple buffering means we only wait on the GPU if it is more than two segments behind us
+	static const uint32_t SEGMENT_COUNT = 3;
+
+	static inline Sptr Create(size_t elementSize, size_t segmentCapacity) {
+		return std::make_shared<PersistentRingBuffer>(elementSize, segmentCapacity);
+	}
+
+	/// <summary>
+	/// Creates a new ring buffer and maps it
+	/// </summary>
+	/// <param name="elementSize">The size of a single vertex, in bytes</param>
+	/// <param name="segmentCapacity">The number of vertices that fit in a single segment</param>
+	PersistentRingBuffer(size_t elementSize, size_t segmentCapacity);
+	~PersistentRingBuffer();
+
+	PersistentRingBuffer(const PersistentRingBuffer& other) = delete;
+	PersistentRingBuffer(PersistentRingBuffer&& other) = delete;
+	PersistentRingBuffer& operator=(const PersistentRingBuffer& other) = delete;
+	PersistentRingBuffer& operator=(PersistentRingBuffer&& other) = delete;
+
+	/// <summary>
+	/// Gets the underlying vertex buffer, for adding to a VAO
+	/// </summary>
+	const VertexBuffer::Sptr& GetBuffer() const { return _buffer; }
+
+	/// <summary>
+	/// Gets a pointer to the next unused element in the current segment, writes through this
+	/// pointer are visible to draws issued after them
+	/// </summary>
+	template <typename T>
+	T* GetWritePointer() const { return reinterpret_cast<T*>(_mapped + _head * _elementSize); }
+	/// <summary>
+	/// Gets the index of the next unused element in the buffer, this is where draws for
+	/// newly written elements should start
+	/// </summary>
+	uint32_t GetHead() const { return (uint32_t)_head; }
+	/// <summary>
+	/// Gets the number of elements that can still be written to the current segment
+	/// </summary>
+	size_t GetRemaining() const { return _segmentEnd - _head; }
+	/// <summary>
+	/// Gets the number of elements that fit in a single segment
+	/// </summary>
+	size_t GetSegmentCapacity() const { return _segmentCapacity; }
+
+	/// <summary>
+	/// Marks elements as used, call this after issuing the draws that read them
+	/// </summary>
+	/// <param name="count">The number of elements that were written</param>
+	void Advance(size_t count);
+	/// <summary>
+	/// Fences the current segment and moves on to the next one, waiting for the GPU to finish
+	/// with it if needed. Call this after issuing all the draws for the current segment
+	/// </summary>
+	void NextSegment();
+
+	/// <summary>
+	/// Gets the number of times we've had to wait for the GPU before writing to a segment
+	/// </summary>
+	uint32_t GetStallCount() const { return _stallCount; }
+
+protected:
+	VertexBuffer::Sptr _buffer;
+	uint8_t*           _mapped;
+
+	size_t   _elementSize;
+	size_t   _segmentCapacity;
+	uint32_t _segment;
+	size_t   _head;
+	size_t   _segmentEnd;
+
+	GLsync   _fences[SEGMENT_COUNT];
+	uint32_t _stallCount;
+};
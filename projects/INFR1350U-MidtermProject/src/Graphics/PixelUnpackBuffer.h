@@ -0,0 +1,29 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// A pixel unpack buffer (PBO) is a source for texture uploads. While one is bound, the data pointer passed
+/// to glTextureSubImage2D is an offset into the buffer, so the copy into the texture can happen on the GPU
+/// without the driver having to copy our pixels first
+/// </summary>
+class PixelUnpackBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<PixelUnpackBuffer> Sptr;
+
+	static inline Sptr Create(BufferUsage usage = BufferUsage::StreamDraw) {
+		return std::make_shared<PixelUnpackBuffer>(usage);
+	}
+
+	/// <summary>
+	/// Creates a new pixel unpack buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_STREAM_DRAW since we usually refill these every frame</param>
+	PixelUnpackBuffer(BufferUsage usage = BufferUsage::StreamDraw) : IBuffer(BufferType::PixelUnpack, usage) { }
+
+	/// <summary>
+	/// Unbinds the current pixel unpack buffer, so that texture uploads read from client memory again
+	/// </summary>
+	static void UnBind() { IBuffer::UnBind(BufferType::PixelUnpack); }
+};
@@ -0,0 +1,45 @@
+#include "Graphics/SamplerCache.h"
+#include <algorithm>
+#include <Logging.h>
+
+#include "Graphics/ITexture.h"
+#include "Graphics/GlStateCache.h"
+
+std::vector<SamplerCache::Entry> SamplerCache::_samplers;
+
+GLuint SamplerCache::Get(const SamplerDescription& description) {
+	// Clamp the anisotropy first, so that descriptions asking for more than we support share a sampler
+	SamplerDescription desc = description;
+	float maxAnisotropy = ITexture::GetLimits().MAX_ANISOTROPY;
+	desc.MaxAnisotropy = glm::clamp(desc.MaxAnisotropy, 1.0f, glm::max(maxAnisotropy, 1.0f));
+
+	auto it = std::find_if(_samplers.begin(), _samplers.end(), [&](const Entry& entry) {
+		return entry.Description == desc;
+	});
+	if (it != _samplers.end()) {
+		return it->Handle;
+	}
+
+	Entry entry;
+	entry.Description = desc;
+	glCreateSamplers(1, &entry.Handle);
+	glSamplerParameteri(entry.Handle, GL_TEXTURE_MIN_FILTER, (GLenum)desc.MinificationFilter);
+	glSamplerParameteri(entry.Handle, GL_TEXTURE_MAG_FILTER, (GLenum)desc.MagnificationFilter);
+	glSamplerParameteri(entry.Handle, GL_TEXTURE_WRAP_S, (GLenum)desc.HorizontalWrap);
+	glSamplerParameteri(entry.Handle, GL_TEXTURE_WRAP_T, (GLenum)desc.VerticalWrap);
+	if (maxAnisotropy > 0.0f) {
+		glSamplerParameterf(entry.Handle, GL_TEXTURE_MAX_ANISOTROPY, desc.MaxAnisotropy);
+	}
+	_samplers.push_back(entry);
+
+	LOG_TRACE("Created sampler {} ({}, {}, {}x anisotropic)", entry.Handle, ~desc.MinificationFilter, ~desc.MagnificationFilter, desc.MaxAnisotropy);
+	return entry.Handle;
+}
+
+void SamplerCache::Clear() {
+	for (Entry& entry : _samplers) {
+		GlStateCache::NotifySamplerDeleted(entry.Handle);
+		glDeleteSamplers(1, &entry.Handle);
+	}
+	_samplers.clear();
+}
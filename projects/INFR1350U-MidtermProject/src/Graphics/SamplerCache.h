@@ -0,0 +1,69 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+#include "Graphics/TextureEnums.h"
+
+/// <summary>
+/// Describes the state of an OpenGL sampler object
+/// </summary>
+struct SamplerDescription {
+	MinFilter MinificationFilter;
+	MagFilter MagnificationFilter;
+	WrapMode  HorizontalWrap;
+	WrapMode  VerticalWrap;
+	/// <summary>
+	/// The maximum number of anisotropic samples, 1 disables anisotropic filtering.
+	/// Will be clamped to the renderer's limit
+	/// </summary>
+	float     MaxAnisotropy;
+
+	SamplerDescription() :
+		MinificationFilter(MinFilter::LinearMipLinear),
+		MagnificationFilter(MagFilter::Linear),
+		HorizontalWrap(WrapMode::Repeat),
+		VerticalWrap(WrapMode::Repeat),
+		MaxAnisotropy(1.0f)
+	{ }
+
+	bool operator ==(const SamplerDescription& other) const {
+		return MinificationFilter == other.MinificationFilter &&
+			MagnificationFilter == other.MagnificationFilter &&
+			HorizontalWrap == other.HorizontalWrap &&
+			VerticalWrap == other.VerticalWrap &&
+			MaxAnisotropy == other.MaxAnisotropy;
+	}
+};
+
+/// <summary>
+/// Hands out shared sampler objects, so that all textures with the same filtering and wrap
+/// settings use the same sampler. Samplers live until the cache is cleared
+/// </summary>
+class SamplerCache {
+public:
+	SamplerCache() = delete;
+
+	/// <summary>
+	/// Gets the sampler object matching the given description, creating it if it does not exist yet
+	/// </summary>
+	/// <param name="description">The sampler state to look up</param>
+	/// <returns>The OpenGL handle to the sampler</returns>
+	static GLuint Get(const SamplerDescription& description);
+
+	/// <summary>
+	/// Gets the number of unique samplers that have been created
+	/// </summary>
+	static size_t GetSamplerCount() { return _samplers.size(); }
+
+	/// <summary>
+	/// Deletes all the samplers in the cache, any textures using them will need to get new samplers
+	/// </summary>
+	static void Clear();
+
+protected:
+	struct Entry {
+		SamplerDescription Description;
+		GLuint             Handle;
+	};
+	// We only ever expect a handful of unique samplers, so a linear search is fine
+	static std::vector<Entry> _samplers;
+};
@@ -1,22 +1,35 @@
 #include "Shader.h"
 #include "Logging.h"
-#include <fstream>
+#include "GlStateCache.h"
+#include "ShaderBinaryCache.h"
+#include "ShaderReloader.h"
+#include "Utils/FileHelpers.h"
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 
+uint32_t Shader::_nextProgramId = 0;
+
 Shader::Shader() :
 	// We zero out all of our members so we don't have garbage data in our class
+	_handle(0),
+	_programId(0),
 	_vs(0),
-	_fs(0),
-	_handle(0)
+	_fs(0)
 {
 	_handle = glCreateProgram();
+	_programId = ++_nextProgramId;
 }
 
 Shader::Shader(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IResource(),
-	_handle(0)
+	_handle(0),
+	_programId(0),
+	_vs(0),
+	_fs(0)
 {
 	_handle = glCreateProgram();
+	_programId = ++_nextProgramId;
 	for (auto& [type, path] : filePaths) {
 		LoadShaderPartFromFile(path.c_str(), type);
 	}
@@ -25,7 +38,9 @@ Shader::Shader(const std::unordered_map<ShaderPartType, std::string>& filePaths)
 
 
 Shader::~Shader() {
+	ShaderReloader::_Untrack(this);
 	if (_handle != 0) {
+		GlStateCache::NotifyProgramDeleted(_handle);
 		glDeleteProgram(_handle);
 		_handle = 0;
 	}
@@ -33,13 +48,36 @@ Shader::~Shader() {
 
 bool Shader::LoadShaderPart(const char* source, ShaderPartType type)
 {
+	switch (type) {
+		case ShaderPartType::Vertex:
+		case ShaderPartType::Fragment:
+			break;
+		default: LOG_WARN("Not implemented"); return false;
+	}
+
+	// We hold on to the source until Link, so we can check the binary cache before compiling anything
+	_sources[type] = source;
+
+	_fileSourceMap[type].Source = source;
+	_fileSourceMap[type].IsFilePath = false;
+
+	return true;
+}
+
+GLuint Shader::_CompileShaderPart(ShaderPartType type) {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader((GLenum)type);
 
 	// Load the GLSL source and compile it
+	std::string finalSource = _GetFinalSource(type);
+	const char* source = finalSource.c_str();
 	glShaderSource(handle, 1, &source, nullptr);
 	glCompileShader(handle);
 
+	return handle;
+}
+
+bool Shader::_CheckShaderPart(GLuint handle, ShaderPartType type) {
 	// Get the compilation status for the shader part
 	GLint status = 0;
 	glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
@@ -56,49 +94,71 @@ bool Shader::LoadShaderPart(const char* source, ShaderPartType type)
 		glGetShaderInfoLog(handle, logSize, &logSize, log);
 
 		// Dump error log
-		LOG_ERROR("Failed to compile shader part:\n{}", log);
+		LOG_ERROR("Failed to compile {} shader part:\n{}", ~type, log);
 
 		// Clean up our log memory
 		delete[] log;
+	}
 
-		// Delete the broken shader result
-		glDeleteShader(handle);
-		handle = 0;
+	return status != GL_FALSE;
+}
 
-		return false;
+uint64_t Shader::_GetBinaryKey() const {
+	// The map has no stable order, so we hash the stages in a fixed order
+	uint64_t result = ShaderBinaryCache::GetBaseKey();
+	for (ShaderPartType type : { ShaderPartType::Vertex, ShaderPartType::Fragment }) {
+		auto it = _sources.find(type);
+		if (it != _sources.end()) {
+			std::string source = _GetFinalSource(type);
+			result = ShaderBinaryCache::Hash(&type, sizeof(ShaderPartType), result);
+			result = ShaderBinaryCache::Hash(source.data(), source.size(), result);
+		}
 	}
+	return result;
+}
 
-	switch (type) {
-		case ShaderPartType::Vertex: _vs = handle; break;
-		case ShaderPartType::Fragment: _fs = handle; break;
-		default: LOG_WARN("Not implemented"); break;
+std::string Shader::_GetFinalSource(ShaderPartType type) const {
+	auto it = _sources.find(type);
+	if (it == _sources.end()) {
+		return "";
 	}
-
-	_fileSourceMap[type].Source = source;
-	_fileSourceMap[type].IsFilePath = false;
-
-	return status != GL_FALSE;
+	return _keywords.empty() ? it->second : InjectKeywords(it->second, _keywords);
 }
 
-bool Shader::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
-	// Open the file at path
-	std::ifstream file(path);
-
-	// Check to see if the file is open
-	if (file.is_open()) {
-		// Create a string stream to load the entire contents of the file
-		std::stringstream stream;
-		stream << file.rdbuf();
+std::string Shader::InjectKeywords(const std::string& source, const std::vector<std::string>& keywords) {
+	// The defines have to go after #version, since it must be the first thing in the shader
+	size_t insertAt = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos) {
+		size_t eol = source.find('\n', version);
+		insertAt = eol == std::string::npos ? source.size() : eol + 1;
+	}
 
-		// Compile the shader part from the loaded contents of the file
-		bool result = LoadShaderPart(stream.str().c_str(), type);
+	std::stringstream defines;
+	if (insertAt == source.size() && insertAt > 0 && source.back() != '\n') {
+		defines << "\n";
+	}
+	for (const std::string& keyword : keywords) {
+		// NAME=VALUE becomes #define NAME VALUE
+		std::string define = keyword;
+		std::replace(define.begin(), define.end(), '=', ' ');
+		defines << "#define " << define << "\n";
+	}
+	// Reset the line number so that compiler errors still match the source file
+	defines << "#line " << std::count(source.begin(), source.begin() + insertAt, '\n') + 1 << "\n";
 
-		_fileSourceMap[type].Source = path;
-		_fileSourceMap[type].IsFilePath = true;
+	std::string result = source;
+	result.insert(insertAt, defines.str());
+	return result;
+}
 
-		// Close the file
-		file.close();
-		return result;
+bool Shader::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
+	// Check to see if the file exists
+	if (FileHelpers::Exists(path)) {
+		// Load the file, pulling in any files that it includes
+		std::vector<std::string> files = { path };
+		std::string source = FileHelpers::ReadResolveIncludes(path, &files);
+		return _LoadShaderPartFromSource(source, path, files, type);
 	}
 	// Failed to open file, log it and return false
 	else {
@@ -107,27 +167,97 @@ bool Shader::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
 	}
 }
 
+bool Shader::_LoadShaderPartFromSource(const std::string& source, const std::string& path, const std::vector<std::string>& files, ShaderPartType type) {
+	for (const std::string& file : files) {
+		if (std::find(_sourceFiles.begin(), _sourceFiles.end(), file) == _sourceFiles.end()) {
+			_sourceFiles.push_back(file);
+		}
+	}
+
+	// Store the shader part from the loaded contents of the file, it gets compiled when we link
+	bool result = LoadShaderPart(source.c_str(), type);
+
+	_fileSourceMap[type].Source = path;
+	_fileSourceMap[type].IsFilePath = true;
+
+	return result;
+}
+
 bool Shader::Link()
 {
-	LOG_ASSERT(_vs != 0 && _fs != 0, "Must attach both a vertex and fragment shader!");
+	LOG_ASSERT(_sources.count(ShaderPartType::Vertex) && _sources.count(ShaderPartType::Fragment), "Must attach both a vertex and fragment shader!");
+
+	auto start = std::chrono::high_resolution_clock::now();
+	// Linking resets all of the program's uniforms
+	_programId = ++_nextProgramId;
+
+	// If we've linked these exact sources on this driver before, we can skip compiling entirely
+	uint64_t key = _GetBinaryKey();
+	if (ShaderBinaryCache::TryLoad(_handle, key)) {
+		float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		ShaderBinaryCache::RecordLoadTime(true, elapsed);
+		LOG_TRACE("Loaded shader program {} from binary cache in {:.2f} ms", _handle, elapsed);
+		ShaderReloader::_Track(this);
+		return true;
+	}
+
+	_BeginLink();
+	bool result = _FinishLink();
+	if (result) {
+		ShaderBinaryCache::Store(_handle, key);
+
+		float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		ShaderBinaryCache::RecordLoadTime(false, elapsed);
+		LOG_TRACE("Compiled shader program {} from source in {:.2f} ms", _handle, elapsed);
+		ShaderReloader::_Track(this);
+	}
+	return result;
+}
+
+void Shader::_BeginLink() {
+	_vs = _CompileShaderPart(ShaderPartType::Vertex);
+	_fs = _CompileShaderPart(ShaderPartType::Fragment);
 
 	// Attach our two shaders
 	glAttachShader(_handle, _vs);
 	glAttachShader(_handle, _fs);
 
-	// Perform linking
+	// Let the driver know we'll want to read back the binary for the cache
+	glProgramParameteri(_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	// Perform linking, we don't check the compile results first since that would force us to wait for them
 	glLinkProgram(_handle);
+}
+
+bool Shader::_IsLinkComplete() const {
+	if (!ShaderReloader::IsParallelCompileSupported()) {
+		return true;
+	}
+	GLint complete = GL_FALSE;
+	glGetProgramiv(_handle, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete != GL_FALSE;
+}
+
+bool Shader::_FinishLink() {
+	GLint status = 0;
+	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
+
+	// If the link failed, it was most likely a compile error in one of the parts
+	bool compiled = true;
+	if (status == GL_FALSE) {
+		compiled &= _CheckShaderPart(_vs, ShaderPartType::Vertex);
+		compiled &= _CheckShaderPart(_fs, ShaderPartType::Fragment);
+	}
 
 	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
 	glDetachShader(_handle, _vs);
 	glDeleteShader(_vs);
 	glDetachShader(_handle, _fs);
 	glDeleteShader(_fs);
+	_vs = 0;
+	_fs = 0;
 
-	GLint status = 0;
-	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
-
-	if (status == GL_FALSE)
+	if (status == GL_FALSE && compiled)
 	{
 		// Get the length of the log
 		GLint length = 0;
@@ -146,14 +276,77 @@ bool Shader::Link()
 	return status != GL_FALSE;
 }
 
+void Shader::_SwapProgram(Shader& other) {
+	std::swap(_handle, other._handle);
+	std::swap(_sources, other._sources);
+	// Locations can be different in the new program, and anything that cached state on the old one needs to know
+	_uniformLocs.clear();
+	other._uniformLocs.clear();
+	_programId = ++_nextProgramId;
+	other._programId = ++_nextProgramId;
+}
+
+Shader::Sptr Shader::CreateVariant(ShaderPartType type, const std::string& path) const {
+	Shader::Sptr result = std::make_shared<Shader>();
+	bool loaded = true;
+	for (auto& [partType, source] : _fileSourceMap) {
+		if (partType == type) {
+			continue;
+		}
+		if (source.IsFilePath) {
+			loaded &= result->LoadShaderPartFromFile(source.Source.c_str(), partType);
+		} else {
+			loaded &= result->LoadShaderPart(source.Source.c_str(), partType);
+		}
+	}
+	loaded &= result->LoadShaderPartFromFile(path.c_str(), type);
+	result->_keywords = _keywords;
+	return loaded && result->Link() ? result : nullptr;
+}
+
+Shader::Sptr Shader::GetVariant(const std::vector<std::string>& keywords) {
+	// Sort the keywords so that the same set always maps to the same variant
+	std::vector<std::string> sorted = keywords;
+	sorted.insert(sorted.end(), _keywords.begin(), _keywords.end());
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+	std::stringstream keyStream;
+	for (const std::string& keyword : sorted) {
+		keyStream << keyword << ";";
+	}
+	std::string key = keyStream.str();
+
+	auto it = _variants.find(key);
+	if (it != _variants.end()) {
+		return it->second;
+	}
+
+	Shader::Sptr result = std::make_shared<Shader>();
+	result->_sources = _sources;
+	result->_fileSourceMap = _fileSourceMap;
+	result->_sourceFiles = _sourceFiles;
+	result->_keywords = sorted;
+	if (!result->Link()) {
+		LOG_ERROR("Failed to compile shader variant with keywords [{}]", key);
+		result = nullptr;
+	} else {
+		LOG_TRACE("Compiled shader variant with keywords [{}]", key);
+	}
+
+	// We store failed variants as well, so we don't try to compile them again every frame
+	_variants[key] = result;
+	return result;
+}
+
 void Shader::Bind() {
-	// Simply calls glUseProgram with our shader handle
-	glUseProgram(_handle);
+	// Goes through the state cache so that re-binding the active program is free
+	GlStateCache::UseProgram(_handle);
 }
 
 void Shader::Unbind() {
 	// We unbind a shader program by using the default program (0)
-	glUseProgram(0);
+	GlStateCache::UseProgram(0);
 }
 
 void Shader::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
@@ -215,6 +408,10 @@ int Shader::__GetUniformLocation(const std::string& name) {
 	if (it == _uniformLocs.end()) {
 		result = glGetUniformLocation(_handle, name.c_str());
 		_uniformLocs[name] = result;
+		// Keyword variants can compile out uniforms, so we only warn the first time instead of every frame
+		if (result == -1) {
+			LOG_WARN("Ignoring uniform \"{}\"", name);
+		}
 	}
 	// Otherwise, we had a value in the map, return it
 	else {
@@ -241,8 +438,11 @@ Shader::Sptr Shader::FromJson(const nlohmann::json& data) {
 		ShaderPartType type = ParseShaderPartType(key, ShaderPartType::Unknown);
 		// As long as the type is valid
 		if (type != ShaderPartType::Unknown) {
-			// If it has a file, we load from file
-			if (blob.contains("file")) {
+			// If it has a file, we load from file (ToJson writes "path", older files used "file")
+			if (blob.contains("path")) {
+				result->LoadShaderPartFromFile(blob["path"].get<std::string>().c_str(), type);
+			}
+			else if (blob.contains("file")) {
 				result->LoadShaderPartFromFile(blob["file"].get<std::string>().c_str(), type);
 			}
 			// Otherwise we see if there's a source and load that instead
@@ -254,4 +454,49 @@ Shader::Sptr Shader::FromJson(const nlohmann::json& data) {
 	}
 	result->Link();
 	return result;
+}
+
+std::function<Shader::Sptr()> Shader::DecodeJson(const nlohmann::json& data) {
+	// A stage that has been read from disk, but not compiled
+	struct DecodedPart {
+		ShaderPartType           Type;
+		std::string              Source;
+		// Empty if the source came from the manifest instead of a file
+		std::string              Path;
+		std::vector<std::string> Files;
+	};
+
+	std::vector<DecodedPart> parts;
+	for (auto& [key, blob] : data.items()) {
+		ShaderPartType type = ParseShaderPartType(key, ShaderPartType::Unknown);
+		if (type == ShaderPartType::Unknown) {
+			continue;
+		}
+		// Same rules as FromJson, "path" is preferred over the older "file"
+		std::string path = blob.contains("path") ? blob["path"].get<std::string>() : (blob.contains("file") ? blob["file"].get<std::string>() : "");
+		if (!path.empty()) {
+			if (FileHelpers::Exists(path)) {
+				DecodedPart part = { type, "", path, { path } };
+				part.Source = FileHelpers::ReadResolveIncludes(path, &part.Files);
+				parts.push_back(part);
+			} else {
+				LOG_WARN("Could not open file at \"{}\"", path);
+			}
+		} else if (blob.contains("source")) {
+			parts.push_back({ type, blob["source"].get<std::string>(), "", {} });
+		}
+	}
+
+	return [parts]() {
+		Shader::Sptr result = std::make_shared<Shader>();
+		for (const DecodedPart& part : parts) {
+			if (part.Path.empty()) {
+				result->LoadShaderPart(part.Source.c_str(), part.Type);
+			} else {
+				result->_LoadShaderPartFromSource(part.Source, part.Path, part.Files, part.Type);
+			}
+		}
+		result->Link();
+		return result;
+	};
 }
\ No newline at end of file
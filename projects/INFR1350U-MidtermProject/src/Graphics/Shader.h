@@ -1,8 +1,10 @@
 #pragma once
 #include <glad/glad.h>
+#include <functional>
 #include <memory>
 #include <string>               // for std::string
 #include <unordered_map>        // for std::unordered_map
+#include <vector>               // for std::vector
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include <Logging.h>            // for the logging functions
@@ -39,6 +41,11 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Shader::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Reads the shader's source files on the calling thread, the returned function compiles and links the
+	/// shader on the main thread. See IResource
+	/// </summary>
+	static std::function<Shader::Sptr()> DecodeJson(const nlohmann::json& data);
 
 public:
 	/// <summary>
@@ -52,6 +59,9 @@ public:
 
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// 
+	/// Note that compilation is deferred until Link, so that we can skip it entirely if the program
+	/// is in the ShaderBinaryCache. Compile errors will be reported by Link
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -59,6 +69,7 @@ public:
 	bool LoadShaderPart(const char* source, ShaderPartType type);
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader) from an external file (in res)
+	/// Any #include "file" lines are resolved relative to the file
 	/// </summary>
 	/// <param name="path">The relative path to the file containing the source</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -66,11 +77,49 @@ public:
 	bool LoadShaderPartFromFile(const char* path, ShaderPartType type);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. If the
+	/// program binary cache has a binary for our sources, that gets loaded instead of compiling
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
 
+	/// <summary>
+	/// Creates and links a new shader that uses the same sources as this one, except for a single
+	/// stage which is loaded from a file instead (ex: to swap out the vertex shader for one that reads
+	/// per-draw data from a storage buffer)
+	/// </summary>
+	/// <param name="type">The stage to replace</param>
+	/// <param name="path">The path to the file containing the source for the replaced stage</param>
+	/// <returns>The new shader, or nullptr if it failed to compile or link</returns>
+	Shader::Sptr CreateVariant(ShaderPartType type, const std::string& path) const;
+
+	/// <summary>
+	/// Gets a version of this shader compiled with the given keywords defined, so that
+	/// the shader can use #ifdef to compile out paths instead of branching at runtime. Keywords
+	/// in the form NAME=VALUE will be defined with a value (ex: MAX_LIGHTS=16)
+	/// 
+	/// Variants are compiled the first time they are requested, and cached for each unique set of keywords
+	/// </summary>
+	/// <param name="keywords">The keywords to define, order and duplicates do not matter</param>
+	/// <returns>The variant, or nullptr if it failed to compile</returns>
+	Shader::Sptr GetVariant(const std::vector<std::string>& keywords);
+	/// <summary>
+	/// Gets the keywords that this shader was compiled with, sorted by name
+	/// </summary>
+	const std::vector<std::string>& GetKeywords() const { return _keywords; }
+	/// <summary>
+	/// Gets the number of keyword variants that have been created from this shader
+	/// </summary>
+	size_t GetVariantCount() const { return _variants.size(); }
+
+	/// <summary>
+	/// Inserts a #define for each keyword after the #version line of a GLSL source
+	/// </summary>
+	/// <param name="source">The GLSL source code</param>
+	/// <param name="keywords">The keywords to define</param>
+	/// <returns>The source with the defines injected</returns>
+	static std::string InjectKeywords(const std::string& source, const std::vector<std::string>& keywords);
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -84,6 +133,11 @@ public:
 	/// Gets the underlying OpenGL handle that this class is wrapping
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
+	/// <summary>
+	/// Gets an ID for the program's current state. It changes whenever the program is linked or swapped
+	/// by a hot reload, and unlike the handle it is never reused, so it can be used to cache program state
+	/// </summary>
+	uint32_t GetProgramId() const { return _programId; }
 
 public:
 	void SetUniformMatrix(int location, const glm::mat3* value, int count = 1, bool transposed = false);
@@ -106,8 +160,6 @@ public:
 		int location = __GetUniformLocation(name);
 		if (location != -1) {
 			SetUniform(location, &value, 1);
-		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
 		}
 	}
 	template <typename T>
@@ -115,18 +167,31 @@ public:
 		int location = __GetUniformLocation(name);
 		if (location != -1) {
 			SetUniformMatrix(location, &value, 1, transposed);
-		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
 		}
 	}
 
 protected:
-	// Stores the vertex and fragment shader handles
-	GLuint _vs;
-	GLuint _fs;
+	// The reloader needs to be able to build a replacement program and swap it in
+	friend class ShaderReloader;
 
 	// Stores the shader program handle
 	GLuint _handle;
+	// See GetProgramId, taken from _nextProgramId
+	uint32_t _programId;
+	static uint32_t _nextProgramId;
+	// The shader parts that are being compiled and linked, only valid between _BeginLink and _FinishLink
+	GLuint _vs;
+	GLuint _fs;
+
+	// Stores the GLSL source for each stage until we link
+	std::unordered_map<ShaderPartType, std::string> _sources;
+	// All the files that our sources were read from, including any files they #include
+	std::vector<std::string> _sourceFiles;
+
+	// The keywords that get defined when we compile, sorted so we can compare sets of keywords
+	std::vector<std::string> _keywords;
+	// Keyword variants of this shader, keyed by their joined keywords
+	std::unordered_map<std::string, Shader::Sptr> _variants;
 
 	// Stores information about the source of our shader parts
 	// EX: if a VS shader is loaded from a file, will contain
@@ -140,4 +205,46 @@ protected:
 	// Map and access to look up uniform locations
 	std::unordered_map<std::string, int> _uniformLocs;
 	int __GetUniformLocation(const std::string& name);
+
+	/// <summary>
+	/// Stores the source for a stage that was read from a file, along with the files it included
+	/// </summary>
+	bool _LoadShaderPartFromSource(const std::string& source, const std::string& path, const std::vector<std::string>& files, ShaderPartType type);
+	/// <summary>
+	/// Gets the source for a stage with our keywords injected, this is what actually gets compiled
+	/// </summary>
+	std::string _GetFinalSource(ShaderPartType type) const;
+	/// <summary>
+	/// Starts compiling a single stage from the sources we've loaded, we don't check the
+	/// status here since that would wait for the compile to finish
+	/// </summary>
+	/// <returns>The handle to the shader part</returns>
+	GLuint _CompileShaderPart(ShaderPartType type);
+	/// <summary>
+	/// Logs the compile errors for a shader part, if it failed to compile
+	/// </summary>
+	/// <returns>True if the part compiled successfully</returns>
+	static bool _CheckShaderPart(GLuint handle, ShaderPartType type);
+	/// <summary>
+	/// Compiles our stages and starts linking the program. With parallel shader compile this returns
+	/// right away, and the driver does the work on it's own threads
+	/// </summary>
+	void _BeginLink();
+	/// <summary>
+	/// Returns true if the link started by _BeginLink has finished, and _FinishLink will not block
+	/// </summary>
+	bool _IsLinkComplete() const;
+	/// <summary>
+	/// Checks the results of the link started by _BeginLink, logs any errors and cleans up the shader parts
+	/// </summary>
+	/// <returns>True if the program linked successfully</returns>
+	bool _FinishLink();
+	/// <summary>
+	/// Takes the program and sources from another shader, giving it our old program to clean up
+	/// </summary>
+	void _SwapProgram(Shader& other);
+	/// <summary>
+	/// Gets the key for this program in the ShaderBinaryCache, based on the sources of all stages
+	/// </summary>
+	uint64_t _GetBinaryKey() const;
 };
\ No newline at end of file
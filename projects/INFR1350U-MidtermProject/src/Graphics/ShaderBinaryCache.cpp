@@ -0,0 +1,179 @@
+#include "Graphics/ShaderBinaryCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <Logging.h>
+
+// The header at the start of every cache file, bump the version if the layout ever changes
+struct ShaderBinaryHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Key;
+	GLenum   Format;
+	uint32_t Length;
+};
+static const uint32_t SHADER_BINARY_MAGIC   = 0x4253544F; // "OTSB"
+static const uint32_t SHADER_BINARY_VERSION = 1;
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME        = 1099511628211ULL;
+
+bool        ShaderBinaryCache::_enabled    = false;
+bool        ShaderBinaryCache::_supported  = false;
+std::string ShaderBinaryCache::_directory  = "";
+uint64_t    ShaderBinaryCache::_driverHash = FNV_OFFSET_BASIS;
+ShaderBinaryCache::Stats ShaderBinaryCache::_stats = ShaderBinaryCache::Stats();
+
+ShaderBinaryCache::Stats::Stats() :
+	CacheHits(0),
+	Compiled(0),
+	Rejected(0),
+	CacheLoadMs(0.0f),
+	CompileMs(0.0f)
+{ }
+
+void ShaderBinaryCache::Init(const std::string& directory) {
+	_directory = directory;
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	_supported = formatCount > 0;
+	if (!_supported) {
+		LOG_WARN("Driver does not support any program binary formats, shaders will always be compiled from source");
+		_enabled = false;
+		return;
+	}
+
+	// Binaries are only valid for the exact driver that created them
+	_driverHash = FNV_OFFSET_BASIS;
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		const char* value = (const char*)glGetString(name);
+		if (value != nullptr) {
+			_driverHash = Hash(value, strlen(value), _driverHash);
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(_directory, error);
+	if (error) {
+		LOG_WARN("Could not create shader cache directory \"{}\": {}", _directory, error.message());
+		_enabled = false;
+		return;
+	}
+
+	_enabled = true;
+	LOG_INFO("Shader binary cache enabled in \"{}\"", _directory);
+}
+
+void ShaderBinaryCache::SetEnabled(bool value) {
+	_enabled = value && _supported;
+}
+
+uint64_t ShaderBinaryCache::Hash(const void* data, size_t size, uint64_t seed) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t result = seed;
+	for (size_t ix = 0; ix < size; ix++) {
+		result ^= bytes[ix];
+		result *= FNV_PRIME;
+	}
+	return result;
+}
+
+bool ShaderBinaryCache::TryLoad(GLuint program, uint64_t key) {
+	if (!_enabled) {
+		return false;
+	}
+
+	std::string path = _GetPath(key);
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	ShaderBinaryHeader header;
+	file.read((char*)&header, sizeof(ShaderBinaryHeader));
+	bool valid = file.good() && header.Magic == SHADER_BINARY_MAGIC && header.Version == SHADER_BINARY_VERSION && header.Key == key;
+
+	std::vector<char> binary;
+	if (valid) {
+		binary.resize(header.Length);
+		file.read(binary.data(), header.Length);
+		valid = file.good();
+	}
+	file.close();
+
+	// The driver may still reject the binary (ex: after a driver update that didn't change the version string)
+	GLint status = GL_FALSE;
+	if (valid) {
+		glProgramBinary(program, header.Format, binary.data(), (GLsizei)binary.size());
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+	}
+
+	if (status == GL_FALSE) {
+		LOG_WARN("Cached shader binary \"{}\" was rejected, recompiling from source", path);
+		_stats.Rejected++;
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		return false;
+	}
+	return true;
+}
+
+void ShaderBinaryCache::Store(GLuint program, uint64_t key) {
+	if (!_enabled) {
+		return;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	ShaderBinaryHeader header;
+	header.Magic = SHADER_BINARY_MAGIC;
+	header.Version = SHADER_BINARY_VERSION;
+	header.Key = key;
+	std::vector<char> binary(length);
+	glGetProgramBinary(program, length, &length, &header.Format, binary.data());
+	header.Length = (uint32_t)length;
+
+	std::string path = _GetPath(key);
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		LOG_WARN("Could not write shader binary to \"{}\"", path);
+		return;
+	}
+	file.write((const char*)&header, sizeof(ShaderBinaryHeader));
+	file.write(binary.data(), header.Length);
+}
+
+void ShaderBinaryCache::RecordLoadTime(bool fromCache, float milliseconds) {
+	if (fromCache) {
+		_stats.CacheHits++;
+		_stats.CacheLoadMs += milliseconds;
+	} else {
+		_stats.Compiled++;
+		_stats.CompileMs += milliseconds;
+	}
+}
+
+void ShaderBinaryCache::LogStats() {
+	// A cold start compiles everything, a warm start should be almost entirely cache hits
+	LOG_INFO("Shaders ready in {:.2f} ms ({} {}): {} from cache in {:.2f} ms, {} compiled in {:.2f} ms, {} rejected",
+		_stats.CacheLoadMs + _stats.CompileMs,
+		_stats.Compiled == 0 && _stats.CacheHits > 0 ? "warm" : "cold",
+		_enabled ? "cache enabled" : "cache disabled",
+		_stats.CacheHits, _stats.CacheLoadMs,
+		_stats.Compiled, _stats.CompileMs,
+		_stats.Rejected);
+}
+
+std::string ShaderBinaryCache::_GetPath(uint64_t key) {
+	std::stringstream stream;
+	stream << _directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return stream.str();
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Stores linked shader programs on disk using glGetProgramBinary, so that on the next launch we
+/// can skip compiling and linking GLSL and hand the driver it's own binary instead
+///
+/// Binaries are keyed by a hash of the shader sources and the driver's vendor, renderer and version
+/// strings, since drivers will reject binaries from other drivers (or even other driver versions)
+/// </summary>
+class ShaderBinaryCache {
+public:
+	/// <summary>
+	/// Timing and hit counts for all the shaders loaded since startup
+	/// </summary>
+	struct Stats {
+		// Programs restored from a cached binary
+		uint32_t CacheHits;
+		// Programs that had to be compiled from source
+		uint32_t Compiled;
+		// Cached binaries that the driver refused to load
+		uint32_t Rejected;
+		// Total time spent restoring cached programs, in milliseconds
+		float    CacheLoadMs;
+		// Total time spent compiling and linking from source, in milliseconds
+		float    CompileMs;
+
+		Stats();
+	};
+
+	ShaderBinaryCache() = delete;
+
+	/// <summary>
+	/// Sets up the cache, must be called after GLAD is loaded. Shaders linked before this
+	/// is called (or if the driver does not support any binary formats) always compile from source
+	/// </summary>
+	/// <param name="directory">The directory to store binaries in, will be created if it does not exist</param>
+	static void Init(const std::string& directory = "shader_cache");
+
+	/// <summary>
+	/// Returns true if the cache has been initialized and the driver supports program binaries
+	/// </summary>
+	static bool IsEnabled() { return _enabled; }
+	/// <summary>
+	/// Allows the cache to be turned off, ex: while editing shaders
+	/// </summary>
+	static void SetEnabled(bool value);
+
+	/// <summary>
+	/// Gets the key for a program, starting with the hash of the driver strings. Feed each
+	/// stage's type and source into it with Hash to build the full key
+	/// </summary>
+	static uint64_t GetBaseKey() { return _driverHash; }
+	/// <summary>
+	/// Feeds the given data into a 64 bit FNV-1a hash
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The size of data in bytes</param>
+	/// <param name="seed">The hash to continue from</param>
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed);
+
+	/// <summary>
+	/// Attempts to restore a program from the cache
+	/// </summary>
+	/// <param name="program">The program object to load the binary into</param>
+	/// <param name="key">The key for the program's sources</param>
+	/// <returns>True if the program was loaded and linked, false if it needs to be compiled from source</returns>
+	static bool TryLoad(GLuint program, uint64_t key);
+	/// <summary>
+	/// Stores a linked program in the cache, the program should have been linked with
+	/// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	/// </summary>
+	/// <param name="program">The linked program to store</param>
+	/// <param name="key">The key for the program's sources</param>
+	static void Store(GLuint program, uint64_t key);
+
+	/// <summary>
+	/// Records how long it took for a shader to become ready, used for our startup timing logs
+	/// </summary>
+	/// <param name="fromCache">True if the shader was restored from the cache</param>
+	/// <param name="milliseconds">The time taken to load the shader</param>
+	static void RecordLoadTime(bool fromCache, float milliseconds);
+	/// <summary>
+	/// Gets the timing and hit counts since startup
+	/// </summary>
+	static const Stats& GetStats() { return _stats; }
+	/// <summary>
+	/// Logs a summary of how long shader loading took, and how much of it was served from the cache
+	/// </summary>
+	static void LogStats();
+
+protected:
+	static bool        _enabled;
+	static bool        _supported;
+	static std::string _directory;
+	static uint64_t    _driverHash;
+	static Stats       _stats;
+
+	/// <summary>
+	/// Gets the path to the file that stores the binary for the given key
+	/// </summary>
+	static std::string _GetPath(uint64_t key);
+};
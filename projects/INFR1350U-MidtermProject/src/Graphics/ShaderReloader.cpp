@@ -0,0 +1,200 @@
+#include "Graphics/ShaderReloader.h"
+#include <algorithm>
+#include <cstring>
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+
+#include "Graphics/ShaderBinaryCache.h"
+#include "Utils/FileHelpers.h"
+
+std::mutex                                  ShaderReloader::_mutex;
+std::unordered_map<Shader*, ShaderReloader::TrackedShader> ShaderReloader::_tracked;
+std::vector<ShaderReloader::PendingReload> ShaderReloader::_pending;
+std::vector<ShaderReloader::ActiveReload>  ShaderReloader::_active;
+FileWatcher::Sptr                          ShaderReloader::_watcher = nullptr;
+bool                                       ShaderReloader::_parallelCompile = false;
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+void ShaderReloader::Init() {
+	// The KHR and ARB versions of the extension are identical, and share their enum values
+	const char* function = nullptr;
+	if (_HasExtension("GL_KHR_parallel_shader_compile")) {
+		function = "glMaxShaderCompilerThreadsKHR";
+	} else if (_HasExtension("GL_ARB_parallel_shader_compile")) {
+		function = "glMaxShaderCompilerThreadsARB";
+	}
+	if (function != nullptr) {
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress(function);
+		if (maxThreads != nullptr) {
+			// 0xFFFFFFFF lets the driver pick how many threads to use
+			maxThreads(0xFFFFFFFF);
+			_parallelCompile = true;
+		}
+	}
+	LOG_INFO("Shader hot reload enabled, parallel shader compile is {}", _parallelCompile ? "supported" : "not supported");
+
+	_watcher = FileWatcher::Create(&ShaderReloader::_OnFileChanged);
+
+	// Any shaders that were loaded before we started need to be watched too
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto& [shader, tracked] : _tracked) {
+		for (const std::string& file : tracked.Files) {
+			_watcher->Watch(file);
+		}
+	}
+}
+
+void ShaderReloader::Cleanup() {
+	// Destroying the watcher joins it's thread, so nothing else will be added to the pending list
+	_watcher = nullptr;
+	_active.clear();
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending.clear();
+}
+
+void ShaderReloader::Update() {
+	std::vector<PendingReload> pending;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(pending, _pending);
+	}
+
+	// Start compiling the new sources
+	for (PendingReload& reload : pending) {
+		// The shader may have been destroyed while the watcher was reading it's files
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_tracked.find(reload.Target) == _tracked.end()) {
+				continue;
+			}
+		}
+
+		// A newer edit replaces a reload that is still compiling
+		_active.erase(std::remove_if(_active.begin(), _active.end(), [&](const ActiveReload& active) {
+			return active.Target == reload.Target;
+		}), _active.end());
+
+		// Stages that were not loaded from files keep their old source
+		Shader::Sptr staging = Shader::Create();
+		for (auto& [type, source] : reload.Target->_sources) {
+			if (reload.Sources.find(type) == reload.Sources.end()) {
+				staging->LoadShaderPart(source.c_str(), type);
+			}
+		}
+		for (auto& [type, source] : reload.Sources) {
+			staging->LoadShaderPart(source.c_str(), type);
+		}
+		staging->_keywords = reload.Target->_keywords;
+
+		staging->_BeginLink();
+		_active.push_back({ reload.Target, staging, reload.Files });
+	}
+
+	// Swap in any programs that have finished, and keep waiting on the rest
+	std::vector<ActiveReload> active;
+	std::swap(active, _active);
+	for (ActiveReload& reload : active) {
+		if (!reload.Staging->_IsLinkComplete()) {
+			_active.push_back(reload);
+			continue;
+		}
+
+		bool linked = reload.Staging->_FinishLink();
+		bool tracked = false;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			tracked = _tracked.find(reload.Target) != _tracked.end();
+		}
+
+		if (!linked) {
+			LOG_WARN("Shader reload failed, keeping the old program");
+		} else if (tracked) {
+			// The staging shader ends up with our old program, and deletes it when it goes out of scope
+			reload.Target->_SwapProgram(*reload.Staging);
+			reload.Target->_sourceFiles = reload.Files;
+			ShaderBinaryCache::Store(reload.Target->GetHandle(), reload.Target->_GetBinaryKey());
+			// Re-track, since the edit may have added or removed includes
+			_Track(reload.Target);
+			LOG_INFO("Reloaded shader program {}", reload.Target->GetHandle());
+		}
+	}
+}
+
+void ShaderReloader::_Track(Shader* shader) {
+	if (shader->_sourceFiles.empty()) {
+		return;
+	}
+
+	TrackedShader tracked;
+	for (auto& [type, source] : shader->_fileSourceMap) {
+		if (source.IsFilePath) {
+			tracked.Paths[type] = source.Source;
+		}
+	}
+	for (const std::string& file : shader->_sourceFiles) {
+		tracked.Files.push_back(FileWatcher::NormalizePath(file));
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_watcher != nullptr) {
+		for (const std::string& file : tracked.Files) {
+			_watcher->Watch(file);
+		}
+	}
+	_tracked[shader] = tracked;
+}
+
+void ShaderReloader::_Untrack(Shader* shader) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_tracked.erase(shader);
+	_pending.erase(std::remove_if(_pending.begin(), _pending.end(), [&](const PendingReload& reload) {
+		return reload.Target == shader;
+	}), _pending.end());
+}
+
+void ShaderReloader::_OnFileChanged(const std::string& path) {
+	// Grab the shaders that use this file, so we don't hold the lock while reading files
+	std::vector<std::pair<Shader*, TrackedShader>> targets;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto& [shader, tracked] : _tracked) {
+			if (std::find(tracked.Files.begin(), tracked.Files.end(), path) != tracked.Files.end()) {
+				targets.push_back({ shader, tracked });
+			}
+		}
+	}
+
+	// Preprocessing happens here on the watcher's thread, so the main thread only has to compile
+	for (auto& [shader, tracked] : targets) {
+		PendingReload reload;
+		reload.Target = shader;
+		for (auto& [type, file] : tracked.Paths) {
+			std::vector<std::string> files = { file };
+			reload.Sources[type] = FileHelpers::ReadResolveIncludes(file, &files);
+			for (const std::string& included : files) {
+				std::string normalized = FileWatcher::NormalizePath(included);
+				if (std::find(reload.Files.begin(), reload.Files.end(), normalized) == reload.Files.end()) {
+					reload.Files.push_back(normalized);
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_pending.erase(std::remove_if(_pending.begin(), _pending.end(), [&](const PendingReload& other) {
+			return other.Target == shader;
+		}), _pending.end());
+		_pending.push_back(reload);
+	}
+}
+
+bool ShaderReloader::_HasExtension(const char* name) {
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint ix = 0; ix < extensionCount; ix++) {
+		if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, ix), name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
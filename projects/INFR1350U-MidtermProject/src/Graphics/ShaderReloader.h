@@ -0,0 +1,101 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/Shader.h"
+#include "Utils/FileWatcher.h"
+
+// GLAD was generated without KHR_parallel_shader_compile, so we declare what we need ourselves
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+
+/// <summary>
+/// Reloads shaders when their source files change on disk, without stalling the running frame
+///
+/// A FileWatcher notices the change and reads and resolves the shader's files on it's own thread.
+/// The new program is then compiled and linked on the main thread, using KHR_parallel_shader_compile
+/// where available so that the driver does the work in the background. The shader keeps using
+/// it's old program until the new one has linked successfully, so a broken edit just logs the errors
+///
+/// All shaders loaded from files are tracked automatically when they link
+/// </summary>
+class ShaderReloader {
+public:
+	ShaderReloader() = delete;
+
+	/// <summary>
+	/// Starts watching the files of all tracked shaders, must be called after GLAD is loaded
+	/// </summary>
+	static void Init();
+	/// <summary>
+	/// Stops the file watcher and drops any reloads that are still in flight
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Starts compiling any shaders whose files have changed, and swaps in any that have
+	/// finished linking. Should be called once per frame on the main thread
+	/// </summary>
+	static void Update();
+
+	/// <summary>
+	/// Returns true if the driver supports KHR_parallel_shader_compile (or the ARB version)
+	/// </summary>
+	static bool IsParallelCompileSupported() { return _parallelCompile; }
+	/// <summary>
+	/// Gets the number of shaders that are being reloaded
+	/// </summary>
+	static size_t GetInFlightCount() { return _active.size(); }
+
+protected:
+	friend class Shader;
+
+	// The files that a tracked shader was loaded from
+	struct TrackedShader {
+		std::unordered_map<ShaderPartType, std::string> Paths;
+		std::vector<std::string>                        Files;
+	};
+	// Sources that have been read by the watcher thread, waiting to be compiled
+	struct PendingReload {
+		Shader*                                         Target;
+		std::unordered_map<ShaderPartType, std::string> Sources;
+		std::vector<std::string>                        Files;
+	};
+	// A replacement program that is being compiled and linked
+	struct ActiveReload {
+		Shader*                  Target;
+		Shader::Sptr             Staging;
+		std::vector<std::string> Files;
+	};
+
+	// Guards _tracked and _pending, which the watcher thread reads and writes
+	static std::mutex                                  _mutex;
+	static std::unordered_map<Shader*, TrackedShader> _tracked;
+	static std::vector<PendingReload>                  _pending;
+
+	// Only touched on the main thread
+	static std::vector<ActiveReload> _active;
+	static FileWatcher::Sptr         _watcher;
+	static bool                      _parallelCompile;
+
+	/// <summary>
+	/// Starts tracking a shader that has been linked, called by Shader::Link
+	/// </summary>
+	static void _Track(Shader* shader);
+	/// <summary>
+	/// Stops tracking a shader, called by the shader's destructor
+	/// </summary>
+	static void _Untrack(Shader* shader);
+	/// <summary>
+	/// Reads the new sources for every shader that uses the file, called on the watcher's thread
+	/// </summary>
+	static void _OnFileChanged(const std::string& path);
+	/// <summary>
+	/// Returns true if the current context supports the given extension
+	/// </summary>
+	static bool _HasExtension(const char* name);
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// A shader storage buffer (SSBO) lets us pass large, variable length arrays of data to our shaders,
+/// ex: per-draw data for multi-draw indirect
+/// </summary>
+class ShaderStorageBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<ShaderStorageBuffer> Sptr;
+
+	static inline Sptr Create(BufferUsage usage = BufferUsage::StreamDraw) {
+		return std::make_shared<ShaderStorageBuffer>(usage);
+	}
+
+	/// <summary>
+	/// Creates a new shader storage buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_STREAM_DRAW since we usually refill these every frame</param>
+	ShaderStorageBuffer(BufferUsage usage = BufferUsage::StreamDraw) : IBuffer(BufferType::ShaderStorage, usage) { }
+
+	/// <summary>
+	/// Binds this buffer to the given binding point, matching layout(binding = X) in the shader
+	/// </summary>
+	/// <param name="slot">The binding point to bind to</param>
+	void Bind(int slot) const { glBindBufferBase((GLenum)_type, slot, _handle); }
+
+	/// <summary>
+	/// Unbinds the shader storage buffer at the given binding point
+	/// </summary>
+	static void UnBind(int slot) { IBuffer::UnBind(BufferType::ShaderStorage, slot); }
+};
@@ -1,36 +1,143 @@
 #include "Texture2D.h"
+#include <mutex>
 #include <stb_image.h>
 #include <Logging.h>
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/TextureStreamer.h"
+#include "Utils/AssetArchive.h"
 
 nlohmann::json Texture2D::ToJson() const {
 	return {
 		{ "filename", _description.Filename },
 		{ "wrap_s",  ~_description.HorizontalWrap },
 		{ "wrap_t",  ~_description.VerticalWrap },
+		{ "min_filter", ~_description.MinificationFilter },
+		{ "mag_filter", ~_description.MagnificationFilter },
+		{ "anisotropy", _description.MaxAnisotropy },
+		{ "mipmaps", _description.GenerateMipMaps },
+		{ "streamed", _description.Streamed },
 	};
 }
 
-Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
-{
+// Reads the parts of a description that we store in the manifest
+static Texture2DDescription ParseDescription(const nlohmann::json& data) {
 	Texture2DDescription descr = Texture2DDescription();
 	descr.Filename = data["filename"];
 	descr.HorizontalWrap = JsonParseEnum(WrapMode, data, "wrap_s", WrapMode::ClampToEdge);
 	descr.VerticalWrap   = JsonParseEnum(WrapMode, data, "wrap_t", WrapMode::ClampToEdge);
-	return std::make_shared<Texture2D>(descr);
+	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "min_filter", MinFilter::LinearMipLinear);
+	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "mag_filter", MagFilter::Linear);
+	descr.MaxAnisotropy   = JsonGet(data, "anisotropy", descr.MaxAnisotropy);
+	descr.GenerateMipMaps = JsonGet(data, "mipmaps", descr.GenerateMipMaps);
+	descr.Streamed        = JsonGet(data, "streamed", descr.Streamed);
+	return descr;
+}
+
+Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
+{
+	return std::make_shared<Texture2D>(ParseDescription(data));
+}
+
+std::function<Texture2D::Sptr()> Texture2D::DecodeJson(const nlohmann::json& data) {
+	Texture2DDescription descr = ParseDescription(data);
+
+	// Streamed textures decode on the TextureStreamer's threads instead, the texture starts as a placeholder
+	if (descr.Streamed && TextureStreamer::IsEnabled() && !descr.Filename.empty()) {
+		return [descr]() {
+			return std::make_shared<Texture2D>(descr);
+		};
+	}
+
+	Texture2DData image;
+	if (!descr.Filename.empty()) {
+		DecodeFile(descr.Filename, descr.FormatHint, image);
+	}
+	// If decoding failed we still create the texture, same as FromJson would
+	return [descr, image]() {
+		return std::make_shared<Texture2D>(descr, image);
+	};
 }
 
-Texture2D::Texture2D(const Texture2DDescription& description) : ITexture(TextureType::_2D) {
+Texture2D::Texture2D(const Texture2DDescription& description) : 
+	ITexture(TextureType::_2D),
+	_mipLevels(1),
+	_sampler(0),
+	_streaming(false)
+{
 	_description = description;
-	_SetTextureParams();
-	_LoadDataFromFile();
+	if (_description.Streamed && TextureStreamer::IsEnabled() && !_description.Filename.empty()) {
+		_BeginStreaming();
+	} else {
+		_SetTextureParams();
+		_LoadDataFromFile();
+	}
+	_UpdateSampler();
+}
+
+Texture2D::Texture2D(const Texture2DDescription& description, const Texture2DData& data) :
+	ITexture(TextureType::_2D),
+	_mipLevels(1),
+	_sampler(0),
+	_streaming(false)
+{
+	_description = description;
+	_description.Width = 0;
+	_description.Height = 0;
+	if (data.Pixels != nullptr) {
+		_LoadDecodedData(data);
+	}
+	_UpdateSampler();
 }
 
-Texture2D::Texture2D(const std::string& filePath) : ITexture(TextureType::_2D) {
+Texture2D::Texture2D(const std::string& filePath) : 
+	ITexture(TextureType::_2D),
+	_mipLevels(1),
+	_sampler(0),
+	_streaming(false)
+{
 	_description.Filename = filePath;
-	_SetTextureParams();
-	_LoadDataFromFile();
+	_description.Streamed = TextureStreamer::IsEnabled();
+	if (_description.Streamed) {
+		_BeginStreaming();
+	} else {
+		_SetTextureParams();
+		_LoadDataFromFile();
+	}
+	_UpdateSampler();
+}
+
+Texture2D::~Texture2D() {
+	if (_streaming) {
+		TextureStreamer::_Cancel(this);
+	}
+}
+
+void Texture2D::SetMinFilter(MinFilter filter) {
+	_description.MinificationFilter = filter;
+	_UpdateSampler();
+}
+
+void Texture2D::SetMagFilter(MagFilter filter) {
+	_description.MagnificationFilter = filter;
+	_UpdateSampler();
+}
+
+void Texture2D::SetAnisotropicFiltering(float value) {
+	_description.MaxAnisotropy = value;
+	_UpdateSampler();
+}
+
+void Texture2D::GenerateMipMaps() {
+	if (_mipLevels > 1) {
+		glGenerateTextureMipmap(_handle);
+	}
+}
+
+void Texture2D::Bind(int slot) {
+	ITexture::Bind(slot);
+	GlStateCache::BindSampler(slot, _sampler);
 }
 
 void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* data, uint32_t offsetX, uint32_t offsetY) {
@@ -48,88 +155,155 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 }
 
 void Texture2D::_LoadDataFromFile() {
-	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
-
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
-		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
+		Texture2DData data;
+		if (DecodeFile(_description.Filename, _description.FormatHint, data)) {
+			_LoadDecodedData(data);
 		}
+	}
+}
 
-		// We should estimate a good format for our data
-
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
-
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format;
-		PixelFormat    image_format;
-		switch (numChannels) {
-			case 1:
-				internal_format = InternalFormat::R8;
-				image_format = PixelFormat::Red;
-				break;
-			case 2:
-				internal_format = InternalFormat::RG8;
-				image_format = PixelFormat::RG;
-				break;
-			case 3:
-				internal_format = InternalFormat::RGB8;
-				image_format = PixelFormat::RGB;
-				break;
-			case 4:
-				internal_format = InternalFormat::RGBA8;
-				image_format = PixelFormat::RGBA;
-				break;
-			default:
-				LOG_ASSERT(false, "Unsupported texture format for texture \"{}\" with {} channels", _description.Filename, numChannels)
-					break;
-		}
+void Texture2D::_LoadDecodedData(const Texture2DData& data) {
+	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+	// Update our description to match what we loaded
+	_description.Format = data.Format;
+	_description.Width = data.Width;
+	_description.Height = data.Height;
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+	// Allocates our memory
+	_SetTextureParams();
 
-		// Allocates our memory
-		_SetTextureParams();
+	// Upload data to our texture
+	LoadData(data.Width, data.Height, data.Layout, PixelType::UByte, data.Pixels.get());
+
+	// Fill in the rest of the mip chain from the image we just loaded
+	GenerateMipMaps();
+}
+
+bool Texture2D::DecodeFile(const std::string& path, PixelFormat formatHint, Texture2DData& outData) {
+	// The flip is global in stb_image, so we set it exactly once instead of racing other threads that are decoding
+	static std::once_flag flipOnce;
+	std::call_once(flipOnce, []() { stbi_set_flip_vertically_on_load(true); });
+
+	// Variables that will store properties about our image
+	int width, height, numChannels;
+	const int targetChannels = GetTexelComponentCount(formatHint);
+
+	// Use STBI to load the image, images in the archive are decoded straight from the mapping
+	uint8_t* data = nullptr;
+	AssetArchive::View view;
+	if (AssetArchive::Read(path, view)) {
+		data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(view.Data), (int)view.Size, &width, &height, &numChannels, targetChannels);
+	} else {
+		data = stbi_load(path.c_str(), &width, &height, &numChannels, targetChannels);
+	}
+
+	// If we could not load any data, warn and bail
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", path);
+		return false;
+	}
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+	// We should estimate a good format for our data
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	if (targetChannels != 0)
+		numChannels = targetChannels;
+
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format;
+	PixelFormat    image_format;
+	switch (numChannels) {
+		case 1:
+			internal_format = InternalFormat::R8;
+			image_format = PixelFormat::Red;
+			break;
+		case 2:
+			internal_format = InternalFormat::RG8;
+			image_format = PixelFormat::RG;
+			break;
+		case 3:
+			internal_format = InternalFormat::RGB8;
+			image_format = PixelFormat::RGB;
+			break;
+		case 4:
+			internal_format = InternalFormat::RGBA8;
+			image_format = PixelFormat::RGBA;
+			break;
+		default:
+			LOG_ASSERT(false, "Unsupported texture format for texture \"{}\" with {} channels", path, numChannels)
+			stbi_image_free(data);
+			return false;
 	}
+
+	// This is one of those poorly documented things in OpenGL
+	if ((numChannels * width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
+
+	outData.Width = width;
+	outData.Height = height;
+	outData.Format = internal_format;
+	outData.Layout = image_format;
+	// The STBI data is freed once the last copy of the image is gone
+	outData.Pixels = std::shared_ptr<uint8_t>(data, [](uint8_t* pixels) { stbi_image_free(pixels); });
+	return true;
 }
 
 void Texture2D::_SetTextureParams() {
 	// Make sure the size is greater than zero and that we have a format specified before trying to set parameters
 	if ((_description.Width * _description.Height > 0) && _description.Format != InternalFormat::Unknown) {
+		_mipLevels = _CalculateMipLevels(_description.Width, _description.Height, _description.GenerateMipMaps);
+
 		// Allocates the memory for our texture
-		glTextureStorage2D(_handle, 1, (GLenum)_description.Format, _description.Width, _description.Height);
+		glTextureStorage2D(_handle, _mipLevels, (GLenum)_description.Format, _description.Width, _description.Height);
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
 	}
 }
 
+void Texture2D::_UpdateSampler() {
+	_sampler = _ApplySampler(_GetSamplerDescription(_description));
+}
+
+void Texture2D::_BeginStreaming() {
+	// A single grey texel, so anything drawn with us looks neutral until the real image arrives
+	static const uint8_t PLACEHOLDER_TEXEL[4] = { 128, 128, 128, 255 };
+
+	_description.Width = 1;
+	_description.Height = 1;
+	_description.Format = InternalFormat::RGBA8;
+	_mipLevels = 1;
+	glTextureStorage2D(_handle, 1, (GLenum)_description.Format, 1, 1);
+	glTextureSubImage2D(_handle, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_TEXEL);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
+
+	_streaming = true;
+	TextureStreamer::_Request(this, _description);
+}
+
+void Texture2D::_FinishStreaming(GLuint handle, const Texture2DData& data, uint32_t mipLevels) {
+	// The placeholder may still be bound, so let the state cache know it's gone
+	GlStateCache::NotifyTextureDeleted(_handle);
+	glDeleteTextures(1, &_handle);
+	_handle = handle;
+
+	_description.Width = data.Width;
+	_description.Height = data.Height;
+	_description.Format = data.Format;
+	_mipLevels = mipLevels;
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
+	_UpdateSampler();
+
+	_streaming = false;
+}
+
 Texture2D::Sptr Texture2D::LoadFromFile(const std::string& path, const Texture2DDescription& description, bool forceRgba) {
 	// Create a copy of the description and change filename to the path
 	Texture2DDescription desc = description;
@@ -1,4 +1,6 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include "ITexture.h"
 
 /// <summary>
@@ -26,6 +28,22 @@ struct Texture2DDescription {
 	/// </summary>
 	WrapMode       VerticalWrap;
 	/// <summary>
+	/// The filter to use when the texture is minified, the mip filters require GenerateMipMaps
+	/// </summary>
+	MinFilter      MinificationFilter;
+	/// <summary>
+	/// The filter to use when the texture is magnified
+	/// </summary>
+	MagFilter      MagnificationFilter;
+	/// <summary>
+	/// The maximum number of anisotropic samples to take, 1 disables anisotropic filtering
+	/// </summary>
+	float          MaxAnisotropy;
+	/// <summary>
+	/// True if a full mip chain should be allocated and generated when the image is loaded
+	/// </summary>
+	bool           GenerateMipMaps;
+	/// <summary>
 	/// The path to the source file for the image, or an empty string if the file has been
 	/// generated
 	/// </summary>
@@ -38,13 +56,52 @@ struct Texture2DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the file should be loaded in the background by the TextureStreamer, the texture will
+	/// be a 1x1 placeholder until it's ready. Ignored if the streamer is not enabled
+	/// </summary>
+	bool           Streamed;
+
 	Texture2DDescription() :
 		Width(0), Height(0),
 		Format(InternalFormat::Unknown),
 		HorizontalWrap(WrapMode::Repeat),
 		VerticalWrap(WrapMode::Repeat),
+		MinificationFilter(MinFilter::LinearMipLinear),
+		MagnificationFilter(MagFilter::Linear),
+		MaxAnisotropy(8.0f),
+		GenerateMipMaps(true),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		Streamed(false)
+	{ }
+};
+
+/// <summary>
+/// The pixels of an image file, decoded on the CPU so that they can be uploaded to a texture
+/// later. Decoding doesn't touch OpenGL, so it can happen on any thread
+/// </summary>
+struct Texture2DData {
+	uint32_t       Width;
+	uint32_t       Height;
+	/// <summary>
+	/// The internal format that best matches the number of channels in the image
+	/// </summary>
+	InternalFormat Format;
+	/// <summary>
+	/// The layout of the pixels
+	/// </summary>
+	PixelFormat    Layout;
+	/// <summary>
+	/// The decoded pixels as unsigned bytes, with the bottom row first
+	/// </summary>
+	std::shared_ptr<uint8_t> Pixels;
+
+	Texture2DData() :
+		Width(0), Height(0),
+		Format(InternalFormat::Unknown),
+		Layout(PixelFormat::RGBA),
+		Pixels(nullptr)
 	{ }
 };
 
@@ -59,11 +116,19 @@ public:
 	Texture2D& operator=(Texture2D&& other) = delete;
 
 	// Make sure we mark our destructor as virtual so base class is called
-	virtual ~Texture2D() = default;
+	virtual ~Texture2D();
 
 public:
+	/// <summary>
+	/// Loads a texture from a file, the file is streamed in the background if the TextureStreamer is enabled
+	/// </summary>
 	Texture2D(const std::string& filePath);
 	Texture2D(const Texture2DDescription& description);
+	/// <summary>
+	/// Creates a texture from an image that has already been decoded with DecodeFile, the size and format
+	/// in the description are replaced with the image's
+	/// </summary>
+	Texture2D(const Texture2DDescription& description, const Texture2DData& data);
 
 	/// <summary>
 	/// Gets the width of this texture in pixels
@@ -85,6 +150,41 @@ public:
 	/// Gets the sampler wrap mode along the y/t/v axis for this texture
 	/// </summary>
 	WrapMode GetWrapT() const { return _description.VerticalWrap; }
+	/// <summary>
+	/// Gets the number of mip levels that are allocated for this texture
+	/// </summary>
+	uint32_t GetMipLevelCount() const { return _mipLevels; }
+	/// <summary>
+	/// Returns true if this texture is still a placeholder, waiting for the TextureStreamer to load it's image
+	/// </summary>
+	bool IsStreaming() const { return _streaming; }
+
+	/// <summary>
+	/// Sets the filter to use when this texture is minified
+	/// </summary>
+	void SetMinFilter(MinFilter filter);
+	MinFilter GetMinFilter() const { return _description.MinificationFilter; }
+	/// <summary>
+	/// Sets the filter to use when this texture is magnified
+	/// </summary>
+	void SetMagFilter(MagFilter filter);
+	MagFilter GetMagFilter() const { return _description.MagnificationFilter; }
+	/// <summary>
+	/// Sets the maximum number of anisotropic samples, 1 disables anisotropic filtering
+	/// </summary>
+	void SetAnisotropicFiltering(float value);
+	float GetAnisotropicFiltering() const { return _description.MaxAnisotropy; }
+
+	/// <summary>
+	/// Regenerates all the mip levels from the first level, call after modifying the texture with LoadData
+	/// </summary>
+	void GenerateMipMaps();
+
+	/// <summary>
+	/// Binds this texture and it's shared sampler object to the given slot
+	/// </summary>
+	/// <param name="slot">The slot to bind, 0 &lt;= slot &lt; MAX_TEXTURE_UNITS</param>
+	virtual void Bind(int slot) override;
 
 	/// <summary>
 	/// Loads a region of data into this texture
@@ -108,9 +208,31 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture2D::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Decodes the image for a texture on the calling thread, the returned function creates the texture on
+	/// the main thread. Streamed textures skip the decode and are handed to the TextureStreamer. See IResource
+	/// </summary>
+	static std::function<Texture2D::Sptr()> DecodeJson(const nlohmann::json& data);
+
+	/// <summary>
+	/// Decodes an image file into memory, without touching OpenGL. Safe to call from any thread
+	/// </summary>
+	/// <param name="path">The path of the image to decode</param>
+	/// <param name="formatHint">Determines the number of channels to decode, ex: RGBA will always decode 4 channels</param>
+	/// <param name="outData">Receives the decoded image</param>
+	/// <returns>True if the image was decoded, false if the file could not be read or has an unsupported format</returns>
+	static bool DecodeFile(const std::string& path, PixelFormat formatHint, Texture2DData& outData);
 
 protected:
+	friend class TextureStreamer;
+
 	Texture2DDescription _description;
+	// The number of mip levels allocated in our storage
+	uint32_t _mipLevels;
+	// Our sampler object, shared with all other textures with the same filtering settings
+	GLuint   _sampler;
+	// True while we're a placeholder for an image that the TextureStreamer is loading
+	bool     _streaming;
 
 	/// <summary>
 	/// Loads this texture from the file specified in the description
@@ -118,9 +240,26 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Allocates our storage to fit an image that has been decoded, and uploads it
+	/// Will overwrite description size and format
+	/// </summary>
+	void _LoadDecodedData(const Texture2DData& data);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
+	/// <summary>
+	/// Updates our texture filtering parameters, and gets our sampler object from the cache
+	/// </summary>
+	void _UpdateSampler();
+	/// <summary>
+	/// Fills our storage with a single texel, and hands our file to the TextureStreamer
+	/// </summary>
+	void _BeginStreaming();
+	/// <summary>
+	/// Replaces our placeholder with a texture that the TextureStreamer has finished uploading, we take ownership of the handle
+	/// </summary>
+	void _FinishStreaming(GLuint handle, const Texture2DData& data, uint32_t mipLevels);
 
 public:
 	static Texture2D::Sptr LoadFromFile(const std::string& path, const Texture2DDescription& description = Texture2DDescription(), bool forceRgba = true);
@@ -0,0 +1,149 @@
+#include "Graphics/Texture2DArray.h"
+#include <algorithm>
+#include <Logging.h>
+#include "Graphics/GlStateCache.h"
+#include "Graphics/Texture2D.h"
+#include "Utils/JsonGlmHelpers.h"
+
+// Box filters an RGBA8 image to a new size, each destination texel averages the source texels that it covers
+// (or takes the nearest one when scaling up)
+static void ResampleRgba(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight) {
+	for (uint32_t y = 0; y < dstHeight; y++) {
+		uint32_t y0 = (uint32_t)((uint64_t)y * srcHeight / dstHeight);
+		uint32_t y1 = glm::max(y0 + 1, (uint32_t)((uint64_t)(y + 1) * srcHeight / dstHeight));
+		for (uint32_t x = 0; x < dstWidth; x++) {
+			uint32_t x0 = (uint32_t)((uint64_t)x * srcWidth / dstWidth);
+			uint32_t x1 = glm::max(x0 + 1, (uint32_t)((uint64_t)(x + 1) * srcWidth / dstWidth));
+
+			uint64_t sum[4] = { 0, 0, 0, 0 };
+			for (uint32_t sy = y0; sy < y1; sy++) {
+				const uint8_t* row = src + ((size_t)sy * srcWidth + x0) * 4;
+				for (uint32_t sx = x0; sx < x1; sx++, row += 4) {
+					sum[0] += row[0];
+					sum[1] += row[1];
+					sum[2] += row[2];
+					sum[3] += row[3];
+				}
+			}
+			uint64_t count = (uint64_t)(x1 - x0) * (y1 - y0);
+			uint8_t* out = dst + ((size_t)y * dstWidth + x) * 4;
+			for (int c = 0; c < 4; c++) {
+				out[c] = (uint8_t)((sum[c] + count / 2) / count);
+			}
+		}
+	}
+}
+
+nlohmann::json Texture2DArray::ToJson() const {
+	return {
+		{ "layer_width", _description.LayerWidth },
+		{ "layer_height", _description.LayerHeight },
+		{ "wrap_s",  ~_description.HorizontalWrap },
+		{ "wrap_t",  ~_description.VerticalWrap },
+		{ "min_filter", ~_description.MinificationFilter },
+		{ "mag_filter", ~_description.MagnificationFilter },
+		{ "anisotropy", _description.MaxAnisotropy },
+		{ "mipmaps", _description.GenerateMipMaps },
+		{ "filenames", _description.Filenames },
+	};
+}
+
+Texture2DArray::Sptr Texture2DArray::FromJson(const nlohmann::json& data) {
+	Texture2DArrayDescription descr = Texture2DArrayDescription();
+	descr.LayerWidth  = JsonGet(data, "layer_width", descr.LayerWidth);
+	descr.LayerHeight = JsonGet(data, "layer_height", descr.LayerHeight);
+	descr.HorizontalWrap = JsonParseEnum(WrapMode, data, "wrap_s", WrapMode::Repeat);
+	descr.VerticalWrap   = JsonParseEnum(WrapMode, data, "wrap_t", WrapMode::Repeat);
+	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "min_filter", MinFilter::LinearMipLinear);
+	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "mag_filter", MagFilter::Linear);
+	descr.MaxAnisotropy   = JsonGet(data, "anisotropy", descr.MaxAnisotropy);
+	descr.GenerateMipMaps = JsonGet(data, "mipmaps", descr.GenerateMipMaps);
+	if (data.contains("filenames")) {
+		descr.Filenames = data["filenames"].get<std::vector<std::string>>();
+	}
+	return std::make_shared<Texture2DArray>(descr);
+}
+
+Texture2DArray::Texture2DArray(const std::vector<std::string>& filenames, uint32_t layerSize) :
+	ITexture(TextureType::_2DArray),
+	_mipLevels(1),
+	_sampler(0)
+{
+	_description.LayerWidth = layerSize;
+	_description.LayerHeight = layerSize;
+	_description.Filenames = filenames;
+	_LoadLayers();
+	_UpdateSampler();
+}
+
+Texture2DArray::Texture2DArray(const Texture2DArrayDescription& description) :
+	ITexture(TextureType::_2DArray),
+	_mipLevels(1),
+	_sampler(0)
+{
+	_description = description;
+	_LoadLayers();
+	_UpdateSampler();
+}
+
+int Texture2DArray::GetLayer(const std::string& filename) const {
+	for (size_t ix = 0; ix < _description.Filenames.size(); ix++) {
+		if (_description.Filenames[ix] == filename) {
+			return (int)ix;
+		}
+	}
+	return -1;
+}
+
+void Texture2DArray::Bind(int slot) {
+	ITexture::Bind(slot);
+	GlStateCache::BindSampler(slot, _sampler);
+}
+
+void Texture2DArray::_LoadLayers() {
+	const uint32_t width = _description.LayerWidth;
+	const uint32_t height = _description.LayerHeight;
+	const uint32_t layers = (uint32_t)_description.Filenames.size();
+	if (width * height * layers == 0) {
+		LOG_WARN("Texture array has no layers, or a layer size of 0");
+		return;
+	}
+	GLint maxLayers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	LOG_ASSERT(layers <= (uint32_t)maxLayers, "Texture array has more layers than the renderer supports!");
+
+	_mipLevels = _CalculateMipLevels(width, height, _description.GenerateMipMaps);
+	glTextureStorage3D(_handle, _mipLevels, GL_RGBA8, width, height, layers);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
+
+	// Rows of RGBA8 are always 4 byte aligned, which is the default unpack alignment
+	std::vector<uint8_t> layer((size_t)width * height * 4);
+	uint64_t separateBytes = 0;
+	for (uint32_t ix = 0; ix < layers; ix++) {
+		const std::string& filename = _description.Filenames[ix];
+		Texture2DData image;
+		if (Texture2D::DecodeFile(filename, PixelFormat::RGBA, image)) {
+			ResampleRgba(image.Pixels.get(), image.Width, image.Height, layer.data(), width, height);
+			// What the image would have cost as it's own texture with a full mip chain
+			separateBytes += (uint64_t)image.Width * image.Height * 4 * 4 / 3;
+		} else {
+			// Same neutral grey as the streamer's placeholder, so a missing image doesn't go unnoticed
+			LOG_WARN("Could not load \"{}\" into layer {} of a texture array", filename, ix);
+			std::fill(layer.begin(), layer.end(), (uint8_t)128);
+		}
+		glTextureSubImage3D(_handle, 0, 0, 0, ix, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data());
+	}
+
+	// Mips are generated per layer, so neighbouring layers never blend together
+	if (_mipLevels > 1) {
+		glGenerateTextureMipmap(_handle);
+	}
+
+	LOG_INFO("Packed {} images into a {}x{} texture array ({:.1f} KB, {:.1f} KB as separate textures)",
+		layers, width, height, (uint64_t)width * height * 4 * layers * 4 / 3 / 1024.0f, separateBytes / 1024.0f);
+}
+
+void Texture2DArray::_UpdateSampler() {
+	_sampler = _ApplySampler(_GetSamplerDescription(_description));
+}
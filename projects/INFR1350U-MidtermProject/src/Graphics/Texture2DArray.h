@@ -0,0 +1,128 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Graphics/ITexture.h"
+
+/// <summary>
+/// Describes how the images in a texture array are packed and sampled
+/// </summary>
+struct Texture2DArrayDescription {
+	/// <summary>
+	/// The size of every layer in texels, images that are a different size are resampled to fit
+	/// </summary>
+	uint32_t       LayerWidth;
+	uint32_t       LayerHeight;
+	/// <summary>
+	/// The wrap mode to use when a UV coordinate is outside the 0-1 range on the x axis
+	/// </summary>
+	WrapMode       HorizontalWrap;
+	/// <summary>
+	/// The wrap mode to use when a UV coordinate is outside the 0-1 range on the y axis
+	/// </summary>
+	WrapMode       VerticalWrap;
+	/// <summary>
+	/// The filter to use when the texture is minified, the mip filters require GenerateMipMaps
+	/// </summary>
+	MinFilter      MinificationFilter;
+	/// <summary>
+	/// The filter to use when the texture is magnified
+	/// </summary>
+	MagFilter      MagnificationFilter;
+	/// <summary>
+	/// The maximum number of anisotropic samples to take, 1 disables anisotropic filtering
+	/// </summary>
+	float          MaxAnisotropy;
+	/// <summary>
+	/// True if a full mip chain should be allocated and generated for every layer
+	/// </summary>
+	bool           GenerateMipMaps;
+	/// <summary>
+	/// The source image for each layer, in layer order
+	/// </summary>
+	std::vector<std::string> Filenames;
+
+	Texture2DArrayDescription() :
+		LayerWidth(64), LayerHeight(64),
+		HorizontalWrap(WrapMode::Repeat),
+		VerticalWrap(WrapMode::Repeat),
+		MinificationFilter(MinFilter::LinearMipLinear),
+		MagnificationFilter(MagFilter::Linear),
+		MaxAnisotropy(8.0f),
+		GenerateMipMaps(true),
+		Filenames(std::vector<std::string>())
+	{ }
+};
+
+/// <summary>
+/// Packs a set of small images (ex: the solid color textures for the paddles and table) into the layers
+/// of a single GL_TEXTURE_2D_ARRAY. Materials that point at a layer of the same array can be drawn in the
+/// same multi-draw, since the layer is passed per draw instead of binding a different texture
+///
+/// Every layer has the same size and is stored as RGBA8, images are box filtered down (or up) to the layer
+/// size when they are imported. Layers can't bleed into each other, so unlike an atlas no padding is needed
+/// </summary>
+class Texture2DArray : public ITexture {
+public:
+	typedef std::shared_ptr<Texture2DArray> Sptr;
+
+	// Remove the copy and and assignment operators
+	Texture2DArray(const Texture2DArray& other) = delete;
+	Texture2DArray(Texture2DArray&& other) = delete;
+	Texture2DArray& operator=(const Texture2DArray& other) = delete;
+	Texture2DArray& operator=(Texture2DArray&& other) = delete;
+
+	virtual ~Texture2DArray() = default;
+
+	/// <summary>
+	/// Imports the given images, one per layer
+	/// </summary>
+	/// <param name="filenames">The images to pack, in layer order</param>
+	/// <param name="layerSize">The width and height of each layer, in texels</param>
+	Texture2DArray(const std::vector<std::string>& filenames, uint32_t layerSize = 64);
+	Texture2DArray(const Texture2DArrayDescription& description);
+
+	uint32_t GetLayerWidth() const { return _description.LayerWidth; }
+	uint32_t GetLayerHeight() const { return _description.LayerHeight; }
+	uint32_t GetLayerCount() const { return (uint32_t)_description.Filenames.size(); }
+	/// <summary>
+	/// Gets the number of mip levels that are allocated for each layer
+	/// </summary>
+	uint32_t GetMipLevelCount() const { return _mipLevels; }
+	/// <summary>
+	/// Gets the layer that an image was packed into
+	/// </summary>
+	/// <param name="filename">The path of the image, as it was given when the array was created</param>
+	/// <returns>The index of the layer, or -1 if the image is not in this array</returns>
+	int GetLayer(const std::string& filename) const;
+
+	/// <summary>
+	/// Binds this texture and it's shared sampler object to the given slot
+	/// </summary>
+	/// <param name="slot">The slot to bind, 0 &lt;= slot &lt; MAX_TEXTURE_UNITS</param>
+	virtual void Bind(int slot) override;
+
+	/// <summary>
+	/// Gets this texture's description, which contains the layer size and source images
+	/// </summary>
+	const Texture2DArrayDescription& GetDescription() const { return _description; }
+
+	virtual nlohmann::json ToJson() const override;
+	static Texture2DArray::Sptr FromJson(const nlohmann::json& data);
+
+protected:
+	Texture2DArrayDescription _description;
+	// The number of mip levels allocated for each layer
+	uint32_t _mipLevels;
+	// Our sampler object, shared with all other textures with the same filtering settings
+	GLuint   _sampler;
+
+	/// <summary>
+	/// Allocates storage for every layer, decodes each image into it's layer, and generates the mips
+	/// </summary>
+	void _LoadLayers();
+	/// <summary>
+	/// Updates our texture filtering parameters, and gets our sampler object from the cache
+	/// </summary>
+	void _UpdateSampler();
+};
@@ -13,6 +13,7 @@ ENUM(TextureType, GLenum,
 	_1D = GL_TEXTURE_1D,
 	_2D = GL_TEXTURE_2D,
 	_3D = GL_TEXTURE_3D,
+	_2DArray = GL_TEXTURE_2D_ARRAY,
 	Cubemap = GL_TEXTURE_CUBE_MAP,
 	_2DMultisample = GL_TEXTURE_2D_MULTISAMPLE
 );
@@ -0,0 +1,329 @@
+#include "Graphics/TextureStreamer.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <Logging.h>
+
+#include "Graphics/GpuFence.h"
+
+bool                                     TextureStreamer::_enabled = false;
+TextureStreamer::Settings                TextureStreamer::_settings;
+TextureStreamer::Stats                   TextureStreamer::_stats;
+ThreadPool::Sptr                         TextureStreamer::_pool = nullptr;
+std::mutex                               TextureStreamer::_mutex;
+std::unordered_map<Texture2D*, uint64_t> TextureStreamer::_tickets;
+uint64_t                                 TextureStreamer::_nextTicket = 1;
+std::vector<TextureStreamer::Upload>     TextureStreamer::_decoded;
+std::vector<TextureStreamer::StagingBuffer> TextureStreamer::_staging;
+uint32_t                                 TextureStreamer::_nextStaging = 0;
+std::deque<TextureStreamer::Upload>      TextureStreamer::_uploads;
+std::vector<TextureStreamer::Upload>     TextureStreamer::_finishing;
+std::chrono::high_resolution_clock::time_point TextureStreamer::_batchStart;
+uint32_t                                 TextureStreamer::_batchFrames = 0;
+bool                                     TextureStreamer::_batchActive = false;
+
+TextureStreamer::Settings::Settings() :
+	StagingBufferSize(4 * 1024 * 1024),
+	StagingBufferCount(3),
+	FrameBudget(4 * 1024 * 1024),
+	WorkerThreads(ThreadPool::GetDefaultThreadCount())
+{ }
+
+TextureStreamer::Stats::Stats() :
+	Requested(0),
+	Streamed(0),
+	Failed(0),
+	BytesUploaded(0),
+	BudgetFrames(0),
+	StagingStalls(0)
+{ }
+
+void TextureStreamer::Init(const Settings& settings) {
+	LOG_ASSERT(!_enabled, "Texture streamer has already been initialized!");
+	_settings = settings;
+	_settings.StagingBufferCount = std::max(_settings.StagingBufferCount, 1u);
+	_stats = Stats();
+
+	// The copies we issue after writing to a staging buffer will see our writes, see IBuffer::AllocatePersistent
+	_staging.resize(_settings.StagingBufferCount);
+	for (StagingBuffer& staging : _staging) {
+		staging.Buffer = PixelUnpackBuffer::Create();
+		staging.Mapped = staging.Buffer->AllocatePersistent(1, _settings.StagingBufferSize);
+		staging.Fence = nullptr;
+		LOG_ASSERT(staging.Mapped != nullptr, "Failed to map texture staging buffer!");
+	}
+
+	_pool = ThreadPool::Create(_settings.WorkerThreads);
+	_enabled = true;
+	LOG_INFO("Texture streaming enabled, {} x {:.1f} MB staging buffers, {:.1f} MB per frame, {} decode threads",
+		_staging.size(), _settings.StagingBufferSize / (1024.0f * 1024.0f), _settings.FrameBudget / (1024.0f * 1024.0f), _pool->GetThreadCount());
+}
+
+void TextureStreamer::Cleanup() {
+	if (!_enabled) {
+		return;
+	}
+	_enabled = false;
+
+	// Any textures that are still waiting keep their placeholders. We forget them before stopping the
+	// workers, so that anything they're still decoding gets thrown away
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto& [target, ticket] : _tickets) {
+			target->_streaming = false;
+		}
+		_tickets.clear();
+	}
+	_pool = nullptr;
+
+	for (Upload& upload : _decoded) {
+		_Discard(upload);
+	}
+	for (Upload& upload : _uploads) {
+		_Discard(upload);
+	}
+	for (Upload& upload : _finishing) {
+		_Discard(upload);
+	}
+	_decoded.clear();
+	_uploads.clear();
+	_finishing.clear();
+
+	for (StagingBuffer& staging : _staging) {
+		if (staging.Fence != nullptr) {
+			glDeleteSync(staging.Fence);
+		}
+		glUnmapNamedBuffer(staging.Buffer->GetHandle());
+	}
+	_staging.clear();
+	_nextStaging = 0;
+	_batchActive = false;
+}
+
+void TextureStreamer::_Request(Texture2D* target, const Texture2DDescription& description) {
+	Upload upload;
+	upload.Target = target;
+	upload.Handle = 0;
+	upload.MipLevels = description.GenerateMipMaps ? 0 : 1;
+	upload.NextRow = 0;
+	upload.Fence = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		upload.Ticket = _nextTicket++;
+		_tickets[target] = upload.Ticket;
+		_stats.Requested++;
+		if (!_batchActive) {
+			_batchActive = true;
+			_batchStart = std::chrono::high_resolution_clock::now();
+			_batchFrames = 0;
+		}
+	}
+
+	std::string path = description.Filename;
+	PixelFormat formatHint = description.FormatHint;
+	_pool->Enqueue([upload, path, formatHint]() mutable {
+		// No point decoding an image for a texture that's already gone
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_IsCurrent(upload)) {
+				return;
+			}
+		}
+		Texture2D::DecodeFile(path, formatHint, upload.Data);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_IsCurrent(upload)) {
+			_decoded.push_back(std::move(upload));
+		}
+	});
+}
+
+void TextureStreamer::_Cancel(Texture2D* target) {
+	// Whatever we have in flight for the texture is thrown away on the next update
+	std::lock_guard<std::mutex> lock(_mutex);
+	_tickets.erase(target);
+}
+
+bool TextureStreamer::_IsCurrent(const Upload& upload) {
+	auto it = _tickets.find(upload.Target);
+	return it != _tickets.end() && it->second == upload.Ticket;
+}
+
+void TextureStreamer::_Discard(Upload& upload) {
+	if (upload.Fence != nullptr) {
+		glDeleteSync(upload.Fence);
+		upload.Fence = nullptr;
+	}
+	if (upload.Handle != 0) {
+		glDeleteTextures(1, &upload.Handle);
+		upload.Handle = 0;
+	}
+}
+
+TextureStreamer::StagingBuffer* TextureStreamer::_AcquireStaging(bool wait) {
+	// The buffers are used in turn, so the next one is always the one that has been in use the longest
+	StagingBuffer& staging = _staging[_nextStaging];
+	if (!GpuFence::IsSignalled(staging.Fence, false)) {
+		_stats.StagingStalls++;
+		if (!wait) {
+			return nullptr;
+		}
+		GpuFence::IsSignalled(staging.Fence, true);
+	}
+	if (staging.Fence != nullptr) {
+		glDeleteSync(staging.Fence);
+		staging.Fence = nullptr;
+	}
+	_nextStaging = (_nextStaging + 1) % (uint32_t)_staging.size();
+	return &staging;
+}
+
+void TextureStreamer::Update() {
+	if (_enabled) {
+		_Update(_settings.FrameBudget, false);
+	}
+}
+
+void TextureStreamer::Flush() {
+	while (_enabled && GetPendingCount() > 0) {
+		_Update(std::numeric_limits<uint64_t>::max(), true);
+		// If everything we have is still being decoded, give the workers a moment
+		if (_uploads.empty() && _finishing.empty() && GetPendingCount() > 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+void TextureStreamer::_Update(uint64_t budget, bool wait) {
+	// Take everything the workers have finished decoding
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (Upload& upload : _decoded) {
+			_uploads.push_back(std::move(upload));
+		}
+		_decoded.clear();
+		_batchFrames++;
+	}
+
+	// Swap in any textures that the GPU has finished with. We hold the lock so the texture can't be
+	// destroyed while we're swapping
+	for (auto it = _finishing.begin(); it != _finishing.end();) {
+		if (!GpuFence::IsSignalled(it->Fence, wait)) {
+			++it;
+			continue;
+		}
+		glDeleteSync(it->Fence);
+		it->Fence = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_IsCurrent(*it)) {
+				it->Target->_FinishStreaming(it->Handle, it->Data, it->MipLevels);
+				it->Handle = 0;
+				_tickets.erase(it->Target);
+				_stats.Streamed++;
+			}
+		}
+		_Discard(*it);
+		it = _finishing.erase(it);
+	}
+
+	// Copy as many rows as our budget allows, the copies themselves are done by the GPU from the staging buffers
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	bool copied = false;
+	while (!_uploads.empty() && budget > 0) {
+		Upload& upload = _uploads.front();
+		bool current;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			current = _IsCurrent(upload);
+			// If the image couldn't be decoded, we just keep the placeholder
+			if (current && upload.Data.Pixels == nullptr) {
+				upload.Target->_streaming = false;
+				_tickets.erase(upload.Target);
+				_stats.Failed++;
+				current = false;
+			}
+		}
+		if (!current) {
+			_Discard(upload);
+			_uploads.pop_front();
+			continue;
+		}
+
+		const uint64_t rowSize = (uint64_t)upload.Data.Width * GetTexelComponentCount(upload.Data.Layout);
+		if (upload.Handle == 0) {
+			if (upload.MipLevels == 0) {
+				upload.MipLevels = Texture2D::_CalculateMipLevels(upload.Data.Width, upload.Data.Height, true);
+			}
+			glCreateTextures(GL_TEXTURE_2D, 1, &upload.Handle);
+			glTextureStorage2D(upload.Handle, upload.MipLevels, (GLenum)upload.Data.Format, upload.Data.Width, upload.Data.Height);
+		}
+
+		uint32_t rows = 0;
+		if (rowSize > _settings.StagingBufferSize) {
+			// A single row doesn't fit in a staging buffer, so we fall back to a regular upload from our own memory
+			LOG_WARN("Rows of {}x{} image are larger than the staging buffers, uploading it directly", upload.Data.Width, upload.Data.Height);
+			rows = upload.Data.Height - upload.NextRow;
+			glTextureSubImage2D(upload.Handle, 0, 0, upload.NextRow, upload.Data.Width, rows, (GLenum)upload.Data.Layout, GL_UNSIGNED_BYTE,
+				upload.Data.Pixels.get() + upload.NextRow * rowSize);
+		} else {
+			StagingBuffer* staging = _AcquireStaging(wait);
+			if (staging == nullptr) {
+				break;
+			}
+			// Always make some progress, even if a single row is over the budget
+			uint64_t maxRows = std::max<uint64_t>(std::min<uint64_t>(budget, _settings.StagingBufferSize) / rowSize, 1);
+			rows = (uint32_t)std::min<uint64_t>(upload.Data.Height - upload.NextRow, maxRows);
+			memcpy(staging->Mapped, upload.Data.Pixels.get() + upload.NextRow * rowSize, rows * rowSize);
+
+			// While the PBO is bound, the data pointer is an offset into it
+			staging->Buffer->Bind();
+			glTextureSubImage2D(upload.Handle, 0, 0, upload.NextRow, upload.Data.Width, rows, (GLenum)upload.Data.Layout, GL_UNSIGNED_BYTE, nullptr);
+			PixelUnpackBuffer::UnBind();
+			staging->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		uint64_t bytes = rows * rowSize;
+		budget -= std::min(budget, bytes);
+		_stats.BytesUploaded += bytes;
+		upload.NextRow += rows;
+		copied = true;
+
+		// All the rows are in, fill the mip chain and wait for the GPU to finish before swapping it in
+		if (upload.NextRow >= upload.Data.Height) {
+			if (upload.MipLevels > 1) {
+				glGenerateTextureMipmap(upload.Handle);
+			}
+			upload.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			_finishing.push_back(std::move(upload));
+			_uploads.pop_front();
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	if (copied && budget == 0 && !_uploads.empty()) {
+		_stats.BudgetFrames++;
+	}
+
+	bool finished = false;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		finished = _batchActive && _tickets.empty();
+		_batchActive = _batchActive && !finished;
+	}
+	if (finished) {
+		float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - _batchStart).count();
+		LOG_INFO("Finished streaming textures in {:.2f} ms over {} frames", elapsed, _batchFrames);
+		LogStats();
+	}
+}
+
+size_t TextureStreamer::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _tickets.size();
+}
+
+void TextureStreamer::LogStats() {
+	LOG_INFO("Textures streamed: {} of {} requested ({} failed), {:.2f} MB uploaded, {} frames over budget, {} staging stalls",
+		_stats.Streamed, _stats.Requested, _stats.Failed, _stats.BytesUploaded / (1024.0 * 1024.0), _stats.BudgetFrames, _stats.StagingStalls);
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/PixelUnpackBuffer.h"
+#include "Graphics/Texture2D.h"
+#include "Utils/ThreadPool.h"
+
+/// <summary>
+/// Loads textures in the background, so that creating a texture from a file doesn't block until the image
+/// has been decoded and uploaded
+///
+/// A streamed texture starts out as a 1x1 placeholder, so it can be bound and drawn right away. The image is
+/// decoded on a pool of worker threads, then copied into a pool of persistently mapped pixel unpack buffers
+/// on the main thread, a few rows at a time. The copies into the real texture are done by the GPU, and each
+/// frame only copies up to FrameBudget bytes so that a big batch of textures doesn't cause a hitch. Once the
+/// GPU has finished with the last copy (checked with a fence), the real texture is swapped in
+///
+/// Textures loaded from files are streamed while the streamer is enabled (see Texture2DDescription::Streamed)
+/// </summary>
+class TextureStreamer {
+public:
+	/// <summary>
+	/// Controls how many resources the streamer uses
+	/// </summary>
+	struct Settings {
+		// The size of each staging buffer, in bytes. A single copy can't be larger than this
+		uint32_t StagingBufferSize;
+		// The number of staging buffers, a buffer can't be reused until the GPU is done copying from it
+		uint32_t StagingBufferCount;
+		// The most bytes that will be copied into textures each frame
+		uint32_t FrameBudget;
+		// The number of threads that decode images
+		uint32_t WorkerThreads;
+
+		Settings();
+	};
+
+	/// <summary>
+	/// Counts for all the textures streamed since Init
+	/// </summary>
+	struct Stats {
+		// Textures that were requested, and that have been swapped in
+		uint32_t Requested;
+		uint32_t Streamed;
+		// Textures that could not be decoded, these keep their placeholder
+		uint32_t Failed;
+		// The total number of bytes copied through the staging buffers
+		uint64_t BytesUploaded;
+		// Frames where there was more to copy than the budget allowed
+		uint32_t BudgetFrames;
+		// Times that we had to wait for the GPU to finish with a staging buffer
+		uint32_t StagingStalls;
+
+		Stats();
+	};
+
+	TextureStreamer() = delete;
+
+	/// <summary>
+	/// Creates the staging buffers and decoding threads, and enables streaming. Must be called after GLAD is loaded
+	/// </summary>
+	static void Init(const Settings& settings = Settings());
+	/// <summary>
+	/// Drops any textures that are still streaming (they keep their placeholders), and releases the staging buffers
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Returns true if the streamer has been initialized, and textures should be streamed
+	/// </summary>
+	static bool IsEnabled() { return _enabled; }
+
+	/// <summary>
+	/// Copies the next part of any decoded images into their textures, and swaps in any that are done. Should be
+	/// called once per frame on the thread that owns the OpenGL context
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Blocks until every texture that has been requested has been swapped in, ignoring the frame budget
+	/// (ex: for a loading screen)
+	/// </summary>
+	static void Flush();
+
+	/// <summary>
+	/// Sets the most bytes that will be copied into textures each frame
+	/// </summary>
+	static void SetFrameBudget(uint32_t bytes) { _settings.FrameBudget = bytes; }
+	static uint32_t GetFrameBudget() { return _settings.FrameBudget; }
+
+	/// <summary>
+	/// Gets the number of textures that are still showing their placeholder
+	/// </summary>
+	static size_t GetPendingCount();
+	/// <summary>
+	/// Gets the counts since Init
+	/// </summary>
+	static const Stats& GetStats() { return _stats; }
+	/// <summary>
+	/// Logs a summary of how much has been streamed
+	/// </summary>
+	static void LogStats();
+
+protected:
+	friend class Texture2D;
+
+	// A persistently mapped buffer that we copy pixels through
+	struct StagingBuffer {
+		PixelUnpackBuffer::Sptr Buffer;
+		uint8_t*                Mapped;
+		// Signalled once the GPU has finished the copy that reads from this buffer
+		GLsync                  Fence;
+	};
+	// A decoded image that is being copied into it's texture
+	struct Upload {
+		Texture2D*    Target;
+		uint64_t      Ticket;
+		Texture2DData Data;
+		// The texture that we're copying into, it replaces the placeholder once it's done
+		GLuint        Handle;
+		uint32_t      MipLevels;
+		uint32_t      NextRow;
+		// Signalled once the last copy and the mip generation are done
+		GLsync        Fence;
+	};
+
+	static bool            _enabled;
+	static Settings        _settings;
+	static Stats           _stats;
+	static ThreadPool::Sptr _pool;
+
+	// Guards _tickets, _decoded and the batch timing, since textures can be created and destroyed while the
+	// render thread is updating us, and the workers push to _decoded
+	static std::mutex                               _mutex;
+	// The textures that are waiting on us, the ticket changes if a texture is destroyed and another takes it's address
+	static std::unordered_map<Texture2D*, uint64_t> _tickets;
+	static uint64_t                                 _nextTicket;
+	static std::vector<Upload>                      _decoded;
+
+	// Only touched on the main thread
+	static std::vector<StagingBuffer> _staging;
+	static uint32_t                   _nextStaging;
+	static std::deque<Upload>         _uploads;
+	static std::vector<Upload>        _finishing;
+	// When the current batch of textures started streaming, for the log (guarded by _mutex)
+	static std::chrono::high_resolution_clock::time_point _batchStart;
+	static uint32_t                                       _batchFrames;
+	static bool                                           _batchActive;
+
+	/// <summary>
+	/// Starts decoding the file for a texture, called by Texture2D after it has created it's placeholder
+	/// </summary>
+	static void _Request(Texture2D* target, const Texture2DDescription& description);
+	/// <summary>
+	/// Stops streaming into a texture, called by the texture's destructor
+	/// </summary>
+	static void _Cancel(Texture2D* target);
+
+	/// <summary>
+	/// Does a frame's worth of work, copying at most budget bytes
+	/// </summary>
+	/// <param name="wait">True to block on the GPU instead of waiting until the next frame</param>
+	static void _Update(uint64_t budget, bool wait);
+	/// <summary>
+	/// Gets a staging buffer that the GPU is done with, or nullptr if they are all in use
+	/// </summary>
+	static StagingBuffer* _AcquireStaging(bool wait);
+	/// <summary>
+	/// Returns true if the texture is still waiting for the given upload
+	/// </summary>
+	static bool _IsCurrent(const Upload& upload);
+	/// <summary>
+	/// Deletes the GL objects for an upload that is no longer needed
+	/// </summary>
+	static void _Discard(Upload& upload);
+};
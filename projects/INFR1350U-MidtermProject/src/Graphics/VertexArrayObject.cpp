@@ -2,13 +2,16 @@
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
 #include "Logging.h"
+#include "GlStateCache.h"
+#include "GeometryArena.h"
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
 	_handle(0),
 	_vertexCount(0),
 	_elementCount(0),
-	_vertexBuffers(std::vector<VertexBufferBinding>())
+	_vertexBuffers(std::vector<VertexBufferBinding>()),
+	_arenaAllocation(nullptr)
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -16,6 +19,7 @@ VertexArrayObject::VertexArrayObject() :
 VertexArrayObject::~VertexArrayObject()
 {
 	if (_handle != 0) {
+		GlStateCache::NotifyVertexArrayDeleted(_handle);
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
 	}
@@ -23,27 +27,29 @@ VertexArrayObject::~VertexArrayObject()
 
 void VertexArrayObject::SetIndexBuffer(const IndexBuffer::Sptr& ibo) {
 	// TODO: What if we already have a buffer? should we delete it? who owns the buffer?
+	// We use DSA here so we don't need to disturb the currently bound VAO
 	_indexBuffer = ibo;
-	Bind();
 	if (_indexBuffer != nullptr) {
-		_indexBuffer->Bind();
+		glVertexArrayElementBuffer(_handle, _indexBuffer->GetHandle());
 		_elementCount = _indexBuffer->GetElementCount();
 	}
 	else {
-		IndexBuffer::Unbind();
+		glVertexArrayElementBuffer(_handle, 0);
 		_elementCount = _vertexCount;
 	}
-	Unbind();
 }
 
-void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes) {
-	if (_vertexBuffers.size() == 0) {
-		_vertexCount = buffer->GetElementCount();
-		if (_indexBuffer == nullptr) {
-			_elementCount = _vertexCount;
+void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes, uint32_t instanceDivisor) {
+	// Per-instance buffers don't have anything to do with our vertex count
+	if (instanceDivisor == 0) {
+		if (_vertexBuffers.size() == 0) {
+			_vertexCount = buffer->GetElementCount();
+			if (_indexBuffer == nullptr) {
+				_elementCount = _vertexCount;
+			}
+		} else if (buffer->GetElementCount() != _vertexCount) {
+			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 		}
-	} else if (buffer->GetElementCount() != _vertexCount) {
-		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
 	VertexBufferBinding binding;
@@ -51,33 +57,64 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const
 	binding.Attributes = attributes;
 	_vertexBuffers.push_back(binding);
 
-
-	Bind();
-	buffer->Bind();
+	// Each attribute gets it's own binding point matching it's slot, since the stride is per-attribute,
+	// the attribute offset is baked into the buffer binding so we don't run into the relative offset limit
 	for (const BufferAttribute& attrib : attributes) {
 		glEnableVertexArrayAttrib(_handle, attrib.Slot);
-		glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
-							  (void*)attrib.Offset);
+		glVertexArrayVertexBuffer(_handle, attrib.Slot, buffer->GetHandle(), (GLintptr)attrib.Offset, attrib.Stride);
+		glVertexArrayAttribFormat(_handle, attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, 0);
+		glVertexArrayAttribBinding(_handle, attrib.Slot, attrib.Slot);
+		glVertexArrayBindingDivisor(_handle, attrib.Slot, instanceDivisor);
+	}
+}
+
+uint32_t VertexArrayObject::GetVertexCount() const {
+	return _vertexBuffers.empty() && _arenaAllocation != nullptr ? _arenaAllocation->VertexCount : _vertexCount;
+}
+
+uint32_t VertexArrayObject::GetIndexCount() const {
+	if (_vertexBuffers.empty() && _arenaAllocation != nullptr) {
+		return _arenaAllocation->IndexCount;
 	}
-	Unbind();
+	return _indexBuffer != nullptr ? _indexBuffer->GetElementCount() : 0;
+}
+
+uint32_t VertexArrayObject::GetElementCount() const {
+	return _vertexBuffers.empty() && _arenaAllocation != nullptr ? _arenaAllocation->IndexCount : _elementCount;
 }
 
 void VertexArrayObject::Draw(DrawMode mode) {
+	if (_vertexBuffers.empty() && _arenaAllocation != nullptr) {
+		_arenaAllocation->Draw(mode, 0, _arenaAllocation->IndexCount);
+		return;
+	}
 	Bind();
 	if (_indexBuffer == nullptr) {
 		glDrawArrays((GLenum)mode, 0, _elementCount);
 	} else {
 		glDrawElements((GLenum)mode, _elementCount, (GLenum)_indexBuffer->GetElementType(), nullptr);
 	}
-	Unbind();
+}
+
+void VertexArrayObject::Draw(DrawMode mode, uint32_t first, uint32_t count) {
+	if (_vertexBuffers.empty() && _arenaAllocation != nullptr) {
+		_arenaAllocation->Draw(mode, first, count);
+		return;
+	}
+	Bind();
+	if (_indexBuffer == nullptr) {
+		glDrawArrays((GLenum)mode, first, count);
+	} else {
+		glDrawElements((GLenum)mode, count, (GLenum)_indexBuffer->GetElementType(), (const void*)((size_t)first * _indexBuffer->GetElementSize()));
+	}
 }
 
 void VertexArrayObject::Bind() {
-	glBindVertexArray(_handle);
+	GlStateCache::BindVertexArray(_handle);
 }
 
 void VertexArrayObject::Unbind() {
-	glBindVertexArray(0);
+	GlStateCache::BindVertexArray(0);
 }
 
 void VertexArrayObject::SetVDecl(const VertexDeclaration& vDecl) {
@@ -99,3 +136,39 @@ const VertexArrayObject::VertexBufferBinding* VertexArrayObject::GetBufferBindin
 	}
 	return nullptr;
 }
+
+bool VertexArrayObject::ReadBack(std::vector<uint8_t>& outVertices, std::vector<uint32_t>& outIndices) {
+	// Meshes in an arena don't have buffers of their own
+	if (_vertexBuffers.empty() && _arenaAllocation != nullptr) {
+		_arenaAllocation->ReadVertices(outVertices);
+		_arenaAllocation->ReadIndices(outIndices);
+		return true;
+	}
+
+	const VertexBufferBinding* binding = GetBufferBinding(AttribUsage::Position);
+	if (binding == nullptr) {
+		return false;
+	}
+	outVertices.resize(binding->Buffer->GetTotalSize());
+	glGetNamedBufferSubData(binding->Buffer->GetHandle(), 0, outVertices.size(), outVertices.data());
+
+	outIndices.resize(_indexBuffer != nullptr ? _indexBuffer->GetElementCount() : binding->Buffer->GetElementCount());
+	if (_indexBuffer == nullptr) {
+		for (uint32_t ix = 0; ix < outIndices.size(); ix++) {
+			outIndices[ix] = ix;
+		}
+		return true;
+	}
+
+	std::vector<uint8_t> indexData(_indexBuffer->GetTotalSize());
+	glGetNamedBufferSubData(_indexBuffer->GetHandle(), 0, indexData.size(), indexData.data());
+	for (size_t ix = 0; ix < outIndices.size(); ix++) {
+		switch (_indexBuffer->GetElementType()) {
+			case IndexType::UByte:  outIndices[ix] = indexData[ix]; break;
+			case IndexType::UShort: outIndices[ix] = reinterpret_cast<const uint16_t*>(indexData.data())[ix]; break;
+			case IndexType::UInt:   outIndices[ix] = reinterpret_cast<const uint32_t*>(indexData.data())[ix]; break;
+			default:                outIndices[ix] = 0; break;
+		}
+	}
+	return true;
+}
@@ -7,6 +7,10 @@
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
+#include "Utils/BoundingVolumes.h"
+
+// Pre-declare so we don't need to include the arena here (it includes us)
+struct ArenaAllocation;
 
 /// <summary>
 /// We'll use this just to make it more clear what the intended usage of an attribute is in our code!
@@ -42,6 +46,7 @@ ENUM(AttributeType, GLenum,
 	UShort  = GL_UNSIGNED_SHORT,
 	Int     = GL_INT,
 	UInt    = GL_UNSIGNED_INT,
+	HalfFloat = GL_HALF_FLOAT,
 	Float   = GL_FLOAT,
 	Double  = GL_DOUBLE,
 	Unknown = GL_NONE
@@ -135,9 +140,9 @@ public:
 	// Destructor does not need to be virtual due to the use of the final keyword
 	~VertexArrayObject();
 
-	uint32_t GetVertexCount() const { return _vertexCount; }
-	uint32_t GetIndexCount() const { return _indexBuffer != nullptr ? _indexBuffer->GetElementCount() : 0; }
-	uint32_t GetElementCount() const { return _elementCount; }
+	uint32_t GetVertexCount() const;
+	uint32_t GetIndexCount() const;
+	uint32_t GetElementCount() const;
 
 	/// <summary>
 	/// Sets the index buffer for this VAO, note that for now, this will not delete the buffer when the VAO is deleted, more on that later
@@ -150,7 +155,8 @@ public:
 	/// </summary>
 	/// <param name="buffer">The buffer to add (note, does not take ownership, you will still need to delete later)</param>
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
-	void AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes);
+	/// <param name="instanceDivisor">If non-zero, the attributes advance once per this many instances instead of once per vertex</param>
+	void AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes, uint32_t instanceDivisor = 0);
 
 	/// <summary>
 	/// Gets the buffer binding that has an attribute with the given usage
@@ -160,7 +166,23 @@ public:
 	/// <returns>A const pointer to the binding, or nullptr if none is found</returns>
 	const VertexBufferBinding* GetBufferBinding(AttribUsage usage);
 
+	/// <summary>
+	/// Reads the mesh's vertices and indices back from the GPU, from either our own buffers or our arena allocation.
+	/// Stalls until the GPU is done with the buffers, so this should only be used when building data from a mesh
+	/// </summary>
+	/// <param name="outVertices">Receives the raw data of the vertex buffer with the position attribute</param>
+	/// <param name="outIndices">Receives the indices widened to 32 bits, or the vertices in order if the mesh is not indexed</param>
+	/// <returns>True if the mesh had data to read</returns>
+	bool ReadBack(std::vector<uint8_t>& outVertices, std::vector<uint32_t>& outIndices);
+
 	void Draw(DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Draws a range of the VAO's vertices or indices, ex: the part of a ring buffer that was just written
+	/// </summary>
+	/// <param name="mode">The primitive type to draw</param>
+	/// <param name="first">The first vertex (or index) to draw</param>
+	/// <param name="count">The number of vertices (or indices) to draw</param>
+	void Draw(DrawMode mode, uint32_t first, uint32_t count);
 
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
@@ -179,6 +201,25 @@ public:
 	void SetVDecl(const VertexDeclaration& vDecl);
 	const VertexDeclaration& GetVDecl();
 
+	/// <summary>
+	/// Sets the object space bounds of the mesh, should be set by whatever creates the VAO's data
+	/// </summary>
+	void SetBounds(const MeshBounds& bounds) { _bounds = bounds; }
+	/// <summary>
+	/// Gets the object space bounds of the mesh, check Box.IsValid() for whether they have been set
+	/// </summary>
+	const MeshBounds& GetBounds() const { return _bounds; }
+
+	/// <summary>
+	/// Sets where this mesh lives in a shared GeometryArena, allowing the renderer to draw it with multi-draw
+	/// indirect. If the VAO has no vertex buffers of it's own, Draw and ReadBack go through the allocation instead
+	/// </summary>
+	void SetArenaAllocation(const std::shared_ptr<ArenaAllocation>& allocation) { _arenaAllocation = allocation; }
+	/// <summary>
+	/// Gets this mesh's allocation in a GeometryArena, or nullptr if it does not have one
+	/// </summary>
+	const std::shared_ptr<ArenaAllocation>& GetArenaAllocation() const { return _arenaAllocation; }
+
 protected:
 	
 	// The index buffer bound to this VAO
@@ -193,6 +234,12 @@ protected:
 	uint32_t _vertexCount;
 	uint32_t _elementCount;
 
+	// The object space bounds of the mesh
+	MeshBounds _bounds;
+
+	// Our mesh's data in a shared geometry arena, freed when the VAO is destroyed
+	std::shared_ptr<ArenaAllocation> _arenaAllocation;
+
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
 };
@@ -0,0 +1,92 @@
+#include "Graphics/VertexPacking.h"
+#include <GLM/gtc/packing.hpp>
+
+// The largest value of a snorm16, GL maps this to 1.0
+static const float SNORM16_MAX = 32767.0f;
+
+// Like glm::sign, but never returns 0, so points on the axes still get folded
+static inline glm::vec2 SignNotZero(const glm::vec2& v) {
+	return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+// Decodes an octahedral normal that is already in [-1, 1]
+static glm::vec3 OctDecode(const glm::vec2& e) {
+	glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+	if (n.z < 0.0f) {
+		glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * SignNotZero(glm::vec2(n));
+		n.x = folded.x;
+		n.y = folded.y;
+	}
+	return glm::normalize(n);
+}
+
+glm::i16vec2 VertexPacking::EncodeNormal(const glm::vec3& normal) {
+	float length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+	if (length <= 0.0f) {
+		return glm::i16vec2(0);
+	}
+
+	// Project onto the octahedron, then fold the bottom half over the top
+	glm::vec2 p = glm::vec2(normal) / length;
+	if (normal.z < 0.0f) {
+		p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * SignNotZero(p);
+	}
+
+	// Rounding to the nearest value isn't always the closest normal once decoded, so we try all 4 neighbours
+	glm::vec3 unit = glm::normalize(normal);
+	glm::vec2 base = glm::floor(glm::clamp(p, -1.0f, 1.0f) * SNORM16_MAX);
+	glm::i16vec2 best = glm::i16vec2(0);
+	float bestScore = -2.0f;
+	for (int ix = 0; ix < 4; ix++) {
+		glm::vec2 candidate = glm::clamp(base + glm::vec2(ix & 1, ix >> 1), -SNORM16_MAX, SNORM16_MAX);
+		// We maximize the dot product, which is the same as minimizing the angle
+		float score = glm::dot(OctDecode(candidate / SNORM16_MAX), unit);
+		if (score > bestScore) {
+			bestScore = score;
+			best = glm::i16vec2(candidate);
+		}
+	}
+	return best;
+}
+
+glm::vec3 VertexPacking::DecodeNormal(const glm::i16vec2& encoded) {
+	// Same conversion that GL does for a normalized snorm attribute
+	return OctDecode(glm::max(glm::vec2(encoded) / SNORM16_MAX, glm::vec2(-1.0f)));
+}
+
+glm::u16vec2 VertexPacking::EncodeUV(const glm::vec2& uv) {
+	return glm::u16vec2(glm::packHalf1x16(uv.x), glm::packHalf1x16(uv.y));
+}
+
+glm::vec2 VertexPacking::DecodeUV(const glm::u16vec2& encoded) {
+	return glm::vec2(glm::unpackHalf1x16(encoded.x), glm::unpackHalf1x16(encoded.y));
+}
+
+glm::u8vec4 VertexPacking::EncodeColor(const glm::vec4& color) {
+	return glm::u8vec4(glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f));
+}
+
+glm::vec4 VertexPacking::DecodeColor(const glm::u8vec4& encoded) {
+	return glm::vec4(encoded) / 255.0f;
+}
+
+const std::vector<std::string>& VertexPacking::GetShaderKeywords(const VertexArrayObject::VertexDeclaration& vDecl) {
+	static const std::vector<std::string> none = {};
+	static const std::vector<std::string> packed = { "PACKED_NORMALS" };
+	static const std::vector<std::string> packedNoColor = { "PACKED_NORMALS", "NO_VERTEX_COLOR" };
+
+	bool packedNormals = false;
+	bool hasColor = false;
+	for (const BufferAttribute& attrib : vDecl) {
+		if (attrib.Usage == AttribUsage::Normal && attrib.Size == 2) {
+			packedNormals = true;
+		} else if (attrib.Usage == AttribUsage::Color) {
+			hasColor = true;
+		}
+	}
+	// Our float formats without a color have always been drawn with the attribute's default (black), so we leave them be
+	if (!packedNormals) {
+		return none;
+	}
+	return hasColor ? packed : packedNoColor;
+}
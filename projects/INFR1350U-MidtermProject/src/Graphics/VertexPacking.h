@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Helpers for encoding vertex attributes into smaller formats, used by the packed vertex types
+///
+/// Normals are octahedral encoded into 2 snorm16s, which keeps them within about 0.01 degrees of the
+/// original. UVs are stored as half floats, and colors as unorm8s. The GPU expands UVs and colors for
+/// us, but normals need to be decoded in the vertex shader (see shaders/vertex_packing.glsl)
+/// </summary>
+class VertexPacking {
+public:
+	VertexPacking() = delete;
+
+	/// <summary>
+	/// Encodes a unit vector with the octahedral mapping, picking whichever rounding gives the smallest
+	/// error once decoded. Zero length vectors will decode to +Z
+	/// </summary>
+	static glm::i16vec2 EncodeNormal(const glm::vec3& normal);
+	/// <summary>
+	/// Decodes an octahedral normal, exactly the same way as the shaders do
+	/// </summary>
+	static glm::vec3 DecodeNormal(const glm::i16vec2& encoded);
+
+	/// <summary>
+	/// Converts a UV to half floats
+	/// </summary>
+	static glm::u16vec2 EncodeUV(const glm::vec2& uv);
+	static glm::vec2 DecodeUV(const glm::u16vec2& encoded);
+
+	/// <summary>
+	/// Converts a color to unorm8s, clamping it to [0, 1]
+	/// </summary>
+	static glm::u8vec4 EncodeColor(const glm::vec4& color);
+	static glm::vec4 DecodeColor(const glm::u8vec4& encoded);
+
+	/// <summary>
+	/// Gets the shader keywords that a mesh with the given vertex declaration needs to be drawn with, ex: PACKED_NORMALS
+	/// if the normals need to be decoded. The lists are static, so they can be compared by address
+	/// </summary>
+	/// <param name="vDecl">The mesh's vertex declaration</param>
+	/// <returns>The keywords to add to the material's keywords, empty for our standard vertex formats</returns>
+	static const std::vector<std::string>& GetShaderKeywords(const VertexArrayObject::VertexDeclaration& vDecl);
+};
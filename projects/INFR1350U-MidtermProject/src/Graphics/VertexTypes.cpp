@@ -1,10 +1,13 @@
 #include "VertexTypes.h"
+#include "VertexPacking.h"
 #pragma warning( push )
 
 VertexPosCol* VPC = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
+VertexPosNormTexPacked* VPNTP = nullptr;
+VertexPosNormTexColPacked* VPNTCP = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -26,4 +29,26 @@ const std::vector<BufferAttribute> VertexPosNormTexCol::V_DECL = {
 	BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->Normal, AttribUsage::Normal),
 	BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->UV, AttribUsage::Texture),
 };
-#pragma warning(pop)
\ No newline at end of file
+const std::vector<BufferAttribute> VertexPosNormTexPacked::V_DECL = {
+	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormTexPacked), (size_t)&VPNTP->Position, AttribUsage::Position),
+	BufferAttribute(2, 2, AttributeType::Short, sizeof(VertexPosNormTexPacked), (size_t)&VPNTP->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexPosNormTexPacked), (size_t)&VPNTP->UV, AttribUsage::Texture),
+};
+const std::vector<BufferAttribute> VertexPosNormTexColPacked::V_DECL = {
+	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Color, AttribUsage::Color, true),
+	BufferAttribute(2, 2, AttributeType::Short, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->UV, AttribUsage::Texture),
+};
+#pragma warning(pop)
+
+VertexPosNormTexPacked::VertexPosNormTexPacked(const VertexPosNormTexCol& vertex) :
+	Position(vertex.Position),
+	Normal(VertexPacking::EncodeNormal(vertex.Normal)),
+	UV(VertexPacking::EncodeUV(vertex.UV)) {}
+
+VertexPosNormTexColPacked::VertexPosNormTexColPacked(const VertexPosNormTexCol& vertex) :
+	Position(vertex.Position),
+	Normal(VertexPacking::EncodeNormal(vertex.Normal)),
+	UV(VertexPacking::EncodeUV(vertex.UV)),
+	Color(VertexPacking::EncodeColor(vertex.Color)) {}
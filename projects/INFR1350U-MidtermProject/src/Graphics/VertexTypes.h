@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
 #include "VertexArrayObject.h"
 
 
@@ -58,4 +59,48 @@ struct VertexPosNormTexCol {
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+
+/// <summary>
+/// A 20 byte alternative to VertexPosNormTexCol, for meshes that don't need vertex colors (ex: anything
+/// loaded from an OBJ, where the color is always white). The normal is octahedral encoded and needs to be
+/// drawn with the PACKED_NORMALS shader keyword, see VertexPacking
+/// </summary>
+struct VertexPosNormTexPacked {
+	glm::vec3    Position;
+	// Octahedral encoded, as snorm16s
+	glm::i16vec2 Normal;
+	// Half floats
+	glm::u16vec2 UV;
+
+	VertexPosNormTexPacked() : Position(glm::vec3(0.0f)), Normal(glm::i16vec2(0)), UV(glm::u16vec2(0)) {}
+	explicit VertexPosNormTexPacked(const VertexPosNormTexCol& vertex);
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A 24 byte alternative to VertexPosNormTexCol, same as VertexPosNormTexPacked with a unorm8 color
+/// </summary>
+struct VertexPosNormTexColPacked {
+	glm::vec3    Position;
+	// Octahedral encoded, as snorm16s
+	glm::i16vec2 Normal;
+	// Half floats
+	glm::u16vec2 UV;
+	glm::u8vec4  Color;
+
+	VertexPosNormTexColPacked() : Position(glm::vec3(0.0f)), Normal(glm::i16vec2(0)), UV(glm::u16vec2(0)), Color(glm::u8vec4(0, 0, 0, 255)) {}
+	explicit VertexPosNormTexColPacked(const VertexPosNormTexCol& vertex);
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// The vertex formats that a mesh can be imported into
+/// </summary>
+ENUM(MeshVertexFormat, int,
+	Full        = 0, // VertexPosNormTexCol
+	Packed      = 1, // VertexPosNormTexPacked
+	PackedColor = 2  // VertexPosNormTexColPacked
+);
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "Utils/AssetArchive.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <zlib.h>
+#include <Logging.h>
+
+bool                     AssetArchive::_mounted = false;
+std::string              AssetArchive::_path;
+MemoryMappedFile         AssetArchive::_file;
+AssetArchiveHeader       AssetArchive::_header;
+const AssetArchiveEntry* AssetArchive::_entries = nullptr;
+const char*              AssetArchive::_names = nullptr;
+std::mutex               AssetArchive::_statsMutex;
+AssetArchive::Stats      AssetArchive::_stats = AssetArchive::Stats();
+
+AssetArchive::View::View() :
+	Data(nullptr),
+	Size(0),
+	Inflated(std::vector<char>())
+{ }
+
+AssetArchive::Stats::Stats() :
+	Stored(0),
+	Inflated(0),
+	BytesInflated(0),
+	InflateMs(0.0f),
+	Misses(0),
+	Loose(0)
+{ }
+
+bool AssetArchive::Mount(const std::string& path) {
+	Unmount();
+
+	if (!_file.Open(path)) {
+		return false;
+	}
+	if (_file.GetSize() < sizeof(AssetArchiveHeader)) {
+		LOG_ERROR("Asset archive '{}' is too small to have a header", path);
+		_file.Close();
+		return false;
+	}
+	memcpy(&_header, _file.GetData(), sizeof(AssetArchiveHeader));
+	if (!_Validate()) {
+		LOG_ERROR("Asset archive '{}' is corrupt or from a different version of the packer", path);
+		_file.Close();
+		return false;
+	}
+
+	// The table of contents starts on an aligned offset, so we can use it straight from the mapping
+	_entries = reinterpret_cast<const AssetArchiveEntry*>(_file.GetData() + _header.TocOffset);
+	_names = _file.GetData() + _header.NamesOffset;
+	_path = path;
+	_mounted = true;
+
+	uint32_t compressed = 0;
+	for (uint32_t ix = 0; ix < _header.EntryCount; ix++) {
+		compressed += (_entries[ix].Flags & ASSET_ENTRY_COMPRESSED) ? 1 : 0;
+	}
+	LOG_INFO("Mounted asset archive '{}' ({} entries, {} compressed, {:.2f} MB)",
+		path, _header.EntryCount, compressed, _file.GetSize() / (1024.0f * 1024.0f));
+
+	std::lock_guard<std::mutex> lock(_statsMutex);
+	_stats = Stats();
+	return true;
+}
+
+void AssetArchive::Unmount() {
+	_mounted = false;
+	_entries = nullptr;
+	_names = nullptr;
+	_path.clear();
+	memset(&_header, 0, sizeof(AssetArchiveHeader));
+	_file.Close();
+}
+
+bool AssetArchive::Contains(const std::string& path) {
+	return _mounted && _Find(NormalizePath(path)) != nullptr;
+}
+
+bool AssetArchive::Read(const std::string& path, View& outView) {
+	if (!_mounted) {
+		return false;
+	}
+
+	const AssetArchiveEntry* entry = _Find(NormalizePath(path));
+	if (entry == nullptr) {
+		std::lock_guard<std::mutex> lock(_statsMutex);
+		_stats.Misses++;
+		return false;
+	}
+
+	// Loose files win, we only check for them once we know the archive has the file so that misses stay cheap
+	if (std::filesystem::exists(path)) {
+		std::lock_guard<std::mutex> lock(_statsMutex);
+		_stats.Loose++;
+		return false;
+	}
+
+	const char* blob = _file.GetData() + entry->Offset;
+
+	// Stored entries don't need to be copied at all
+	if ((entry->Flags & ASSET_ENTRY_COMPRESSED) == 0) {
+		outView.Inflated.clear();
+		outView.Data = blob;
+		outView.Size = (size_t)entry->Size;
+
+		std::lock_guard<std::mutex> lock(_statsMutex);
+		_stats.Stored++;
+		return true;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	outView.Inflated.resize((size_t)entry->Size);
+	uLongf inflatedSize = (uLongf)entry->Size;
+	int result = uncompress(reinterpret_cast<Bytef*>(outView.Inflated.data()), &inflatedSize,
+		reinterpret_cast<const Bytef*>(blob), (uLong)entry->StoredSize);
+	if (result != Z_OK || inflatedSize != entry->Size ||
+		crc32(0L, reinterpret_cast<const Bytef*>(outView.Inflated.data()), (uInt)inflatedSize) != entry->Checksum) {
+		LOG_ERROR("Could not inflate '{}' from asset archive '{}' (zlib error {})", path, _path, result);
+		outView.Inflated.clear();
+		return false;
+	}
+	outView.Data = outView.Inflated.data();
+	outView.Size = outView.Inflated.size();
+
+	float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	std::lock_guard<std::mutex> lock(_statsMutex);
+	_stats.Inflated++;
+	_stats.BytesInflated += entry->Size;
+	_stats.InflateMs += elapsed;
+	return true;
+}
+
+std::string AssetArchive::NormalizePath(const std::string& path) {
+	std::string result = path;
+	std::replace(result.begin(), result.end(), '\\', '/');
+	result = std::filesystem::path(result).lexically_normal().generic_string();
+	// lexically_normal leaves a single leading ./ alone on some standard libraries
+	while (result.size() > 2 && result[0] == '.' && result[1] == '/') {
+		result.erase(0, 2);
+	}
+	return result;
+}
+
+AssetArchive::Stats AssetArchive::GetStats() {
+	std::lock_guard<std::mutex> lock(_statsMutex);
+	return _stats;
+}
+
+void AssetArchive::LogStats() {
+	if (!_mounted) {
+		return;
+	}
+	Stats stats = GetStats();
+	LOG_INFO("Asset archive '{}': {} reads in place, {} inflated ({:.2f} MB in {:.2f} ms), {} not in the archive, {} overridden by loose files",
+		_path, stats.Stored,
+		stats.Inflated, stats.BytesInflated / (1024.0f * 1024.0f), stats.InflateMs,
+		stats.Misses, stats.Loose);
+}
+
+bool AssetArchive::_Validate() {
+	const uint64_t fileSize = _file.GetSize();
+	if (_header.Magic != ASSET_ARCHIVE_MAGIC || _header.Version != ASSET_ARCHIVE_VERSION) {
+		return false;
+	}
+	if (_header.TocOffset % alignof(AssetArchiveEntry) != 0 ||
+		_header.TocOffset > fileSize ||
+		(fileSize - _header.TocOffset) / sizeof(AssetArchiveEntry) < _header.EntryCount ||
+		_header.NamesOffset > fileSize || fileSize - _header.NamesOffset < _header.NamesSize) {
+		return false;
+	}
+
+	const AssetArchiveEntry* entries = reinterpret_cast<const AssetArchiveEntry*>(_file.GetData() + _header.TocOffset);
+	const char* names = _file.GetData() + _header.NamesOffset;
+	std::string_view previous;
+	for (uint32_t ix = 0; ix < _header.EntryCount; ix++) {
+		const AssetArchiveEntry& entry = entries[ix];
+		if ((uint64_t)entry.NameOffset + entry.NameLength > _header.NamesSize ||
+			entry.Offset > fileSize || fileSize - entry.Offset < entry.StoredSize) {
+			return false;
+		}
+		if ((entry.Flags & ASSET_ENTRY_COMPRESSED) == 0 && entry.StoredSize != entry.Size) {
+			return false;
+		}
+		// The binary search relies on the entries being sorted, with no duplicates
+		std::string_view name(names + entry.NameOffset, entry.NameLength);
+		if (ix > 0 && !(previous < name)) {
+			return false;
+		}
+		previous = name;
+	}
+	return true;
+}
+
+const AssetArchiveEntry* AssetArchive::_Find(const std::string& normalized) {
+	const AssetArchiveEntry* end = _entries + _header.EntryCount;
+	const AssetArchiveEntry* it = std::lower_bound(_entries, end, std::string_view(normalized),
+		[](const AssetArchiveEntry& entry, std::string_view name) {
+			return std::string_view(_names + entry.NameOffset, entry.NameLength) < name;
+		});
+	if (it != end && std::string_view(_names + it->NameOffset, it->NameLength) == normalized) {
+		return it;
+	}
+	return nullptr;
+}
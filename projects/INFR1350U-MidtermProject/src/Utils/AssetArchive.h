@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Utils/AssetArchiveFormat.h"
+#include "Utils/MemoryMappedFile.h"
+
+/// <summary>
+/// Serves resource files out of a single packed archive (see the AssetPacker tool), instead of opening each
+/// loose file under res/. The archive is memory mapped, and entries are found with a binary search over it's
+/// sorted table of contents. Entries that were stored uncompressed are read in place from the mapping, and
+/// compressed entries are inflated into memory owned by the View
+///
+/// While an archive is mounted, FileHelpers::ReadFile, the OBJ loaders and Texture2D check it before falling
+/// back to the filesystem, so loose files that are not in the archive still load. A loose copy of a file that
+/// is in the archive takes precedence over the packed one, so files edited during development (ex: shaders being
+/// hot reloaded by the ShaderReloader) are never shadowed by a stale copy in the archive
+///
+/// Usage:
+///     AssetArchive::Mount("assets.pak");
+///     AssetArchive::View view;
+///     if (AssetArchive::Read("gObj_puck/puck.obj", view)) {
+///         Parse(view.Data, view.Size);
+///     }
+/// </summary>
+class AssetArchive {
+public:
+	/// <summary>
+	/// The contents of an entry. Data points into the archive's mapping for stored entries, or into Inflated
+	/// for compressed ones, so it's only valid while the view is alive and the archive is mounted
+	/// </summary>
+	struct View {
+		const char*       Data;
+		size_t            Size;
+		// Only used by compressed entries, holds the inflated contents
+		std::vector<char> Inflated;
+
+		View();
+		View(const View& other) = delete;
+		View(View&& other) = default;
+		View& operator=(const View& other) = delete;
+		View& operator=(View&& other) = default;
+	};
+
+	/// <summary>
+	/// Counts for all the reads since the archive was mounted
+	/// </summary>
+	struct Stats {
+		// Entries that were read in place from the mapping
+		uint32_t Stored;
+		// Entries that had to be inflated, and the time and memory that took
+		uint32_t Inflated;
+		uint64_t BytesInflated;
+		float    InflateMs;
+		// Reads that were not in the archive, and fell back to the filesystem
+		uint32_t Misses;
+		// Reads that were in the archive, but used a loose copy of the file instead
+		uint32_t Loose;
+
+		Stats();
+	};
+
+	AssetArchive() = delete;
+
+	/// <summary>
+	/// Maps an archive and validates it's table of contents, replacing any archive that was already mounted.
+	/// Should not be called while resources are loading, since views may point into the old mapping
+	/// </summary>
+	/// <param name="path">The path of the archive to mount</param>
+	/// <returns>True if the archive was mounted</returns>
+	static bool Mount(const std::string& path);
+	/// <summary>
+	/// Unmaps the archive, any views of it's stored entries are no longer valid after this
+	/// </summary>
+	static void Unmount();
+
+	static bool IsMounted() { return _mounted; }
+	static const std::string& GetPath() { return _path; }
+	static uint32_t GetEntryCount() { return _mounted ? _header.EntryCount : 0; }
+
+	/// <summary>
+	/// Returns true if the archive has an entry for the given path
+	/// </summary>
+	static bool Contains(const std::string& path);
+	/// <summary>
+	/// Reads an entry from the archive. This is safe to call from worker threads
+	/// </summary>
+	/// <param name="path">The path of the file, relative to the working directory (ex: shaders/frag_shader.glsl)</param>
+	/// <param name="outView">Receives the entry's contents</param>
+	/// <returns>True if the entry was found and could be read, false if the file should be loaded from disk (including when there is a loose copy of it)</returns>
+	static bool Read(const std::string& path, View& outView);
+
+	/// <summary>
+	/// Converts a path to the form used for archive entries, with forward slashes and no ./ or ../ parts
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+	/// <summary>
+	/// Gets the counts since the archive was mounted
+	/// </summary>
+	static Stats GetStats();
+	/// <summary>
+	/// Logs a summary of how many reads were served from the archive
+	/// </summary>
+	static void LogStats();
+
+protected:
+	static bool                     _mounted;
+	static std::string              _path;
+	static MemoryMappedFile         _file;
+	static AssetArchiveHeader       _header;
+	// Point into the mapping
+	static const AssetArchiveEntry* _entries;
+	static const char*              _names;
+
+	// Reads happen on the loader threads too
+	static std::mutex _statsMutex;
+	static Stats      _stats;
+
+	/// <summary>
+	/// Checks that the header and every entry in the table of contents fit in the file
+	/// </summary>
+	static bool _Validate();
+	/// <summary>
+	/// Binary searches the table of contents for a normalized path
+	/// </summary>
+	/// <returns>The entry, or nullptr if the archive does not have it</returns>
+	static const AssetArchiveEntry* _Find(const std::string& normalized);
+};
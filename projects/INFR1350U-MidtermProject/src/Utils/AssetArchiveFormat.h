@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// The on-disk layout of an asset archive (.pak), shared by the AssetArchive and the AssetPacker tool
+//
+// File layout: header, table of contents, names, then the entry blobs. The table of contents is sorted by
+// name (byte-wise) so that entries can be found with a binary search, and every blob starts on an
+// ASSET_ARCHIVE_ALIGNMENT boundary so that stored entries can be used in place from the mapping
+
+static const uint32_t ASSET_ARCHIVE_MAGIC   = 0x4B41504F; // "OPAK"
+static const uint32_t ASSET_ARCHIVE_VERSION = 1;
+// Blobs start on a cache line, the mapping itself is always page aligned
+static const uint64_t ASSET_ARCHIVE_ALIGNMENT = 64;
+
+// Per-entry flags
+static const uint32_t ASSET_ENTRY_COMPRESSED = 1 << 0;
+
+// The header at the start of every archive, bump the version if the layout ever changes
+struct AssetArchiveHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t Reserved;
+	// Offsets from the start of the file
+	uint64_t TocOffset;
+	uint64_t NamesOffset;
+	uint64_t NamesSize;
+};
+
+// A single entry in the table of contents
+struct AssetArchiveEntry {
+	// The entry's path relative to the resource folder, with forward slashes (ex: gObj_puck/puck.obj)
+	uint32_t NameOffset;
+	uint32_t NameLength;
+	uint32_t Flags;
+	// CRC32 of the uncompressed contents, checked when a compressed entry is inflated
+	uint32_t Checksum;
+	// Where the blob is, and how big it is in the archive and once inflated (the same if it's stored)
+	uint64_t Offset;
+	uint64_t StoredSize;
+	uint64_t Size;
+};
+
+static inline uint64_t AlignArchiveOffset(uint64_t offset) {
+	return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~(ASSET_ARCHIVE_ALIGNMENT - 1);
+}
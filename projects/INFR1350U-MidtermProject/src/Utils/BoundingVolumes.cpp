@@ -0,0 +1,213 @@
+#include "BoundingVolumes.h"
+#include <limits>
+#include <algorithm>
+
+// SSE2 is always available on x64, for other targets we fall back to the scalar path
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define BOUNDS_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+AABB::AABB() :
+	Min(glm::vec3( std::numeric_limits<float>::max())),
+	Max(glm::vec3(-std::numeric_limits<float>::max()))
+{ }
+
+AABB::AABB(const glm::vec3& min, const glm::vec3& max) :
+	Min(min),
+	Max(max)
+{ }
+
+void AABB::Expand(const glm::vec3& point) {
+	Min = glm::min(Min, point);
+	Max = glm::max(Max, point);
+}
+
+void AABB::Expand(const AABB& other) {
+	Min = glm::min(Min, other.Min);
+	Max = glm::max(Max, other.Max);
+}
+
+AABB AABB::Transformed(const glm::mat4& transform) const {
+	if (!IsValid()) {
+		return *this;
+	}
+
+	// Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990
+	// Start with the translation, then for each row of the rotation/scale pick
+	// whichever of the min or max corner contributes the most in each direction
+	glm::vec3 translation = glm::vec3(transform[3]);
+	AABB result(translation, translation);
+	for (int col = 0; col < 3; col++) {
+		for (int row = 0; row < 3; row++) {
+			float a = transform[col][row] * Min[col];
+			float b = transform[col][row] * Max[col];
+			result.Min[row] += glm::min(a, b);
+			result.Max[row] += glm::max(a, b);
+		}
+	}
+	return result;
+}
+
+BoundingSphere::BoundingSphere() :
+	Center(glm::vec3(0.0f)),
+	Radius(0.0f)
+{ }
+
+BoundingSphere::BoundingSphere(const glm::vec3& center, float radius) :
+	Center(center),
+	Radius(radius)
+{ }
+
+BoundingSphere BoundingSphere::Transformed(const glm::mat4& transform) const {
+	float scaleSq = glm::max(glm::max(
+		glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+		glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+		glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])));
+	return BoundingSphere(glm::vec3(transform * glm::vec4(Center, 1.0f)), Radius * glm::sqrt(scaleSq));
+}
+
+MeshBounds MeshBounds::FromPositions(const void* positions, size_t count, size_t stride) {
+	MeshBounds result;
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(positions);
+
+	// First pass finds the box
+	for (size_t ix = 0; ix < count; ix++) {
+		result.Box.Expand(*reinterpret_cast<const glm::vec3*>(data + ix * stride));
+	}
+	if (!result.Box.IsValid()) {
+		return result;
+	}
+
+	// Second pass finds the smallest radius that contains all points around the box center,
+	// which is usually a fair bit tighter than using the box's half diagonal
+	float radiusSq = 0.0f;
+	glm::vec3 center = result.Box.GetCenter();
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 delta = *reinterpret_cast<const glm::vec3*>(data + ix * stride) - center;
+		radiusSq = glm::max(radiusSq, glm::dot(delta, delta));
+	}
+	result.Sphere = BoundingSphere(center, glm::sqrt(radiusSq));
+	return result;
+}
+
+MeshBounds MeshBounds::Transformed(const glm::mat4& transform) const {
+	MeshBounds result;
+	result.Box = Box.Transformed(transform);
+	result.Sphere = Sphere.Transformed(transform);
+	return result;
+}
+
+Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection) {
+	// Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"
+	// GLM is column major, so we need to grab the rows manually
+	glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	Frustum result;
+	result.Planes[0] = row3 + row0; // Left
+	result.Planes[1] = row3 - row0; // Right
+	result.Planes[2] = row3 + row1; // Bottom
+	result.Planes[3] = row3 - row1; // Top
+	result.Planes[4] = row3 + row2; // Near
+	result.Planes[5] = row3 - row2; // Far
+
+	// Normalize the planes so that sphere tests can use the distance directly
+	for (int ix = 0; ix < 6; ix++) {
+		float length = glm::length(glm::vec3(result.Planes[ix]));
+		if (length > 0.0f) {
+			result.Planes[ix] /= length;
+		}
+	}
+	return result;
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+	for (int ix = 0; ix < 6; ix++) {
+		if (glm::dot(glm::vec3(Planes[ix]), sphere.Center) + Planes[ix].w < -sphere.Radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const AABB& box) const {
+	return Classify(box) != FrustumTest::Outside;
+}
+
+FrustumTest Frustum::Classify(const AABB& box) const {
+	FrustumTest result = FrustumTest::Inside;
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extents = box.GetExtents();
+	for (int ix = 0; ix < 6; ix++) {
+		glm::vec3 normal = glm::vec3(Planes[ix]);
+		// Project the box extents onto the plane normal to get the "radius" of the box along it
+		float radius = glm::dot(extents, glm::abs(normal));
+		float distance = glm::dot(normal, center) + Planes[ix].w;
+		if (distance < -radius) {
+			return FrustumTest::Outside;
+		}
+		if (distance < radius) {
+			result = FrustumTest::Intersect;
+		}
+	}
+	return result;
+}
+
+size_t Frustum::CullSpheresScalar(const BoundingSphere* spheres, size_t count, uint8_t* results) const {
+	size_t visible = 0;
+	for (size_t ix = 0; ix < count; ix++) {
+		results[ix] = Intersects(spheres[ix]) ? 1 : 0;
+		visible += results[ix];
+	}
+	return visible;
+}
+
+size_t Frustum::CullSpheres(const BoundingSphere* spheres, size_t count, uint8_t* results) const {
+	#ifdef BOUNDS_USE_SSE
+	// Splat each plane's components into their own registers
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int ix = 0; ix < 6; ix++) {
+		planeX[ix] = _mm_set1_ps(Planes[ix].x);
+		planeY[ix] = _mm_set1_ps(Planes[ix].y);
+		planeZ[ix] = _mm_set1_ps(Planes[ix].z);
+		planeW[ix] = _mm_set1_ps(Planes[ix].w);
+	}
+
+	size_t visible = 0;
+	size_t batchEnd = count & ~(size_t)3;
+	const float* data = reinterpret_cast<const float*>(spheres);
+	for (size_t ix = 0; ix < batchEnd; ix += 4) {
+		// Each sphere is 4 floats, so we can load 4 of them and transpose to get
+		// the X, Y, Z and radius of all 4 spheres in their own registers
+		__m128 x = _mm_loadu_ps(data + ix * 4 + 0);
+		__m128 y = _mm_loadu_ps(data + ix * 4 + 4);
+		__m128 z = _mm_loadu_ps(data + ix * 4 + 8);
+		__m128 r = _mm_loadu_ps(data + ix * 4 + 12);
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+
+		// A sphere is outside if it is fully behind any of the planes
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < 6; p++) {
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+				_mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++) {
+			results[ix + lane] = (mask & (1 << lane)) ? 0 : 1;
+			visible += results[ix + lane];
+		}
+	}
+
+	// Handle whatever is left over that doesn't fill a full register
+	return visible + CullSpheresScalar(spheres + batchEnd, count - batchEnd, results + batchEnd);
+	#else
+	return CullSpheresScalar(spheres, count, results);
+	#endif
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// An axis aligned bounding box, represented by it's minimum and maximum corners
+/// </summary>
+struct AABB {
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	/// <summary>
+	/// Creates a new empty (invalid) bounding box, use Expand to grow it around points
+	/// </summary>
+	AABB();
+	AABB(const glm::vec3& min, const glm::vec3& max);
+
+	/// <summary>
+	/// Returns true if this box contains at least one point
+	/// </summary>
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	/// <summary>
+	/// Grows the box so that it contains the given point
+	/// </summary>
+	void Expand(const glm::vec3& point);
+	/// <summary>
+	/// Grows the box so that it contains another box
+	/// </summary>
+	void Expand(const AABB& other);
+
+	/// <summary>
+	/// Gets the axis aligned box that contains this box after transformation, uses
+	/// Arvo's method so we don't need to transform all 8 corners
+	/// </summary>
+	/// <param name="transform">The affine transformation to apply</param>
+	AABB Transformed(const glm::mat4& transform) const;
+};
+
+/// <summary>
+/// A bounding sphere, stored as 4 floats so that arrays of spheres can be
+/// loaded directly into SIMD registers
+/// </summary>
+struct BoundingSphere {
+	glm::vec3 Center;
+	float     Radius;
+
+	BoundingSphere();
+	BoundingSphere(const glm::vec3& center, float radius);
+
+	/// <summary>
+	/// Gets the sphere that contains this sphere after transformation, the radius
+	/// is scaled by the largest axis scale of the transform
+	/// </summary>
+	/// <param name="transform">The affine transformation to apply</param>
+	BoundingSphere Transformed(const glm::mat4& transform) const;
+};
+
+/// <summary>
+/// Stores both a box and a sphere for a set of points, the sphere is cheaper to
+/// test in bulk, while the box is a tighter fit for most of our meshes
+/// </summary>
+struct MeshBounds {
+	AABB           Box;
+	BoundingSphere Sphere;
+
+	/// <summary>
+	/// Calculates bounds from a strided array of positions
+	/// </summary>
+	/// <param name="positions">Pointer to the first position in the array</param>
+	/// <param name="count">The number of positions in the array</param>
+	/// <param name="stride">The number of bytes between the start of each position</param>
+	static MeshBounds FromPositions(const void* positions, size_t count, size_t stride = sizeof(glm::vec3));
+
+	/// <summary>
+	/// Gets the bounds after transformation by the given matrix
+	/// </summary>
+	MeshBounds Transformed(const glm::mat4& transform) const;
+};
+
+/// <summary>
+/// The results of testing a volume against a frustum
+/// </summary>
+enum class FrustumTest : uint8_t {
+	Outside   = 0,
+	Intersect = 1,
+	Inside    = 2
+};
+
+/// <summary>
+/// A view frustum, represented by 6 inward facing planes (ax + by + cz + d = 0)
+/// </summary>
+struct Frustum {
+	// Left, Right, Bottom, Top, Near, Far
+	glm::vec4 Planes[6];
+
+	/// <summary>
+	/// Extracts the frustum planes from a view-projection matrix (Gribb & Hartmann)
+	/// </summary>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Returns true if any part of the sphere is inside the frustum
+	/// </summary>
+	bool Intersects(const BoundingSphere& sphere) const;
+	/// <summary>
+	/// Returns true if any part of the box is inside the frustum
+	/// </summary>
+	bool Intersects(const AABB& box) const;
+	/// <summary>
+	/// Determines whether a box is completely outside, completely inside, or intersecting the frustum
+	/// </summary>
+	FrustumTest Classify(const AABB& box) const;
+
+	/// <summary>
+	/// Tests a batch of spheres against the frustum, using SSE to test 4 spheres at a time
+	/// </summary>
+	/// <param name="spheres">The array of spheres to test</param>
+	/// <param name="count">The number of spheres in the array</param>
+	/// <param name="results">An array of count elements, will be set to 1 if the sphere is visible, 0 otherwise</param>
+	/// <returns>The number of visible spheres</returns>
+	size_t CullSpheres(const BoundingSphere* spheres, size_t count, uint8_t* results) const;
+	/// <summary>
+	/// The same as CullSpheres, but without SIMD, used as a baseline for comparison
+	/// </summary>
+	size_t CullSpheresScalar(const BoundingSphere* spheres, size_t count, uint8_t* results) const;
+};
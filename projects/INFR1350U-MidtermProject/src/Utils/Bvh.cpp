@@ -0,0 +1,154 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <Logging.h>
+
+Bvh::Bvh() :
+	_nodes(std::vector<Node>()),
+	_items(std::vector<uint32_t>()),
+	_centroids(std::vector<glm::vec3>()),
+	_itemBounds(std::vector<AABB>()),
+	_buildBounds(nullptr)
+{ }
+
+void Bvh::Build(const std::vector<AABB>& bounds) {
+	Clear();
+	if (bounds.empty()) {
+		return;
+	}
+
+	_items.resize(bounds.size());
+	_centroids.resize(bounds.size());
+	for (uint32_t ix = 0; ix < bounds.size(); ix++) {
+		_items[ix] = ix;
+		_centroids[ix] = bounds[ix].GetCenter();
+	}
+
+	// A binary tree with N / MAX_LEAF_SIZE leaves has less than twice that many nodes
+	_nodes.reserve((bounds.size() / MAX_LEAF_SIZE + 1) * 2);
+
+	_buildBounds = &bounds;
+	_BuildRecursive(0, (uint32_t)bounds.size());
+	_buildBounds = nullptr;
+
+	_itemBounds.resize(_items.size());
+	for (size_t ix = 0; ix < _items.size(); ix++) {
+		_itemBounds[ix] = bounds[_items[ix]];
+	}
+}
+
+void Bvh::Refit(const std::vector<AABB>& bounds) {
+	LOG_ASSERT(bounds.size() == _items.size(), "Refit requires the same number of items as the last build!");
+
+	for (size_t ix = 0; ix < _items.size(); ix++) {
+		_itemBounds[ix] = bounds[_items[ix]];
+	}
+
+	// Children are always stored after their parents, so walking backwards means
+	// we update every child before it's parent
+	for (size_t ix = _nodes.size(); ix-- > 0;) {
+		Node& node = _nodes[ix];
+		node.Bounds = AABB();
+		if (node.Count > 0) {
+			for (uint32_t item = node.Offset; item < node.Offset + node.Count; item++) {
+				node.Bounds.Expand(_itemBounds[item]);
+			}
+		} else {
+			node.Bounds.Expand(_nodes[ix + 1].Bounds);
+			node.Bounds.Expand(_nodes[node.Offset].Bounds);
+		}
+	}
+}
+
+void Bvh::Clear() {
+	_nodes.clear();
+	_items.clear();
+	_centroids.clear();
+	_itemBounds.clear();
+}
+
+uint32_t Bvh::_BuildRecursive(uint32_t begin, uint32_t end) {
+	uint32_t nodeIx = (uint32_t)_nodes.size();
+	_nodes.emplace_back();
+
+	// Find the bounds of all the items, as well as the bounds of their centers which we use to pick a split axis
+	AABB bounds;
+	AABB centerBounds;
+	for (uint32_t ix = begin; ix < end; ix++) {
+		bounds.Expand((*_buildBounds)[_items[ix]]);
+		centerBounds.Expand(_centroids[_items[ix]]);
+	}
+	_nodes[nodeIx].Bounds = bounds;
+
+	uint32_t count = end - begin;
+	glm::vec3 size = centerBounds.Max - centerBounds.Min;
+	// Make a leaf if we are small enough, or if all the centers are at the same spot and can't be split
+	if (count <= MAX_LEAF_SIZE || (size.x <= 0.0f && size.y <= 0.0f && size.z <= 0.0f)) {
+		_nodes[nodeIx].Offset = begin;
+		_nodes[nodeIx].Count  = count;
+		return nodeIx;
+	}
+
+	// Split along the longest axis at the median, nth_element keeps this O(n) per level
+	int axis = (size.x > size.y && size.x > size.z) ? 0 : (size.y > size.z ? 1 : 2);
+	uint32_t mid = begin + count / 2;
+	std::nth_element(_items.begin() + begin, _items.begin() + mid, _items.begin() + end, [&](uint32_t a, uint32_t b) {
+		return _centroids[a][axis] < _centroids[b][axis];
+	});
+
+	// Left child always follows the parent, so we only need to store the right
+	_BuildRecursive(begin, mid);
+	uint32_t right = _BuildRecursive(mid, end);
+	_nodes[nodeIx].Offset = right;
+	_nodes[nodeIx].Count  = 0;
+	return nodeIx;
+}
+
+void Bvh::Query(const Frustum& frustum, std::vector<uint32_t>& results) const {
+	if (_nodes.empty()) {
+		return;
+	}
+
+	// Using an explicit stack to avoid recursion, our trees are balanced so 64 is plenty
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		uint32_t nodeIx = stack[--stackSize];
+		const Node& node = _nodes[nodeIx];
+
+		FrustumTest test = frustum.Classify(node.Bounds);
+		if (test == FrustumTest::Outside) {
+			continue;
+		}
+		// If the node is completely inside, all of it's children are too
+		if (test == FrustumTest::Inside) {
+			_AddSubtree(nodeIx, results);
+			continue;
+		}
+
+		if (node.Count > 0) {
+			// The leaf is only partially visible, so test it's items individually
+			for (uint32_t ix = node.Offset; ix < node.Offset + node.Count; ix++) {
+				if (frustum.Intersects(_itemBounds[ix])) {
+					results.push_back(_items[ix]);
+				}
+			}
+		} else {
+			stack[stackSize++] = node.Offset;
+			stack[stackSize++] = nodeIx + 1;
+		}
+	}
+}
+
+void Bvh::_AddSubtree(uint32_t nodeIx, std::vector<uint32_t>& results) const {
+	const Node& node = _nodes[nodeIx];
+	if (node.Count > 0) {
+		for (uint32_t ix = 0; ix < node.Count; ix++) {
+			results.push_back(_items[node.Offset + ix]);
+		}
+	} else {
+		_AddSubtree(nodeIx + 1, results);
+		_AddSubtree(node.Offset, results);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+#include "Utils/BoundingVolumes.h"
+
+/// <summary>
+/// A simple bounding volume hierarchy over a set of axis aligned boxes, used for
+/// culling large numbers of objects without testing every one of them
+///
+/// Nodes are stored in a flat array in depth first order, and leaves refer to
+/// a range of the re-ordered item index list
+/// </summary>
+class Bvh {
+public:
+	// The maximum number of items we will store in a single leaf
+	static const uint32_t MAX_LEAF_SIZE = 4;
+
+	Bvh();
+	~Bvh() = default;
+
+	/// <summary>
+	/// Rebuilds the hierarchy from the given boxes, the index of each box is what
+	/// will be reported by queries
+	/// </summary>
+	/// <param name="bounds">The boxes to build the hierarchy over</param>
+	void Build(const std::vector<AABB>& bounds);
+	/// <summary>
+	/// Updates the bounds of all nodes without changing the structure of the tree, this is much
+	/// cheaper than a rebuild, but the tree will get less efficient if objects move a lot
+	/// </summary>
+	/// <param name="bounds">The new boxes, must be the same count and order as the last call to Build</param>
+	void Refit(const std::vector<AABB>& bounds);
+	/// <summary>
+	/// Clears the hierarchy
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Finds all the items that intersect the given frustum
+	/// </summary>
+	/// <param name="frustum">The frustum to test against</param>
+	/// <param name="results">The vector to append the indices of visible items to</param>
+	void Query(const Frustum& frustum, std::vector<uint32_t>& results) const;
+
+	/// <summary>
+	/// Gets the number of items that the hierarchy was built with
+	/// </summary>
+	size_t GetItemCount() const { return _items.size(); }
+	/// <summary>
+	/// Gets the number of nodes in the hierarchy
+	/// </summary>
+	size_t GetNodeCount() const { return _nodes.size(); }
+
+protected:
+	struct Node {
+		AABB     Bounds;
+		// For leaves, this is the first index into _items, otherwise it is the index of the right child
+		// (the left child always directly follows it's parent)
+		uint32_t Offset;
+		// The number of items in a leaf, 0 for interior nodes
+		uint32_t Count;
+	};
+
+	std::vector<Node>      _nodes;
+	std::vector<uint32_t>  _items;
+	std::vector<glm::vec3> _centroids;
+	// The item bounds, stored in the same order as _items so that partially visible leaves can test their items
+	std::vector<AABB>      _itemBounds;
+	const std::vector<AABB>* _buildBounds;
+
+	uint32_t _BuildRecursive(uint32_t begin, uint32_t end);
+	void _AddSubtree(uint32_t nodeIx, std::vector<uint32_t>& results) const;
+};
@@ -3,10 +3,19 @@
 #include <filesystem>
 #include <Logging.h>
 
+#include "Utils/AssetArchive.h"
 #include "Utils/StringUtils.h"
 
 std::string FileHelpers::ReadFile(const std::string& filename) {
 	std::string result;
+
+	// Files that are only in the archive are read from it, loose copies take precedence (see AssetArchive::Read)
+	AssetArchive::View view;
+	if (AssetArchive::Read(filename, view)) {
+		result.assign(view.Data, view.Size);
+		return result;
+	}
+
 	std::ifstream in(filename, std::ios::in | std::ios::binary); // ifstream closes itself due to RAII
 
 	if (in) {
@@ -31,7 +40,11 @@ std::string FileHelpers::ReadFile(const std::string& filename) {
 	return result;
 }
 
-std::string FileHelpers::ReadResolveIncludes(const std::string& filename) {
+bool FileHelpers::Exists(const std::string& filename) {
+	return std::filesystem::exists(filename) || AssetArchive::Contains(filename);
+}
+
+std::string FileHelpers::ReadResolveIncludes(const std::string& filename, std::vector<std::string>* includedFiles /*= nullptr*/) {
 	// Read the entire file contents for processing
 	std::string result = ReadFile(filename);
 	// Determine where the file we just read resides on the filesystem
@@ -66,9 +79,17 @@ std::string FileHelpers::ReadResolveIncludes(const std::string& filename) {
 			target = folder / path;
 		}
 
-		// Make sure file exists, then load and resolve it's includes
-		LOG_ASSERT(std::filesystem::exists(target), "File does not exist");
-		std::string replacement = FileHelpers::ReadResolveIncludes(target.string());
+		// Make sure file exists, then load and resolve it's includes. We don't assert here, since shaders
+		// get re-read while the app is running and a typo shouldn't take everything down
+		std::string replacement;
+		if (FileHelpers::Exists(target.string())) {
+			replacement = FileHelpers::ReadResolveIncludes(target.string(), includedFiles);
+			if (includedFiles != nullptr) {
+				includedFiles->push_back(target.string());
+			}
+		} else {
+			LOG_ERROR("Could not find included file \"{}\" in \"{}\"", target.string(), filename);
+		}
 
 		// Inject result into our string
 		result.replace(seek, eol - seek, replacement);
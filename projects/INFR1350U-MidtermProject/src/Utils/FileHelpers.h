@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 class FileHelpers {
 public:
@@ -12,13 +13,20 @@ public:
 	/// <returns>The entire contents of the file stored in a string</returns>
 	static std::string ReadFile(const std::string& filename);
 
+	/// <summary>
+	/// Checks whether a file can be read, either from the mounted AssetArchive or from disk
+	/// </summary>
+	/// <param name="filename">The path of the file to check</param>
+	static bool Exists(const std::string& filename);
+
 	/// <summary>
 	/// Reads the entire contents of a file, and will also recursively include
 	/// any other files needed as indicated by a #include fileName on a line
 	/// </summary>
 	/// <param name="filename">The path of the file to load</param>
+	/// <param name="includedFiles">If not null, the paths of all the included files will be appended to this list</param>
 	/// <returns>The entire contents of the file, with includes resolved, stored in a string</returns>
-	static std::string ReadResolveIncludes(const std::string& filename);
+	static std::string ReadResolveIncludes(const std::string& filename, std::vector<std::string>* includedFiles = nullptr);
 
 	/// <summary>
 	/// Helper for writing the contents of a string into a file
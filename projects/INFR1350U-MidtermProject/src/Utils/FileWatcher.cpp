@@ -0,0 +1,99 @@
+#include "Utils/FileWatcher.h"
+#include <vector>
+#include <Logging.h>
+
+FileWatcher::FileWatcher(const Callback& callback, std::chrono::milliseconds interval) :
+	_callback(callback),
+	_interval(interval),
+	_files(std::unordered_map<std::string, WatchedFile>()),
+	_running(true)
+{
+	_thread = std::thread(&FileWatcher::_Run, this);
+}
+
+FileWatcher::~FileWatcher() {
+	// Wake the thread up so we don't have to wait for the rest of it's interval
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_running = false;
+	}
+	_wake.notify_all();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+void FileWatcher::Watch(const std::string& path) {
+	std::string normalized = NormalizePath(path);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_files.find(normalized) == _files.end()) {
+		_files[normalized] = _GetFileState(normalized);
+	}
+}
+
+void FileWatcher::Unwatch(const std::string& path) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_files.erase(NormalizePath(path));
+}
+
+size_t FileWatcher::GetWatchedCount() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _files.size();
+}
+
+std::string FileWatcher::NormalizePath(const std::string& path) {
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+void FileWatcher::_Run() {
+	std::vector<std::pair<std::string, WatchedFile>> files;
+	std::vector<std::string> changed;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_running) {
+		_wake.wait_for(lock, _interval, [this]() { return !_running; });
+		if (!_running) {
+			break;
+		}
+
+		// Copy the list so we can hit the filesystem without holding the lock
+		files.assign(_files.begin(), _files.end());
+		lock.unlock();
+
+		changed.clear();
+		for (auto& [path, state] : files) {
+			WatchedFile current = _GetFileState(path);
+			// Editors often save by deleting and re-creating a file, so we only report files that exist
+			if (current.Exists && (!state.Exists || current.LastWrite != state.LastWrite)) {
+				changed.push_back(path);
+			}
+			state = current;
+		}
+
+		lock.lock();
+		for (auto& [path, state] : files) {
+			auto it = _files.find(path);
+			if (it != _files.end()) {
+				it->second = state;
+			}
+		}
+
+		// The callback may want to watch more files, so we can't hold the lock while calling it
+		if (!changed.empty()) {
+			lock.unlock();
+			for (const std::string& path : changed) {
+				LOG_TRACE("File changed: \"{}\"", path);
+				_callback(path);
+			}
+			lock.lock();
+		}
+	}
+}
+
+FileWatcher::WatchedFile FileWatcher::_GetFileState(const std::string& path) {
+	WatchedFile result;
+	std::error_code error;
+	result.LastWrite = std::filesystem::last_write_time(path, error);
+	result.Exists = !error;
+	return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/// <summary>
+/// Watches a set of files on a background thread, and invokes a callback when any of them
+/// are modified. The callback is invoked on the watcher's thread, so it must be thread safe,
+/// and should not touch OpenGL
+///
+/// Files are checked by polling their last write times, which works the same on every platform
+/// and is plenty fast for the handful of files we care about
+/// </summary>
+class FileWatcher final {
+public:
+	typedef std::shared_ptr<FileWatcher> Sptr;
+	typedef std::function<void(const std::string&)> Callback;
+
+	static inline Sptr Create(const Callback& callback, std::chrono::milliseconds interval = std::chrono::milliseconds(250)) {
+		return std::make_shared<FileWatcher>(callback, interval);
+	}
+
+	/// <summary>
+	/// Creates a new file watcher, and starts it's background thread
+	/// </summary>
+	/// <param name="callback">The function to call with the path of any file that changes</param>
+	/// <param name="interval">How often to check the files for changes</param>
+	FileWatcher(const Callback& callback, std::chrono::milliseconds interval);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher& other) = delete;
+	FileWatcher(FileWatcher&& other) = delete;
+	FileWatcher& operator=(const FileWatcher& other) = delete;
+	FileWatcher& operator=(FileWatcher&& other) = delete;
+
+	/// <summary>
+	/// Starts watching a file, does nothing if the file is already being watched
+	/// </summary>
+	/// <param name="path">The path to the file to watch</param>
+	void Watch(const std::string& path);
+	/// <summary>
+	/// Stops watching a file
+	/// </summary>
+	/// <param name="path">The path to the file to stop watching</param>
+	void Unwatch(const std::string& path);
+
+	/// <summary>
+	/// Gets the number of files that are being watched
+	/// </summary>
+	size_t GetWatchedCount() const;
+
+	/// <summary>
+	/// Normalizes a path so that different spellings of the same path compare equal
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+protected:
+	struct WatchedFile {
+		std::filesystem::file_time_type LastWrite;
+		bool                            Exists;
+	};
+
+	Callback                  _callback;
+	std::chrono::milliseconds _interval;
+
+	mutable std::mutex                           _mutex;
+	std::unordered_map<std::string, WatchedFile> _files;
+
+	std::atomic_bool        _running;
+	std::condition_variable _wake;
+	std::thread             _thread;
+
+	/// <summary>
+	/// The loop for our background thread
+	/// </summary>
+	void _Run();
+	/// <summary>
+	/// Gets the current state of a file on disk
+	/// </summary>
+	static WatchedFile _GetFileState(const std::string& path);
+};
@@ -11,6 +11,7 @@
 #include "imgui_internal.h"
 
 #include <Logging.h>
+#include "Graphics/GlStateCache.h"
 
 #include <GLM/glm.hpp>
 
@@ -37,6 +38,9 @@ void ImGuiHelper::Init(GLFWwindow* window) {
 	// Set up the ImGui implementation for OpenGL
 	ImGui_ImplGlfw_InitForOpenGL(window, true);
 	ImGui_ImplOpenGL3_Init("#version 410");
+	// The renderer creates it's shader and font texture on the first frame if we don't, doing it now
+	// means StartFrame never needs a GL context
+	ImGui_ImplOpenGL3_CreateDeviceObjects();
 
 	// Dark mode FTW
 	ImGui::StyleColorsDark();
@@ -75,6 +79,11 @@ void ImGuiHelper::StartFrame() {
 }
 
 void ImGuiHelper::EndFrame() {
+	RenderDrawData(Render());
+	UpdateViewports();
+}
+
+ImDrawData* ImGuiHelper::Render() {
 	LOG_ASSERT(_window != nullptr, "You must initialize ImGuiHelper before use!");
 
 	// Make sure ImGui knows how big our window is
@@ -85,8 +94,24 @@ void ImGuiHelper::EndFrame() {
 
 	// Render all of our ImGui elements
 	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	return ImGui::GetDrawData();
+}
+
+void ImGuiHelper::RenderDrawData(ImDrawData* drawData) {
+	if (drawData == nullptr) {
+		return;
+	}
+	ImGui_ImplOpenGL3_RenderDrawData(drawData);
+	// ImGui's renderer makes it's own GL calls, so we can't trust the state cache anymore
+	GlStateCache::Invalidate();
+}
 
+void ImGuiHelper::DisableViewports() {
+	ImGui::GetIO().ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+}
+
+void ImGuiHelper::UpdateViewports() {
+	ImGuiIO& io = ImGui::GetIO();
 	// If we have multiple viewports enabled (can drag into a new window)
 	if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
 		// Update the windows that ImGui is using
@@ -97,3 +122,52 @@ void ImGuiHelper::EndFrame() {
 	}
 }
 
+ImGuiDrawSnapshot::ImGuiDrawSnapshot() :
+	_drawData(ImDrawData()),
+	_lists(std::vector<ImDrawList*>())
+{ }
+
+ImGuiDrawSnapshot::~ImGuiDrawSnapshot() {
+	for (ImDrawList* list : _lists) {
+		IM_DELETE(list);
+	}
+	_lists.clear();
+}
+
+// Copies an ImVector without releasing it's memory first, unlike ImVector's assignment operator
+template <typename T>
+static void CopyImVector(ImVector<T>& dest, const ImVector<T>& src) {
+	dest.resize(src.Size);
+	if (src.Size > 0) {
+		memcpy(dest.Data, src.Data, (size_t)src.Size * sizeof(T));
+	}
+}
+
+void ImGuiDrawSnapshot::Capture(const ImDrawData* drawData) {
+	if (drawData == nullptr || !drawData->Valid) {
+		_drawData.Clear();
+		return;
+	}
+
+	// The renderer only reads the command, index and vertex buffers, so those are all we copy
+	while (_lists.size() < (size_t)drawData->CmdListsCount) {
+		_lists.push_back(IM_NEW(ImDrawList)(nullptr));
+	}
+	for (int ix = 0; ix < drawData->CmdListsCount; ix++) {
+		const ImDrawList* source = drawData->CmdLists[ix];
+		ImDrawList* dest = _lists[ix];
+		CopyImVector(dest->CmdBuffer, source->CmdBuffer);
+		CopyImVector(dest->IdxBuffer, source->IdxBuffer);
+		CopyImVector(dest->VtxBuffer, source->VtxBuffer);
+		dest->Flags = source->Flags;
+	}
+
+	_drawData = *drawData;
+	_drawData.CmdLists = _lists.data();
+	// The viewport belongs to ImGui's context, and may not exist by the time we are drawn
+	_drawData.OwnerViewport = nullptr;
+}
+
+ImDrawData* ImGuiDrawSnapshot::GetDrawData() {
+	return _drawData.Valid ? &_drawData : nullptr;
+}
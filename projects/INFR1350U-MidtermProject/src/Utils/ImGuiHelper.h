@@ -1,6 +1,7 @@
 #pragma once
 // Include ImGui so it will be visible when we include this file
 #include <imgui.h>
+#include <vector>
 
 // Will be included in the CPP to avoid header bloat
 struct GLFWwindow;
@@ -31,12 +32,59 @@ public:
 	/// </summary>
 	static void EndFrame();
 
+	/// <summary>
+	/// Ends the ImGui frame and builds it's draw lists without drawing them, does not touch OpenGL
+	/// </summary>
+	/// <returns>The draw data for the frame, owned by ImGui and only valid until the next StartFrame</returns>
+	static ImDrawData* Render();
+	/// <summary>
+	/// Draws the given ImGui draw data to the currently bound framebuffer
+	/// </summary>
+	static void RenderDrawData(ImDrawData* drawData);
+	/// <summary>
+	/// Updates and draws any ImGui windows that have been dragged outside of our main window, must be
+	/// called from the main thread
+	/// </summary>
+	static void UpdateViewports();
+	/// <summary>
+	/// Stops ImGui windows from being dragged outside of our main window, platform windows need to be
+	/// created on the main thread and drawn with our GL context, so we can't use them with a render thread
+	/// </summary>
+	static void DisableViewports();
+
 protected:
 	ImGuiHelper() = default;
 
 	static GLFWwindow* _window;
 };
 
+/// <summary>
+/// A copy of ImGui's draw data for a frame, so that it can be drawn on another thread while ImGui re-uses
+/// it's own draw lists for the next frame. The draw lists are kept between captures, so after the first
+/// few frames capturing only copies the vertices, indices and commands
+/// </summary>
+class ImGuiDrawSnapshot {
+public:
+	ImGuiDrawSnapshot();
+	~ImGuiDrawSnapshot();
+
+	ImGuiDrawSnapshot(const ImGuiDrawSnapshot& other) = delete;
+	ImGuiDrawSnapshot& operator=(const ImGuiDrawSnapshot& other) = delete;
+
+	/// <summary>
+	/// Copies the given draw data into this snapshot
+	/// </summary>
+	void Capture(const ImDrawData* drawData);
+	/// <summary>
+	/// Gets the captured draw data, or nullptr if nothing has been captured
+	/// </summary>
+	ImDrawData* GetDrawData();
+
+protected:
+	ImDrawData               _drawData;
+	std::vector<ImDrawList*> _lists;
+};
+
 // Allows for an ImGui command to have a left aligned label instead of right aligned
 // EX: LABEL_LEFT(ImGui::DragFloat3, "Label", &value);
 #define LABEL_LEFT(func, label, ...) (ImGui::TextUnformatted(label), ImGui::SameLine(), func("##" label, __VA_ARGS__))
\ No newline at end of file
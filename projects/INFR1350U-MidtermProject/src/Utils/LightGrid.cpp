@@ -0,0 +1,279 @@
+#include "Utils/LightGrid.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+// SSE2 is always available on x64, for other targets we fall back to the scalar path
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define LIGHTGRID_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+LightGrid::LightGrid() :
+	_tilesX(0), _tilesY(0), _slices(0),
+	_nearPlane(0.1f), _farPlane(1000.0f),
+	_sliceScale(0.0f), _sliceBias(0.0f),
+	_boundsProjection(glm::mat4(1.0f)),
+	_boundsDirty(true),
+	_threadsUsed(0)
+{ }
+
+void LightGrid::Configure(uint32_t tilesX, uint32_t tilesY, uint32_t slices, float nearPlane, float farPlane) {
+	_tilesX = tilesX;
+	_tilesY = tilesY;
+	_slices = slices;
+	_nearPlane = nearPlane;
+	_farPlane = farPlane;
+
+	// Slice k starts at near * (far / near)^(k / slices), solving for k gives us log(depth) * scale + bias
+	float logRatio = glm::log(_farPlane / _nearPlane);
+	_sliceScale = (float)_slices / logRatio;
+	_sliceBias = -(float)_slices * glm::log(_nearPlane) / logRatio;
+
+	uint32_t count = GetClusterCount();
+	_minX.resize(count); _minY.resize(count); _minZ.resize(count);
+	_maxX.resize(count); _maxY.resize(count); _maxZ.resize(count);
+	_clusters.resize(count);
+	_boundsDirty = true;
+}
+
+uint32_t LightGrid::GetSlice(float depth) const {
+	if (depth <= _nearPlane) {
+		return 0;
+	}
+	int slice = (int)glm::floor(glm::log(depth) * _sliceScale + _sliceBias);
+	return (uint32_t)glm::clamp(slice, 0, (int)_slices - 1);
+}
+
+AABB LightGrid::GetClusterBounds(uint32_t index) const {
+	return AABB(glm::vec3(_minX[index], _minY[index], _minZ[index]), glm::vec3(_maxX[index], _maxY[index], _maxZ[index]));
+}
+
+void LightGrid::Build(const glm::mat4& view, const glm::mat4& projection, const BoundingSphere* lights, uint32_t lightCount, uint32_t threadCount, bool useSimd, ThreadPool* pool) {
+	uint32_t clusterCount = GetClusterCount();
+	if (clusterCount == 0) {
+		return;
+	}
+
+	if (_boundsDirty || projection != _boundsProjection) {
+		_BuildClusterBounds(projection);
+	}
+
+	// Move the lights into view space and find which tiles they touch, this is shared by all the threads
+	_viewLights.resize(lightCount);
+	_lightTiles.resize(lightCount);
+	_lightVisible.resize(lightCount);
+	for (uint32_t ix = 0; ix < lightCount; ix++) {
+		_viewLights[ix] = lights[ix].Transformed(view);
+		_lightVisible[ix] = _GetTileRange(projection, _viewLights[ix], _lightTiles[ix]) ? 1 : 0;
+	}
+
+	// Each thread gets a contiguous range of slices, so they each own a contiguous range of clusters. The calling
+	// thread takes the first range, and the pool's workers take the rest
+	uint32_t maxThreads = pool != nullptr ? pool->GetThreadCount() + 1 : 1;
+	uint32_t threads = glm::clamp(glm::min(glm::min(threadCount, maxThreads), lightCount / MIN_LIGHTS_PER_THREAD), 1u, _slices);
+	_bins.resize(threads);
+	for (uint32_t ix = 1; ix < threads; ix++) {
+		uint32_t start = _slices * ix / threads;
+		uint32_t end = _slices * (ix + 1) / threads;
+		Bin* bin = &_bins[ix];
+		pool->Enqueue([this, start, end, useSimd, bin]() {
+			_BinSlices(start, end, useSimd, *bin);
+		});
+	}
+	_BinSlices(0, _slices / threads, useSimd, _bins[0]);
+	if (threads > 1) {
+		pool->Wait();
+	}
+	_threadsUsed = threads;
+
+	// Stitch the bins together, each bin's offsets are relative to the start of it's own index list
+	size_t total = 0;
+	for (const Bin& bin : _bins) {
+		total += bin.Indices.size();
+	}
+	_lightIndices.resize(total);
+	uint32_t base = 0;
+	for (uint32_t ix = 0; ix < threads; ix++) {
+		const Bin& bin = _bins[ix];
+		uint32_t clusterStart = (_slices * ix / threads) * _tilesX * _tilesY;
+		uint32_t clusterEnd = (_slices * (ix + 1) / threads) * _tilesX * _tilesY;
+		for (uint32_t cluster = clusterStart; cluster < clusterEnd; cluster++) {
+			_clusters[cluster].Offset += base;
+		}
+		if (!bin.Indices.empty()) {
+			memcpy(_lightIndices.data() + base, bin.Indices.data(), bin.Indices.size() * sizeof(uint32_t));
+		}
+		base += (uint32_t)bin.Indices.size();
+	}
+}
+
+void LightGrid::_BuildClusterBounds(const glm::mat4& projection) {
+	glm::mat4 invProjection = glm::inverse(projection);
+	auto unproject = [&](float x, float y, float z) {
+		glm::vec4 result = invProjection * glm::vec4(x, y, z, 1.0f);
+		return glm::vec3(result) / result.w;
+	};
+
+	for (uint32_t y = 0; y < _tilesY; y++) {
+		for (uint32_t x = 0; x < _tilesX; x++) {
+			// Find the rays through each corner of the tile, from the near to the far plane of the projection
+			float ndcX[2] = { -1.0f + 2.0f * x / _tilesX, -1.0f + 2.0f * (x + 1) / _tilesX };
+			float ndcY[2] = { -1.0f + 2.0f * y / _tilesY, -1.0f + 2.0f * (y + 1) / _tilesY };
+			glm::vec3 nearPoints[4], farPoints[4];
+			for (int corner = 0; corner < 4; corner++) {
+				nearPoints[corner] = unproject(ndcX[corner & 1], ndcY[corner >> 1], -1.0f);
+				farPoints[corner]  = unproject(ndcX[corner & 1], ndcY[corner >> 1],  1.0f);
+			}
+
+			for (uint32_t slice = 0; slice < _slices; slice++) {
+				// The depths that bound this slice, in front of the camera
+				float depths[2] = {
+					_nearPlane * glm::pow(_farPlane / _nearPlane, (float)slice / _slices),
+					_nearPlane * glm::pow(_farPlane / _nearPlane, (float)(slice + 1) / _slices)
+				};
+
+				// Slide along each corner ray to where it crosses the slice's planes, this works for both
+				// perspective and orthographic projections
+				AABB bounds;
+				for (int corner = 0; corner < 4; corner++) {
+					float nearDepth = -nearPoints[corner].z;
+					float farDepth = -farPoints[corner].z;
+					for (float depth : depths) {
+						float t = (depth - nearDepth) / (farDepth - nearDepth);
+						bounds.Expand(glm::mix(nearPoints[corner], farPoints[corner], t));
+					}
+				}
+
+				uint32_t index = GetClusterIndex(x, y, slice);
+				_minX[index] = bounds.Min.x; _minY[index] = bounds.Min.y; _minZ[index] = bounds.Min.z;
+				_maxX[index] = bounds.Max.x; _maxY[index] = bounds.Max.y; _maxZ[index] = bounds.Max.z;
+			}
+		}
+	}
+
+	_boundsProjection = projection;
+	_boundsDirty = false;
+}
+
+bool LightGrid::_GetTileRange(const glm::mat4& projection, const BoundingSphere& sphere, glm::uvec4& range) const {
+	float nearDepth = -sphere.Center.z - sphere.Radius;
+	float farDepth  = -sphere.Center.z + sphere.Radius;
+
+	// Completely behind the camera, or past the last slice
+	if (farDepth <= 0.0f || nearDepth > _farPlane) {
+		return false;
+	}
+
+	// If the sphere crosses the camera plane, the projection of it's corners is meaningless, so assume it covers the screen
+	glm::vec2 ndcMin = glm::vec2(-1.0f), ndcMax = glm::vec2(1.0f);
+	if (nearDepth > 0.0f) {
+		ndcMin = glm::vec2(FLT_MAX);
+		ndcMax = glm::vec2(-FLT_MAX);
+		// All of the box is in front of the camera, so the hull of the projected corners contains the sphere
+		for (int corner = 0; corner < 8; corner++) {
+			glm::vec3 offset = glm::vec3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+			glm::vec4 clip = projection * glm::vec4(sphere.Center + offset * sphere.Radius, 1.0f);
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+		if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) {
+			return false;
+		}
+	}
+
+	glm::vec2 tiles = glm::vec2(_tilesX, _tilesY);
+	glm::ivec2 minTile = glm::ivec2(glm::floor((ndcMin * 0.5f + 0.5f) * tiles));
+	glm::ivec2 maxTile = glm::ivec2(glm::floor((ndcMax * 0.5f + 0.5f) * tiles));
+	minTile = glm::clamp(minTile, glm::ivec2(0), glm::ivec2(_tilesX - 1, _tilesY - 1));
+	maxTile = glm::clamp(maxTile, glm::ivec2(0), glm::ivec2(_tilesX - 1, _tilesY - 1));
+	range = glm::uvec4(minTile.x, minTile.y, maxTile.x, maxTile.y);
+	return true;
+}
+
+void LightGrid::_BinSlices(uint32_t sliceStart, uint32_t sliceEnd, bool useSimd, Bin& bin) {
+	uint32_t sliceSize = _tilesX * _tilesY;
+	uint32_t clusterStart = sliceStart * sliceSize;
+	uint32_t clusterEnd = sliceEnd * sliceSize;
+
+	// Gather every (cluster, light) pair, going light by light so that each cluster's list ends up sorted
+	bin.Pairs.clear();
+	for (uint32_t light = 0; light < (uint32_t)_viewLights.size(); light++) {
+		if (!_lightVisible[light]) {
+			continue;
+		}
+		const BoundingSphere& sphere = _viewLights[light];
+		const glm::uvec4& tiles = _lightTiles[light];
+
+		uint32_t firstSlice = glm::max(GetSlice(-sphere.Center.z - sphere.Radius), sliceStart);
+		uint32_t lastSlice = glm::min(GetSlice(-sphere.Center.z + sphere.Radius) + 1, sliceEnd);
+		float radiusSq = sphere.Radius * sphere.Radius;
+
+		for (uint32_t slice = firstSlice; slice < lastSlice; slice++) {
+			for (uint32_t y = tiles.y; y <= tiles.w; y++) {
+				uint32_t rowStart = GetClusterIndex(0, y, slice);
+				uint32_t x = tiles.x;
+
+				#ifdef LIGHTGRID_USE_SSE
+				// Test 4 clusters at a time, by finding the squared distance from the sphere's center to each box
+				if (useSimd) {
+					__m128 cx = _mm_set1_ps(sphere.Center.x);
+					__m128 cy = _mm_set1_ps(sphere.Center.y);
+					__m128 cz = _mm_set1_ps(sphere.Center.z);
+					__m128 r2 = _mm_set1_ps(radiusSq);
+					__m128 zero = _mm_setzero_ps();
+					for (; x + 3 <= tiles.z; x += 4) {
+						uint32_t ix = rowStart + x;
+						__m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_minX[ix]), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&_maxX[ix])), zero));
+						__m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_minY[ix]), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&_maxY[ix])), zero));
+						__m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_minZ[ix]), cz), zero), _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&_maxZ[ix])), zero));
+						__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+						int mask = _mm_movemask_ps(_mm_cmple_ps(distSq, r2));
+						for (int lane = 0; lane < 4; lane++) {
+							if (mask & (1 << lane)) {
+								bin.Pairs.push_back(ix + lane - clusterStart);
+								bin.Pairs.push_back(light);
+							}
+						}
+					}
+				}
+				#endif
+
+				// Whatever is left over, or everything if we're not using SIMD
+				for (; x <= tiles.z; x++) {
+					uint32_t ix = rowStart + x;
+					float dx = glm::max(_minX[ix] - sphere.Center.x, 0.0f) + glm::max(sphere.Center.x - _maxX[ix], 0.0f);
+					float dy = glm::max(_minY[ix] - sphere.Center.y, 0.0f) + glm::max(sphere.Center.y - _maxY[ix], 0.0f);
+					float dz = glm::max(_minZ[ix] - sphere.Center.z, 0.0f) + glm::max(sphere.Center.z - _maxZ[ix], 0.0f);
+					if (dx * dx + dy * dy + dz * dz <= radiusSq) {
+						bin.Pairs.push_back(ix - clusterStart);
+						bin.Pairs.push_back(light);
+					}
+				}
+			}
+		}
+	}
+
+	// Counting sort the pairs into per-cluster lists, we use the cluster array to hold the counts since
+	// this thread is the only one touching this range of clusters
+	for (uint32_t cluster = clusterStart; cluster < clusterEnd; cluster++) {
+		_clusters[cluster] = { 0, 0 };
+	}
+	for (size_t ix = 0; ix < bin.Pairs.size(); ix += 2) {
+		_clusters[clusterStart + bin.Pairs[ix]].Count++;
+	}
+	uint32_t offset = 0;
+	for (uint32_t cluster = clusterStart; cluster < clusterEnd; cluster++) {
+		_clusters[cluster].Offset = offset;
+		offset += _clusters[cluster].Count;
+		// Reset the count so we can use it as our write cursor
+		_clusters[cluster].Count = 0;
+	}
+	bin.Indices.resize(offset);
+	for (size_t ix = 0; ix < bin.Pairs.size(); ix += 2) {
+		Cluster& cluster = _clusters[clusterStart + bin.Pairs[ix]];
+		bin.Indices[cluster.Offset + cluster.Count] = bin.Pairs[ix + 1];
+		cluster.Count++;
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+#include "Utils/BoundingVolumes.h"
+#include "Utils/ThreadPool.h"
+
+/// <summary>
+/// Bins lights into a view space froxel grid for clustered forward shading. The screen is split into
+/// tiles, and the depth range is split into exponentially spaced slices, so each cluster covers
+/// roughly the same amount of space on screen. Each cluster gets a compact list of the lights
+/// whose range touches it, so the fragment shader only needs to loop over those lights
+///
+/// This class does not touch OpenGL, so it can be tested and benchmarked on it's own
+/// </summary>
+class LightGrid {
+public:
+	/// <summary>
+	/// The range of the light index list used by a single cluster, matches a uvec2 in std430
+	/// </summary>
+	struct Cluster {
+		uint32_t Offset;
+		uint32_t Count;
+	};
+
+	// The minimum number of lights for each extra thread we use, threads aren't worth it for small scenes
+	static const uint32_t MIN_LIGHTS_PER_THREAD = 32;
+
+	LightGrid();
+	~LightGrid() = default;
+
+	/// <summary>
+	/// Sets the number of clusters along each axis, and the depth range that the slices will cover
+	/// </summary>
+	/// <param name="tilesX">The number of tiles across the screen</param>
+	/// <param name="tilesY">The number of tiles up the screen</param>
+	/// <param name="slices">The number of depth slices</param>
+	/// <param name="nearPlane">The distance to the start of the first slice, should match the camera</param>
+	/// <param name="farPlane">The distance to the end of the last slice, should match the camera</param>
+	void Configure(uint32_t tilesX, uint32_t tilesY, uint32_t slices, float nearPlane, float farPlane);
+
+	/// <summary>
+	/// Bins the lights into the grid, replacing the results of the last build
+	/// </summary>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="projection">The camera's projection matrix, the cluster bounds are only recalculated when this changes</param>
+	/// <param name="lights">The world space spheres of influence for each light</param>
+	/// <param name="lightCount">The number of lights</param>
+	/// <param name="threadCount">The maximum number of threads to use including the calling thread, will use fewer if there are not many lights</param>
+	/// <param name="useSimd">Whether to test 4 clusters at a time using SSE</param>
+	/// <param name="pool">The workers to run the extra threads on, without one the calling thread does all the work. Build waits for the pool to go idle, so it should not be shared with other work</param>
+	void Build(const glm::mat4& view, const glm::mat4& projection, const BoundingSphere* lights, uint32_t lightCount, uint32_t threadCount = 1, bool useSimd = true, ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// Gets the index of the cluster at the given tile and slice
+	/// </summary>
+	uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t slice) const { return x + y * _tilesX + slice * _tilesX * _tilesY; }
+	/// <summary>
+	/// Gets the slice that a view space depth (positive distance in front of the camera) falls into, clamped to the grid
+	/// </summary>
+	uint32_t GetSlice(float depth) const;
+	/// <summary>
+	/// Gets the scale and bias that convert log(depth) into a slice index, for use in the shader
+	/// </summary>
+	glm::vec2 GetSliceScaleBias() const { return glm::vec2(_sliceScale, _sliceBias); }
+	/// <summary>
+	/// Gets the view space bounds of a cluster
+	/// </summary>
+	AABB GetClusterBounds(uint32_t index) const;
+
+	glm::uvec3 GetDimensions() const { return glm::uvec3(_tilesX, _tilesY, _slices); }
+	float GetNearPlane() const { return _nearPlane; }
+	float GetFarPlane() const { return _farPlane; }
+	uint32_t GetClusterCount() const { return _tilesX * _tilesY * _slices; }
+	uint32_t GetThreadsUsed() const { return _threadsUsed; }
+
+	/// <summary>
+	/// Gets the light list range for every cluster, indexed by GetClusterIndex
+	/// </summary>
+	const std::vector<Cluster>& GetClusters() const { return _clusters; }
+	/// <summary>
+	/// Gets the packed lists of light indices that the clusters refer to
+	/// </summary>
+	const std::vector<uint32_t>& GetLightIndices() const { return _lightIndices; }
+
+protected:
+	uint32_t _tilesX, _tilesY, _slices;
+	float    _nearPlane, _farPlane;
+	float    _sliceScale, _sliceBias;
+
+	// The projection that the cluster bounds were built for, we only rebuild when it changes
+	glm::mat4 _boundsProjection;
+	bool      _boundsDirty;
+
+	// View space bounds of each cluster, stored as structure of arrays so we can load 4 clusters into SIMD registers
+	std::vector<float> _minX, _minY, _minZ;
+	std::vector<float> _maxX, _maxY, _maxZ;
+
+	// The lights in view space, and the range of tiles (min xy, max xy) they cover on screen, rebuilt every frame
+	std::vector<BoundingSphere> _viewLights;
+	std::vector<glm::uvec4>     _lightTiles;
+	std::vector<uint8_t>        _lightVisible;
+
+	std::vector<Cluster>  _clusters;
+	std::vector<uint32_t> _lightIndices;
+	uint32_t              _threadsUsed;
+
+	/// <summary>
+	/// The output from binning a range of slices, each thread gets it's own so they never share memory
+	/// </summary>
+	struct Bin {
+		// Pairs of (cluster, light) that overlap, before being sorted into per-cluster lists
+		std::vector<uint32_t> Pairs;
+		// The per-cluster light lists for this bin's slices, offsets are relative to this bin
+		std::vector<uint32_t> Indices;
+	};
+	std::vector<Bin> _bins;
+
+	/// <summary>
+	/// Recalculates the view space bounds of every cluster from the projection matrix
+	/// </summary>
+	void _BuildClusterBounds(const glm::mat4& projection);
+	/// <summary>
+	/// Bins all the lights into the clusters within the slice range [sliceStart, sliceEnd)
+	/// </summary>
+	void _BinSlices(uint32_t sliceStart, uint32_t sliceEnd, bool useSimd, Bin& bin);
+	/// <summary>
+	/// Finds the range of tiles that a view space sphere may overlap on screen
+	/// </summary>
+	/// <returns>False if the sphere is not on screen</returns>
+	bool _GetTileRange(const glm::mat4& projection, const BoundingSphere& sphere, glm::uvec4& range) const;
+};
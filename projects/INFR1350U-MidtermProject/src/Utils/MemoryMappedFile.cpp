@@ -0,0 +1,134 @@
+#include "Utils/MemoryMappedFile.h"
+#include <Logging.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile() :
+	_isOpen(false),
+	_data(nullptr),
+	_size(0)
+	#ifdef _WIN32
+	, _file(INVALID_HANDLE_VALUE),
+	_mapping(nullptr)
+	#endif
+{ }
+
+MemoryMappedFile::~MemoryMappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+bool MemoryMappedFile::Open(const std::string& filename) {
+	Close();
+
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_ERROR("Could not open file '{}' for mapping", filename);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		LOG_ERROR("Could not get the size of file '{}'", filename);
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_size = (size_t)size.QuadPart;
+	_isOpen = true;
+
+	// Windows won't map an empty file, but there's nothing to read anyways
+	if (_size == 0) {
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		LOG_ERROR("Could not create a mapping for file '{}'", filename);
+		Close();
+		return false;
+	}
+	_mapping = mapping;
+
+	_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		LOG_ERROR("Could not map a view of file '{}'", filename);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mapping != nullptr) {
+		CloseHandle(_mapping);
+	}
+	if (_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(_file);
+	}
+	_file = INVALID_HANDLE_VALUE;
+	_mapping = nullptr;
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+}
+#else
+bool MemoryMappedFile::Open(const std::string& filename) {
+	Close();
+
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		LOG_ERROR("Could not open file '{}' for mapping", filename);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0) {
+		LOG_ERROR("Could not get the size of file '{}'", filename);
+		close(file);
+		return false;
+	}
+	_size = (size_t)info.st_size;
+	_isOpen = true;
+
+	// mmap fails on zero length mappings, but there's nothing to read anyways
+	if (_size > 0) {
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED) {
+			LOG_ERROR("Could not map file '{}'", filename);
+			close(file);
+			_size = 0;
+			_isOpen = false;
+			return false;
+		}
+		// We read the whole file front to back
+		madvise(data, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const char*>(data);
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	close(file);
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	if (_data != nullptr) {
+		munmap(const_cast<char*>(_data), _size);
+	}
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+}
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// Maps a file into memory as read only, so that loaders can parse it in place without copying
+/// it into a string first. The mapping is released when the object is destroyed
+///
+/// Usage:
+///     MemoryMappedFile file;
+///     if (file.Open("meshes/table.obj")) {
+///         Parse(file.GetData(), file.GetSize());
+///     }
+/// </summary>
+class MemoryMappedFile {
+public:
+	MemoryMappedFile();
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile(MemoryMappedFile&& other) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile& operator=(MemoryMappedFile&& other) = delete;
+
+	/// <summary>
+	/// Maps the given file, closing any file that was already mapped
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	/// <returns>True if the file was mapped, empty files will open with a size of 0 and no data</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Unmaps the file, any pointers into it's data are no longer valid after this
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return _isOpen; }
+	const char* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+protected:
+	bool        _isOpen;
+	const char* _data;
+	size_t      _size;
+
+	#ifdef _WIN32
+	// The file and mapping handles, stored as void* so we don't need Windows.h in the header
+	void* _file;
+	void* _mapping;
+	#endif
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
+#include <Logging.h>
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/GeometryArena.h"
+#include "Utils/MeshOptimizer.h"
 
 /// <summary>
 /// A utility class that lets us add vertices and indices, then bake it into a final mesh, using interleaved
@@ -118,26 +121,40 @@ public:
 
 	/// <summary>
 	/// Creates and returns a VertexArraybject from the current data
+	///
+	/// If the MeshOptimizer is enabled, the mesh is indexed (if it wasn't already) and reordered for the
+	/// GPU's vertex caches before it's uploaded, so the builder's vertices and indices will be changed
 	/// </summary>
 	/// <returns>A VertexArrayObject</returns>
 	VertexArrayObject::Sptr Bake() {
-		VertexBuffer::Sptr vbo = VertexBuffer::Create();
-		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
-
-		IndexBuffer::Sptr ebo = nullptr;
-		if (_indices.size() > 0) {
-			ebo = IndexBuffer::Create();
-			ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		if (MeshOptimizer::IsEnabled() && _vertices.size() > 0) {
+			// Most of our generated shapes add 3 vertices per triangle, merge the shared ones so there's something to reuse
+			if (_indices.size() == 0) {
+				MeshOptimizer::GenerateIndices(_vertices, _indices);
+			}
+			MeshOptimizer::Stats stats = MeshOptimizer::Optimize(_vertices, _indices);
+			LOG_TRACE("Optimized generated mesh in {:.3f} ms ({} vertices, {} indices), ACMR {:.3f} -> {:.3f}", stats.Milliseconds,
+				_vertices.size(), _indices.size(), stats.AcmrBefore, stats.AcmrAfter);
 		}
 
-		// Create VAO and attach the buffers
 		VertexArrayObject::Sptr result = VertexArrayObject::Create();
-		result->AddVertexBuffer(vbo, VertType::V_DECL);
-		result->SetIndexBuffer(ebo);
 
 		// Store our vertex type in the VAO's vertex declaration
 		result->SetVDecl(VertType::V_DECL);
 
+		// Calculate the bounds from whichever attribute is our position
+		for (const BufferAttribute& attrib : VertType::V_DECL) {
+			if (attrib.Usage == AttribUsage::Position && _vertices.size() > 0) {
+				const uint8_t* positions = reinterpret_cast<const uint8_t*>(_vertices.data()) + attrib.Offset;
+				result->SetBounds(MeshBounds::FromPositions(positions, _vertices.size(), sizeof(VertType)));
+				break;
+			}
+		}
+
+		// The mesh lives in the shared arena for our vertex format so the renderer can batch our draws
+		result->SetArenaAllocation(GeometryArena::GetForMesh<VertType>(_vertices.size())->Allocate(
+			_vertices.data(), (uint32_t)_vertices.size(), _indices.size() > 0 ? _indices.data() : nullptr, (uint32_t)_indices.size()));
+
 		return result;
 	}
 	
@@ -0,0 +1,371 @@
+#include "Utils/MeshOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <GLM/glm.hpp>
+#include <Logging.h>
+
+bool MeshOptimizer::_enabled = true;
+
+MeshOptimizer::Options::Options() :
+	VertexCache(true),
+	Overdraw(true),
+	VertexFetch(true),
+	CacheSize(16),
+	OverdrawThreshold(1.05f)
+{ }
+
+MeshOptimizer::Stats::Stats() :
+	AcmrBefore(0.0f),
+	AcmrAfter(0.0f),
+	AtvrBefore(0.0f),
+	AtvrAfter(0.0f),
+	Clusters(0),
+	Milliseconds(0.0f)
+{ }
+
+// A simulated FIFO post-transform cache. Rather than storing the cache entries, we store the time that each vertex
+// entered the cache, a vertex is still in the cache if less than cacheSize vertices have entered since
+struct FifoCache {
+	std::vector<uint32_t> EntryTime;
+	uint32_t Time;
+	uint32_t Size;
+
+	FifoCache(size_t vertexCount, uint32_t size) :
+		EntryTime(vertexCount, 0),
+		Time(size + 1),
+		Size(size)
+	{ }
+
+	// Returns true if the vertex was a cache miss (and had to be transformed)
+	bool Access(uint32_t vertex) {
+		if (Time - EntryTime[vertex] > Size) {
+			EntryTime[vertex] = Time++;
+			return true;
+		}
+		return false;
+	}
+
+	// Empties the cache, by moving time forwards far enough that everything has been pushed out
+	void Reset() {
+		Time += Size + 1;
+	}
+};
+
+size_t MeshOptimizer::_CountCacheMisses(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	FifoCache cache(vertexCount, cacheSize);
+	size_t misses = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		misses += cache.Access(indices[ix]) ? 1 : 0;
+	}
+	return misses;
+}
+
+float MeshOptimizer::CalculateAcmr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	size_t triangles = indices.size() / 3;
+	return triangles > 0 ? (float)_CountCacheMisses(indices.data(), indices.size(), vertexCount, cacheSize) / triangles : 0.0f;
+}
+
+float MeshOptimizer::CalculateAtvr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	return vertexCount > 0 ? (float)_CountCacheMisses(indices.data(), indices.size(), vertexCount, cacheSize) / vertexCount : 0.0f;
+}
+
+MeshOptimizer::Stats MeshOptimizer::Optimize(void* vertices, size_t vertexCount, size_t vertexStride, size_t positionOffset, std::vector<uint32_t>& indices, const Options& options) {
+	auto startTime = std::chrono::high_resolution_clock::now();
+	Stats result;
+
+	if (indices.size() % 3 != 0) {
+		LOG_WARN("Cannot optimize a mesh with {} indices, it is not a triangle list", indices.size());
+		return result;
+	}
+	for (uint32_t index : indices) {
+		if (index >= vertexCount) {
+			LOG_WARN("Cannot optimize a mesh with out of range indices ({} >= {})", index, vertexCount);
+			return result;
+		}
+	}
+
+	uint32_t cacheSize = std::max(options.CacheSize, 3u);
+	result.AcmrBefore = CalculateAcmr(indices, vertexCount, cacheSize);
+	result.AtvrBefore = CalculateAtvr(indices, vertexCount, cacheSize);
+
+	if (options.VertexCache) {
+		std::vector<uint32_t> clusters;
+		OptimizeVertexCache(indices, vertexCount, cacheSize, &clusters);
+		result.Clusters = (uint32_t)clusters.size();
+
+		if (options.Overdraw) {
+			const uint8_t* positions = reinterpret_cast<const uint8_t*>(vertices) + positionOffset;
+			result.Clusters = OptimizeOverdraw(indices, clusters, positions, vertexCount, vertexStride, cacheSize, options.OverdrawThreshold);
+		}
+	}
+	if (options.VertexFetch) {
+		OptimizeVertexFetch(vertices, vertexCount, vertexStride, indices);
+	}
+
+	result.AcmrAfter = CalculateAcmr(indices, vertexCount, cacheSize);
+	result.AtvrAfter = CalculateAtvr(indices, vertexCount, cacheSize);
+	result.Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* outClusters) {
+	size_t triangleCount = indices.size() / 3;
+	if (outClusters != nullptr) {
+		outClusters->clear();
+	}
+	if (triangleCount == 0 || vertexCount == 0) {
+		return;
+	}
+
+	// Build the vertex -> triangle adjacency, as one flat list with an offset per vertex
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (uint32_t index : indices) {
+		liveTriangles[index]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + liveTriangles[ix];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t ix = 0; ix < indices.size(); ix++) {
+		adjacency[fill[indices[ix]]++] = (uint32_t)(ix / 3);
+	}
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool>     emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	deadEnds.reserve(indices.size());
+	result.reserve(indices.size());
+
+	const int32_t k = (int32_t)cacheSize;
+	int32_t time = k + 1;
+	size_t cursor = 0;
+	int64_t fanning = indices[0];
+	if (outClusters != nullptr) {
+		outClusters->push_back(0);
+	}
+
+	while (fanning >= 0) {
+		candidates.clear();
+
+		// Emit every triangle around the fanning vertex that hasn't been emitted yet
+		for (uint32_t ix = adjacencyOffsets[fanning]; ix < adjacencyOffsets[fanning + 1]; ix++) {
+			uint32_t triangle = adjacency[ix];
+			if (emitted[triangle]) {
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[triangle * 3 + corner];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				// Only vertices that have fallen out of the cache get a new time stamp
+				if (time - (int32_t)cacheTime[vertex] > k) {
+					cacheTime[vertex] = time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Pick the candidate that will still be in the cache after fanning around it, preferring the oldest
+		int64_t next = -1;
+		int32_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (liveTriangles[vertex] > 0) {
+				int32_t priority = 0;
+				if (time - (int32_t)cacheTime[vertex] + 2 * (int32_t)liveTriangles[vertex] <= k) {
+					priority = time - (int32_t)cacheTime[vertex];
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+		}
+
+		// Dead end, fall back to a recently used vertex, and then to the next unfinished vertex in the mesh
+		if (next == -1) {
+			while (!deadEnds.empty() && next == -1) {
+				uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0) {
+					next = vertex;
+				}
+			}
+			while (next == -1 && cursor < vertexCount) {
+				if (liveTriangles[cursor] > 0) {
+					next = (int64_t)cursor;
+				}
+				cursor++;
+			}
+			// Jumping to a new part of the mesh is a hard boundary for the overdraw clusters
+			if (next != -1 && outClusters != nullptr && result.size() < indices.size() && outClusters->back() != result.size() / 3) {
+				outClusters->push_back((uint32_t)(result.size() / 3));
+			}
+		}
+		fanning = next;
+	}
+
+	indices = std::move(result);
+}
+
+uint32_t MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const void* positions, size_t vertexCount, size_t stride, uint32_t cacheSize, float threshold) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || clusters.empty()) {
+		return 0;
+	}
+
+	auto position = [&](uint32_t vertex) -> glm::vec3 {
+		glm::vec3 result;
+		memcpy(&result, reinterpret_cast<const uint8_t*>(positions) + vertex * stride, sizeof(glm::vec3));
+		return result;
+	};
+
+	// Split the hard clusters into smaller ones, wherever the ACMR of the cluster so far is close enough to the ACMR of
+	// the whole cluster. Smaller clusters can be sorted better, but each split costs us a cold cache
+	std::vector<uint32_t> splits;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t ix = 0; ix < clusters.size(); ix++) {
+		uint32_t start = clusters[ix];
+		uint32_t end = ix + 1 < clusters.size() ? clusters[ix + 1] : (uint32_t)triangleCount;
+		size_t clusterMisses = _CountCacheMisses(indices.data() + start * 3, (end - start) * 3, vertexCount, cacheSize);
+		float clusterAcmr = (float)clusterMisses / (end - start);
+
+		splits.push_back(start);
+		cache.Reset();
+		uint32_t splitStart = start;
+		size_t misses = 0;
+		for (uint32_t triangle = start; triangle < end; triangle++) {
+			for (int corner = 0; corner < 3; corner++) {
+				misses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+			}
+			if (triangle + 1 < end && (float)misses / (triangle + 1 - splitStart) <= clusterAcmr * threshold) {
+				splits.push_back(triangle + 1);
+				splitStart = triangle + 1;
+				misses = 0;
+				cache.Reset();
+			}
+		}
+	}
+
+	// The center of the mesh, from the average of the vertices that are actually used
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	for (uint32_t index : indices) {
+		meshCenter += position(index);
+	}
+	meshCenter /= (float)indices.size();
+
+	// Clusters facing away from the center, and far out from it, are likely to be in front of the rest of the mesh
+	// from any direction they can be seen from. Those get sorted to the front
+	struct ClusterSortData {
+		uint32_t Start;
+		uint32_t End;
+		float    Key;
+	};
+	std::vector<ClusterSortData> sortData(splits.size());
+	for (size_t ix = 0; ix < splits.size(); ix++) {
+		ClusterSortData& data = sortData[ix];
+		data.Start = splits[ix];
+		data.End = ix + 1 < splits.size() ? splits[ix + 1] : (uint32_t)triangleCount;
+
+		float area = 0.0f;
+		glm::vec3 centroid = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		for (uint32_t triangle = data.Start; triangle < data.End; triangle++) {
+			glm::vec3 a = position(indices[triangle * 3 + 0]);
+			glm::vec3 b = position(indices[triangle * 3 + 1]);
+			glm::vec3 c = position(indices[triangle * 3 + 2]);
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triangleArea = glm::length(cross);
+			centroid += (a + b + c) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		float normalLength = glm::length(normal);
+		data.Key = (area > 0.0f && normalLength > 0.0f) ? glm::dot(centroid / area - meshCenter, normal / normalLength) : 0.0f;
+	}
+	std::stable_sort(sortData.begin(), sortData.end(), [](const ClusterSortData& a, const ClusterSortData& b) {
+		return a.Key > b.Key;
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const ClusterSortData& data : sortData) {
+		result.insert(result.end(), indices.begin() + data.Start * 3, indices.begin() + data.End * 3);
+	}
+	indices = std::move(result);
+
+	return (uint32_t)sortData.size();
+}
+
+void MeshOptimizer::OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& indices) {
+	static const uint32_t UNUSED = 0xFFFFFFFF;
+	if (vertexCount == 0) {
+		return;
+	}
+
+	// Vertices get numbered in the order that they are first used, anything left over goes at the end
+	std::vector<uint32_t> remap(vertexCount, UNUSED);
+	uint32_t next = 0;
+	for (uint32_t& index : indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = next++;
+		}
+		index = remap[index];
+	}
+	for (uint32_t& target : remap) {
+		if (target == UNUSED) {
+			target = next++;
+		}
+	}
+
+	uint8_t* data = reinterpret_cast<uint8_t*>(vertices);
+	std::vector<uint8_t> original(data, data + vertexCount * vertexStride);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		memcpy(data + remap[ix] * vertexStride, original.data() + ix * vertexStride, vertexStride);
+	}
+}
+
+size_t MeshOptimizer::GenerateIndices(void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& outIndices) {
+	static const uint32_t EMPTY = 0xFFFFFFFF;
+	uint8_t* data = reinterpret_cast<uint8_t*>(vertices);
+
+	// Open addressing table of unique vertex indices, kept under half full so probes stay short
+	size_t tableSize = 16;
+	while (tableSize < vertexCount * 2) {
+		tableSize <<= 1;
+	}
+	std::vector<uint32_t> table(tableSize, EMPTY);
+
+	outIndices.reserve(outIndices.size() + vertexCount);
+	uint32_t uniqueCount = 0;
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		const uint8_t* vertex = data + ix * vertexStride;
+
+		// FNV-1a over the raw bytes, we only merge vertices that are bit for bit identical
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t byte = 0; byte < vertexStride; byte++) {
+			hash = (hash ^ vertex[byte]) * 1099511628211ull;
+		}
+
+		size_t slot = (size_t)hash & (tableSize - 1);
+		while (table[slot] != EMPTY && memcmp(data + table[slot] * vertexStride, vertex, vertexStride) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == EMPTY) {
+			// Unique vertices are packed towards the front, we never write ahead of the vertex we're reading
+			if (uniqueCount != ix) {
+				memcpy(data + uniqueCount * vertexStride, vertex, vertexStride);
+			}
+			table[slot] = uniqueCount++;
+		}
+		outIndices.push_back(table[slot]);
+	}
+	return uniqueCount;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Reorders a mesh's triangles and vertices so that it renders faster on the GPU, without changing
+/// what is drawn. Runs entirely on the CPU, so it can be used on imported meshes before they are
+/// cached, and tested without an OpenGL context
+///
+/// The full pass runs three stages:
+///    - Vertex cache ordering (Tipsify), reorders triangles so that recently transformed vertices
+///      are reused while they are still in the post-transform cache
+///    - Overdraw ordering, splits the result into clusters and sorts them so that outward facing
+///      clusters on the outside of the mesh are drawn first, and can occlude the rest
+///    - Vertex fetch ordering, renumbers the vertices in the order they are first used, so that the
+///      vertex fetches walk linearly through memory
+///
+/// Cache efficiency is reported as ACMR (average cache miss ratio, the number of vertex shader
+/// invocations per triangle), using a simulated FIFO cache. 0.5 is the best case for a large grid,
+/// 3.0 is the worst case (no reuse at all)
+///
+/// See "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander, Nehab, Barczak 2007)
+/// </summary>
+class MeshOptimizer {
+public:
+	/// <summary>
+	/// Controls which stages of Optimize are run
+	/// </summary>
+	struct Options {
+		bool     VertexCache;
+		bool     Overdraw;
+		bool     VertexFetch;
+		// The size of the cache that Tipsify should target, in vertices
+		uint32_t CacheSize;
+		// How much worse the ACMR of a cluster is allowed to get when splitting it up for the overdraw
+		// ordering (ex: 1.05 allows a 5% increase). Larger values give smaller clusters
+		float    OverdrawThreshold;
+
+		Options();
+	};
+
+	/// <summary>
+	/// The results of optimizing a mesh
+	/// </summary>
+	struct Stats {
+		// ACMR before and after the pass, with a FIFO cache of Options::CacheSize
+		float    AcmrBefore;
+		float    AcmrAfter;
+		// ATVR (average transform to vertex ratio), 1.0 means every vertex was only transformed once
+		float    AtvrBefore;
+		float    AtvrAfter;
+		// The number of clusters that were sorted by the overdraw stage
+		uint32_t Clusters;
+		// How long the pass took, in milliseconds
+		float    Milliseconds;
+
+		Stats();
+	};
+
+	MeshOptimizer() = delete;
+
+	/// <summary>
+	/// Allows the pass to be turned off globally (ex: to compare against the unoptimized meshes). This only affects
+	/// MeshBuilder::Bake and mesh importing, calling Optimize directly will always run the pass
+	/// </summary>
+	static void SetEnabled(bool value) { _enabled = value; }
+	static bool IsEnabled() { return _enabled; }
+
+	/// <summary>
+	/// Runs the optimization pass on a mesh, reordering it's indices and vertices in place
+	/// </summary>
+	/// <param name="vertices">The mesh's vertex data</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="vertexStride">The size of a single vertex, in bytes</param>
+	/// <param name="positionOffset">The offset of the vec3 position within a vertex, in bytes</param>
+	/// <param name="indices">The mesh's triangle indices, 3 per triangle</param>
+	/// <param name="options">The stages to run</param>
+	/// <returns>The ACMR before and after, and other stats for the pass</returns>
+	static Stats Optimize(void* vertices, size_t vertexCount, size_t vertexStride, size_t positionOffset, std::vector<uint32_t>& indices, const Options& options = Options());
+
+	/// <summary>
+	/// Runs the optimization pass on a mesh, using the vertex type's declaration to find the position
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex, must have a V_DECL with a position attribute</typeparam>
+	template <typename VertType>
+	static Stats Optimize(std::vector<VertType>& vertices, std::vector<uint32_t>& indices, const Options& options = Options()) {
+		for (const BufferAttribute& attrib : VertType::V_DECL) {
+			if (attrib.Usage == AttribUsage::Position) {
+				return Optimize(vertices.data(), vertices.size(), sizeof(VertType), attrib.Offset, indices, options);
+			}
+		}
+		// Without a position, we can still do everything except the overdraw ordering
+		Options noOverdraw = options;
+		noOverdraw.Overdraw = false;
+		return Optimize(vertices.data(), vertices.size(), sizeof(VertType), 0, indices, noOverdraw);
+	}
+
+	/// <summary>
+	/// Reorders triangles to improve post-transform vertex cache reuse, using Tipsify
+	/// </summary>
+	/// <param name="indices">The triangle indices to reorder in place</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="cacheSize">The size of the cache to target, in vertices</param>
+	/// <param name="outClusters">If not null, receives the first triangle of each cluster (places where Tipsify had to jump to a new area of the mesh)</param>
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* outClusters = nullptr);
+	/// <summary>
+	/// Sorts clusters of triangles so that the ones most likely to occlude the rest of the mesh are drawn first. Clusters
+	/// are split further where it doesn't hurt the ACMR by more than the threshold
+	/// </summary>
+	/// <param name="indices">The triangle indices to reorder in place, should already be ordered with OptimizeVertexCache</param>
+	/// <param name="clusters">The first triangle of each cluster from OptimizeVertexCache</param>
+	/// <param name="positions">A pointer to the first vertex's position</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="stride">The distance between positions, in bytes</param>
+	/// <param name="cacheSize">The size of the cache to use when measuring ACMR</param>
+	/// <param name="threshold">How much worse a cluster's ACMR can get when it is split</param>
+	/// <returns>The number of clusters that were sorted</returns>
+	static uint32_t OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const void* positions, size_t vertexCount, size_t stride, uint32_t cacheSize, float threshold);
+	/// <summary>
+	/// Renumbers vertices in the order they are first referenced by the indices, moving the vertex data to match.
+	/// Vertices that are never referenced are moved to the end
+	/// </summary>
+	/// <param name="vertices">The vertex data to reorder in place</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="vertexStride">The size of a single vertex, in bytes</param>
+	/// <param name="indices">The indices to remap</param>
+	static void OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& indices);
+
+	/// <summary>
+	/// Turns a non-indexed mesh (3 vertices per triangle) into an indexed one, by merging vertices that are exactly the
+	/// same. The unique vertices are packed at the start of the vertex data, in the order they were first seen
+	/// </summary>
+	/// <param name="vertices">The vertex data to compact in place</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="vertexStride">The size of a single vertex, in bytes</param>
+	/// <param name="outIndices">The list to append the indices to, one per input vertex</param>
+	/// <returns>The number of unique vertices</returns>
+	static size_t GenerateIndices(void* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint32_t>& outIndices);
+	/// <summary>
+	/// Turns a non-indexed mesh into an indexed one, shrinking the vertex list to only the unique vertices
+	/// </summary>
+	template <typename VertType>
+	static void GenerateIndices(std::vector<VertType>& vertices, std::vector<uint32_t>& outIndices) {
+		vertices.resize(GenerateIndices(vertices.data(), vertices.size(), sizeof(VertType), outIndices));
+	}
+
+	/// <summary>
+	/// Calculates the average cache miss ratio (vertex shader invocations per triangle) by running the indices through a FIFO cache
+	/// </summary>
+	/// <param name="indices">The triangle indices to measure</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="cacheSize">The number of vertices the cache can hold</param>
+	/// <returns>The ACMR, or 0 if there are no triangles</returns>
+	static float CalculateAcmr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+	/// <summary>
+	/// Calculates the average transform to vertex ratio (vertex shader invocations per vertex) by running the indices through a FIFO cache
+	/// </summary>
+	static float CalculateAtvr(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+protected:
+	static bool _enabled;
+
+	/// <summary>
+	/// Counts the cache misses for a range of indices, using a FIFO cache
+	/// </summary>
+	static size_t _CountCacheMisses(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+};
@@ -6,24 +6,66 @@
 #include <iostream>
 #include <GLFW/glfw3.h>
 #include <filesystem>
+#include <memory>
 
+#include "Utils/AssetArchive.h"
+#include "Utils/MeshOptimizer.h"
 #include "Utils/StringUtils.h"
 
+// Lets us stream straight out of a block of memory, so files from the AssetArchive are parsed without a copy
+class MemoryStreamBuf : public std::streambuf {
+public:
+	MemoryStreamBuf(const char* data, size_t size) {
+		char* begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+};
+
 VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 {
-	if (!std::filesystem::exists(filename)) {
-		LOG_WARN("Failed to find OBJ file: \"{}\"", filename);
+	float startTime = glfwGetTime();
+
+	std::vector<VertexPosNormTexCol> vertexData;
+	std::vector<uint32_t> indices;
+	if (!LoadVertices(filename, vertexData, indices)) {
 		return nullptr;
 	}
+	if (MeshOptimizer::IsEnabled()) {
+		MeshOptimizer::Stats stats = MeshOptimizer::Optimize(vertexData, indices);
+		LOG_TRACE("Optimized OBJ file \"{}\", ACMR {:.3f} -> {:.3f}", filename, stats.AcmrBefore, stats.AcmrAfter);
+	}
+	VertexArrayObject::Sptr result = CreateMesh(vertexData, indices);
 
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	// Calculate and trace out how long it took us to load
+	float endTime = glfwGetTime();
+	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, vertexData.size(), indices.size());
 
-	// If our file fails to open, we will throw an error
-	if (!file) {
-		throw std::runtime_error("Failed to open file");
+	return result;
+}
+
+bool ObjLoader::LoadVertices(const std::string& filename, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// Files in the archive are read in place, anything else is opened from disk
+	AssetArchive::View view;
+	std::unique_ptr<MemoryStreamBuf> archiveBuffer = nullptr;
+	std::ifstream fileStream;
+	if (AssetArchive::Read(filename, view)) {
+		archiveBuffer = std::make_unique<MemoryStreamBuf>(view.Data, view.Size);
+	} else {
+		if (!std::filesystem::exists(filename)) {
+			LOG_WARN("Failed to find OBJ file: \"{}\"", filename);
+			return false;
+		}
+
+		// Open our file in binary mode
+		fileStream.open(filename, std::ios::binary);
+
+		// If our file fails to open, we will throw an error
+		if (!fileStream) {
+			throw std::runtime_error("Failed to open file");
+		}
 	}
+	std::istream file(archiveBuffer != nullptr ? static_cast<std::streambuf*>(archiveBuffer.get()) : fileStream.rdbuf());
 
 	std::string line;
 	
@@ -32,11 +74,11 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 	std::vector<glm::vec3> normals;
 	std::vector<glm::vec2> uvs;
 	std::vector<glm::ivec3> vertices;
+	std::vector<glm::ivec3> polygon;
 
 	glm::vec3 vecData;
 	glm::ivec3 vertexIndices;
-
-	float startTime = glfwGetTime();
+	std::string corner;
 
 	// Read and process the entire file
 	while (file.peek() != EOF) {
@@ -68,8 +110,6 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 		}
 
 		// The f command defines a polygon in the mesh
-		// NOTE: make sure you triangulate in blender, otherwise it will
-		// output quads instead of triangles
 		else if (command == "f") {
 			// Read the rest of the line from the file
 			std::getline(file, line);
@@ -78,59 +118,110 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 			// Create a string stream so we can use streaming operators on it
 			std::stringstream stream = std::stringstream(line);
 
-			// We'll support only triangles
-			for (int ix = 0; ix < 3; ix++) {
-				// Read in the 3 attributes (position, UV, normal)
-				char separator;
-				stream >> vertexIndices.x >> separator >> vertexIndices.y >> separator >> vertexIndices.z;
+			// Read every corner of the polygon
+			polygon.clear();
+			while (stream >> corner) {
+				// Read in the attributes (position/UV/normal), the UV and normal may be left out (ex: 1//2 or 1)
+				vertexIndices = glm::ivec3(0);
+				std::stringstream cornerStream = std::stringstream(corner);
+				cornerStream >> vertexIndices.x;
+				if (cornerStream.peek() == '/') {
+					cornerStream.get();
+					if (cornerStream.peek() != '/') {
+						cornerStream >> vertexIndices.y;
+					}
+					if (cornerStream.peek() == '/') {
+						cornerStream.get();
+						cornerStream >> vertexIndices.z;
+					}
+				}
 
 				// The OBJ format can have negative values, which are a reference from the last added attributes
 				if (vertexIndices.x < 0) { vertexIndices.x = positions.size() + 1 + vertexIndices.x; }
 				if (vertexIndices.y < 0) { vertexIndices.y = uvs.size()       + 1 + vertexIndices.y; }
 				if (vertexIndices.z < 0) { vertexIndices.z = normals.size()   + 1 + vertexIndices.z; }
 
-				// OBJ format uses 1-based indices
+				// OBJ format uses 1-based indices, missing attributes end up as -1
 				vertexIndices -= glm::ivec3(1);
+				polygon.push_back(vertexIndices);
+			}
 
-				// add the vertex indices to the list
-				// NOTE: This will create duplicate vertices!
-				// A smarter solution would create a map of what attribute
-				// combos have already been added
-				vertices.push_back(vertexIndices);
+			// Triangulate quads and other polygons as a fan around the first corner
+			for (size_t ix = 1; ix + 1 < polygon.size(); ix++) {
+				vertices.push_back(polygon[0]);
+				vertices.push_back(polygon[ix]);
+				vertices.push_back(polygon[ix + 1]);
 			}
 		}
 	}
 
-	// TODO: Generate mesh from the data we loaded
-	std::vector<VertexPosNormTexCol> vertexData;
-
-	for (int ix = 0; ix < vertices.size(); ix++) {
-		glm::ivec3 attribs = vertices[ix];
-
-		// Extract attributes from lists (except color)
-		glm::vec3 position = positions[attribs.x];
-		glm::vec2 uv       = uvs[attribs.y];
-		glm::vec3 normal   = normals[attribs.z];
-		glm::vec4 color    = glm::vec4(1.0f);
+	BuildIndexedMesh(positions, uvs, normals, vertices, outVertices, outIndices);
+	return true;
+}
 
-		// Add the vertex to the mesh
-		vertexData.push_back(VertexPosNormTexCol(position, normal, uv, color));
+// Looks up a 0-based index, returning zeroes for indices that are missing or out of range
+template <typename T>
+static inline T GetAttribute(const std::vector<T>& list, int index, uint32_t& invalidCount) {
+	if (index >= 0 && (size_t)index < list.size()) {
+		return list[index];
+	}
+	// -1 means the face did not specify this attribute, which is allowed
+	if (index != -1) {
+		invalidCount++;
 	}
+	return T(0.0f);
+}
 
-	// Create a vertex buffer and load all our vertex data
-	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
-	vertexBuffer->LoadData(vertexData.data(), vertexData.size());
+// Mixes a position/uv/normal index triple into a hash for our vertex table
+static inline uint32_t HashCorner(const glm::ivec3& corner) {
+	uint32_t hash = (uint32_t)corner.x * 0x9E3779B1u;
+	hash ^= (uint32_t)corner.y * 0x85EBCA77u + (hash << 6) + (hash >> 2);
+	hash ^= (uint32_t)corner.z * 0xC2B2AE3Du + (hash << 6) + (hash >> 2);
+	return hash ^ (hash >> 15);
+}
 
-	// Create the VAO, and add the vertices
-	VertexArrayObject::Sptr result = VertexArrayObject::Create();
-	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
+void ObjLoader::BuildIndexedMesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals,
+	const std::vector<glm::ivec3>& corners, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	static const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
 
-	result->SetVDecl(VertexPosNormTexCol::V_DECL);
-	
-	// Calculate and trace out how long it took us to load
-	float endTime = glfwGetTime();
-	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, vertexData.size(), 0);
+	// Open addressing table from corner to vertex, kept at most half full so probes stay short
+	size_t capacity = 16;
+	while (capacity < corners.size() * 2) {
+		capacity <<= 1;
+	}
+	const size_t mask = capacity - 1;
+	std::vector<uint32_t> table(capacity, EMPTY_SLOT);
+	std::vector<glm::ivec3> uniqueCorners;
+	uniqueCorners.reserve(corners.size() / 2);
+
+	size_t firstVertex = outVertices.size();
+	outVertices.reserve(firstVertex + corners.size() / 2);
+	outIndices.reserve(outIndices.size() + corners.size());
+
+	uint32_t invalidCount = 0;
+	for (const glm::ivec3& attribs : corners) {
+		size_t slot = HashCorner(attribs) & mask;
+		while (table[slot] != EMPTY_SLOT && uniqueCorners[table[slot]] != attribs) {
+			slot = (slot + 1) & mask;
+		}
 
-	return result;
-	//return VertexArrayObject::Create();
+		// First time we've seen this combination of attributes, add a new vertex for it
+		if (table[slot] == EMPTY_SLOT) {
+			table[slot] = (uint32_t)uniqueCorners.size();
+			uniqueCorners.push_back(attribs);
+
+			// Extract attributes from lists (except color)
+			glm::vec3 position = GetAttribute(positions, attribs.x, invalidCount);
+			glm::vec2 uv       = GetAttribute(uvs, attribs.y, invalidCount);
+			glm::vec3 normal   = GetAttribute(normals, attribs.z, invalidCount);
+			glm::vec4 color    = glm::vec4(1.0f);
+			outVertices.push_back(VertexPosNormTexCol(position, normal, uv, color));
+		}
+		outIndices.push_back(table[slot]);
+	}
+
+	if (invalidCount > 0) {
+		LOG_WARN("OBJ data has {} face indices that are out of range, using zeroes for those attributes", invalidCount);
+	}
 }
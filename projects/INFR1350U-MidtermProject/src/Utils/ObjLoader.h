@@ -8,6 +8,57 @@ class ObjLoader
 public:
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
 
+	/// <summary>
+	/// Reads the faces from an OBJ file into a list of unique vertices and triangle indices, without
+	/// touching OpenGL. Quads and other polygons are triangulated as fans
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="outVertices">The list to append the vertices to</param>
+	/// <param name="outIndices">The list to append the indices to, 3 per triangle, relative to the first vertex added</param>
+	/// <returns>True if the file exists and was read</returns>
+	static bool LoadVertices(const std::string& filename, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outIndices);
+
+	/// <summary>
+	/// Turns the triangulated face corners from an OBJ file into unique vertices and indices, so that each
+	/// position/uv/normal combination is only stored once. This is shared with the OptimizedObjLoader
+	/// </summary>
+	/// <param name="positions">The positions from the file</param>
+	/// <param name="uvs">The UVs from the file</param>
+	/// <param name="normals">The normals from the file</param>
+	/// <param name="corners">The 0-based position, uv, and normal index of each triangle corner, -1 if not specified</param>
+	/// <param name="outVertices">The list to append the unique vertices to</param>
+	/// <param name="outIndices">The list to append one index per corner to</param>
+	static void BuildIndexedMesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals,
+		const std::vector<glm::ivec3>& corners, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outIndices);
+
+	/// <summary>
+	/// Creates a mesh from indexed triangles, setting up it's bounds and arena allocation. The mesh goes in the
+	/// arena with the smallest index type that fits. This is shared with the OptimizedObjLoader so that both loaders
+	/// produce the same meshes
+	/// </summary>
+	/// <typeparam name="VertType">The vertex format to create the mesh with, ex: one of the packed formats</typeparam>
+	template <typename VertType>
+	static VertexArrayObject::Sptr CreateMesh(const std::vector<VertType>& vertexData, const std::vector<uint32_t>& indices) {
+		VertexArrayObject::Sptr result = VertexArrayObject::Create();
+		result->SetVDecl(VertType::V_DECL);
+
+		// Every vertex is used by at least one face, so they all contribute to the bounds
+		for (const BufferAttribute& attrib : VertType::V_DECL) {
+			if (attrib.Usage == AttribUsage::Position && vertexData.size() > 0) {
+				const uint8_t* positions = reinterpret_cast<const uint8_t*>(vertexData.data()) + attrib.Offset;
+				result->SetBounds(MeshBounds::FromPositions(positions, vertexData.size(), sizeof(VertType)));
+				break;
+			}
+		}
+
+		// The mesh lives in the shared arena for our vertex format so the renderer can batch our draws, most of
+		// our meshes are small enough to go in the one with 16 bit indices
+		result->SetArenaAllocation(GeometryArena::GetForMesh<VertType>(vertexData.size())->Allocate(
+			vertexData.data(), (uint32_t)vertexData.size(), indices.size() > 0 ? indices.data() : nullptr, (uint32_t)indices.size()));
+
+		return result;
+	}
+
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
@@ -0,0 +1,222 @@
+#include "Utils/OptimizedObjLoader.h"
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+
+#include "Utils/AssetArchive.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/ObjLoader.h"
+
+// The number of each kind of line in a file, used to size our lists before parsing
+struct ObjLineCounts {
+	size_t Positions = 0;
+	size_t Normals   = 0;
+	size_t UVs       = 0;
+	size_t Faces     = 0;
+};
+
+static inline bool IsBlank(char c) {
+	return c == ' ' || c == '\t';
+}
+
+static inline const char* SkipBlanks(const char* p, const char* end) {
+	while (p < end && IsBlank(*p)) {
+		p++;
+	}
+	return p;
+}
+
+// Returns a pointer to the start of the next line
+static inline const char* SkipLine(const char* p, const char* end) {
+	const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+	return newline != nullptr ? newline + 1 : end;
+}
+
+// Checks if the line at p starts with the given command, followed by whitespace
+static inline bool IsCommand(const char* p, const char* end, const char* command, size_t length) {
+	return (size_t)(end - p) > length && memcmp(p, command, length) == 0 && IsBlank(p[length]);
+}
+
+static inline const char* ParseFloat(const char* p, const char* end, float& out) {
+	p = SkipBlanks(p, end);
+	// from_chars doesn't accept a leading +, but streams do
+	if (p < end && *p == '+') {
+		p++;
+	}
+	std::from_chars_result result = std::from_chars(p, end, out);
+	if (result.ec != std::errc()) {
+		out = 0.0f;
+	}
+	return result.ptr;
+}
+
+// Parses a single face index, leaves out as 0 (no index) if there isn't one
+static inline const char* ParseIndex(const char* p, const char* end, int& out) {
+	if (p < end && *p == '+') {
+		p++;
+	}
+	std::from_chars_result result = std::from_chars(p, end, out);
+	if (result.ec != std::errc()) {
+		out = 0;
+	}
+	return result.ptr;
+}
+
+static ObjLineCounts CountLines(const char* p, const char* end) {
+	ObjLineCounts result;
+	while (p < end) {
+		p = SkipBlanks(p, end);
+		if (IsCommand(p, end, "v", 1)) {
+			result.Positions++;
+		} else if (IsCommand(p, end, "vn", 2)) {
+			result.Normals++;
+		} else if (IsCommand(p, end, "vt", 2)) {
+			result.UVs++;
+		} else if (IsCommand(p, end, "f", 1)) {
+			result.Faces++;
+		}
+		p = SkipLine(p, end);
+	}
+	return result;
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename)
+{
+	float startTime = glfwGetTime();
+
+	std::vector<VertexPosNormTexCol> vertexData;
+	std::vector<uint32_t> indices;
+	if (!LoadVertices(filename, vertexData, indices)) {
+		return nullptr;
+	}
+	if (MeshOptimizer::IsEnabled()) {
+		MeshOptimizer::Stats stats = MeshOptimizer::Optimize(vertexData, indices);
+		LOG_TRACE("Optimized OBJ file \"{}\", ACMR {:.3f} -> {:.3f}", filename, stats.AcmrBefore, stats.AcmrAfter);
+	}
+	VertexArrayObject::Sptr result = ObjLoader::CreateMesh(vertexData, indices);
+
+	// Calculate and trace out how long it took us to load
+	float endTime = glfwGetTime();
+	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, vertexData.size(), indices.size());
+
+	return result;
+}
+
+bool OptimizedObjLoader::LoadVertices(const std::string& filename, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// Files in the archive are already mapped, so we can parse them in place
+	AssetArchive::View view;
+	if (AssetArchive::Read(filename, view)) {
+		Parse(view.Data, view.Size, outVertices, outIndices);
+		return true;
+	}
+
+	if (!std::filesystem::exists(filename)) {
+		LOG_WARN("Failed to find OBJ file: \"{}\"", filename);
+		return false;
+	}
+
+	MemoryMappedFile file;
+	if (!file.Open(filename)) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	Parse(file.GetData(), file.GetSize(), outVertices, outIndices);
+	return true;
+}
+
+void OptimizedObjLoader::Parse(const char* data, size_t size, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	const char* p = data;
+	const char* end = data + size;
+
+	ObjLineCounts counts = CountLines(p, end);
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::ivec3> vertices;
+	std::vector<glm::ivec3> polygon;
+	positions.reserve(counts.Positions);
+	normals.reserve(counts.Normals);
+	uvs.reserve(counts.UVs);
+	vertices.reserve(counts.Faces * 3);
+
+	glm::vec3 vecData;
+	glm::ivec3 vertexIndices;
+
+	while (p < end) {
+		p = SkipBlanks(p, end);
+
+		// The v command defines a vertex's position
+		if (IsCommand(p, end, "v", 1)) {
+			p = ParseFloat(p + 1, end, vecData.x);
+			p = ParseFloat(p, end, vecData.y);
+			p = ParseFloat(p, end, vecData.z);
+			positions.push_back(vecData);
+		}
+		else if (IsCommand(p, end, "vn", 2)) {
+			p = ParseFloat(p + 2, end, vecData.x);
+			p = ParseFloat(p, end, vecData.y);
+			p = ParseFloat(p, end, vecData.z);
+			normals.push_back(vecData);
+		}
+		else if (IsCommand(p, end, "vt", 2)) {
+			p = ParseFloat(p + 2, end, vecData.x);
+			p = ParseFloat(p, end, vecData.y);
+			uvs.push_back(glm::vec2(vecData));
+		}
+		// The f command defines a polygon in the mesh
+		else if (IsCommand(p, end, "f", 1)) {
+			polygon.clear();
+			p = SkipBlanks(p + 1, end);
+			while (p < end && (isdigit((unsigned char)*p) || *p == '-' || *p == '+')) {
+				// Each corner is position/uv/normal, where the uv and normal may be left out (ex: 1//2 or 1)
+				const char* cornerStart = p;
+				vertexIndices = glm::ivec3(0);
+				p = ParseIndex(p, end, vertexIndices.x);
+				// Not actually a number (ex: a lone -), give up on the rest of the face
+				if (p == cornerStart) {
+					break;
+				}
+				if (p < end && *p == '/') {
+					p++;
+					if (p < end && *p != '/') {
+						p = ParseIndex(p, end, vertexIndices.y);
+					}
+					if (p < end && *p == '/') {
+						p = ParseIndex(p + 1, end, vertexIndices.z);
+					}
+				}
+
+				// The OBJ format can have negative values, which are a reference from the last added attributes
+				if (vertexIndices.x < 0) { vertexIndices.x = (int)positions.size() + 1 + vertexIndices.x; }
+				if (vertexIndices.y < 0) { vertexIndices.y = (int)uvs.size()       + 1 + vertexIndices.y; }
+				if (vertexIndices.z < 0) { vertexIndices.z = (int)normals.size()   + 1 + vertexIndices.z; }
+
+				// OBJ format uses 1-based indices, missing attributes end up as -1
+				vertexIndices -= glm::ivec3(1);
+				polygon.push_back(vertexIndices);
+				p = SkipBlanks(p, end);
+			}
+
+			// Triangulate quads and other polygons as a fan around the first corner, same as the ObjLoader
+			for (size_t ix = 1; ix + 1 < polygon.size(); ix++) {
+				vertices.push_back(polygon[0]);
+				vertices.push_back(polygon[ix]);
+				vertices.push_back(polygon[ix + 1]);
+			}
+		}
+
+		// Anything else (comments, groups, materials, extra components) is ignored
+		p = SkipLine(p, end);
+	}
+
+	// Attributes are resolved at the end, since faces are allowed to reference attributes that come after them
+	ObjLoader::BuildIndexedMesh(positions, uvs, normals, vertices, outVertices, outIndices);
+}
@@ -12,6 +12,16 @@
 /// Resources must additionally define a static method as such:
 /// static std::shared_ptr<Type> FromJson(const nlohmann::json&);
 /// where Type is the Type of resource
+///
+/// Resources can optionally split their loading in two, so that manifests can be loaded on
+/// worker threads (see ResourceManager::LoadManifest):
+/// static std::function<std::shared_ptr<Type>()> DecodeJson(const nlohmann::json&);
+/// does everything that doesn't need OpenGL (ex: reading and decoding files) and may be called
+/// from any thread, the function it returns creates the resource on the main thread
+///
+/// Resources that need other resources to be loaded first (ex: a material's shader) should
+/// also define:
+/// static std::vector<Guid> GetJsonDependencies(const nlohmann::json&);
 /// </summary>
 class IResource {
 public:
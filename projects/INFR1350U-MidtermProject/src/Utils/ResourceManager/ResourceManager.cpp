@@ -1,11 +1,38 @@
 #include "Utils/ResourceManager/ResourceManager.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <Logging.h>
 
+#include "Graphics/ShaderBinaryCache.h"
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
+#include "Utils/MemoryMappedFile.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ThreadPool.h"
 
 std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
-std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
+std::map<std::string, ResourceManager::TypeLoader> ResourceManager::_typeLoaders;
+std::unordered_map<uint64_t, IResource::Sptr> ResourceManager::_contentLookup;
+std::map<Guid, uint64_t> ResourceManager::_contentHashes;
+std::unordered_map<std::string, ResourceManager::FileHash> ResourceManager::_fileHashes;
+ResourceManager::Stats ResourceManager::_stats;
+
+ResourceManager::Stats::Stats() :
+	Created(0),
+	LoadsAvoided(0)
+{ }
+
+ResourceManager::ManifestStats::ManifestStats() :
+	Resources(0),
+	WorkerThreads(0),
+	TotalMs(0.0f),
+	DecodeMs(0.0f),
+	UploadMs(0.0f),
+	WaitMs(0.0f)
+{ }
 
 nlohmann::json ResourceManager::_manifest;
 
@@ -21,33 +48,230 @@ const nlohmann::json& ResourceManager::GetManifest() {
 	return _manifest;
 }
 
-void ResourceManager::LoadManifest(const std::string& path) {
+// A resource from a manifest that is being loaded
+struct PendingResource {
+	const nlohmann::json*         Data;
+	ResourceManager::UploadFunc   Upload;
+	// Set if decoding failed, the resource is skipped
+	std::string                   Error;
+	// The resources that are waiting for this one to be created
+	std::vector<size_t>           Dependents;
+	// The number of dependencies that haven't been created yet
+	uint32_t                      Waiting;
+	bool                          Decoded;
+};
+
+ResourceManager::ManifestStats ResourceManager::LoadManifest(const std::string& path, int workerThreads) {
+	typedef std::chrono::high_resolution_clock Clock;
+	auto startTime = Clock::now();
+
 	std::string contents = FileHelpers::ReadFile(path);
 	nlohmann::json blob = nlohmann::json::parse(contents);
 
+	// Gather everything we know how to load, so we can find dependencies by GUID
+	std::vector<PendingResource> pending;
+	std::vector<const TypeLoader*> loaders;
+	std::map<Guid, size_t> indices;
 	for (auto& [typeName, items] : blob.items()) {
-		auto& func = _typeLoaders[typeName];
-		if (func) {
-			for (auto& [guid, blob] : items.items()) {
-				func(blob);
+		auto it = _typeLoaders.find(typeName);
+		if (it == _typeLoaders.end()) {
+			continue;
+		}
+		for (auto& [guid, data] : items.items()) {
+			indices[Guid(guid)] = pending.size();
+			pending.push_back({ &data, nullptr, "", {}, 0, false });
+			loaders.push_back(&it->second);
+		}
+	}
+	for (size_t ix = 0; ix < pending.size(); ix++) {
+		for (const Guid& dependency : loaders[ix]->GetDependencies(*pending[ix].Data)) {
+			// Anything that isn't in the manifest is assumed to already be loaded (or missing, which FromJson handles)
+			auto it = indices.find(dependency);
+			if (it != indices.end() && it->second != ix) {
+				pending[it->second].Dependents.push_back(ix);
+				pending[ix].Waiting++;
+			}
+		}
+	}
+
+	ManifestStats stats;
+	stats.Resources = (uint32_t)pending.size();
+
+	// Workers push the index of each resource that they finish decoding
+	std::mutex decodedMutex;
+	std::condition_variable decodedSignal;
+	std::vector<size_t> decodedQueue;
+	std::atomic<int64_t> decodeMicroseconds(0);
+	auto decode = [&](size_t ix) {
+		auto decodeStart = Clock::now();
+		PendingResource& resource = pending[ix];
+		try {
+			resource.Upload = loaders[ix]->Decode(*resource.Data);
+		} catch (const std::exception& e) {
+			resource.Error = e.what();
+		}
+		decodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - decodeStart).count();
+
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		decodedQueue.push_back(ix);
+		decodedSignal.notify_one();
+	};
+
+	// Start decoding everything, the pool is stopped at the end of the function once it's out of work
+	uint32_t threadCount = workerThreads < 0 ? ThreadPool::GetDefaultThreadCount() : (uint32_t)workerThreads;
+	std::unique_ptr<ThreadPool> pool = nullptr;
+	if (threadCount > 0 && pending.size() > 0) {
+		pool = std::make_unique<ThreadPool>(threadCount);
+		stats.WorkerThreads = pool->GetThreadCount();
+		for (size_t ix = 0; ix < pending.size(); ix++) {
+			pool->Enqueue([&decode, ix]() { decode(ix); });
+		}
+	} else {
+		for (size_t ix = 0; ix < pending.size(); ix++) {
+			decode(ix);
+		}
+	}
+
+	// Create resources as they become ready, anything that is waiting on another resource is created right after it
+	std::vector<size_t> ready;
+	std::vector<size_t> decoded;
+	size_t decodedCount = 0;
+	size_t created = 0;
+	while (created < pending.size()) {
+		if (ready.empty()) {
+			auto waitStart = Clock::now();
+			{
+				std::unique_lock<std::mutex> lock(decodedMutex);
+				if (decodedCount < pending.size()) {
+					decodedSignal.wait(lock, [&]() { return !decodedQueue.empty(); });
+				}
+				decoded.swap(decodedQueue);
+			}
+			stats.WaitMs += std::chrono::duration<float, std::milli>(Clock::now() - waitStart).count();
+
+			for (size_t ix : decoded) {
+				pending[ix].Decoded = true;
+				if (pending[ix].Waiting == 0) {
+					ready.push_back(ix);
+				}
+			}
+			decodedCount += decoded.size();
+			decoded.clear();
+
+			// Everything is decoded, but nothing can be created, so there must be a cycle. We load the rest in manifest
+			// order, same as before we had dependencies. Ready is taken from the back, so we push them in reverse
+			if (ready.empty() && decodedCount == pending.size()) {
+				LOG_WARN("Manifest \"{}\" has resources that depend on each other, loading them in order", path);
+				for (size_t ix = pending.size(); ix-- > 0; ) {
+					if (pending[ix].Waiting > 0) {
+						pending[ix].Waiting = 0;
+						ready.push_back(ix);
+					}
+				}
+			}
+			continue;
+		}
+
+		size_t ix = ready.back();
+		ready.pop_back();
+		PendingResource& resource = pending[ix];
+
+		auto uploadStart = Clock::now();
+		if (resource.Upload) {
+			try {
+				resource.Upload();
+			} catch (const std::exception& e) {
+				resource.Error = e.what();
+			}
+		}
+		if (!resource.Error.empty()) {
+			LOG_ERROR("Failed to load resource {} from \"{}\": {}", resource.Data->value("guid", "?"), path, resource.Error);
+		}
+		stats.UploadMs += std::chrono::duration<float, std::milli>(Clock::now() - uploadStart).count();
+		created++;
+
+		// Failed resources still count as done, their dependents will just get nullptr like they would have before
+		for (size_t dependent : resource.Dependents) {
+			if (pending[dependent].Waiting > 0 && --pending[dependent].Waiting == 0 && pending[dependent].Decoded) {
+				ready.push_back(dependent);
 			}
 		}
 	}
+
+	stats.DecodeMs = decodeMicroseconds / 1000.0f;
+	stats.TotalMs = std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+	LOG_INFO("Loaded {} resources from \"{}\" in {:.2f} ms ({} worker threads): {:.2f} ms decoding, {:.2f} ms uploading, {:.2f} ms waiting",
+		stats.Resources, path, stats.TotalMs, stats.WorkerThreads, stats.DecodeMs, stats.UploadMs, stats.WaitMs);
+	return stats;
 }
 
 void ResourceManager::SaveManifest(const std::string& path) {
 	// Update all resources in the manifest so they match their current representation
 	for (auto& [type, map] : _resources) {
 		for (auto& [guid, res] : map) {
-			_manifest[StringTools::SanitizeClassName(type.name())][guid.str()] = res->ToJson();
+			// Make sure the data has the GUID, since the type loaders need it
+			nlohmann::json data = res->ToJson();
+			data["guid"] = guid.str();
+			auto hash = _contentHashes.find(guid);
+			if (hash != _contentHashes.end()) {
+				data["content_hash"] = hash->second;
+			}
+			_manifest[StringTools::SanitizeClassName(type.name())][guid.str()] = data;
 		}
 	}
 	FileHelpers::WriteContentsToFile(path, _manifest.dump(1,'\t'));
 }
 
+void ResourceManager::LogStats() {
+	LOG_INFO("Resources: {} created, {} duplicate loads avoided", _stats.Created, _stats.LoadsAvoided);
+}
+
 void ResourceManager::Cleanup() {
 	for (auto& [type, map] : _resources) {
 		map.clear();
 	}
+	_contentLookup.clear();
+	_contentHashes.clear();
+	_fileHashes.clear();
+}
+
+void ResourceManager::_RecordContentHash(const IResource::Sptr& asset, uint64_t hash) {
+	_contentLookup[hash] = asset;
+	_contentHashes[asset->GetGUID()] = hash;
+}
+
+uint64_t ResourceManager::_HashBytes(const void* data, size_t size, uint64_t seed) {
+	return ShaderBinaryCache::Hash(data, size, seed);
+}
+
+uint64_t ResourceManager::_HashString(const std::string& value, uint64_t seed) {
+	// Include the length, so that ("ab", "c") and ("a", "bc") don't hash the same
+	size_t length = value.size();
+	seed = _HashBytes(&length, sizeof(size_t), seed);
+	return _HashBytes(value.data(), value.size(), seed);
+}
+
+uint64_t ResourceManager::_HashArgument(const std::string& value, uint64_t seed) {
+	std::error_code error;
+	if (!std::filesystem::is_regular_file(value, error)) {
+		return _HashString(value, seed);
+	}
+
+	// Re-use the hash from last time unless the file has changed since then
+	uintmax_t size = std::filesystem::file_size(value, error);
+	int64_t writeTime = (int64_t)std::filesystem::last_write_time(value, error).time_since_epoch().count();
+	auto it = _fileHashes.find(value);
+	if (it == _fileHashes.end() || it->second.Size != size || it->second.WriteTime != writeTime) {
+		MemoryMappedFile file;
+		if (!file.Open(value)) {
+			return _HashString(value, seed);
+		}
+		it = _fileHashes.insert_or_assign(value, FileHash{ size, writeTime, _HashBytes(file.GetData(), file.GetSize(), FNV_OFFSET_BASIS) }).first;
+	}
+
+	// Tag it so a file can't collide with a string that happens to have the same hash
+	static const char tag[] = "file:";
+	seed = _HashBytes(tag, sizeof(tag), seed);
+	return _HashBytes(&it->second.Hash, sizeof(uint64_t), seed);
 }
 
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <json.hpp>
+#include <functional>
+#include <map>
 #include <unordered_map>
 #include <typeindex>
+#include <type_traits>
 
 #include "Graphics/Texture2D.h";
 #include "Graphics/VertexArrayObject.h";
@@ -25,14 +28,93 @@ public:
 	static void Init();
 
 	/// <summary>
-	/// Creates a new asset, and forwards the arguments to it's constructor
+	/// Counts how many assets were created, and how many were shared with an existing asset instead
+	/// </summary>
+	struct Stats {
+		// Assets that were constructed (and loaded)
+		uint32_t Created;
+		// CreateAsset calls that returned an existing asset instead of loading it again
+		uint32_t LoadsAvoided;
+
+		Stats();
+	};
+
+	/// <summary>
+	/// Timing for a single call to LoadManifest, all times are in milliseconds
+	/// </summary>
+	struct ManifestStats {
+		// The number of resources that were loaded
+		uint32_t Resources;
+		// The number of worker threads that decoded resources, 0 if everything ran on the calling thread
+		uint32_t WorkerThreads;
+		// Time from starting the load until the last resource was uploaded
+		float    TotalMs;
+		// Time spent decoding resources, summed over all the threads
+		float    DecodeMs;
+		// Time the calling thread spent creating the resources (ex: uploading to OpenGL)
+		float    UploadMs;
+		// Time the calling thread spent waiting on the workers
+		float    WaitMs;
+
+		ManifestStats();
+	};
+
+	/// <summary>
+	/// Finishes loading a resource on the thread that owns the OpenGL context, see IResource
+	/// </summary>
+	typedef std::function<IResource::Sptr()> UploadFunc;
+
+	/// <summary>
+	/// Gets an asset with the given constructor arguments, creating it if it doesn't exist yet. If an asset
+	/// of the same type was already created with the same arguments, that asset is returned instead, so
+	/// loading the same mesh or texture several times only loads it once
+	///
+	/// Arguments that are paths to files are compared by the file's contents, so copies of a file will also
+	/// share an asset. Assets with no arguments (ex: materials) are always unique, since they are filled in
+	/// after they are created. Use CreateUniqueAsset for assets that will be modified after they are created
+	///
+	/// The lookup is saved in the manifest, so assets loaded with LoadManifest are shared as well. This is
+	/// not thread safe, only call it from the main thread (LoadManifest's workers never call it)
 	/// </summary>
 	/// <typeparam name="T">The type of asset to create</typeparam>
 	/// <typeparam name="...TArgs">The types for the arguments to forward to the constructor</typeparam>
 	/// <param name="...args">The arguments to forward to the constructor</param>
-	/// <returns>The GUID of the newly created asset</returns>
+	/// <returns>The new asset, or the existing asset with the same arguments</returns>
 	template <typename T, typename ... TArgs, typename = std::enable_if<is_valid_resource<T>()>::type>
 	static std::shared_ptr<T> CreateAsset(TArgs&&... args) {
+		if constexpr (sizeof...(TArgs) == 0) {
+			return CreateUniqueAsset<T>();
+		} else {
+			// The type is part of the key, so different types loaded from the same file don't collide
+			uint64_t key = _HashString(typeid(T).name(), FNV_OFFSET_BASIS);
+			((key = _HashArgument(args, key)), ...);
+
+			auto it = _contentLookup.find(key);
+			if (it != _contentLookup.end()) {
+				std::shared_ptr<T> existing = std::dynamic_pointer_cast<T>(it->second);
+				if (existing != nullptr) {
+					_stats.LoadsAvoided++;
+					return existing;
+				}
+			}
+
+			std::shared_ptr<T> asset = CreateUniqueAsset<T>(std::forward<TArgs>(args)...);
+			_RecordContentHash(asset, key);
+			_manifest[StringTools::SanitizeClassName(typeid(T).name())][asset->IResource::GetGUID().str()]["content_hash"] = key;
+			return asset;
+		}
+	}
+
+	/// <summary>
+	/// Creates a new asset, and forwards the arguments to it's constructor. Unlike CreateAsset, this will
+	/// never return an existing asset, use this for copies that are meant to be changed independently
+	/// </summary>
+	/// <typeparam name="T">The type of asset to create</typeparam>
+	/// <typeparam name="...TArgs">The types for the arguments to forward to the constructor</typeparam>
+	/// <param name="...args">The arguments to forward to the constructor</param>
+	/// <returns>The newly created asset</returns>
+	template <typename T, typename ... TArgs, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static std::shared_ptr<T> CreateUniqueAsset(TArgs&&... args) {
 		// Create and store the asset
 		std::shared_ptr<T> asset = std::make_shared<T>(std::forward<TArgs>(args)...);
 		_resources[std::type_index(typeid(T))][asset->IResource::GetGUID()] = asset;
@@ -46,6 +128,7 @@ public:
 
 		// Store the JSON data in the resource manifest (based on the type's name)
 		_manifest[StringTools::SanitizeClassName(typeid(T).name())][guid] = data;
+		_stats.Created++;
 		return asset;
 	}
 
@@ -72,11 +155,37 @@ public:
 		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
 
 		// Create the type loader for the type
-		_typeLoaders[typeName] = [](const nlohmann::json& data) {
-			IResource::Sptr res = T::FromJson(data);
-			res->OverrideGUID(Guid(data["guid"]));
-			_resources[std::type_index(typeid(T))][res->GetGUID()] = res;
-			return res->GetGUID();
+		TypeLoader& loader = _typeLoaders[typeName];
+		loader.Decode = [](const nlohmann::json& data) -> UploadFunc {
+			// Types that don't split their loading do all of it on the main thread
+			UploadFunc upload;
+			if constexpr (test_decode_json<T, const nlohmann::json&>::value) {
+				upload = T::DecodeJson(data);
+			} else {
+				upload = [data]() { return T::FromJson(data); };
+			}
+
+			Guid guid = Guid(data.at("guid").get<std::string>());
+			// Assets that were made with CreateAsset remember their arguments' hash, so CreateAsset can find them
+			uint64_t contentHash = data.value("content_hash", (uint64_t)0);
+			return [upload, guid, contentHash]() {
+				IResource::Sptr res = upload();
+				if (res != nullptr) {
+					res->OverrideGUID(guid);
+					_resources[std::type_index(typeid(T))][guid] = res;
+					if (contentHash != 0) {
+						_RecordContentHash(res, contentHash);
+					}
+				}
+				return res;
+			};
+		};
+		loader.GetDependencies = [](const nlohmann::json& data) {
+			if constexpr (test_json_dependencies<T, const nlohmann::json&>::value) {
+				return T::GetJsonDependencies(data);
+			} else {
+				return std::vector<Guid>();
+			}
 		};
 
 		// Make sure we haven't registered the type yet, then add an empty object
@@ -92,21 +201,47 @@ public:
 	static const nlohmann::json& GetManifest();
 	/// <summary>
 	/// Loads a manifest file into the resource manager
+	///
+	/// Resources that implement DecodeJson (see IResource) are decoded on a pool of worker threads, while
+	/// the calling thread creates the resources as soon as they are decoded and everything they depend on
+	/// has been created. Must be called from the thread that owns the OpenGL context
 	/// </summary>
 	/// <param name="path">The path to the JSON manifest file</param>
-	static void LoadManifest(const std::string& path);
+	/// <param name="workerThreads">The number of threads to decode on, -1 uses ThreadPool::GetDefaultThreadCount, 0 loads everything on the calling thread</param>
+	/// <returns>How long the load took, and where the time went</returns>
+	static ManifestStats LoadManifest(const std::string& path, int workerThreads = -1);
 	/// <summary>
 	/// Saves the manifest to the given JSON file
 	/// </summary>
 	/// <param name="path">The path to the file to output</param>
 	static void SaveManifest(const std::string& path);
 
+	/// <summary>
+	/// Gets the number of assets created and shared since startup
+	/// </summary>
+	static const Stats& GetStats() { return _stats; }
+	/// <summary>
+	/// Logs how many loads were avoided by sharing assets
+	/// </summary>
+	static void LogStats();
+
 	/// <summary>
 	/// Releases all resources held by the resource manager
 	/// </summary>
 	static void Cleanup();
 
 protected:
+	static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+	/// <summary>
+	/// A file's content hash, along with what we need to tell if it has changed since we hashed it
+	/// </summary>
+	struct FileHash {
+		uintmax_t Size;
+		int64_t   WriteTime;
+		uint64_t  Hash;
+	};
+
 	/// <summary>
 	/// This is a map of maps
 	/// The top level map uses type_index, so there's a map per resource type
@@ -114,9 +249,76 @@ protected:
 	/// </summary>
 	static std::map<std::type_index, std::map<Guid, IResource::Sptr>> _resources;
 	/// <summary>
+	/// How to load a registered type from JSON
+	/// </summary>
+	struct TypeLoader {
+		// Does the CPU side of loading a resource, may run on a worker thread. The function it returns
+		// creates and stores the resource on the main thread
+		std::function<UploadFunc(const nlohmann::json&)>        Decode;
+		// Gets the GUIDs of the resources that need to be created first
+		std::function<std::vector<Guid>(const nlohmann::json&)> GetDependencies;
+	};
+	/// <summary>
 	/// This map stores registered types, so we can load them from JSON files
 	/// </summary>
-	static std::map<std::string, std::function<Guid(const nlohmann::json&)>> _typeLoaders;
+	static std::map<std::string, TypeLoader> _typeLoaders;
+	/// <summary>
+	/// Maps the hash of an asset's type and constructor arguments to the asset, used by CreateAsset
+	///
+	/// This, _contentHashes, _fileHashes and _stats are not locked, they are only used on the main thread
+	/// </summary>
+	static std::unordered_map<uint64_t, IResource::Sptr> _contentLookup;
+	/// <summary>
+	/// The reverse of _contentLookup, so SaveManifest can store each asset's hash
+	/// </summary>
+	static std::map<Guid, uint64_t> _contentHashes;
+	/// <summary>
+	/// Content hashes for the files that have been passed to CreateAsset, so we only read each file once
+	/// </summary>
+	static std::unordered_map<std::string, FileHash> _fileHashes;
+	static Stats _stats;
+
+	static void _RecordContentHash(const IResource::Sptr& asset, uint64_t hash);
 
 	static nlohmann::json _manifest;
+
+	static uint64_t _HashString(const std::string& value, uint64_t seed);
+
+	/// <summary>
+	/// Hashes a string argument, if it is the path to a file the file's contents are hashed instead
+	/// </summary>
+	static uint64_t _HashArgument(const std::string& value, uint64_t seed);
+	static uint64_t _HashArgument(const char* value, uint64_t seed) { return _HashArgument(std::string(value), seed); }
+	/// <summary>
+	/// Hashes numbers and enums by value
+	/// </summary>
+	template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>
+	static uint64_t _HashArgument(T value, uint64_t seed) {
+		return _HashBytes(&value, sizeof(T), seed);
+	}
+	/// <summary>
+	/// Hashes a list of arguments (ex: the images for a texture array), in order
+	/// </summary>
+	template <typename T>
+	static uint64_t _HashArgument(const std::vector<T>& value, uint64_t seed) {
+		for (const T& item : value) {
+			seed = _HashArgument(item, seed);
+		}
+		return _HashArgument((uint64_t)value.size(), seed);
+	}
+	/// <summary>
+	/// Hashes a map of arguments (ex: the stages of a shader), in sorted order so that the hash doesn't
+	/// depend on the order of the buckets
+	/// </summary>
+	template <typename TKey, typename TValue>
+	static uint64_t _HashArgument(const std::unordered_map<TKey, TValue>& value, uint64_t seed) {
+		std::map<TKey, TValue> sorted(value.begin(), value.end());
+		for (const auto& [key, item] : sorted) {
+			seed = _HashArgument(key, seed);
+			seed = _HashArgument(item, seed);
+		}
+		return seed;
+	}
+
+	static uint64_t _HashBytes(const void* data, size_t size, uint64_t seed);
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount) :
+	_jobs(std::deque<Job>()),
+	_running(0),
+	_stopping(false)
+{
+	threadCount = std::max(threadCount, 1u);
+	_workers.reserve(threadCount);
+	for (uint32_t ix = 0; ix < threadCount; ix++) {
+		_workers.emplace_back(&ThreadPool::_Run, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_jobReady.notify_all();
+	for (std::thread& worker : _workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+void ThreadPool::Enqueue(const Job& job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(job);
+	}
+	_jobReady.notify_one();
+}
+
+void ThreadPool::Wait() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this]() { return _jobs.empty() && _running == 0; });
+}
+
+uint32_t ThreadPool::GetDefaultThreadCount() {
+	// hardware_concurrency is allowed to return 0 if it can't tell
+	uint32_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void ThreadPool::_Run() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		// We only stop once the queue is empty, so nothing that was queued gets dropped
+		_jobReady.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+		if (_jobs.empty()) {
+			break;
+		}
+
+		Job job = std::move(_jobs.front());
+		_jobs.pop_front();
+		_running++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		_running--;
+		if (_running == 0 && _jobs.empty()) {
+			_idle.notify_all();
+		}
+	}
+}
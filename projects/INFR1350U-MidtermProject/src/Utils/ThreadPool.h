@@ -0,0 +1,83 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// A fixed set of worker threads that run jobs from a shared queue, in the order they were queued.
+/// Jobs run on the workers, so they must be thread safe and should not touch OpenGL
+///
+/// Usage:
+///     ThreadPool pool(ThreadPool::GetDefaultThreadCount());
+///     for (const std::string& file : files) {
+///         pool.Enqueue([file]() { Decode(file); });
+///     }
+///     pool.Wait();
+/// </summary>
+class ThreadPool final {
+public:
+	typedef std::shared_ptr<ThreadPool> Sptr;
+	typedef std::function<void()> Job;
+
+	static inline Sptr Create(uint32_t threadCount = GetDefaultThreadCount()) {
+		return std::make_shared<ThreadPool>(threadCount);
+	}
+
+	/// <summary>
+	/// Creates a new thread pool, and starts it's workers
+	/// </summary>
+	/// <param name="threadCount">The number of worker threads, at least 1 thread is always created</param>
+	ThreadPool(uint32_t threadCount);
+	/// <summary>
+	/// Finishes any jobs that are still queued, then stops the workers
+	/// </summary>
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool(ThreadPool&& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	ThreadPool& operator=(ThreadPool&& other) = delete;
+
+	/// <summary>
+	/// Adds a job to the end of the queue, it will run on the first worker that is free
+	/// </summary>
+	void Enqueue(const Job& job);
+	/// <summary>
+	/// Blocks until every job that has been queued has finished running
+	/// </summary>
+	void Wait();
+
+	/// <summary>
+	/// Gets the number of worker threads in this pool
+	/// </summary>
+	uint32_t GetThreadCount() const { return (uint32_t)_workers.size(); }
+
+	/// <summary>
+	/// Gets the number of workers to use when we want to keep every core busy, one less than the number
+	/// of hardware threads so that the main thread gets a core to itself
+	/// </summary>
+	static uint32_t GetDefaultThreadCount();
+
+protected:
+	std::mutex              _mutex;
+	// Signalled when a job is queued, or when we are shutting down
+	std::condition_variable _jobReady;
+	// Signalled when the last running job finishes
+	std::condition_variable _idle;
+	std::deque<Job>         _jobs;
+	// The number of jobs that have been taken from the queue but haven't finished yet
+	uint32_t                _running;
+	bool                    _stopping;
+
+	std::vector<std::thread> _workers;
+
+	/// <summary>
+	/// The loop for each of our worker threads
+	/// </summary>
+	void _Run();
+};
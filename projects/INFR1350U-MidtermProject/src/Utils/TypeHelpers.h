@@ -8,7 +8,23 @@ namespace detail {
 	static auto test_json(int)->sfinae_true<decltype(std::declval<T>().FromJson(std::declval<A0>()))>;
 	template<class, class A0>
 	static auto test_json(long)->std::false_type;
+
+	template<class T, class A0>
+	static auto test_decode_json(int)->sfinae_true<decltype(std::declval<T>().DecodeJson(std::declval<A0>()))>;
+	template<class, class A0>
+	static auto test_decode_json(long)->std::false_type;
+
+	template<class T, class A0>
+	static auto test_json_dependencies(int)->sfinae_true<decltype(std::declval<T>().GetJsonDependencies(std::declval<A0>()))>;
+	template<class, class A0>
+	static auto test_json_dependencies(long)->std::false_type;
 } // detail::
 
 template<class T, class Arg>
-struct test_json : decltype(detail::test_json<T, Arg>(0)){};
\ No newline at end of file
+struct test_json : decltype(detail::test_json<T, Arg>(0)){};
+
+template<class T, class Arg>
+struct test_decode_json : decltype(detail::test_decode_json<T, Arg>(0)){};
+
+template<class T, class Arg>
+struct test_json_dependencies : decltype(detail::test_json_dependencies<T, Arg>(0)){};
\ No newline at end of file
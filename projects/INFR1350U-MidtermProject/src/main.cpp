@@ -26,7 +26,17 @@
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/Shader.h"
 #include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DArray.h"
 #include "Graphics/VertexTypes.h"
+#include "Graphics/GlStateCache.h"
+#include "Graphics/ShaderBinaryCache.h"
+#include "Graphics/MeshBinaryCache.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/ShaderReloader.h"
+#include "Graphics/DebugDraw.h"
+#include "Graphics/GpuProfiler.h"
+#include "Graphics/Framebuffer.h"
+#include "Graphics/GeometryArena.h"
 
 // Utilities
 #include "Utils/MeshBuilder.h"
@@ -35,6 +45,7 @@
 #include "Utils/ImGuiHelper.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/FileHelpers.h"
+#include "Utils/AssetArchive.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
 #include "Utils/GlmDefines.h"
@@ -43,6 +54,9 @@
 #include "Gameplay/Material.h"
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Scene.h"
+#include "Gameplay/SceneRenderer.h"
+#include "Gameplay/RenderThread.h"
+#include "Gameplay/TableRails.h"
 
 // Components
 #include "Gameplay/Components/IComponent.h"
@@ -64,6 +78,16 @@
 // BounceBehaviour
 #include "BounceBehaviour.h"
 
+// Benchmarks
+#include "Benchmarks/Benchmark.h"
+#include "Benchmarks/CullingBenchmark.h"
+#include "Benchmarks/ClusterBenchmark.h"
+#include "Benchmarks/PhysicsDebugBenchmark.h"
+#include "Benchmarks/ObjLoaderBenchmark.h"
+#include "Benchmarks/MeshOptimizerBenchmark.h"
+#include "Benchmarks/VertexFormatBenchmark.h"
+#include "Benchmarks/ManifestLoadBenchmark.h"
+
 //#define LOG_GL_NOTIFICATIONS
 
 /*
@@ -107,6 +131,51 @@ glm::ivec2 windowSize = glm::ivec2(1920, 1080);
 // The title of our GLFW window
 std::string windowTitle = "INFR1350U-Midterm-Airhockey-Jeffrey&Justin";
 
+/// <summary>
+/// Options for hidden-window offscreen rendering (ex: benchmarks, or capturing frames), set from the command line:
+///     --offscreen [--resolution WIDTHxHEIGHT] [--frames N] [--dump DIRECTORY] [--dump-every N]
+///
+/// This is not a true headless mode, the context still comes from a GLFW window with the platform's native API
+/// (WGL on Windows), it just isn't shown. It needs a desktop session or display like any other run
+/// </summary>
+struct OffscreenOptions {
+	bool        Enabled = false;
+	// The number of frames to render before exiting, or 0 to run until the process is killed
+	int         FrameCount = 600;
+	// If not empty, frames are written to this directory as PNGs
+	std::string DumpDirectory = "";
+	int         DumpInterval = 1;
+};
+OffscreenOptions offscreen;
+// When rendering offscreen, we render into this instead of the window
+Framebuffer::Sptr offscreenTarget = nullptr;
+
+/// <summary>
+/// Reads the offscreen options from the command line
+/// </summary>
+void parseOffscreenOptions(int argc, char** argv) {
+	for (int ix = 1; ix < argc; ix++) {
+		std::string arg = argv[ix];
+		bool hasValue = ix + 1 < argc;
+		if (arg == "--offscreen") {
+			offscreen.Enabled = true;
+		} else if (arg == "--resolution" && hasValue) {
+			int width = 0, height = 0;
+			if (sscanf(argv[++ix], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+				windowSize = glm::ivec2(width, height);
+			} else {
+				LOG_WARN("Invalid resolution \"{}\", expected WIDTHxHEIGHT", argv[ix]);
+			}
+		} else if (arg == "--frames" && hasValue) {
+			offscreen.FrameCount = std::max(atoi(argv[++ix]), 0);
+		} else if (arg == "--dump" && hasValue) {
+			offscreen.DumpDirectory = argv[++ix];
+		} else if (arg == "--dump-every" && hasValue) {
+			offscreen.DumpInterval = std::max(atoi(argv[++ix]), 1);
+		}
+	}
+}
+
 
 // using namespace should generally be avoided, and if used, make sure it's ONLY in cpp files
 using namespace Gameplay;
@@ -116,13 +185,70 @@ using namespace Gameplay::Physics;
 Scene::Sptr scene = nullptr;
 
 void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
+	RenderThread::Enqueue([width, height]() { glViewport(0, 0, width, height); });
 	windowSize = glm::ivec2(width, height);
 	if (windowSize.x * windowSize.y > 0) {
 		scene->MainCamera->ResizeWindow(width, height);
 	}
 }
 
+/// <summary>
+/// Sets up the back buffer for a new frame, runs on the render thread if there is one
+/// </summary>
+void beginRenderFrame() {
+	GlStateCache::NewFrame();
+	GpuProfiler::BeginFrame();
+
+	// Everything from here on draws into our offscreen target when there is one
+	if (offscreenTarget != nullptr) {
+		offscreenTarget->Bind();
+	}
+
+	// Clear the color and depth buffers
+	GpuProfiler::BeginPass("Clear");
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	GpuProfiler::EndPass();
+}
+
+/// <summary>
+/// Draws a frame that the simulation has captured and presents it, runs on the render thread if there is one
+/// </summary>
+/// <param name="packet">The scene data for the frame</param>
+/// <param name="uiDrawData">The ImGui draw data for the frame</param>
+void renderFrame(RenderPacket& packet, ImDrawData* uiDrawData) {
+	// Render all our visible objects
+	GpuProfiler::BeginPass("Scene");
+	SceneRenderer::Render(packet);
+	GpuProfiler::EndPass();
+
+	// The physics debug view that the simulation captured for this frame, if debug drawing is on
+	if (!packet.PhysicsDebug.IsEmpty()) {
+		GpuProfiler::BeginPass("Physics Debug");
+		packet.SourceScene->GetPhysicsDebugCache()->Render(packet.PhysicsDebug, packet.ViewProjection);
+		GpuProfiler::EndPass();
+	}
+
+	VertexArrayObject::Unbind();
+
+	GpuProfiler::BeginPass("ImGui");
+	ImGuiHelper::RenderDrawData(uiDrawData);
+	GpuProfiler::EndPass();
+
+	GpuProfiler::EndFrame();
+
+	if (offscreenTarget != nullptr) {
+		// Reading the frame back stalls until the GPU is done with it, so dumping will lower our throughput
+		if (!offscreen.DumpDirectory.empty() && packet.Frame % offscreen.DumpInterval == 0) {
+			char fileName[32];
+			snprintf(fileName, sizeof(fileName), "frame_%05d.png", (int)packet.Frame);
+			offscreenTarget->SaveToFile((std::filesystem::path(offscreen.DumpDirectory) / fileName).string());
+		}
+		Framebuffer::Unbind();
+	} else {
+		glfwSwapBuffers(window);
+	}
+}
+
 /// <summary>
 /// Handles intializing GLFW, should be called before initGLAD, but after Logger::Init()
 /// Also handles creating the GLFW window
@@ -135,9 +261,24 @@ bool initGLFW() {
 		return false;
 	}
 
+	// When rendering offscreen, GLFW still owns our context through a window, but the window is never shown
+	// and we render into our own framebuffer instead of it's swap chain
+	if (offscreen.Enabled) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	//Create a new GLFW window and make it current
 	window = glfwCreateWindow(windowSize.x, windowSize.y, windowTitle.c_str(), nullptr, nullptr);
+	if (window == nullptr) {
+		LOG_ERROR("Failed to create GLFW window");
+		return false;
+	}
 	glfwMakeContextCurrent(window);
+
+	// We want to render frames back to back when rendering offscreen, not wait on vsync
+	if (offscreen.Enabled) {
+		glfwSwapInterval(0);
+	}
 	
 	// Set our window resized callback
 	glfwSetWindowSizeCallback(window, GlfwWindowResizedCallback);
@@ -176,10 +317,13 @@ bool DrawSaveLoadImGui(Scene::Sptr& scene, std::string& path) {
 	ImGui::SameLine();
 	// Load scene from file button
 	if (ImGui::Button("Load")) {
-		// Since it's a reference to a ptr, this will
-		// overwrite the existing scene!
-		scene = nullptr;
-		scene = Scene::Load(path);
+		// The old scene has to be destroyed and the new one loaded with the GL context
+		RenderThread::Execute([&]() {
+			// Since it's a reference to a ptr, this will
+			// overwrite the existing scene!
+			scene = nullptr;
+			scene = Scene::Load(path);
+		});
 
 		return true;
 	}
@@ -193,20 +337,17 @@ bool DrawSaveLoadImGui(Scene::Sptr& scene, std::string& path) {
 /// <param name="light">The light to modify</param>
 /// <returns>True if the parameters have changed, false if otherwise</returns>
 bool DrawLightImGui(const Scene::Sptr& scene, const char* title, int ix) {
-	bool isEdited = false;
 	bool result = false;
 	Light& light = scene->Lights[ix];
 	ImGui::PushID(&light); // We can also use pointers as numbers for unique IDs
 	if (ImGui::CollapsingHeader(title)) {
-		isEdited |= ImGui::DragFloat3("Pos", &light.Position.x, 0.01f);
-		isEdited |= ImGui::ColorEdit3("Col", &light.Color.r);
-		isEdited |= ImGui::DragFloat("Range", &light.Range, 0.1f);
+		// The renderer uploads the lights every frame, so edits will show up right away
+		ImGui::DragFloat3("Pos", &light.Position.x, 0.01f);
+		ImGui::ColorEdit3("Col", &light.Color.r);
+		ImGui::DragFloat("Range", &light.Range, 0.1f);
 
 		result = ImGui::Button("Delete");
 	}
-	if (isEdited) {
-		scene->SetShaderLight(ix);
-	}
 
 	ImGui::PopID();
 	return result;
@@ -233,11 +374,49 @@ int rScore = -1;
 bool resetCheck = false;
 bool isWin = false;
 
-int main() {
+int main(int argc, char** argv) {
 //// Initialize ////
 	#pragma region GeneralInitialize
 	Logger::Init(); // We'll borrow the logger from the toolkit, but we need to initialize it
 
+	// Register our benchmarks, if one was requested on the command line we run it instead of the game
+	Benchmark::Register("culling", "Frustum culling of random objects (sphere, SSE, AABB, BVH), no GL needed", CullingBenchmark::Run);
+	Benchmark::Register("clusters", "Binning random lights into a clustered light grid (scalar, SSE, threaded), no GL needed", ClusterBenchmark::Run);
+	Benchmark::Register("physics-debug", "Drawing the 12 rail triggers with debugDrawWorld vs the cached wireframes, no GL needed", PhysicsDebugBenchmark::Run);
+	Benchmark::Register("obj-loader", "Loading a large synthetic OBJ with the ObjLoader vs the OptimizedObjLoader, no GL needed", ObjLoaderBenchmark::Run);
+	Benchmark::Register("mesh-optimizer", "Vertex cache, overdraw and vertex fetch ordering, reporting ACMR from a simulated FIFO cache, no GL needed", MeshOptimizerBenchmark::Run);
+	Benchmark::Register("vertex-formats", "Encoding error, VBO memory and vertex fetch bandwidth of the packed vertex formats on the table and rails, no GL needed", VertexFormatBenchmark::Run);
+	Benchmark::Register("manifest-load", "Loading a manifest of the project's assets on the main thread vs decoding on worker threads", ManifestLoadBenchmark::Run, true);
+	if (Benchmark::IsRequested(argc, argv) && !Benchmark::RequiresContext(argc, argv)) {
+		return Benchmark::Run(argc, argv);
+	}
+	parseOffscreenOptions(argc, argv);
+	// Benchmarks that need OpenGL get a hidden window, they're run once everything is initialized
+	if (Benchmark::IsRequested(argc, argv)) {
+		offscreen.Enabled = true;
+	}
+
+	// Whether GL submission should run on it's own thread, see RenderThread
+	bool useRenderThread = false;
+	// Whether textures should load in the background, see TextureStreamer
+	bool streamTextures = false;
+	// The packed resources to load from, see AssetArchive. Loose files are used if it doesn't exist
+	std::string archivePath = "assets.pak";
+	for (int ix = 1; ix < argc; ix++) {
+		if (strcmp(argv[ix], "--render-thread") == 0) {
+			useRenderThread = true;
+		} else if (strcmp(argv[ix], "--stream-textures") == 0) {
+			streamTextures = true;
+		} else if (strcmp(argv[ix], "--archive") == 0 && ix + 1 < argc) {
+			archivePath = argv[++ix];
+		} else if (strcmp(argv[ix], "--no-archive") == 0) {
+			archivePath = "";
+		}
+	}
+	if (!archivePath.empty() && std::filesystem::exists(archivePath)) {
+		AssetArchive::Mount(archivePath);
+	}
+
 	//Initialize GLFW
 	if (!initGLFW())
 		return 1;
@@ -257,8 +436,20 @@ int main() {
 	// Initialize our resource manager
 	ResourceManager::Init();
 
+	// Linked shaders get cached on disk, so only the first launch needs to compile them
+	ShaderBinaryCache::Init();
+	// Shaders get reloaded whenever their files change, so we can edit them without restarting
+	ShaderReloader::Init();
+	// Times the passes of our frame on the GPU and CPU, shown in the debugging window
+	GpuProfiler::Init();
+	// Textures show a placeholder until they've been decoded and uploaded in the background
+	if (streamTextures) {
+		TextureStreamer::Init();
+	}
+
 	// Register all our resource types so we can load them from manifest files
 	ResourceManager::RegisterType<Texture2D>();
+	ResourceManager::RegisterType<Texture2DArray>();
 	ResourceManager::RegisterType<Material>();
 	ResourceManager::RegisterType<MeshResource>();
 	ResourceManager::RegisterType<Shader>();
@@ -272,12 +463,28 @@ int main() {
 	ComponentManager::RegisterType<JumpBehaviour>();
 	ComponentManager::RegisterType<MaterialSwapBehaviour>();
 	ComponentManager::RegisterType<BounceBehaviour>();
+
+	if (Benchmark::IsRequested(argc, argv)) {
+		int result = Benchmark::Run(argc, argv);
+		ShaderReloader::Cleanup();
+		TextureStreamer::Cleanup();
+		GpuProfiler::Cleanup();
+		ImGuiHelper::Cleanup();
+		ResourceManager::Cleanup();
+		GeometryArena::Cleanup();
+		AssetArchive::Unmount();
+		Logger::Uninitialize();
+		return result;
+	}
 	#pragma endregion
 
 	// GL states, we'll enable depth testing and backface fulling
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	// These go through the state cache so it knows what the pipeline looks like
+	GlStateCache::SetDepthTest(true);
+	GlStateCache::SetDepthFunc(DepthFunc::Less);
+	GlStateCache::SetDepthWrite(true);
+	GlStateCache::SetCulling(true);
+	GlStateCache::SetCullMode(CullMode::Back);
 	glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
 
 	bool loadScene = false;
@@ -306,10 +513,10 @@ int main() {
 		Texture2D::Sptr    monkeyTex  = ResourceManager::CreateAsset<Texture2D>("textures/monkey-uvMap.png");
 		
 		//// Table
-		MeshResource::Sptr mesh_table = ResourceManager::CreateAsset<MeshResource>("gObj_table/table.obj");
+		// The table and rails only need positions, normals and UVs, so they use the packed vertex format (20 bytes instead of 48)
+		MeshResource::Sptr mesh_table = ResourceManager::CreateAsset<MeshResource>("gObj_table/table.obj", MeshVertexFormat::Packed);
 		MeshResource::Sptr mesh_table_plane = ResourceManager::CreateAsset<MeshResource>("gObj_table/table_plane.obj");
 		Texture2D::Sptr tex_table = ResourceManager::CreateAsset<Texture2D>("gObj_table/tex_table.png");
-		Texture2D::Sptr tex_white = ResourceManager::CreateAsset<Texture2D>("gObj_table/blankTexture.jpg");
 
 		//// Puck
 		MeshResource::Sptr mesh_puck = ResourceManager::CreateAsset<MeshResource>("gObj_puck/puck.obj");
@@ -318,22 +525,18 @@ int main() {
 		//// Paddle
 		MeshResource::Sptr mesh_paddle = ResourceManager::CreateAsset<MeshResource>("gObj_paddle/paddle.obj");
 		MeshResource::Sptr mesh_paddle2 = ResourceManager::CreateAsset<MeshResource>("gObj_paddle/paddle.obj");
-		Texture2D::Sptr tex_paddle_red = ResourceManager::CreateAsset<Texture2D>("gObj_paddle/Red.jpg");
-		Texture2D::Sptr tex_paddle_blue = ResourceManager::CreateAsset<Texture2D>("gObj_paddle/Blue.jpg");
+
+		//// Solid colors
+		// These are all a single color, so they're packed into one small texture array instead of loading each as a
+		// full size texture, and the materials using them can share a multi-draw
+		Texture2DArray::Sptr tex_solid_colors = ResourceManager::CreateAsset<Texture2DArray>(std::vector<std::string>{
+			"gObj_table/blankTexture.jpg",
+			"gObj_paddle/Red.jpg",
+			"gObj_paddle/Blue.jpg"
+		});
 
 		//// Edge
-		MeshResource::Sptr mesh_edge1 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge2 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge3 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge4 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge5 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge6 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge7 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge8 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge9 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge10 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge11 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
-		MeshResource::Sptr mesh_edge12 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj");
+		MeshResource::Sptr mesh_edge = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edge_uni.obj", MeshVertexFormat::Packed);
 
 		MeshResource::Sptr mesh_edgeS1 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edgeS1.obj");
 		MeshResource::Sptr mesh_edgeS2 = ResourceManager::CreateAsset<MeshResource>("gObj_edge/edgeS2.obj");
@@ -360,7 +563,8 @@ int main() {
 		{
 			material_white->Name = "White";
 			material_white->MatShader = scene->BaseShader;
-			material_white->Texture = tex_white;
+			material_white->TextureArray = tex_solid_colors;
+			material_white->TextureLayer = tex_solid_colors->GetLayer("gObj_table/blankTexture.jpg");
 			material_white->Shininess = 2.0f;
 		}
 
@@ -388,7 +592,8 @@ int main() {
 		{
 			material_paddle->Name = "Paddle";
 			material_paddle->MatShader = scene->BaseShader;
-			material_paddle->Texture = tex_paddle_red;
+			material_paddle->TextureArray = tex_solid_colors;
+			material_paddle->TextureLayer = tex_solid_colors->GetLayer("gObj_paddle/Red.jpg");
 			material_paddle->Shininess = 256.0f;
 		}
 
@@ -396,7 +601,8 @@ int main() {
 		{
 			material_paddle2->Name = "Paddle2";
 			material_paddle2->MatShader = scene->BaseShader;
-			material_paddle2->Texture = tex_paddle_blue;
+			material_paddle2->TextureArray = tex_solid_colors;
+			material_paddle2->TextureLayer = tex_solid_colors->GetLayer("gObj_paddle/Blue.jpg");
 			material_paddle2->Shininess = 256.0f;
 		}
 
@@ -547,189 +753,40 @@ int main() {
 		}
 		//// Edge
 		#pragma region 12 Edges
-		GameObject::Sptr gObj_edge1 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge1->GUID);
-			gObj_edge1->SetPostion(glm::vec3(-17.230f, 5.540f, -8.02f));
-			gObj_edge1->SetRotation(glm::vec3(0.0f, 0.0f, -93.5f));
-			gObj_edge1->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge1->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge1);
-			renderer->SetMaterial(material_white);
-
-			//TriggerVolume::Sptr volume = gObj_edge1->Add<TriggerVolume>();
-			BounceBehaviour::Sptr bounce = gObj_edge1->Add<BounceBehaviour>();
-			TriggerVolume::Sptr volume = bounce->AddComponent<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge2 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge2->GUID);
-			gObj_edge2->SetPostion(glm::vec3(-17.230f, -5.540f, -8.02f));
-			gObj_edge2->SetRotation(glm::vec3(0.0f, 0.0f, -86.5f));
-			gObj_edge2->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge2->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge2);
+		// The rails all share one mesh, their layout is in TableRails.h so the benchmarks can build the same table
+		for (size_t ix = 0; ix < std::size(TABLE_RAILS); ix++) {
+			const TableRail& rail = TABLE_RAILS[ix];
+			GameObject::Sptr gObj_edge = scene->CreateGameObject("Edge");
+			edgeID.push_back(gObj_edge->GUID);
+			gObj_edge->SetPostion(rail.Position);
+			gObj_edge->SetRotation(glm::vec3(0.0f, 0.0f, rail.Rotation));
+			gObj_edge->SetScale(glm::vec3(rail.Length, 1.0f, 1.0f));
+			RenderComponent::Sptr renderer = gObj_edge->Add<RenderComponent>();
+			renderer->SetMesh(mesh_edge);
 			renderer->SetMaterial(material_white);
 
-			TriggerVolume::Sptr volume = gObj_edge2->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge3 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge3->GUID);
-			gObj_edge3->SetPostion(glm::vec3(-12.790f, 11.280f, -8.02f));
-			gObj_edge3->SetRotation(glm::vec3(0.0f, 0.0f, -147.1));
-			gObj_edge3->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge3->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge3);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge3->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge4 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge4->GUID);
-			gObj_edge4->SetPostion(glm::vec3(-12.790f, -11.280f, -8.02f));
-			gObj_edge4->SetRotation(glm::vec3(0.0f, 0.0f, -32.9f));
-			gObj_edge4->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge4->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge4);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge4->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge5 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge5->GUID);
-			gObj_edge5->SetPostion(glm::vec3(-4.210f, 12.800f, -8.02f));
-			gObj_edge5->SetRotation(glm::vec3(0.0f, 0.0f, 163.7f));
-			gObj_edge5->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge5->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge5);
-			renderer->SetMaterial(material_white);
-			
-
-			TriggerVolume::Sptr volume = gObj_edge5->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge6 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge6->GUID);
-			gObj_edge6->SetPostion(glm::vec3(-4.210f, -12.800f, -8.02f));
-			gObj_edge6->SetRotation(glm::vec3(0.0f, 0.0f, 16.3f));
-			gObj_edge6->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge6->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge6);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge6->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge7 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge7->GUID);
-			gObj_edge7->SetPostion(glm::vec3(4.210f, 12.800f, -8.02f));
-			gObj_edge7->SetRotation(glm::vec3(0.0f, 0.0f, -163.7f));
-			gObj_edge7->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge7->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge7);
-			renderer->SetMaterial(material_white);
-			
-
-			TriggerVolume::Sptr volume = gObj_edge7->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge8 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge8->GUID);
-			gObj_edge8->SetPostion(glm::vec3(4.210f, -12.800f, -8.02f));
-			gObj_edge8->SetRotation(glm::vec3(0.0f, 0.0f, -16.3f));
-			gObj_edge8->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge8->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge8);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge8->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(4.430f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge9 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge9->GUID);
-			gObj_edge9->SetPostion(glm::vec3(12.790f, 11.280f, -8.02f));
-			gObj_edge9->SetRotation(glm::vec3(0.0f, 0.0f, 147.1f));
-			gObj_edge9->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge9->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge9);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge9->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge10 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge10->GUID);
-			gObj_edge10->SetPostion(glm::vec3(12.790f, -11.280f, -8.02f));
-			gObj_edge10->SetRotation(glm::vec3(0.0f, 0.0f, 32.9f));
-			gObj_edge10->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge10->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge10);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge10->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(5.080f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge11 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge11->GUID);
-			gObj_edge11->SetPostion(glm::vec3(17.230f, 5.540f, -8.02f));
-			gObj_edge11->SetRotation(glm::vec3(0.0f, 0.0f, 93.5f));
-			gObj_edge11->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge11->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge11);
-			renderer->SetMaterial(material_white);
-			
-			TriggerVolume::Sptr volume = gObj_edge11->Add<TriggerVolume>();
-			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-		}
-		GameObject::Sptr gObj_edge12 = scene->CreateGameObject("Edge");
-		{
-			edgeID.push_back(gObj_edge12->GUID);
-			gObj_edge12->SetPostion(glm::vec3(17.230f, -5.540f, -8.02f));
-			gObj_edge12->SetRotation(glm::vec3(0.0f, 0.0f, 86.5f));
-			gObj_edge12->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
-			RenderComponent::Sptr renderer = gObj_edge12->Add<RenderComponent>();
-			renderer->SetMesh(mesh_edge12);
-			renderer->SetMaterial(material_white);
-
-			TriggerVolume::Sptr volume = gObj_edge12->Add<TriggerVolume>();
+			// Only the first rail has the bounce behaviour, which adds it's own trigger
+			TriggerVolume::Sptr volume;
+			if (ix == 0) {
+				BounceBehaviour::Sptr bounce = gObj_edge->Add<BounceBehaviour>();
+				volume = bounce->AddComponent<TriggerVolume>();
+			} else {
+				volume = gObj_edge->Add<TriggerVolume>();
+			}
 			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
-			collider->SetScale(glm::vec3(2.980f, 1.0f, 1.0f));
+			collider->SetScale(glm::vec3(rail.Length, 1.0f, 1.0f));
 		}
 
-		
-
 		#pragma endregion
 
 		 
 
 		//// Edge Skin
+		// The skins and mask never move and share a material, so we flag them as static to merge them into one draw
 		GameObject::Sptr gObj_edgeS1 = scene->CreateGameObject("Edge_skin1");
 		{
 			gObj_edgeS1->SetPostion(glm::vec3(0.0f, 0.0f, -8.0f));
+			gObj_edgeS1->IsStatic = true;
 
 			RenderComponent::Sptr renderer = gObj_edgeS1->Add<RenderComponent>();
 			renderer->SetMesh(mesh_edgeS1);
@@ -738,6 +795,7 @@ int main() {
 		GameObject::Sptr gObj_edgeS2 = scene->CreateGameObject("Edge_skin2");
 		{
 			gObj_edgeS2->SetPostion(glm::vec3(0.0f, 0.0f, -8.0f));
+			gObj_edgeS2->IsStatic = true;
 
 			RenderComponent::Sptr renderer = gObj_edgeS2->Add<RenderComponent>();
 			renderer->SetMesh(mesh_edgeS2);
@@ -746,6 +804,7 @@ int main() {
 		GameObject::Sptr gObj_edgeS3 = scene->CreateGameObject("Edge_skin3");
 		{
 			gObj_edgeS3->SetPostion(glm::vec3(0.0f, 0.0f, -8.0f));
+			gObj_edgeS3->IsStatic = true;
 
 			RenderComponent::Sptr renderer = gObj_edgeS3->Add<RenderComponent>();
 			renderer->SetMesh(mesh_edgeS3);
@@ -754,6 +813,7 @@ int main() {
 		GameObject::Sptr gObj_edgeS4 = scene->CreateGameObject("Edge_skin4");
 		{
 			gObj_edgeS4->SetPostion(glm::vec3(0.0f, 0.0f, -8.0f));
+			gObj_edgeS4->IsStatic = true;
 
 			RenderComponent::Sptr renderer = gObj_edgeS4->Add<RenderComponent>();
 			renderer->SetMesh(mesh_edgeS4);
@@ -766,6 +826,7 @@ int main() {
 		GameObject::Sptr gObj_edgeMask = scene->CreateGameObject("Edge_mask");
 		{
 			gObj_edgeMask->SetPostion(glm::vec3(0.0f, 0.0f, -8.0f));
+			gObj_edgeMask->IsStatic = true;
 
 			RenderComponent::Sptr renderer = gObj_edgeMask->Add<RenderComponent>();
 			renderer->SetMesh(mesh_edgeMask);
@@ -787,6 +848,33 @@ int main() {
 	scene->Window = window;
 	scene->Awake();
 
+	// Hidden windows may not get the size we asked for, so make sure the camera matches our render target
+	if (offscreen.Enabled) {
+		offscreenTarget = Framebuffer::Create(windowSize.x, windowSize.y);
+		if (!offscreen.DumpDirectory.empty()) {
+			std::filesystem::create_directories(offscreen.DumpDirectory);
+		}
+		scene->MainCamera->ResizeWindow(windowSize.x, windowSize.y);
+		LOG_INFO("Rendering offscreen (hidden window) at {}x{} for {} frames", windowSize.x, windowSize.y, offscreen.FrameCount);
+	}
+
+	// Log how long our shaders and meshes took to load, so we can compare cold and warm starts
+	ShaderBinaryCache::LogStats();
+	MeshBinaryCache::LogStats();
+	ResourceManager::LogStats();
+	AssetArchive::LogStats();
+
+	// The debug drawer creates it's buffers and shader the first time it's used, so that has to happen while we still own the context
+	DebugDrawer::Get();
+
+	// From here on, the render thread owns the GL context
+	if (useRenderThread) {
+		ImGuiHelper::DisableViewports();
+		RenderThread::Start(window, beginRenderFrame, [](RenderPacket& packet) {
+			renderFrame(packet, packet.UiDrawData.GetDrawData());
+		});
+	}
+
 	// We'll use this to allow editing the save/load path
 	// via ImGui, note the reserve to allocate extra space
 	// for input!
@@ -809,11 +897,23 @@ int main() {
 	
 	float countDown = 2;
 
+	// Used to report our throughput when rendering offscreen
+	int frameIndex = 0;
+	double offscreenStart = glfwGetTime();
+
 ///// Game loop /////
 #pragma region Game Loop
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
 		ImGuiHelper::StartFrame();
+		// The render thread starts it's frames as soon as it's done with the last one
+		if (!RenderThread::IsRunning()) {
+			beginRenderFrame();
+		}
+		// Swap in any shaders that have been edited and finished compiling
+		RenderThread::Enqueue([]() { ShaderReloader::Update(); });
+		// Copy the next part of any textures that are streaming in, and swap in any that are done
+		RenderThread::Enqueue([]() { TextureStreamer::Update(); });
 		
 		// modify position of these two.... - Justin Lee: "seems location not matter much, so I just place it here."
 		checkIsReseting();
@@ -841,12 +941,15 @@ int main() {
 
 				// If we've gone from playing to not playing, restore the state from before we started playing
 				if (!scene->IsPlaying) {
-					scene = nullptr;
-					// We reload to scene from our cached state
-					scene = Scene::FromJson(editorSceneState);
-					// Don't forget to reset the scene's window and wake all the objects!
-					scene->Window = window;
-					scene->Awake();
+					// Destroying and waking scenes creates and deletes GL objects
+					RenderThread::Execute([&]() {
+						scene = nullptr;
+						// We reload to scene from our cached state
+						scene = Scene::FromJson(editorSceneState);
+						// Don't forget to reset the scene's window and wake all the objects!
+						scene->Window = window;
+						scene->Awake();
+					});
 				}
 			}
 
@@ -860,7 +963,7 @@ int main() {
 				// We have loaded a new scene, call awake to set
 				// up all our components
 				scene->Window = window;
-				scene->Awake();
+				RenderThread::Execute([&]() { scene->Awake(); });
 			}
 			ImGui::Separator();
 			// Draw a dropdown to select our physics debug draw mode
@@ -869,11 +972,25 @@ int main() {
 			}
 			LABEL_LEFT(ImGui::SliderFloat, "Playback Speed:    ", &playbackSpeed, 0.0f, 10.0f);
 			ImGui::Separator();
+			// Show how many GL calls the state cache issued vs skipped last frame
+			if (ImGui::CollapsingHeader("GL State Calls")) {
+				GlStateCache::DrawStatsGui();
+			}
+			if (ImGui::CollapsingHeader("Renderer")) {
+				SceneRenderer::RenderImGui();
+				scene->GetStaticBatcher()->RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("Physics Debug Draw")) {
+				scene->GetPhysicsDebugCache()->RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("GPU Profiler")) {
+				GpuProfiler::RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("Render Thread")) {
+				RenderThread::RenderImGui();
+			}
 		}
 
-		// Clear the color and depth buffers
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
 		// Update our application level uniforms every frame
 
 		// Draw some ImGui stuff for the lights
@@ -922,35 +1039,6 @@ int main() {
 			scene->DrawAllGameObjectGUIs();
 		}
 
-		// The current material that is bound for rendering
-		Material::Sptr currentMat = nullptr;
-		Shader::Sptr shader = nullptr;
-
-		// Render all our objects
-		ComponentManager::Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
-
-			// If the material has changed, we need to bind the new shader and set up our material and frame data
-			// Note: This is a good reason why we should be sorting the render components in ComponentManager
-			if (renderable->GetMaterial() != currentMat) {
-				currentMat = renderable->GetMaterial();
-				shader = currentMat->MatShader;
-
-				shader->Bind();
-				shader->SetUniform("u_CamPos", scene->MainCamera->GetGameObject()->GetPosition());
-				currentMat->Apply();
-			}
-			
-
-			// Grab the game object so we can do some stuff with it
-			GameObject* object = renderable->GetGameObject();
-
-			// Set vertex shader parameters
-			shader->SetUniformMatrix("u_ModelViewProjection", viewProj * object->GetTransform());
-			shader->SetUniformMatrix("u_Model", object->GetTransform());
-			shader->SetUniformMatrix("u_NormalMatrix", glm::mat3(glm::transpose(glm::inverse(object->GetTransform()))));
-			// Draw the object
-			renderable->GetMesh()->Draw();
-		});
 		
 
 		/// <summary>
@@ -1107,27 +1195,69 @@ int main() {
 
 		// End our ImGui window
 		ImGui::End();
-		
-		VertexArrayObject::Unbind();
 
 		lastFrame = thisFrame;
 
-		ImGuiHelper::EndFrame();
+		// Capture everything we need to draw this frame
+		RenderPacket& packet = RenderThread::GetWritePacket();
+		packet.Frame = frameIndex;
+		SceneRenderer::Gather(scene, packet);
+		ImDrawData* uiDrawData = ImGuiHelper::Render();
+
+		if (RenderThread::IsRunning()) {
+			// ImGui will re-use it's draw lists for our next frame, so the render thread gets a copy
+			packet.UiDrawData.Capture(uiDrawData);
+			RenderThread::Submit();
+		} else {
+			renderFrame(packet, uiDrawData);
+			packet.Reset();
+			ImGuiHelper::UpdateViewports();
+		}
 
-		glfwSwapBuffers(window);
+		frameIndex++;
+		if (offscreen.Enabled && offscreen.FrameCount > 0 && frameIndex >= offscreen.FrameCount) {
+			break;
+		}
 		
 	}
 
+	// Draw anything that's still in flight and take our GL context back
+	RenderThread::Stop();
+
+	if (offscreen.Enabled) {
+		double elapsed = glfwGetTime() - offscreenStart;
+		LOG_INFO("Rendered {} frames in {:.2f}s ({:.3f}ms per frame, {:.1f} FPS)",
+			frameIndex, elapsed, frameIndex > 0 ? elapsed * 1000.0 / frameIndex : 0.0, elapsed > 0.0 ? frameIndex / elapsed : 0.0);
+	}
+
 	
 //// ENDREGION
 #pragma endregion
 
+	// Stop watching our shader files
+	ShaderReloader::Cleanup();
+
+	// Drop any textures that are still streaming in
+	TextureStreamer::Cleanup();
+
+	// Release our timer queries
+	GpuProfiler::Cleanup();
+
 	// Clean up the ImGui library
 	ImGuiHelper::Cleanup();
 
+	// Release the scene, so it's meshes are freed while we still have a GL context
+	scene = nullptr;
+
 	// Clean up the resource manager
 	ResourceManager::Cleanup();
 
+	// Release the shared geometry arenas, now that the meshes allocated in them are gone
+	GeometryArena::Cleanup();
+
+	// Release the mapping of our packed resources
+	AssetArchive::Unmount();
+
 	// Clean up the toolkit logger so we don't leak memory
 	Logger::Uninitialize();
 	return 0;
@@ -0,0 +1,293 @@
+// Packs a resource folder into a single asset archive (.pak) that the game can memory map, see AssetArchive
+//
+// Usage:
+//     AssetPacker <resource folder> <output archive> [--compress] [--level 0-9] [--min-saving PERCENT] [--exclude .ext]...
+//     AssetPacker --list <archive>
+//
+// Blender source files (.blend, .blend1) and the game's mesh sidecars (.mesh) are left out by default
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "Utils/AssetArchiveFormat.h"
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Settings from the command line
+/// </summary>
+struct PackOptions {
+	fs::path                 Root;
+	fs::path                 Output;
+	bool                     Compress = false;
+	int                      Level = Z_BEST_COMPRESSION;
+	// A compressed entry is only kept if it's at least this much smaller (ex: PNGs and JPGs almost never are)
+	float                    MinSaving = 0.1f;
+	std::vector<std::string> Excluded = { ".blend", ".blend1", ".mesh", ".pak" };
+};
+
+/// <summary>
+/// A file that will go in the archive
+/// </summary>
+struct PackEntry {
+	std::string       Name;
+	std::vector<char> Contents;
+	// Only filled in if the entry will be stored compressed
+	std::vector<char> Compressed;
+	uint32_t          Checksum = 0;
+};
+
+static std::string ToLower(std::string value) {
+	std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return value;
+}
+
+static bool ReadContents(const fs::path& path, std::vector<char>& outContents) {
+	std::ifstream in(path, std::ios::in | std::ios::binary);
+	if (!in) {
+		return false;
+	}
+	in.seekg(0, std::ios::end);
+	std::streamoff size = in.tellg();
+	if (size < 0) {
+		return false;
+	}
+	outContents.resize((size_t)size);
+	in.seekg(0, std::ios::beg);
+	in.read(outContents.data(), size);
+	return (bool)in || size == 0;
+}
+
+static void WritePadding(std::ofstream& out, uint64_t& offset) {
+	static const char padding[ASSET_ARCHIVE_ALIGNMENT] = { 0 };
+	uint64_t aligned = AlignArchiveOffset(offset);
+	out.write(padding, (std::streamsize)(aligned - offset));
+	offset = aligned;
+}
+
+/// <summary>
+/// Collects every file under the root that isn't excluded, sorted by name so the game can binary search them
+/// </summary>
+static bool CollectEntries(const PackOptions& options, std::vector<PackEntry>& outEntries, uint32_t& outExcluded) {
+	std::error_code error;
+	for (fs::recursive_directory_iterator it(options.Root, error), end; it != end; it.increment(error)) {
+		if (error) {
+			fprintf(stderr, "Could not read %s: %s\n", it->path().string().c_str(), error.message().c_str());
+			return false;
+		}
+		if (!it->is_regular_file()) {
+			continue;
+		}
+
+		std::string extension = ToLower(it->path().extension().string());
+		if (std::find(options.Excluded.begin(), options.Excluded.end(), extension) != options.Excluded.end()) {
+			outExcluded++;
+			continue;
+		}
+
+		PackEntry entry;
+		entry.Name = fs::relative(it->path(), options.Root).lexically_normal().generic_string();
+		if (!ReadContents(it->path(), entry.Contents)) {
+			fprintf(stderr, "Could not read %s\n", it->path().string().c_str());
+			return false;
+		}
+		outEntries.push_back(std::move(entry));
+	}
+
+	std::sort(outEntries.begin(), outEntries.end(), [](const PackEntry& a, const PackEntry& b) { return a.Name < b.Name; });
+	return true;
+}
+
+/// <summary>
+/// Deflates an entry, keeping the result only if it saves enough space
+/// </summary>
+static void CompressEntry(const PackOptions& options, PackEntry& entry) {
+	entry.Checksum = (uint32_t)crc32(0L, reinterpret_cast<const Bytef*>(entry.Contents.data()), (uInt)entry.Contents.size());
+	if (!options.Compress || entry.Contents.empty()) {
+		return;
+	}
+
+	uLongf compressedSize = compressBound((uLong)entry.Contents.size());
+	entry.Compressed.resize(compressedSize);
+	int result = compress2(reinterpret_cast<Bytef*>(entry.Compressed.data()), &compressedSize,
+		reinterpret_cast<const Bytef*>(entry.Contents.data()), (uLong)entry.Contents.size(), options.Level);
+	if (result != Z_OK || compressedSize > entry.Contents.size() * (1.0f - options.MinSaving)) {
+		entry.Compressed.clear();
+		return;
+	}
+	entry.Compressed.resize(compressedSize);
+}
+
+static bool WriteArchive(const PackOptions& options, const std::vector<PackEntry>& entries) {
+	AssetArchiveHeader header;
+	memset(&header, 0, sizeof(AssetArchiveHeader));
+	header.Magic = ASSET_ARCHIVE_MAGIC;
+	header.Version = ASSET_ARCHIVE_VERSION;
+	header.EntryCount = (uint32_t)entries.size();
+
+	// Lay out the table of contents and names, then the blobs after them
+	std::vector<AssetArchiveEntry> toc(entries.size());
+	std::string names;
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		toc[ix].NameOffset = (uint32_t)names.size();
+		toc[ix].NameLength = (uint32_t)entries[ix].Name.size();
+		// Null terminated so the names are readable in a hex editor, the length doesn't include it
+		names += entries[ix].Name;
+		names += '\0';
+	}
+	header.TocOffset = AlignArchiveOffset(sizeof(AssetArchiveHeader));
+	header.NamesOffset = header.TocOffset + toc.size() * sizeof(AssetArchiveEntry);
+	header.NamesSize = names.size();
+
+	uint64_t offset = AlignArchiveOffset(header.NamesOffset + header.NamesSize);
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		const PackEntry& entry = entries[ix];
+		bool compressed = !entry.Compressed.empty();
+		toc[ix].Flags = compressed ? ASSET_ENTRY_COMPRESSED : 0;
+		toc[ix].Checksum = entry.Checksum;
+		toc[ix].Offset = offset;
+		toc[ix].StoredSize = compressed ? entry.Compressed.size() : entry.Contents.size();
+		toc[ix].Size = entry.Contents.size();
+		offset = AlignArchiveOffset(offset + toc[ix].StoredSize);
+	}
+
+	// Write to a temporary file first, so a failed pack doesn't leave a broken archive behind
+	fs::path temporary = options.Output;
+	temporary += ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!out) {
+			fprintf(stderr, "Could not open %s for writing\n", temporary.string().c_str());
+			return false;
+		}
+
+		uint64_t written = 0;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(AssetArchiveHeader));
+		written += sizeof(AssetArchiveHeader);
+		WritePadding(out, written);
+		out.write(reinterpret_cast<const char*>(toc.data()), toc.size() * sizeof(AssetArchiveEntry));
+		out.write(names.data(), names.size());
+		written += toc.size() * sizeof(AssetArchiveEntry) + names.size();
+		for (const PackEntry& entry : entries) {
+			WritePadding(out, written);
+			const std::vector<char>& blob = entry.Compressed.empty() ? entry.Contents : entry.Compressed;
+			out.write(blob.data(), blob.size());
+			written += blob.size();
+		}
+		if (!out) {
+			fprintf(stderr, "Could not write %s\n", temporary.string().c_str());
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(temporary, options.Output, error);
+	if (error) {
+		fprintf(stderr, "Could not replace %s: %s\n", options.Output.string().c_str(), error.message().c_str());
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Prints the table of contents of an existing archive
+/// </summary>
+static int ListArchive(const fs::path& path) {
+	std::vector<char> contents;
+	AssetArchiveHeader header;
+	if (!ReadContents(path, contents) || contents.size() < sizeof(AssetArchiveHeader)) {
+		fprintf(stderr, "Could not read %s\n", path.string().c_str());
+		return 1;
+	}
+	memcpy(&header, contents.data(), sizeof(AssetArchiveHeader));
+	if (header.Magic != ASSET_ARCHIVE_MAGIC || header.Version != ASSET_ARCHIVE_VERSION ||
+		header.TocOffset + (uint64_t)header.EntryCount * sizeof(AssetArchiveEntry) > contents.size() ||
+		header.NamesOffset + header.NamesSize > contents.size()) {
+		fprintf(stderr, "%s is not an asset archive, or was packed by a different version\n", path.string().c_str());
+		return 1;
+	}
+
+	const AssetArchiveEntry* toc = reinterpret_cast<const AssetArchiveEntry*>(contents.data() + header.TocOffset);
+	const char* names = contents.data() + header.NamesOffset;
+	for (uint32_t ix = 0; ix < header.EntryCount; ix++) {
+		printf("%10llu %10llu %s %.*s\n",
+			(unsigned long long)toc[ix].Size, (unsigned long long)toc[ix].StoredSize,
+			(toc[ix].Flags & ASSET_ENTRY_COMPRESSED) ? "deflate" : "stored ",
+			(int)toc[ix].NameLength, names + toc[ix].NameOffset);
+	}
+	printf("%u entries, %llu bytes\n", header.EntryCount, (unsigned long long)contents.size());
+	return 0;
+}
+
+static void PrintUsage() {
+	printf("Usage:\n");
+	printf("    AssetPacker <resource folder> <output archive> [--compress] [--level 0-9] [--min-saving PERCENT] [--exclude .ext]...\n");
+	printf("    AssetPacker --list <archive>\n");
+}
+
+int main(int argc, char** argv) {
+	if (argc == 3 && strcmp(argv[1], "--list") == 0) {
+		return ListArchive(argv[2]);
+	}
+	if (argc < 3) {
+		PrintUsage();
+		return 1;
+	}
+
+	PackOptions options;
+	options.Root = argv[1];
+	options.Output = argv[2];
+	for (int ix = 3; ix < argc; ix++) {
+		bool hasValue = ix + 1 < argc;
+		if (strcmp(argv[ix], "--compress") == 0) {
+			options.Compress = true;
+		} else if (strcmp(argv[ix], "--level") == 0 && hasValue) {
+			options.Level = std::clamp(atoi(argv[++ix]), 0, 9);
+		} else if (strcmp(argv[ix], "--min-saving") == 0 && hasValue) {
+			options.MinSaving = std::clamp((float)atof(argv[++ix]) / 100.0f, 0.0f, 1.0f);
+		} else if (strcmp(argv[ix], "--exclude") == 0 && hasValue) {
+			options.Excluded.push_back(ToLower(argv[++ix]));
+		} else {
+			fprintf(stderr, "Unknown option %s\n", argv[ix]);
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (!fs::is_directory(options.Root)) {
+		fprintf(stderr, "%s is not a folder\n", options.Root.string().c_str());
+		return 1;
+	}
+
+	std::vector<PackEntry> entries;
+	uint32_t excluded = 0;
+	if (!CollectEntries(options, entries, excluded)) {
+		return 1;
+	}
+
+	uint64_t totalSize = 0;
+	uint64_t storedSize = 0;
+	uint32_t compressedCount = 0;
+	for (PackEntry& entry : entries) {
+		CompressEntry(options, entry);
+		totalSize += entry.Contents.size();
+		storedSize += entry.Compressed.empty() ? entry.Contents.size() : entry.Compressed.size();
+		compressedCount += entry.Compressed.empty() ? 0 : 1;
+	}
+
+	if (!WriteArchive(options, entries)) {
+		return 1;
+	}
+	printf("Packed %zu files into %s (%u compressed, %u excluded): %.2f MB -> %.2f MB\n",
+		entries.size(), options.Output.string().c_str(), compressedCount, excluded,
+		totalSize / (1024.0 * 1024.0), storedSize / (1024.0 * 1024.0));
+	return 0;
+}